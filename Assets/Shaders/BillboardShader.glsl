@@ -0,0 +1,45 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#version 330 core
+
+#if defined(VERTEX_SHADER_BUILD)
+
+layout (location = 0) in vec2 corner;
+layout (location = 1) in vec4 positionAndSize;
+layout (location = 2) in vec4 color;
+
+layout (std140) uniform Camera
+{
+	mat4 view;
+	mat4 projection;
+};
+
+out vec2 textureCoordinate0;
+out vec4 color0;
+
+void main()
+{
+	// Expand the quad in camera space, so it always faces the camera
+	vec4 center = view * vec4(positionAndSize.xyz, 1.0);
+	center.xy += corner * positionAndSize.w;
+
+	gl_Position = projection * center;
+	textureCoordinate0 = corner + vec2(0.5);
+	color0 = color;
+}
+
+#elif defined(FRAGMENT_SHADER_BUILD)
+
+in vec2 textureCoordinate0;
+in vec4 color0;
+
+out vec4 color;
+
+uniform sampler2D diffuse;
+
+void main()
+{
+	color = texture(diffuse, textureCoordinate0) * color0;
+}
+
+#endif
@@ -0,0 +1,55 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#version 330 core
+
+#if defined(VERTEX_SHADER_BUILD)
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec2 textureCoordinate;
+layout (location = 2) in vec3 normal;
+layout (location = 4) in vec4 boneIndices;
+layout (location = 5) in vec4 boneWeights;
+layout (location = 6) in mat4 transform;
+// x is the index of the instance's first bone matrix in the bone buffer
+layout (location = 10) in vec4 boneOffset;
+
+// Bone matrices of every instance drawn this frame, as 4 texels (columns) per matrix
+uniform samplerBuffer bones;
+
+out vec2 textureCoordinate0;
+out vec3 normal0;
+
+mat4 GetBone(float boneIndex)
+{
+	int texel = (int(boneOffset.x) + int(boneIndex)) * 4;
+	return mat4(texelFetch(bones, texel), texelFetch(bones, texel + 1),
+		texelFetch(bones, texel + 2), texelFetch(bones, texel + 3));
+}
+
+void main()
+{
+	mat4 skinning = GetBone(boneIndices.x) * boneWeights.x
+		+ GetBone(boneIndices.y) * boneWeights.y
+		+ GetBone(boneIndices.z) * boneWeights.z
+		+ GetBone(boneIndices.w) * boneWeights.w;
+
+	gl_Position = transform * skinning * vec4(position, 1.0);
+	textureCoordinate0 = textureCoordinate;
+	normal0 = (transform * skinning * vec4(normal, 0.0)).xyz;
+}
+
+#elif defined(FRAGMENT_SHADER_BUILD)
+
+in vec2 textureCoordinate0;
+in vec3 normal0;
+
+out vec4 color;
+
+uniform sampler2D diffuse;
+
+void main()
+{
+	color = texture(diffuse, textureCoordinate0);
+}
+
+#endif
@@ -0,0 +1,112 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#version 330 core
+
+#if defined(VERTEX_SHADER_BUILD)
+
+layout (location = 0) in vec2 corner;
+layout (location = 1) in vec4 centerAndRadius;
+
+layout (std140) uniform Camera
+{
+	mat4 view;
+	mat4 projection;
+};
+
+out vec3 viewPosition0;
+flat out vec4 sphere0;
+
+void main()
+{
+	vec3 center = (view * vec4(centerAndRadius.xyz, 1.0)).xyz;
+	float radius = centerAndRadius.w;
+	float centerDistance = length(center);
+
+	sphere0 = vec4(center, radius);
+
+	// The camera is inside the sphere, so it cannot be seen from outside. Collapse the quad.
+	if (centerDistance <= radius)
+	{
+		viewPosition0 = vec3(0.0);
+		gl_Position = vec4(0.0, 0.0, 0.0, 1.0);
+		return;
+	}
+
+	// Place the quad on the circle where the sphere's silhouette touches it, which is exactly
+	// the size of the silhouette as seen from the camera at any distance and field of view
+	vec3 axis = center / centerDistance;
+	vec3 up = abs(axis.y) > 0.99 ? vec3(1.0, 0.0, 0.0) : vec3(0.0, 1.0, 0.0);
+	vec3 right = normalize(cross(up, axis));
+	up = cross(axis, right);
+
+	float circleDistance = centerDistance - radius * radius / centerDistance;
+	float circleRadius = radius * sqrt(centerDistance * centerDistance - radius * radius) /
+		centerDistance;
+
+	viewPosition0 = axis * circleDistance + (right * corner.x + up * corner.y) * circleRadius;
+	gl_Position = projection * vec4(viewPosition0, 1.0);
+}
+
+#elif defined(FRAGMENT_SHADER_BUILD)
+
+in vec3 viewPosition0;
+flat in vec4 sphere0;
+
+out vec4 color;
+
+layout (std140) uniform Camera
+{
+	mat4 view;
+	mat4 projection;
+};
+
+uniform sampler2D diffuse;
+
+const float PI = 3.14159265359;
+
+void main()
+{
+	// Intersect the ray from the camera through this pixel with the sphere
+	vec3 direction = normalize(viewPosition0);
+	vec3 center = sphere0.xyz;
+	float radius = sphere0.w;
+
+	float b = dot(direction, center);
+	float h = b * b - dot(center, center) + radius * radius;
+	if (h < 0.0)
+	{
+		discard;
+	}
+
+	vec3 hit = direction * (b - sqrt(h));
+
+	// Write the depth of the sphere's surface rather than of the quad, so spheres intersect
+	// each other and the rest of the scene correctly
+	vec4 clipPosition = projection * vec4(hit, 1.0);
+	float depth = clipPosition.z / clipPosition.w;
+	gl_FragDepth = (gl_DepthRange.diff * depth + gl_DepthRange.near + gl_DepthRange.far) * 0.5;
+
+	// Map the texture by the normal in model space, so it stays fixed to the sphere as the
+	// camera moves
+	vec3 normal = transpose(mat3(view)) * ((hit - center) / radius);
+	vec2 textureCoordinate = vec2(atan(normal.x, normal.z) / (2.0 * PI) + 0.5,
+		acos(clamp(-normal.y, -1.0, 1.0)) / PI);
+
+	// The horizontal coordinate wraps around at the back of the sphere. Take its derivatives
+	// from a copy wrapping around at the front, wherever that one changes less, so the seam
+	// does not select the smallest mip level.
+	vec2 wrapped = vec2(fract(textureCoordinate.x + 0.5), textureCoordinate.y);
+	vec2 gradientX = dFdx(textureCoordinate);
+	vec2 gradientY = dFdy(textureCoordinate);
+	vec2 wrappedGradientX = dFdx(wrapped);
+	vec2 wrappedGradientY = dFdy(wrapped);
+	if (abs(wrappedGradientX.x) + abs(wrappedGradientY.x) < abs(gradientX.x) + abs(gradientY.x))
+	{
+		gradientX = wrappedGradientX;
+		gradientY = wrappedGradientY;
+	}
+
+	color = textureGrad(diffuse, textureCoordinate, gradientX, gradientY);
+}
+
+#endif
@@ -1,41 +1,44 @@
 #version 330 core
 
+// Layers drawn by each instance; must match Text::MAX_PACKED_LAYERS
+#define MAX_LAYERS 4
+
 #if defined(VERTEX_SHADER_BUILD)
 
 layout (location = 0) in vec2 position;
 layout (location = 1) in vec2 textureCoordinate;
-layout (location = 2) in vec4 textColor;
-layout (location = 3) in float smoothing;
-layout (location = 4) in float offset;
-layout (location = 5) in mat4 transform;
+layout (location = 2) in mat4 layerColors;
+layout (location = 6) in vec4 layerSmoothing;
+layout (location = 7) in vec4 layerOffsets;
+layout (location = 8) in mat4 transform;
 
 out vec2 textureCoordinate0;
-out vec4 textColor0;
-out float smoothing0;
-out float offset0;
+flat out mat4 layerColors0;
+flat out vec4 layerSmoothing0;
+flat out vec4 layerOffsets0;
 
 void main()
 {
 	gl_Position = transform * vec4(position, 0.0, 1.0);
 	textureCoordinate0 = textureCoordinate;
-	textColor0 = textColor;
-	smoothing0 = smoothing;
-	offset0 = offset;
+	layerColors0 = layerColors;
+	layerSmoothing0 = layerSmoothing;
+	layerOffsets0 = layerOffsets;
 }
 
 #elif defined(FRAGMENT_SHADER_BUILD)
 
 in vec2 textureCoordinate0;
 
-// Final color to use for text
-in vec4 textColor0; 
+// Color of each layer, from the bottom layer to the top. Unused layers are transparent.
+flat in mat4 layerColors0;
 
-// Controls how smooth the text edges are (0 = none, 1 = full)
-in float smoothing0; 
+// Controls how smooth the text edges of each layer are (0 = none, 1 = full)
+flat in vec4 layerSmoothing0;
 
-// Controls what the distance threshold is (0.5 for intended shape, < 0.5 for shape with increased
-// border, > 0.5 for shape with decreased border
-in float offset0;
+// Controls the distance threshold of each layer (0.5 for intended shape, < 0.5 for shape with
+// increased border, > 0.5 for shape with decreased border)
+flat in vec4 layerOffsets0;
 
 out vec4 color;
 
@@ -45,9 +48,20 @@ uniform sampler2D texture0;
 void main()
 {
 	float sampledDistance = texture(texture0, textureCoordinate0).r;
-	float alpha = smoothstep(offset0 - smoothing0, offset0 + smoothing0, sampledDistance);
+	vec4 alphas = smoothstep(layerOffsets0 - layerSmoothing0, layerOffsets0 + layerSmoothing0,
+		vec4(sampledDistance));
+
+	// Blend the layers over each other, as separate draws of each layer would
+	vec3 premultiplied = vec3(0.0);
+	float alpha = 0.0;
+	for (int i = 0; i < MAX_LAYERS; i++)
+	{
+		float layerAlpha = layerColors0[i].w * alphas[i];
+		premultiplied = layerColors0[i].xyz * layerAlpha + premultiplied * (1.0 - layerAlpha);
+		alpha = layerAlpha + alpha * (1.0 - layerAlpha);
+	}
 
-	color = vec4(textColor0.xyz, textColor0.w * alpha);
+	color = vec4(alpha > 0.0 ? premultiplied / alpha : vec3(0.0), alpha);
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -25,6 +25,7 @@
  */
 
 #include "AABB.h"
+#include "SIMD.h"
 
 AABB::AABB(const std::vector<glm::vec3>& points)
 {
@@ -74,3 +75,57 @@ AABB AABB::Translate(const glm::vec3& translation) const
 	// Apply translation to min and max extents
 	return AABB(extents[0] + translation, extents[1] + translation);
 }
+
+AABB AABB::Transform(const glm::mat4& transform) const
+{
+	AABB result;
+	TransformMany(this, &transform, &result, 1);
+	return result;
+}
+
+void AABB::TransformMany(const AABB* bounds, const glm::mat4* transforms, AABB* result,
+	size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		const glm::vec3 center = bounds[i].GetCenter();
+		const glm::vec3 halfSize = (bounds[i].extents[1] - bounds[i].extents[0]) * 0.5f;
+		const float* matrix = &transforms[i][0][0];
+
+#if defined(GLENGINE_SSE2)
+		const __m128 signMask = _mm_set1_ps(-0.0f);
+		const __m128 column0 = _mm_loadu_ps(matrix);
+		const __m128 column1 = _mm_loadu_ps(matrix + 4);
+		const __m128 column2 = _mm_loadu_ps(matrix + 8);
+
+		__m128 newCenter = _mm_loadu_ps(matrix + 12);
+		newCenter = _mm_add_ps(newCenter, _mm_mul_ps(column0, _mm_set1_ps(center.x)));
+		newCenter = _mm_add_ps(newCenter, _mm_mul_ps(column1, _mm_set1_ps(center.y)));
+		newCenter = _mm_add_ps(newCenter, _mm_mul_ps(column2, _mm_set1_ps(center.z)));
+
+		__m128 newHalfSize = _mm_mul_ps(_mm_andnot_ps(signMask, column0), _mm_set1_ps(halfSize.x));
+		newHalfSize = _mm_add_ps(newHalfSize,
+			_mm_mul_ps(_mm_andnot_ps(signMask, column1), _mm_set1_ps(halfSize.y)));
+		newHalfSize = _mm_add_ps(newHalfSize,
+			_mm_mul_ps(_mm_andnot_ps(signMask, column2), _mm_set1_ps(halfSize.z)));
+
+		float minExtents[4];
+		float maxExtents[4];
+		_mm_storeu_ps(minExtents, _mm_sub_ps(newCenter, newHalfSize));
+		_mm_storeu_ps(maxExtents, _mm_add_ps(newCenter, newHalfSize));
+
+		result[i].extents[0] = glm::vec3(minExtents[0], minExtents[1], minExtents[2]);
+		result[i].extents[1] = glm::vec3(maxExtents[0], maxExtents[1], maxExtents[2]);
+#else
+		const glm::mat3 rotationScale = glm::mat3(transforms[i]);
+		const glm::mat3 absolute = glm::mat3(glm::abs(rotationScale[0]),
+			glm::abs(rotationScale[1]), glm::abs(rotationScale[2]));
+
+		const glm::vec3 newCenter = rotationScale * center + glm::vec3(transforms[i][3]);
+		const glm::vec3 newHalfSize = absolute * halfSize;
+
+		result[i].extents[0] = newCenter - newHalfSize;
+		result[i].extents[1] = newCenter + newHalfSize;
+#endif
+	}
+}
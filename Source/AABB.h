@@ -79,6 +79,35 @@ public:
 	 */
 	[[nodiscard]] AABB Translate(const glm::vec3& translation) const;
 
+	bool operator==(const AABB& other) const
+	{
+		return extents[0] == other.extents[0] && extents[1] == other.extents[1];
+	}
+
+	bool operator!=(const AABB& other) const { return !(*this == other); }
+
+	/**
+	 * Transforms a copy of the AABB by a full affine transform, including rotation and scaling.
+	 * The result is the tightest AABB around the transformed box (Arvo's method).
+	 * 
+	 * @param transform The affine transform to apply.
+	 * @return The transformed copy of the AABB.
+	 */
+	[[nodiscard]] AABB Transform(const glm::mat4& transform) const;
+
+	/**
+	 * Transforms many AABBs by their own affine transforms in one batch. Each box is converted
+	 * into a center and half size; the new center is the transformed center, and the new half
+	 * size is the half size transformed by the absolute value of the matrix.
+	 * 
+	 * @param bounds Array of AABBs to transform.
+	 * @param transforms Array of transforms, one per AABB.
+	 * @param result Array to write the transformed AABBs to. May alias bounds.
+	 * @param count The number of AABBs.
+	 */
+	static void TransformMany(const AABB* bounds, const glm::mat4* transforms, AABB* result,
+		size_t count);
+
 	// Getter methods...
 	[[nodiscard]] glm::vec3 GetCenter() const { return (extents[0] + extents[1]) * 0.5f; }
 	[[nodiscard]] glm::vec3 GetMinExtents() const { return extents[0]; }
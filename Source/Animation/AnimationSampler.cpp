@@ -0,0 +1,269 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#include "AnimationSampler.h"
+#include "SIMD.h"
+
+#include <cmath>
+
+static constexpr float QUANTIZATION_SCALE = 1.0f / 32767.0f;
+
+/**
+ * @brief Finds the two keys surrounding a point in time.
+ * @return false if the clip has no keys.
+ */
+static bool FindFrames(const AnimationClip& clip, float time, bool loop, unsigned int& frame0,
+	unsigned int& frame1, float& alpha)
+{
+	if (clip.numFrames == 0)
+	{
+		return false;
+	}
+
+	if (loop && clip.duration > 0.0f)
+	{
+		time = std::fmod(time, clip.duration);
+		if (time < 0.0f)
+		{
+			time += clip.duration;
+		}
+	}
+	else
+	{
+		time = glm::clamp(time, 0.0f, clip.duration);
+	}
+
+	const float framePosition = time * clip.sampleRate;
+	const unsigned int lastFrame = clip.numFrames - 1;
+
+	frame0 = glm::min((unsigned int)framePosition, lastFrame);
+	frame1 = glm::min(frame0 + 1, lastFrame);
+	alpha = glm::clamp(framePosition - (float)frame0, 0.0f, 1.0f);
+	return true;
+}
+
+#if defined(GLENGINE_SSE2)
+
+/** @brief Loads 4 16-bit normalized integers, converted to floats in [-1, 1]. */
+static inline __m128 LoadNormalized(const int16_t* values)
+{
+	__m128i integers = _mm_loadl_epi64((const __m128i*)values);
+	// Sign extend to 32 bits by moving each value into the high half, then shifting back down
+	integers = _mm_srai_epi32(_mm_unpacklo_epi16(integers, integers), 16);
+	return _mm_mul_ps(_mm_cvtepi32_ps(integers), _mm_set1_ps(QUANTIZATION_SCALE));
+}
+
+/** @brief 4 component dot product, broadcast to all lanes. */
+static inline __m128 Dot4(__m128 a, __m128 b)
+{
+	__m128 products = _mm_mul_ps(a, b);
+	__m128 shuffled = _mm_shuffle_ps(products, products, _MM_SHUFFLE(2, 3, 0, 1));
+	__m128 sums = _mm_add_ps(products, shuffled);
+	shuffled = _mm_movehl_ps(shuffled, sums);
+	sums = _mm_add_ss(sums, shuffled);
+	return _mm_shuffle_ps(sums, sums, 0);
+}
+
+void AnimationSampler::SampleClip(const AnimationClip& clip, float time, bool loop,
+	BonePose* poses)
+{
+	unsigned int frame0, frame1;
+	float alpha;
+	if (!FindFrames(clip, time, loop, frame0, frame1, alpha))
+	{
+		return;
+	}
+
+	const AnimationClip::Key* keys0 = clip.GetFrame(frame0);
+	const AnimationClip::Key* keys1 = clip.GetFrame(frame1);
+	const __m128 t = _mm_set1_ps(alpha);
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+
+	for (unsigned int i = 0; i < clip.numBones; i++)
+	{
+		// Rotation; normalized lerp along the shortest path
+		const __m128 rotation0 = LoadNormalized(keys0[i].rotation);
+		__m128 rotation1 = LoadNormalized(keys1[i].rotation);
+		rotation1 = _mm_xor_ps(rotation1, _mm_and_ps(Dot4(rotation0, rotation1), signMask));
+		__m128 rotation = _mm_add_ps(rotation0, _mm_mul_ps(_mm_sub_ps(rotation1, rotation0), t));
+		rotation = _mm_div_ps(rotation, _mm_sqrt_ps(Dot4(rotation, rotation)));
+		_mm_store_ps(poses[i].rotation, rotation);
+
+		// Translation and scale; lerp then dequantize, as dequantization is linear
+		const __m128 translationCenter = _mm_loadu_ps(&clip.translationCenters[i][0]);
+		const __m128 translationExtent = _mm_loadu_ps(&clip.translationExtents[i][0]);
+		const __m128 translation0 = LoadNormalized(keys0[i].translation);
+		const __m128 translation1 = LoadNormalized(keys1[i].translation);
+		const __m128 translation = _mm_add_ps(translation0,
+			_mm_mul_ps(_mm_sub_ps(translation1, translation0), t));
+		_mm_store_ps(poses[i].translation,
+			_mm_add_ps(translationCenter, _mm_mul_ps(translation, translationExtent)));
+
+		const __m128 scaleCenter = _mm_loadu_ps(&clip.scaleCenters[i][0]);
+		const __m128 scaleExtent = _mm_loadu_ps(&clip.scaleExtents[i][0]);
+		const __m128 scale0 = LoadNormalized(keys0[i].scale);
+		const __m128 scale1 = LoadNormalized(keys1[i].scale);
+		const __m128 scale = _mm_add_ps(scale0, _mm_mul_ps(_mm_sub_ps(scale1, scale0), t));
+		_mm_store_ps(poses[i].scale, _mm_add_ps(scaleCenter, _mm_mul_ps(scale, scaleExtent)));
+	}
+}
+
+#else
+
+void AnimationSampler::SampleClip(const AnimationClip& clip, float time, bool loop,
+	BonePose* poses)
+{
+	unsigned int frame0, frame1;
+	float alpha;
+	if (!FindFrames(clip, time, loop, frame0, frame1, alpha))
+	{
+		return;
+	}
+
+	const AnimationClip::Key* keys0 = clip.GetFrame(frame0);
+	const AnimationClip::Key* keys1 = clip.GetFrame(frame1);
+
+	for (unsigned int i = 0; i < clip.numBones; i++)
+	{
+		float rotation0[4], rotation1[4];
+		float dot = 0.0f;
+		for (unsigned int j = 0; j < 4; j++)
+		{
+			rotation0[j] = keys0[i].rotation[j] * QUANTIZATION_SCALE;
+			rotation1[j] = keys1[i].rotation[j] * QUANTIZATION_SCALE;
+			dot += rotation0[j] * rotation1[j];
+		}
+
+		float lengthSquared = 0.0f;
+		for (unsigned int j = 0; j < 4; j++)
+		{
+			const float target = dot < 0.0f ? -rotation1[j] : rotation1[j];
+			poses[i].rotation[j] = rotation0[j] + (target - rotation0[j]) * alpha;
+			lengthSquared += poses[i].rotation[j] * poses[i].rotation[j];
+		}
+
+		const float inverseLength = 1.0f / std::sqrt(lengthSquared);
+		for (unsigned int j = 0; j < 4; j++)
+		{
+			poses[i].rotation[j] *= inverseLength;
+
+			const float translation0 = keys0[i].translation[j] * QUANTIZATION_SCALE;
+			const float translation1 = keys1[i].translation[j] * QUANTIZATION_SCALE;
+			poses[i].translation[j] = clip.translationCenters[i][j] + clip.translationExtents[i][j]
+				* (translation0 + (translation1 - translation0) * alpha);
+
+			const float scale0 = keys0[i].scale[j] * QUANTIZATION_SCALE;
+			const float scale1 = keys1[i].scale[j] * QUANTIZATION_SCALE;
+			poses[i].scale[j] = clip.scaleCenters[i][j] + clip.scaleExtents[i][j]
+				* (scale0 + (scale1 - scale0) * alpha);
+		}
+	}
+}
+
+#endif
+
+/** @brief Builds the translate * rotate * scale matrix of a bone pose. */
+static inline void ComposeBoneMatrix(const BonePose& pose, glm::mat4& result)
+{
+	const float x = pose.rotation[0];
+	const float y = pose.rotation[1];
+	const float z = pose.rotation[2];
+	const float w = pose.rotation[3];
+
+	const float sx = pose.scale[0];
+	const float sy = pose.scale[1];
+	const float sz = pose.scale[2];
+
+	result[0] = glm::vec4((1.0f - 2.0f * (y * y + z * z)) * sx, 2.0f * (x * y + w * z) * sx,
+		2.0f * (x * z - w * y) * sx, 0.0f);
+	result[1] = glm::vec4(2.0f * (x * y - w * z) * sy, (1.0f - 2.0f * (x * x + z * z)) * sy,
+		2.0f * (y * z + w * x) * sy, 0.0f);
+	result[2] = glm::vec4(2.0f * (x * z + w * y) * sz, 2.0f * (y * z - w * x) * sz,
+		(1.0f - 2.0f * (x * x + y * y)) * sz, 0.0f);
+	result[3] = glm::vec4(pose.translation[0], pose.translation[1], pose.translation[2], 1.0f);
+}
+
+void AnimationSampler::ComputeSkinningMatrices(const Skeleton& skeleton, const BonePose* poses,
+	glm::mat4* modelPoses, glm::mat4* skinningMatrices)
+{
+	const unsigned int numBones = skeleton.GetNumBones();
+	glm::mat4 local;
+
+	// Parents always precede their children, so their model pose is already known
+	for (unsigned int i = 0; i < numBones; i++)
+	{
+		ComposeBoneMatrix(poses[i], local);
+
+		const int parent = skeleton.parents[i];
+		const glm::mat4& parentPose = parent < 0
+			? skeleton.globalInverseTransform
+			: modelPoses[parent];
+
+		SIMD::MultiplyMat4(parentPose, local, modelPoses[i]);
+		SIMD::MultiplyMat4(modelPoses[i], skeleton.inverseBindPoses[i], skinningMatrices[i]);
+	}
+}
+
+void AnimationSampler::SkinVertices(const float* positions, const float* normals,
+	const float* boneIndices, const float* boneWeights, unsigned int numVertices,
+	const glm::mat4* skinningMatrices, float* outPositions, float* outNormals)
+{
+	for (unsigned int i = 0; i < numVertices; i++)
+	{
+		const float* indices = boneIndices + i * 4;
+		const float* weights = boneWeights + i * 4;
+
+#if defined(GLENGINE_SSE2)
+		// Blend the influencing matrices, one column at a time
+		__m128 columns[4] = { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(),
+			_mm_setzero_ps() };
+		for (unsigned int j = 0; j < 4; j++)
+		{
+			if (weights[j] == 0.0f)
+			{
+				continue;
+			}
+
+			const float* matrix = &skinningMatrices[(unsigned int)indices[j]][0][0];
+			const __m128 weight = _mm_set1_ps(weights[j]);
+			for (unsigned int k = 0; k < 4; k++)
+			{
+				columns[k] = _mm_add_ps(columns[k], _mm_mul_ps(_mm_loadu_ps(matrix + k * 4), weight));
+			}
+		}
+
+		const float* position = positions + i * 3;
+		const float* normal = normals + i * 3;
+
+		alignas(16) float skinnedPosition[4];
+		alignas(16) float skinnedNormal[4];
+		_mm_store_ps(skinnedPosition, _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(columns[0], _mm_set1_ps(position[0])),
+			_mm_mul_ps(columns[1], _mm_set1_ps(position[1]))), _mm_add_ps(
+			_mm_mul_ps(columns[2], _mm_set1_ps(position[2])), columns[3])));
+		_mm_store_ps(skinnedNormal, _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(columns[0], _mm_set1_ps(normal[0])),
+			_mm_mul_ps(columns[1], _mm_set1_ps(normal[1]))),
+			_mm_mul_ps(columns[2], _mm_set1_ps(normal[2]))));
+#else
+		glm::mat4 blended(0.0f);
+		for (unsigned int j = 0; j < 4; j++)
+		{
+			if (weights[j] != 0.0f)
+			{
+				blended += skinningMatrices[(unsigned int)indices[j]] * weights[j];
+			}
+		}
+
+		const glm::vec4 skinnedPosition = blended * glm::vec4(positions[i * 3],
+			positions[i * 3 + 1], positions[i * 3 + 2], 1.0f);
+		const glm::vec4 skinnedNormal = blended * glm::vec4(normals[i * 3],
+			normals[i * 3 + 1], normals[i * 3 + 2], 0.0f);
+#endif
+
+		for (unsigned int j = 0; j < 3; j++)
+		{
+			outPositions[i * 3 + j] = skinnedPosition[j];
+			outNormals[i * 3 + j] = skinnedNormal[j];
+		}
+	}
+}
@@ -0,0 +1,60 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include "Skeleton.h"
+
+/**
+ * @brief Local (parent-relative) transform of a single bone.
+ */
+struct alignas(16) BonePose
+{
+	float rotation[4]; // Quaternion; x, y, z, w
+	float translation[4]; // x, y, z, padding
+	float scale[4]; // x, y, z, padding
+};
+
+/**
+ * @brief Vectorized kernels used to evaluate skeletal animation. All kernels operate on whole
+ * skeletons at a time so they can be batched across many animated entities.
+ */
+namespace AnimationSampler
+{
+	/**
+	 * @brief Samples every bone of a clip at a point in time, interpolating between the two
+	 *		closest keys.
+	 * @param clip Clip to sample.
+	 * @param time Time in seconds. Wrapped into the clip if looping, otherwise clamped.
+	 * @param loop Whether the clip is looping.
+	 * @param poses Output array of clip.numBones local bone poses.
+	 */
+	void SampleClip(const AnimationClip& clip, float time, bool loop, BonePose* poses);
+
+	/**
+	 * @brief Converts local bone poses into skinning matrices; the transform from the bind pose
+	 *		of the mesh into the animated pose, for each bone.
+	 * @param skeleton Skeleton the poses belong to.
+	 * @param poses Array of skeleton.GetNumBones() local bone poses.
+	 * @param modelPoses Scratch array of skeleton.GetNumBones() matrices, receiving the
+	 *		model-space transform of each bone.
+	 * @param skinningMatrices Output array of skeleton.GetNumBones() matrices.
+	 */
+	void ComputeSkinningMatrices(const Skeleton& skeleton, const BonePose* poses,
+		glm::mat4* modelPoses, glm::mat4* skinningMatrices);
+
+	/**
+	 * @brief CPU skinning fallback, for when skinning cannot be done in the vertex shader. Each
+	 *		vertex is influenced by up to 4 bones.
+	 * @param positions Bind pose positions, 3 floats per vertex.
+	 * @param normals Bind pose normals, 3 floats per vertex.
+	 * @param boneIndices Bone indices, 4 floats per vertex.
+	 * @param boneWeights Bone weights, 4 floats per vertex, which should sum to 1.
+	 * @param numVertices Number of vertices to skin.
+	 * @param skinningMatrices Skinning matrices, from ComputeSkinningMatrices.
+	 * @param outPositions Output skinned positions, 3 floats per vertex.
+	 * @param outNormals Output skinned normals, 3 floats per vertex. Not renormalized.
+	 */
+	void SkinVertices(const float* positions, const float* normals, const float* boneIndices,
+		const float* boneWeights, unsigned int numVertices, const glm::mat4* skinningMatrices,
+		float* outPositions, float* outNormals);
+}
@@ -0,0 +1,56 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#include "Animator.h"
+
+#include <algorithm>
+
+unsigned int Animator::AddInstance(const Skeleton& skeleton, const AnimationClip& clip, float time,
+	bool loop)
+{
+	Instance instance;
+	instance.skeleton = &skeleton;
+	instance.clip = &clip;
+	instance.time = time;
+	instance.loop = loop;
+	instance.matrixOffset = numMatrices;
+
+	numMatrices += skeleton.GetNumBones();
+	instances.push_back(instance);
+	return (unsigned int)instances.size() - 1;
+}
+
+void Animator::Update()
+{
+	if (skinningMatrices.size() < numMatrices)
+	{
+		skinningMatrices.resize(numMatrices);
+	}
+
+	for (const Instance& instance : instances)
+	{
+		const unsigned int numBones = instance.skeleton->GetNumBones();
+		if (instance.clip->numBones != numBones || instance.clip->numFrames == 0)
+		{
+			// Leave mismatched instances in the bind pose
+			std::fill_n(skinningMatrices.begin() + instance.matrixOffset, numBones, glm::mat4(1.0f));
+			continue;
+		}
+
+		// Scratch space is shared by all instances; only the skinning matrices are kept
+		if (poses.size() < numBones)
+		{
+			poses.resize(numBones);
+			modelPoses.resize(numBones);
+		}
+
+		AnimationSampler::SampleClip(*instance.clip, instance.time, instance.loop, poses.data());
+		AnimationSampler::ComputeSkinningMatrices(*instance.skeleton, poses.data(),
+			modelPoses.data(), &skinningMatrices[instance.matrixOffset]);
+	}
+}
+
+void Animator::Clear()
+{
+	instances.clear();
+	numMatrices = 0;
+}
@@ -0,0 +1,67 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include "AnimationSampler.h"
+
+#include <vector>
+
+/**
+ * @brief Evaluates the poses of many animated instances in one batch. Instances are queued over
+ * the course of a frame, then sampled and converted into skinning matrices together in Update,
+ * which keeps the sampling kernels hot and avoids per-entity allocations.
+ */
+class Animator
+{
+public:
+	Animator() {}
+
+	/**
+	 * @brief Queues an instance to be animated in the next update.
+	 * @param skeleton Skeleton of the instance.
+	 * @param clip Clip to play, whose bones match the skeleton.
+	 * @param time Playback time in seconds.
+	 * @param loop Whether the clip is looping.
+	 * @return Index of the instance, used to retrieve its skinning matrices after the update.
+	 */
+	unsigned int AddInstance(const Skeleton& skeleton, const AnimationClip& clip, float time,
+		bool loop = true);
+
+	/** @brief Samples and poses all queued instances. */
+	void Update();
+
+	/** @brief Removes all queued instances. Output buffers are kept for reuse. */
+	void Clear();
+
+	inline const glm::mat4* GetSkinningMatrices(unsigned int instance) const
+	{
+		return &skinningMatrices[instances[instance].matrixOffset];
+	}
+
+	inline unsigned int GetNumBones(unsigned int instance) const
+	{
+		return instances[instance].skeleton->GetNumBones();
+	}
+
+	inline unsigned int GetNumInstances() const { return (unsigned int)instances.size(); }
+
+private:
+	// Disallow copy and assign
+	Animator(const Animator& other) = delete;
+	void operator=(const Animator& other) = delete;
+
+	struct Instance
+	{
+		const Skeleton* skeleton;
+		const AnimationClip* clip;
+		float time;
+		bool loop;
+		size_t matrixOffset;
+	};
+
+	std::vector<Instance> instances;
+	std::vector<BonePose> poses;
+	std::vector<glm::mat4> modelPoses;
+	std::vector<glm::mat4> skinningMatrices;
+	size_t numMatrices = 0;
+};
@@ -0,0 +1,65 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include <GLM/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Bone hierarchy of a skinned model. Bones are stored so that every parent comes before
+ * its children, which lets the local-to-model pass run as a single forward loop.
+ */
+struct Skeleton
+{
+	// Maximum number of bones of a skeleton, which bounds the size of each skinning palette.
+	// Files with larger skeletons are rejected by LoadSkinnedModels.
+	static constexpr unsigned int MAX_BONES = 64;
+
+	std::vector<std::string> boneNames;
+	// Index of the parent of each bone, or -1 for the root
+	std::vector<int> parents;
+	// Transforms from model space into the space of each bone, in the bind pose
+	std::vector<glm::mat4> inverseBindPoses;
+	// Inverse of the root node transform, applied to the root so skinned vertices stay in mesh space
+	glm::mat4 globalInverseTransform = glm::mat4(1.0f);
+
+	inline unsigned int GetNumBones() const { return (unsigned int)parents.size(); }
+};
+
+/**
+ * @brief Animation clip in a compact, quantized format. Tracks are resampled at a fixed rate on
+ * import so every bone shares the same key times, and keys are stored frame-major; sampling a
+ * pose then only touches two contiguous runs of memory.
+ *
+ * Rotations are stored as 16-bit normalized quaternions. Translations and scales are stored as
+ * 16-bit normalized offsets within a per-bone range (center +/- extent).
+ */
+struct AnimationClip
+{
+	struct Key
+	{
+		int16_t rotation[4]; // x, y, z, w
+		int16_t translation[4]; // x, y, z, padding
+		int16_t scale[4]; // x, y, z, padding
+	};
+
+	std::string name;
+	// Length of the clip, in seconds
+	float duration = 0.0f;
+	// Number of keys per second
+	float sampleRate = 30.0f;
+	unsigned int numFrames = 0;
+	unsigned int numBones = 0;
+
+	// numFrames * numBones keys, frame-major
+	std::vector<Key> keys;
+	std::vector<glm::vec4> translationCenters;
+	std::vector<glm::vec4> translationExtents;
+	std::vector<glm::vec4> scaleCenters;
+	std::vector<glm::vec4> scaleExtents;
+
+	inline const Key* GetFrame(unsigned int frame) const { return &keys[frame * numBones]; }
+};
@@ -0,0 +1,599 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#include "HLODBuilder.h"
+#include "Jobs/JobSystem.h"
+#include "Rendering/Mesh.h"
+#include "Rendering/TexturePacker.h"
+#include "Timing.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+
+#include "stb_image.h"
+
+// Texels of each texture repeated around it in the atlas, so filtering and smaller mipmaps do not
+// bleed its neighbours in
+static const int ATLAS_PADDING = 4;
+// Largest simplification cell coordinate along each axis, so cells fit in 16 bits of a key
+static const int MAX_CELL = 0xFFFF;
+// "GLHL", little endian
+static const uint32_t HLOD_FILE_MAGIC = 0x4C484C47;
+static const uint32_t HLOD_FILE_VERSION = 1;
+
+/** @return The smallest box enclosing both boxes. */
+static inline AABB Enclose(const AABB& a, const AABB& b)
+{
+	return AABB(glm::min(a.GetMinExtents(), b.GetMinExtents()),
+		glm::max(a.GetMaxExtents(), b.GetMaxExtents()));
+}
+
+/**
+ * @brief Halves an RGBA image with a box filter until it fits in a size.
+ * @param texture Image to downscale.
+ * @param maxSize Largest width or height of the result.
+ * @param size Set to the size of the result.
+ * @return Pixels of the result.
+ */
+static std::vector<unsigned char> Downscale(const ArrayBitmap& texture, int maxSize,
+	glm::ivec2& size)
+{
+	size = glm::ivec2(texture.GetWidth(), texture.GetHeight());
+	std::vector<unsigned char> pixels((size_t)size.x * size.y * 4);
+	std::memcpy(pixels.data(), texture.GetPixelArray(), pixels.size());
+
+	while (size.x > maxSize || size.y > maxSize)
+	{
+		const glm::ivec2 newSize = glm::max(size / 2, glm::ivec2(1));
+		std::vector<unsigned char> newPixels((size_t)newSize.x * newSize.y * 4);
+
+		for (int y = 0; y < newSize.y; y++)
+		{
+			const int y0 = std::min(y * 2, size.y - 1);
+			const int y1 = std::min(y * 2 + 1, size.y - 1);
+			for (int x = 0; x < newSize.x; x++)
+			{
+				const int x0 = std::min(x * 2, size.x - 1);
+				const int x1 = std::min(x * 2 + 1, size.x - 1);
+				for (int channel = 0; channel < 4; channel++)
+				{
+					const unsigned int sum =
+						pixels[((size_t)y0 * size.x + x0) * 4 + channel] +
+						pixels[((size_t)y0 * size.x + x1) * 4 + channel] +
+						pixels[((size_t)y1 * size.x + x0) * 4 + channel] +
+						pixels[((size_t)y1 * size.x + x1) * 4 + channel];
+					newPixels[((size_t)y * newSize.x + x) * 4 + channel] =
+						(unsigned char)((sum + 2) / 4);
+				}
+			}
+		}
+
+		size = newSize;
+		pixels = std::move(newPixels);
+	}
+
+	return pixels;
+}
+
+HLODBuilder::HLODBuilder(JobSystem* jobSystem) : jobSystem(jobSystem) {}
+
+void HLODBuilder::AddMesh(const IndexedModel& model, const ArrayBitmap& texture,
+	const glm::mat4& transform)
+{
+	const std::span<const float> positions = model.GetElement(0);
+
+	glm::vec3 minExtents(std::numeric_limits<float>::max());
+	glm::vec3 maxExtents(-std::numeric_limits<float>::max());
+	for (size_t i = 0; i + 2 < positions.size(); i += 3)
+	{
+		const glm::vec3 position = glm::vec3(transform *
+			glm::vec4(positions[i], positions[i + 1], positions[i + 2], 1.0f));
+		minExtents = glm::min(minExtents, position);
+		maxExtents = glm::max(maxExtents, position);
+	}
+
+	if (positions.empty())
+	{
+		minExtents = maxExtents = glm::vec3(transform[3]);
+	}
+
+	meshes.push_back({ &model, &texture, transform, AABB(minExtents, maxExtents) });
+}
+
+void HLODBuilder::Build(const Settings& settings)
+{
+	clusters.clear();
+
+	// Ordered, so clusters are numbered the same on every build
+	std::map<std::tuple<int, int, int>, unsigned int> cellClusters;
+	for (unsigned int i = 0; i < (unsigned int)meshes.size(); i++)
+	{
+		const AABB& bounds = meshes[i].bounds;
+		const glm::ivec3 cell = glm::ivec3(glm::floor(bounds.GetCenter() /
+			settings.clusterSize));
+
+		const auto [it, isNew] = cellClusters.emplace(std::make_tuple(cell.x, cell.y, cell.z),
+			(unsigned int)clusters.size());
+		if (isNew)
+		{
+			clusters.emplace_back();
+			clusters.back().bounds = bounds;
+		}
+
+		HLODCluster& cluster = clusters[it->second];
+		cluster.members.push_back(i);
+		cluster.bounds = Enclose(cluster.bounds, bounds);
+	}
+
+	const auto buildClusters = [&](unsigned int begin, unsigned int end)
+	{
+		std::vector<glm::vec4> textureRegions;
+		for (unsigned int i = begin; i < end; i++)
+		{
+			BuildAtlas(clusters[i], settings, textureRegions);
+			BuildProxy(clusters[i], settings, textureRegions);
+		}
+	};
+
+	if (jobSystem)
+	{
+		jobSystem->ParallelFor((unsigned int)clusters.size(), 1, buildClusters);
+	}
+	else
+	{
+		buildClusters(0, (unsigned int)clusters.size());
+	}
+}
+
+void HLODBuilder::BuildAtlas(HLODCluster& cluster, const Settings& settings,
+	std::vector<glm::vec4>& textureRegions) const
+{
+	// Members sharing a texture share its place in the atlas
+	std::vector<const ArrayBitmap*> textures;
+	for (unsigned int member : cluster.members)
+	{
+		if (std::find(textures.begin(), textures.end(), meshes[member].texture) == textures.end())
+		{
+			textures.push_back(meshes[member].texture);
+		}
+	}
+
+	std::vector<glm::ivec2> origins(textures.size());
+	std::vector<glm::ivec2> sizes(textures.size());
+
+	int initialSize = 1;
+	while (initialSize < std::max(settings.maxTextureSize, 1) + ATLAS_PADDING * 2)
+	{
+		initialSize *= 2;
+	}
+
+	TexturePacker packer(glm::ivec2(initialSize), 4);
+	for (size_t i = 0; i < textures.size(); i++)
+	{
+		const std::vector<unsigned char> pixels = Downscale(*textures[i],
+			std::max(settings.maxTextureSize, 1), sizes[i]);
+
+		// Extend the edges of the texture into its padding
+		const glm::ivec2 paddedSize = sizes[i] + ATLAS_PADDING * 2;
+		std::vector<unsigned char> padded((size_t)paddedSize.x * paddedSize.y * 4);
+		for (int y = 0; y < paddedSize.y; y++)
+		{
+			const int sourceY = std::clamp(y - ATLAS_PADDING, 0, sizes[i].y - 1);
+			for (int x = 0; x < paddedSize.x; x++)
+			{
+				const int sourceX = std::clamp(x - ATLAS_PADDING, 0, sizes[i].x - 1);
+				std::memcpy(&padded[((size_t)y * paddedSize.x + x) * 4],
+					&pixels[((size_t)sourceY * sizes[i].x + sourceX) * 4], 4);
+			}
+		}
+
+		origins[i] = packer.PackTexture(padded.data(), paddedSize) + ATLAS_PADDING;
+	}
+
+	// The atlas may have grown while packing, so regions are only known once all are packed
+	const glm::ivec2 atlasSize = packer.GetTextureSize();
+	cluster.atlasWidth = atlasSize.x;
+	cluster.atlasHeight = atlasSize.y;
+	cluster.atlas.resize((size_t)atlasSize.x * atlasSize.y);
+	std::memcpy(cluster.atlas.data(), packer.GetBuffer(), cluster.atlas.size() * sizeof(int));
+
+	// Offset and scale of each member's texture coordinates into the atlas
+	textureRegions.resize(cluster.members.size());
+	for (size_t i = 0; i < cluster.members.size(); i++)
+	{
+		const size_t texture = std::find(textures.begin(), textures.end(),
+			meshes[cluster.members[i]].texture) - textures.begin();
+		textureRegions[i] = glm::vec4(glm::vec2(origins[texture]) / glm::vec2(atlasSize),
+			glm::vec2(sizes[texture]) / glm::vec2(atlasSize));
+	}
+}
+
+void HLODBuilder::BuildProxy(HLODCluster& cluster, const Settings& settings,
+	const std::vector<glm::vec4>& textureRegions) const
+{
+	struct WeldedVertex
+	{
+		glm::vec3 position;
+		glm::vec2 textureCoordinate;
+		glm::vec3 normal;
+		glm::vec3 tangent;
+		float occlusion;
+		unsigned int count;
+	};
+
+	std::unordered_map<uint64_t, unsigned int> cellVertices;
+	std::vector<WeldedVertex> welded;
+	std::vector<std::array<unsigned int, 3>> triangles;
+	std::vector<unsigned int> vertexMap;
+
+	const glm::vec3 origin = cluster.bounds.GetMinExtents();
+	const float inverseCellSize = 1.0f / std::max(settings.simplifyCellSize, 1e-6f);
+
+	for (size_t i = 0; i < cluster.members.size(); i++)
+	{
+		const SourceMesh& mesh = meshes[cluster.members[i]];
+		const std::span<const float> positions = mesh.model->GetElement(0);
+		const std::span<const float> textureCoordinates = mesh.model->GetElement(1);
+		const std::span<const float> normals = mesh.model->GetElement(2);
+		const std::span<const float> tangents = mesh.model->GetElement(3);
+		const std::span<const float> occlusion = mesh.model->GetElement(4);
+		const size_t numVertices = positions.size() / 3;
+		const glm::mat3 normalTransform = glm::transpose(glm::inverse(glm::mat3(mesh.transform)));
+		const glm::vec4& region = textureRegions[i];
+
+		// Members sharing a texture may be welded together; identify it by its first member
+		uint64_t textureSlot = 0;
+		while (meshes[cluster.members[textureSlot]].texture != mesh.texture)
+		{
+			textureSlot++;
+		}
+
+		vertexMap.resize(numVertices);
+		for (size_t v = 0; v < numVertices; v++)
+		{
+			const glm::vec3 position = glm::vec3(mesh.transform *
+				glm::vec4(positions[v * 3], positions[v * 3 + 1], positions[v * 3 + 2], 1.0f));
+			const glm::vec3 normal = normalTransform *
+				glm::vec3(normals[v * 3], normals[v * 3 + 1], normals[v * 3 + 2]);
+			const glm::vec3 tangent = glm::mat3(mesh.transform) *
+				glm::vec3(tangents[v * 3], tangents[v * 3 + 1], tangents[v * 3 + 2]);
+			const glm::vec2 textureCoordinate = glm::vec2(region) + glm::vec2(region.z, region.w) *
+				glm::clamp(glm::vec2(textureCoordinates[v * 2], textureCoordinates[v * 2 + 1]),
+					glm::vec2(0.0f), glm::vec2(1.0f));
+
+			// Vertices are only welded to others in the same cell, with the same texture and
+			// facing roughly the same way, so opposite sides of thin walls stay apart
+			const glm::ivec3 cell = glm::clamp(glm::ivec3((position - origin) * inverseCellSize),
+				glm::ivec3(0), glm::ivec3(MAX_CELL));
+			const glm::vec3 absNormal = glm::abs(normal);
+			const unsigned int axis = absNormal.x >= absNormal.y && absNormal.x >= absNormal.z ?
+				0 : (absNormal.y >= absNormal.z ? 1 : 2);
+			const unsigned int facing = axis * 2 + (normal[axis] < 0.0f ? 1 : 0);
+			const uint64_t key = (uint64_t)cell.x | ((uint64_t)cell.y << 16) |
+				((uint64_t)cell.z << 32) | ((uint64_t)facing << 48) | (textureSlot << 51);
+
+			const auto [it, isNew] = cellVertices.emplace(key, (unsigned int)welded.size());
+			if (isNew)
+			{
+				welded.push_back({ glm::vec3(0.0f), glm::vec2(0.0f), glm::vec3(0.0f),
+					glm::vec3(0.0f), 0.0f, 0 });
+			}
+
+			WeldedVertex& vertex = welded[it->second];
+			vertex.position += position;
+			vertex.textureCoordinate += textureCoordinate;
+			vertex.normal += glm::length(normal) > 0.0f ? glm::normalize(normal) : normal;
+			vertex.tangent += tangent;
+			vertex.occlusion += occlusion.size() == numVertices ? occlusion[v] : 0.0f;
+			vertex.count++;
+			vertexMap[v] = it->second;
+		}
+
+		const std::span<const unsigned int> indices = mesh.model->GetIndices();
+		for (size_t t = 0; t + 2 < indices.size(); t += 3)
+		{
+			std::array<unsigned int, 3> triangle = { vertexMap[indices[t]],
+				vertexMap[indices[t + 1]], vertexMap[indices[t + 2]] };
+
+			// Triangles smaller than a cell collapse
+			if (triangle[0] == triangle[1] || triangle[1] == triangle[2] ||
+				triangle[2] == triangle[0])
+			{
+				continue;
+			}
+
+			// Start at the smallest index without changing the winding, so duplicates match
+			const size_t first = std::min_element(triangle.begin(), triangle.end()) -
+				triangle.begin();
+			std::rotate(triangle.begin(), triangle.begin() + first, triangle.end());
+			triangles.push_back(triangle);
+		}
+	}
+
+	std::sort(triangles.begin(), triangles.end());
+	triangles.erase(std::unique(triangles.begin(), triangles.end()), triangles.end());
+
+	// Keep only the vertices of triangles which survived, in the order they are first used
+	std::vector<unsigned int> remap(welded.size(), (unsigned int)-1);
+	std::vector<unsigned int> indices;
+	indices.reserve(triangles.size() * 3);
+	unsigned int numVertices = 0;
+	for (const std::array<unsigned int, 3>& triangle : triangles)
+	{
+		for (unsigned int index : triangle)
+		{
+			if (remap[index] == (unsigned int)-1)
+			{
+				remap[index] = numVertices++;
+			}
+			indices.push_back(remap[index]);
+		}
+	}
+
+	std::vector<float> positions(numVertices * 3);
+	std::vector<float> textureCoordinates(numVertices * 2);
+	std::vector<float> normals(numVertices * 3);
+	std::vector<float> tangents(numVertices * 3);
+	std::vector<float> occlusion(numVertices);
+	for (size_t i = 0; i < welded.size(); i++)
+	{
+		if (remap[i] == (unsigned int)-1)
+		{
+			continue;
+		}
+
+		const WeldedVertex& vertex = welded[i];
+		const unsigned int v = remap[i];
+		const float weight = 1.0f / (float)vertex.count;
+
+		glm::vec3 normal = vertex.normal;
+		normal = glm::length(normal) > 0.0f ? glm::normalize(normal) : glm::vec3(0.0f, 1.0f, 0.0f);
+
+		// Keep the tangent perpendicular to the averaged normal
+		glm::vec3 tangent = vertex.tangent - normal * glm::dot(normal, vertex.tangent);
+		if (!(glm::length(tangent) > 0.0f))
+		{
+			tangent = glm::cross(normal, std::abs(normal.y) < 0.99f ?
+				glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f));
+		}
+		tangent = glm::normalize(tangent);
+
+		const glm::vec3 position = vertex.position * weight;
+		const glm::vec2 textureCoordinate = vertex.textureCoordinate * weight;
+		std::memcpy(&positions[v * 3], &position, sizeof(glm::vec3));
+		std::memcpy(&textureCoordinates[v * 2], &textureCoordinate, sizeof(glm::vec2));
+		std::memcpy(&normals[v * 3], &normal, sizeof(glm::vec3));
+		std::memcpy(&tangents[v * 3], &tangent, sizeof(glm::vec3));
+		occlusion[v] = vertex.occlusion * weight;
+	}
+
+	IndexedModel& proxy = cluster.proxy;
+	proxy = IndexedModel();
+	proxy.AllocateElement(3); // Positions
+	proxy.AllocateElement(2); // Texture Coordinates
+	proxy.AllocateElement(3); // Normals
+	proxy.AllocateElement(3); // Tangents
+	proxy.AllocateElement(1); // Ambient occlusion
+	proxy.SetInstancedElementStartIndex(5); // Begin instanced data
+	proxy.AllocateElement(16); // Transform matrix
+
+	proxy.AdoptElement(0, std::move(positions));
+	proxy.AdoptElement(1, std::move(textureCoordinates));
+	proxy.AdoptElement(2, std::move(normals));
+	proxy.AdoptElement(3, std::move(tangents));
+	proxy.AdoptElement(4, std::move(occlusion));
+	proxy.AdoptIndices(std::move(indices));
+}
+
+bool SaveHLOD(const std::string& fileName, const std::vector<HLODCluster>& clusters,
+	unsigned int numMeshes)
+{
+	std::ofstream file(fileName, std::ios::binary);
+	if (!file.is_open())
+	{
+		Log::Error("Could not open HLOD file {} for writing", fileName);
+		return false;
+	}
+
+	const uint32_t header[4] = { HLOD_FILE_MAGIC, HLOD_FILE_VERSION, numMeshes,
+		(uint32_t)clusters.size() };
+	file.write((const char*)header, sizeof(header));
+
+	for (const HLODCluster& cluster : clusters)
+	{
+		const glm::vec3 bounds[2] = { cluster.bounds.GetMinExtents(),
+			cluster.bounds.GetMaxExtents() };
+		const std::span<const unsigned int> indices = cluster.proxy.GetIndices();
+		const uint32_t sizes[6] = { (uint32_t)cluster.members.size(),
+			(uint32_t)(cluster.proxy.GetElement(0).size() / 3), (uint32_t)indices.size(),
+			(uint32_t)cluster.atlasWidth, (uint32_t)cluster.atlasHeight, 0 };
+
+		file.write((const char*)bounds, sizeof(bounds));
+		file.write((const char*)sizes, sizeof(sizes));
+		file.write((const char*)cluster.members.data(),
+			cluster.members.size() * sizeof(unsigned int));
+		for (unsigned int element = 0; element < 5; element++)
+		{
+			const std::span<const float> data = cluster.proxy.GetElement(element);
+			file.write((const char*)data.data(), data.size_bytes());
+		}
+		file.write((const char*)indices.data(), indices.size_bytes());
+		file.write((const char*)cluster.atlas.data(), cluster.atlas.size() * sizeof(int));
+	}
+
+	if (!file.good())
+	{
+		Log::Error("Could not write HLOD file {}", fileName);
+		return false;
+	}
+
+	return true;
+}
+
+bool LoadHLOD(const std::string& fileName, std::vector<HLODCluster>& clusters,
+	unsigned int numMeshes)
+{
+	std::ifstream file(fileName, std::ios::binary);
+	if (!file.is_open())
+	{
+		// Content is drawn without proxies until they are built, so this is not an error
+		return false;
+	}
+
+	uint32_t header[4] = {};
+	file.read((char*)header, sizeof(header));
+	if (!file.good() || header[0] != HLOD_FILE_MAGIC)
+	{
+		Log::Error("{} is not an HLOD file", fileName);
+		return false;
+	}
+
+	if (header[1] != HLOD_FILE_VERSION)
+	{
+		Log::Error("Unsupported HLOD file version {}", header[1]);
+		return false;
+	}
+
+	if (header[2] != numMeshes)
+	{
+		Log::Warning("HLOD file {} was built for {} meshes, not {}; ignoring it", fileName,
+			header[2], numMeshes);
+		return false;
+	}
+
+	// Read everything before appending any cluster, so a bad file adds none of them
+	std::vector<HLODCluster> loaded(header[3]);
+	for (HLODCluster& cluster : loaded)
+	{
+		glm::vec3 bounds[2];
+		uint32_t sizes[6] = {};
+		file.read((char*)bounds, sizeof(bounds));
+		file.read((char*)sizes, sizeof(sizes));
+		if (!file.good() || sizes[0] > numMeshes || sizes[2] % 3 != 0 ||
+			(uint64_t)sizes[3] * sizes[4] > (1ull << 28))
+		{
+			Log::Error("HLOD file {} is corrupt", fileName);
+			return false;
+		}
+
+		const uint32_t numVertices = sizes[1];
+		std::vector<float> elements[5] = { std::vector<float>(numVertices * 3),
+			std::vector<float>(numVertices * 2), std::vector<float>(numVertices * 3),
+			std::vector<float>(numVertices * 3), std::vector<float>(numVertices) };
+		std::vector<unsigned int> indices(sizes[2]);
+
+		cluster.bounds = AABB(bounds[0], bounds[1]);
+		cluster.members.resize(sizes[0]);
+		cluster.atlasWidth = (int)sizes[3];
+		cluster.atlasHeight = (int)sizes[4];
+		cluster.atlas.resize((size_t)sizes[3] * sizes[4]);
+
+		file.read((char*)cluster.members.data(), cluster.members.size() * sizeof(unsigned int));
+		for (std::vector<float>& element : elements)
+		{
+			file.read((char*)element.data(), element.size() * sizeof(float));
+		}
+		file.read((char*)indices.data(), indices.size() * sizeof(unsigned int));
+		file.read((char*)cluster.atlas.data(), cluster.atlas.size() * sizeof(int));
+
+		if (!file.good())
+		{
+			Log::Error("HLOD file {} is truncated", fileName);
+			return false;
+		}
+
+		if (std::any_of(cluster.members.begin(), cluster.members.end(),
+				[numMeshes](unsigned int member) { return member >= numMeshes; }) ||
+			std::any_of(indices.begin(), indices.end(),
+				[numVertices](unsigned int index) { return index >= numVertices; }))
+		{
+			Log::Error("HLOD file {} is corrupt", fileName);
+			return false;
+		}
+
+		cluster.proxy.AllocateElement(3); // Positions
+		cluster.proxy.AllocateElement(2); // Texture Coordinates
+		cluster.proxy.AllocateElement(3); // Normals
+		cluster.proxy.AllocateElement(3); // Tangents
+		cluster.proxy.AllocateElement(1); // Ambient occlusion
+		cluster.proxy.SetInstancedElementStartIndex(5); // Begin instanced data
+		cluster.proxy.AllocateElement(16); // Transform matrix
+		for (unsigned int element = 0; element < 5; element++)
+		{
+			cluster.proxy.AdoptElement(element, std::move(elements[element]));
+		}
+		cluster.proxy.AdoptIndices(std::move(indices));
+	}
+
+	clusters.insert(clusters.end(), std::make_move_iterator(loaded.begin()),
+		std::make_move_iterator(loaded.end()));
+	return true;
+}
+
+bool BuildModelHLOD(const std::string& fileName, const std::string& textureFileName,
+	const HLODBuilder::Settings& settings)
+{
+	std::vector<IndexedModel> models = LoadModels(fileName);
+	if (models.empty())
+	{
+		return false;
+	}
+
+	int width, height, bytesPerPixel;
+	unsigned char* imageData = stbi_load(textureFileName.c_str(), &width, &height,
+		&bytesPerPixel, 4);
+	if (imageData == nullptr)
+	{
+		Log::Error("Texture loading failed for texture: {}", textureFileName);
+		return false;
+	}
+
+	ArrayBitmap texture(width, height);
+	std::memcpy(texture.GetPixelArray(), imageData, (size_t)width * height * 4);
+	stbi_image_free(imageData);
+
+	const double startTime = Timing::GetPreciseTime();
+	const glm::mat4 identity(1.0f);
+
+	JobSystem jobSystem;
+	HLODBuilder builder(&jobSystem);
+	size_t numTriangles = 0;
+	for (const IndexedModel& model : models)
+	{
+		builder.AddMesh(model, texture, identity);
+		numTriangles += model.GetNumIndices() / 3;
+	}
+	builder.Build(settings);
+
+	const double endTime = Timing::GetPreciseTime();
+
+	const std::vector<HLODCluster>& clusters = builder.GetClusters();
+	const std::string hlodFileName = fileName + HLOD_FILE_EXTENSION;
+	if (!SaveHLOD(hlodFileName, clusters, builder.GetNumMeshes()))
+	{
+		return false;
+	}
+
+	size_t numProxyTriangles = 0;
+	for (const HLODCluster& cluster : clusters)
+	{
+		numProxyTriangles += cluster.proxy.GetNumIndices() / 3;
+	}
+
+	std::cout << "Built " << clusters.size() << " HLOD clusters from " << models.size()
+		<< " meshes to " << hlodFileName << std::endl;
+	std::cout << "Triangles: " << numTriangles << " -> " << numProxyTriangles << std::endl;
+	std::cout << "Build: " << (endTime - startTime) * 1000.0 << " ms on "
+		<< jobSystem.GetNumThreads() << " threads" << std::endl;
+
+	return true;
+}
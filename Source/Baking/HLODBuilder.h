@@ -0,0 +1,143 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include "AABB.h"
+#include "Rendering/IndexedModel.h"
+#include "Rendering/ArrayBitmap.h"
+
+#include <GLM/glm.hpp>
+
+#include <string>
+#include <vector>
+
+class JobSystem;
+
+// Appended to the name of a model file to get the name of its hierarchical LOD file
+inline constexpr const char* HLOD_FILE_EXTENSION = ".hlod";
+
+/**
+ * @brief A group of nearby static meshes, and the single simplified mesh standing in for all of
+ *		them from far away.
+ */
+struct HLODCluster
+{
+	// Bounds of every member, in world space
+	AABB bounds;
+
+	// Indices of the meshes in the cluster, in the order they were added to the builder
+	std::vector<unsigned int> members;
+
+	// Merged and simplified mesh, laid out as by LoadModels, with positions in world space
+	IndexedModel proxy;
+
+	// RGBA texture atlas holding the textures of every member, mapped by the proxy
+	int atlasWidth = 0;
+	int atlasHeight = 0;
+	std::vector<int> atlas;
+};
+
+/**
+ * @brief Builds hierarchical LOD proxies for static content, offline.
+ *
+ * Meshes are grouped into clusters by the cell of a uniform grid holding the center of their
+ * bounds. The meshes of a cluster are merged in world space and simplified by vertex clustering:
+ * vertices sharing a simplification cell, texture and facing are welded into their average, and
+ * triangles which collapse are dropped. The textures of a cluster are downscaled and packed into
+ * one atlas, so the proxy of the whole cluster is drawn with a single draw call.
+ *
+ * Texture coordinates are clamped to their texture, so textures which repeat across a mesh are
+ * not reproduced on the proxy.
+ */
+class HLODBuilder
+{
+public:
+	struct Settings
+	{
+		// Size of the grid cells meshes are clustered by
+		float clusterSize = 50.0f;
+		// Size of the grid cells vertices are welded by. Details smaller than this are lost.
+		float simplifyCellSize = 1.0f;
+		// Largest width or height of a texture in the atlas. Larger textures are downscaled.
+		int maxTextureSize = 128;
+	};
+
+	/**
+	 * @param jobSystem Job system to build clusters on, or nullptr to do all the work on the
+	 *		calling thread.
+	 */
+	explicit HLODBuilder(JobSystem* jobSystem = nullptr);
+	virtual ~HLODBuilder() {}
+
+	/**
+	 * @brief Adds a static mesh. The model and texture must outlive Build.
+	 * @param model Model laid out as by LoadModels.
+	 * @param texture RGBA texture of the model.
+	 * @param transform Transform of the model in the world.
+	 */
+	void AddMesh(const IndexedModel& model, const ArrayBitmap& texture,
+		const glm::mat4& transform);
+
+	/** @brief Clusters every mesh added so far, and builds the proxy of every cluster. */
+	void Build(const Settings& settings);
+
+	inline unsigned int GetNumMeshes() const { return (unsigned int)meshes.size(); }
+	inline std::vector<HLODCluster>& GetClusters() { return clusters; }
+	inline const std::vector<HLODCluster>& GetClusters() const { return clusters; }
+
+private:
+	// Disallow copy and assign
+	HLODBuilder(const HLODBuilder& other) = delete;
+	void operator=(const HLODBuilder& other) = delete;
+
+	struct SourceMesh
+	{
+		const IndexedModel* model;
+		const ArrayBitmap* texture;
+		glm::mat4 transform;
+		AABB bounds;
+	};
+
+	/** @brief Packs the textures of a cluster's members into its atlas. */
+	void BuildAtlas(HLODCluster& cluster, const Settings& settings,
+		std::vector<glm::vec4>& textureRegions) const;
+
+	/** @brief Merges and simplifies the meshes of a cluster into its proxy. */
+	void BuildProxy(HLODCluster& cluster, const Settings& settings,
+		const std::vector<glm::vec4>& textureRegions) const;
+
+	JobSystem* jobSystem;
+	std::vector<SourceMesh> meshes;
+	std::vector<HLODCluster> clusters;
+};
+
+/**
+ * @brief Writes clusters to a file.
+ * @param fileName Path of the file to write.
+ * @param clusters Clusters to write.
+ * @param numMeshes Number of meshes the clusters were built from.
+ * @return Whether the file was written.
+ */
+bool SaveHLOD(const std::string& fileName, const std::vector<HLODCluster>& clusters,
+	unsigned int numMeshes);
+
+/**
+ * @brief Reads clusters written by SaveHLOD.
+ * @param fileName Path of the file to read.
+ * @param clusters List to append the clusters to. Nothing is appended if the file does not match.
+ * @param numMeshes Number of meshes the clusters must have been built from.
+ * @return Whether the clusters were read.
+ */
+bool LoadHLOD(const std::string& fileName, std::vector<HLODCluster>& clusters,
+	unsigned int numMeshes);
+
+/**
+ * @brief Builds the hierarchical LOD of every mesh in a model file, all sharing a texture, and
+ * saves it next to the model file. Prints the reduction in draws and triangles.
+ * @param fileName Path of the model file.
+ * @param textureFileName Path of the texture of the model.
+ * @param settings Settings of the build.
+ * @return Whether the clusters were built and saved.
+ */
+bool BuildModelHLOD(const std::string& fileName, const std::string& textureFileName,
+	const HLODBuilder::Settings& settings = HLODBuilder::Settings());
@@ -0,0 +1,273 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#include "OcclusionBaker.h"
+#include "Jobs/JobSystem.h"
+#include "Rendering/Mesh.h"
+#include "Timing.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+
+// Vertices baked per job
+static const unsigned int VERTICES_PER_BATCH = 64;
+// "GLAO", little endian
+static const uint32_t OCCLUSION_FILE_MAGIC = 0x4F414C47;
+static const uint32_t OCCLUSION_FILE_VERSION = 1;
+
+/** @return The bits of an integer in reverse order, as a fraction in [0, 1). */
+static inline float RadicalInverse(uint32_t bits)
+{
+	bits = (bits << 16) | (bits >> 16);
+	bits = ((bits & 0x55555555) << 1) | ((bits & 0xAAAAAAAA) >> 1);
+	bits = ((bits & 0x33333333) << 2) | ((bits & 0xCCCCCCCC) >> 2);
+	bits = ((bits & 0x0F0F0F0F) << 4) | ((bits & 0xF0F0F0F0) >> 4);
+	bits = ((bits & 0x00FF00FF) << 8) | ((bits & 0xFF00FF00) >> 8);
+	return (float)bits * 2.3283064365386963e-10f;
+}
+
+/** @return A well mixed hash of an integer. */
+static inline uint32_t Hash(uint32_t value)
+{
+	value ^= value >> 16;
+	value *= 0x7FEB352D;
+	value ^= value >> 15;
+	value *= 0x846CA68B;
+	value ^= value >> 16;
+	return value;
+}
+
+/** @brief Builds an orthonormal basis around a unit vector, without branching on its axis. */
+static inline void GetBasis(const glm::vec3& normal, glm::vec3& tangent, glm::vec3& bitangent)
+{
+	const float sign = std::copysign(1.0f, normal.z);
+	const float a = -1.0f / (sign + normal.z);
+	const float b = normal.x * normal.y * a;
+	tangent = glm::vec3(1.0f + sign * normal.x * normal.x * a, sign * b, -sign * normal.x);
+	bitangent = glm::vec3(b, sign + normal.y * normal.y * a, -normal.y);
+}
+
+OcclusionBaker::OcclusionBaker(JobSystem* jobSystem) : jobSystem(jobSystem) {}
+
+void OcclusionBaker::AddModel(const IndexedModel& model, const glm::mat4& transform)
+{
+	scene.AddTriangles(model.GetElement(0), model.GetIndices(), transform);
+}
+
+void OcclusionBaker::Build()
+{
+	scene.Build();
+}
+
+void OcclusionBaker::Bake(IndexedModel& model, const glm::mat4& transform,
+	const Settings& settings)
+{
+	const std::span<const float> positions = model.GetElement(0);
+	const std::span<const float> normals = model.GetElement(2);
+	const unsigned int numVertices = (unsigned int)(positions.size() / 3);
+	const glm::mat3 normalTransform = glm::transpose(glm::inverse(glm::mat3(transform)));
+	const unsigned int numRays = std::max(settings.numRays, 1u);
+
+	std::vector<float> occlusion(numVertices, 0.0f);
+
+	const auto bakeVertices = [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int i = begin; i < end; i++)
+		{
+			const glm::vec3 localNormal(normals[i * 3], normals[i * 3 + 1], normals[i * 3 + 2]);
+			const float normalLength = glm::length(normalTransform * localNormal);
+			if (!(normalLength > 0.0f))
+			{
+				continue;
+			}
+
+			const glm::vec3 normal = normalTransform * localNormal / normalLength;
+			const glm::vec3 position = glm::vec3(transform *
+				glm::vec4(positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2], 1.0f));
+			const glm::vec3 origin = position + normal * settings.bias;
+
+			glm::vec3 tangent;
+			glm::vec3 bitangent;
+			GetBasis(normal, tangent, bitangent);
+
+			// Rotate the sequence differently at every vertex, so neighbours do not band together
+			const uint32_t hash = Hash(i);
+			const float rotationU = (float)(hash & 0xFFFF) / 65536.0f;
+			const float rotationV = (float)(hash >> 16) / 65536.0f;
+
+			unsigned int numHits = 0;
+			for (unsigned int j = 0; j < numRays; j++)
+			{
+				float u = ((float)j + 0.5f) / (float)numRays + rotationU;
+				float v = RadicalInverse(j) + rotationV;
+				u -= std::floor(u);
+				v -= std::floor(v);
+
+				// Cosine weighted, so rays near the horizon count for less
+				const float radius = std::sqrt(u);
+				const float angle = 6.28318530718f * v;
+				const glm::vec3 direction = tangent * (radius * std::cos(angle)) +
+					bitangent * (radius * std::sin(angle)) + normal * std::sqrt(1.0f - u);
+
+				if (scene.IsOccluded(origin, direction, settings.maxDistance))
+				{
+					numHits++;
+				}
+			}
+
+			occlusion[i] = (float)numHits / (float)numRays;
+		}
+	};
+
+	if (jobSystem)
+	{
+		jobSystem->ParallelFor(numVertices, VERTICES_PER_BATCH, bakeVertices);
+	}
+	else
+	{
+		bakeVertices(0, numVertices);
+	}
+
+	model.AdoptElement(4, std::move(occlusion));
+}
+
+bool SaveOcclusion(const std::string& fileName, const std::vector<IndexedModel>& models)
+{
+	std::ofstream file(fileName, std::ios::binary);
+	if (!file.is_open())
+	{
+		Log::Error("Could not open occlusion file {} for writing", fileName);
+		return false;
+	}
+
+	const uint32_t header[3] = { OCCLUSION_FILE_MAGIC, OCCLUSION_FILE_VERSION,
+		(uint32_t)models.size() };
+	file.write((const char*)header, sizeof(header));
+
+	for (const IndexedModel& model : models)
+	{
+		const std::span<const float> occlusion = model.GetElement(4);
+		const uint32_t numVertices = (uint32_t)occlusion.size();
+		file.write((const char*)&numVertices, sizeof(numVertices));
+		file.write((const char*)occlusion.data(), occlusion.size_bytes());
+	}
+
+	if (!file.good())
+	{
+		Log::Error("Could not write occlusion file {}", fileName);
+		return false;
+	}
+
+	return true;
+}
+
+bool LoadOcclusion(const std::string& fileName, std::vector<IndexedModel>& models)
+{
+	std::ifstream file(fileName, std::ios::binary);
+	if (!file.is_open())
+	{
+		// Models without baked occlusion are common, so this is not an error
+		return false;
+	}
+
+	uint32_t header[3] = {};
+	file.read((char*)header, sizeof(header));
+	if (!file.good() || header[0] != OCCLUSION_FILE_MAGIC)
+	{
+		Log::Error("{} is not an occlusion file", fileName);
+		return false;
+	}
+
+	if (header[1] != OCCLUSION_FILE_VERSION)
+	{
+		Log::Error("Unsupported occlusion file version {}", header[1]);
+		return false;
+	}
+
+	if (header[2] != models.size())
+	{
+		Log::Warning("Occlusion file {} was baked for {} meshes, not {}; ignoring it", fileName,
+			header[2], models.size());
+		return false;
+	}
+
+	// Read everything before changing any model, so a bad file leaves them all unbaked
+	std::vector<std::vector<float>> occlusion(models.size());
+	for (size_t i = 0; i < models.size(); i++)
+	{
+		uint32_t numVertices = 0;
+		file.read((char*)&numVertices, sizeof(numVertices));
+		if (!file.good() || numVertices != models[i].GetElement(0).size() / 3)
+		{
+			Log::Warning("Occlusion file {} does not match mesh {}; ignoring it", fileName, i);
+			return false;
+		}
+
+		occlusion[i].resize(numVertices);
+		file.read((char*)occlusion[i].data(), (std::streamsize)numVertices * sizeof(float));
+		if (!file.good())
+		{
+			Log::Error("Occlusion file {} is truncated", fileName);
+			return false;
+		}
+	}
+
+	for (size_t i = 0; i < models.size(); i++)
+	{
+		models[i].AdoptElement(4, std::move(occlusion[i]));
+	}
+
+	return true;
+}
+
+bool BakeModelOcclusion(const std::string& fileName, const OcclusionBaker::Settings& settings)
+{
+	std::vector<IndexedModel> models = LoadModels(fileName);
+	if (models.empty())
+	{
+		return false;
+	}
+
+	const double startTime = Timing::GetPreciseTime();
+	const glm::mat4 identity(1.0f);
+
+	JobSystem jobSystem;
+	OcclusionBaker baker(&jobSystem);
+	for (const IndexedModel& model : models)
+	{
+		baker.AddModel(model, identity);
+	}
+	baker.Build();
+
+	const double buildTime = Timing::GetPreciseTime();
+
+	size_t numVertices = 0;
+	for (IndexedModel& model : models)
+	{
+		baker.Bake(model, identity, settings);
+		numVertices += model.GetElement(0).size() / 3;
+	}
+
+	const double endTime = Timing::GetPreciseTime();
+
+	const std::string occlusionFileName = fileName + OCCLUSION_FILE_EXTENSION;
+	if (!SaveOcclusion(occlusionFileName, models))
+	{
+		return false;
+	}
+
+	std::cout << "Baked occlusion of " << numVertices << " vertices with " << settings.numRays
+		<< " rays each to " << occlusionFileName << std::endl;
+	std::cout << "BVH build: " << (buildTime - startTime) * 1000.0 << " ms ("
+		<< baker.GetScene().GetNumTriangles() << " triangles, "
+		<< baker.GetScene().GetNumNodes() << " nodes)" << std::endl;
+	std::cout << "Bake: " << (endTime - buildTime) * 1000.0 << " ms ("
+		<< (double)numVertices * settings.numRays / std::max(endTime - buildTime, 1e-9) / 1e6
+		<< " million rays per second on " << jobSystem.GetNumThreads() << " threads)"
+		<< std::endl;
+
+	return true;
+}
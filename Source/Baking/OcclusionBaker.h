@@ -0,0 +1,102 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include "TriangleBVH.h"
+#include "Rendering/IndexedModel.h"
+
+#include <GLM/glm.hpp>
+
+#include <string>
+#include <vector>
+
+class JobSystem;
+
+// Appended to the name of a model file to get the name of its baked occlusion file
+inline constexpr const char* OCCLUSION_FILE_EXTENSION = ".occlusion";
+
+/**
+ * @brief Bakes per vertex ambient occlusion for static models, by tracing rays from every vertex
+ * against a scene of occluding triangles.
+ *
+ * Occlusion is written to element 4 of models laid out as by LoadModels, as the fraction of the
+ * hemisphere above the vertex which is blocked, so 0 is fully lit. Rays are cosine weighted and
+ * follow a Hammersley sequence, rotated by a hash of the vertex index, so bakes are noise free
+ * across a surface and repeatable.
+ */
+class OcclusionBaker
+{
+public:
+	struct Settings
+	{
+		// Rays traced from every vertex
+		unsigned int numRays = 128;
+		// Occluders at this distance or further do not darken a vertex
+		float maxDistance = 1.0f;
+		// Distance rays start above the surface, so they do not hit the surface itself
+		float bias = 0.001f;
+	};
+
+	/**
+	 * @param jobSystem Job system to spread vertices over, or nullptr to do all the work on the
+	 *		calling thread.
+	 */
+	explicit OcclusionBaker(JobSystem* jobSystem = nullptr);
+	virtual ~OcclusionBaker() {}
+
+	/**
+	 * @brief Adds a model's triangles to the occluding scene. Build must be called before baking.
+	 * @param model Model with positions in element 0.
+	 * @param transform Transform of the model in the scene.
+	 */
+	void AddModel(const IndexedModel& model, const glm::mat4& transform);
+
+	/** @brief Builds the scene from every model added so far. */
+	void Build();
+
+	/**
+	 * @brief Bakes the occlusion of a model's vertices. The model is usually part of the scene.
+	 * @param model Model laid out as by LoadModels. Element 4 is replaced.
+	 * @param transform Transform of the model in the scene.
+	 * @param settings Settings of the bake.
+	 */
+	void Bake(IndexedModel& model, const glm::mat4& transform, const Settings& settings);
+
+	inline const TriangleBVH& GetScene() const { return scene; }
+
+private:
+	// Disallow copy and assign
+	OcclusionBaker(const OcclusionBaker& other) = delete;
+	void operator=(const OcclusionBaker& other) = delete;
+
+	JobSystem* jobSystem;
+	TriangleBVH scene;
+};
+
+/**
+ * @brief Writes the baked occlusion (element 4) of every model to a file.
+ * @param fileName Path of the file to write.
+ * @param models Models in the order they were loaded.
+ * @return Whether the file was written.
+ */
+bool SaveOcclusion(const std::string& fileName, const std::vector<IndexedModel>& models);
+
+/**
+ * @brief Reads baked occlusion from a file into element 4 of every model. Nothing is changed if
+ *		the file does not match the models.
+ * @param fileName Path of the file written by SaveOcclusion.
+ * @param models Models in the order they were loaded when the file was written.
+ * @return Whether occlusion was read.
+ */
+bool LoadOcclusion(const std::string& fileName, std::vector<IndexedModel>& models);
+
+/**
+ * @brief Bakes the occlusion of every mesh in a model file against each other, and saves it next
+ * to the model file, where LoadModels finds it. Prints the time taken. No rendering is done, so
+ * this can run without a window.
+ * @param fileName Path of the model file.
+ * @param settings Settings of the bake.
+ * @return Whether the occlusion was baked and saved.
+ */
+bool BakeModelOcclusion(const std::string& fileName,
+	const OcclusionBaker::Settings& settings = OcclusionBaker::Settings());
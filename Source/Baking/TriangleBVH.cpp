@@ -0,0 +1,481 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#include "TriangleBVH.h"
+#include "SIMD.h"
+
+#include <algorithm>
+#include <cfloat>
+
+// Most triangles stored in a leaf; one block
+static const unsigned int MAX_LEAF_TRIANGLES = 4;
+// Number of bins triangle centroids are sorted into when searching for a split
+static const unsigned int NUM_BINS = 12;
+// Deepest a traversal can go; far more than a balanced tree of 4 billion triangles needs
+static const unsigned int MAX_STACK_SIZE = 128;
+
+/** @return Half the surface area of a box, which is all the surface area heuristic needs. */
+static inline float GetHalfArea(const glm::vec3& min, const glm::vec3& max)
+{
+	const glm::vec3 extent = glm::max(max - min, glm::vec3(0.0f));
+	return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+}
+
+void TriangleBVH::AddTriangles(std::span<const float> positions,
+	std::span<const unsigned int> indices, const glm::mat4& transform)
+{
+	const size_t numVertices = positions.size() / 3;
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		for (unsigned int j = 0; j < 3; j++)
+		{
+			const unsigned int index = indices[i + j];
+			const glm::vec3 position = index < numVertices ?
+				glm::vec3(positions[index * 3], positions[index * 3 + 1], positions[index * 3 + 2]) :
+				glm::vec3(0.0f);
+			vertices.push_back(glm::vec3(transform * glm::vec4(position, 1.0f)));
+		}
+	}
+}
+
+void TriangleBVH::Build()
+{
+	nodes.clear();
+	blocks.clear();
+
+	const unsigned int numTriangles = GetNumTriangles();
+	buildTriangles.resize(numTriangles);
+	for (unsigned int i = 0; i < numTriangles; i++)
+	{
+		const glm::vec3& a = vertices[i * 3];
+		const glm::vec3& b = vertices[i * 3 + 1];
+		const glm::vec3& c = vertices[i * 3 + 2];
+
+		BuildTriangle& triangle = buildTriangles[i];
+		triangle.min = glm::min(a, glm::min(b, c));
+		triangle.max = glm::max(a, glm::max(b, c));
+		triangle.centroid = (triangle.min + triangle.max) * 0.5f;
+		triangle.index = i;
+	}
+
+	if (numTriangles > 0)
+	{
+		BuildNode(0, numTriangles);
+	}
+
+	// Only needed while building
+	buildTriangles.clear();
+	buildTriangles.shrink_to_fit();
+}
+
+unsigned int TriangleBVH::Split(unsigned int begin, unsigned int end)
+{
+	const unsigned int count = end - begin;
+	if (count <= MAX_LEAF_TRIANGLES)
+	{
+		return begin;
+	}
+
+	glm::vec3 centroidMin(FLT_MAX);
+	glm::vec3 centroidMax(-FLT_MAX);
+	for (unsigned int i = begin; i < end; i++)
+	{
+		centroidMin = glm::min(centroidMin, buildTriangles[i].centroid);
+		centroidMax = glm::max(centroidMax, buildTriangles[i].centroid);
+	}
+
+	const glm::vec3 extent = centroidMax - centroidMin;
+	const unsigned int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) :
+		(extent.y > extent.z ? 1 : 2);
+
+	unsigned int middle = begin;
+	if (extent[axis] > 0.0f)
+	{
+		// Sort the centroids into bins along the longest axis
+		unsigned int binCounts[NUM_BINS] = {};
+		glm::vec3 binMin[NUM_BINS];
+		glm::vec3 binMax[NUM_BINS];
+		std::fill(binMin, binMin + NUM_BINS, glm::vec3(FLT_MAX));
+		std::fill(binMax, binMax + NUM_BINS, glm::vec3(-FLT_MAX));
+
+		const float binScale = NUM_BINS / extent[axis];
+		const auto getBin = [&](const BuildTriangle& triangle)
+		{
+			const unsigned int bin = (unsigned int)((triangle.centroid[axis] - centroidMin[axis]) *
+				binScale);
+			return std::min(bin, NUM_BINS - 1);
+		};
+
+		for (unsigned int i = begin; i < end; i++)
+		{
+			const unsigned int bin = getBin(buildTriangles[i]);
+			binCounts[bin]++;
+			binMin[bin] = glm::min(binMin[bin], buildTriangles[i].min);
+			binMax[bin] = glm::max(binMax[bin], buildTriangles[i].max);
+		}
+
+		// Cost of the left side of each split, sweeping from the left
+		float leftCosts[NUM_BINS - 1];
+		glm::vec3 sweepMin(FLT_MAX);
+		glm::vec3 sweepMax(-FLT_MAX);
+		unsigned int sweepCount = 0;
+		for (unsigned int i = 0; i + 1 < NUM_BINS; i++)
+		{
+			sweepMin = glm::min(sweepMin, binMin[i]);
+			sweepMax = glm::max(sweepMax, binMax[i]);
+			sweepCount += binCounts[i];
+			leftCosts[i] = sweepCount > 0 ? GetHalfArea(sweepMin, sweepMax) * sweepCount : 0.0f;
+		}
+
+		// Add the cost of the right side, sweeping from the right, and pick the cheapest split
+		float bestCost = FLT_MAX;
+		unsigned int bestSplit = 0;
+		sweepMin = glm::vec3(FLT_MAX);
+		sweepMax = glm::vec3(-FLT_MAX);
+		sweepCount = 0;
+		for (unsigned int i = NUM_BINS - 1; i > 0; i--)
+		{
+			sweepMin = glm::min(sweepMin, binMin[i]);
+			sweepMax = glm::max(sweepMax, binMax[i]);
+			sweepCount += binCounts[i];
+			const float cost = leftCosts[i - 1] +
+				(sweepCount > 0 ? GetHalfArea(sweepMin, sweepMax) * sweepCount : 0.0f);
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestSplit = i;
+			}
+		}
+
+		middle = (unsigned int)(std::partition(buildTriangles.begin() + begin,
+			buildTriangles.begin() + end, [&](const BuildTriangle& triangle)
+			{
+				return getBin(triangle) < bestSplit;
+			}) - buildTriangles.begin());
+	}
+
+	// Fall back to splitting by count, if all centroids are equal or ended up in one bin
+	if (middle == begin || middle == end)
+	{
+		middle = begin + count / 2;
+		std::nth_element(buildTriangles.begin() + begin, buildTriangles.begin() + middle,
+			buildTriangles.begin() + end, [axis](const BuildTriangle& a, const BuildTriangle& b)
+			{
+				return a.centroid[axis] < b.centroid[axis];
+			});
+	}
+
+	return middle;
+}
+
+int TriangleBVH::BuildNode(unsigned int begin, unsigned int end)
+{
+	// Split in two, then split each half in two again, for up to 4 children
+	unsigned int ranges[4][2];
+	unsigned int numRanges = 0;
+
+	const unsigned int middle = Split(begin, end);
+	const unsigned int halves[2][2] = { { begin, middle }, { middle, end } };
+	for (unsigned int i = 0; i < 2; i++)
+	{
+		const unsigned int halfBegin = halves[i][0];
+		const unsigned int halfEnd = halves[i][1];
+		if (halfBegin == halfEnd)
+		{
+			continue;
+		}
+
+		const unsigned int quarter = Split(halfBegin, halfEnd);
+		if (quarter != halfBegin)
+		{
+			ranges[numRanges][0] = halfBegin;
+			ranges[numRanges++][1] = quarter;
+			ranges[numRanges][0] = quarter;
+			ranges[numRanges++][1] = halfEnd;
+		}
+		else
+		{
+			ranges[numRanges][0] = halfBegin;
+			ranges[numRanges++][1] = halfEnd;
+		}
+	}
+
+	const int nodeIndex = (int)nodes.size();
+	nodes.emplace_back();
+
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		glm::vec3 min(FLT_MAX);
+		glm::vec3 max(-FLT_MAX);
+		// Unused children are empty leaves, so a ray which grazes their bounds does nothing
+		int child = -1;
+		unsigned int numBlocks = 0;
+
+		if (i < numRanges)
+		{
+			const unsigned int rangeBegin = ranges[i][0];
+			const unsigned int rangeEnd = ranges[i][1];
+			for (unsigned int j = rangeBegin; j < rangeEnd; j++)
+			{
+				min = glm::min(min, buildTriangles[j].min);
+				max = glm::max(max, buildTriangles[j].max);
+			}
+
+			if (rangeEnd - rangeBegin <= MAX_LEAF_TRIANGLES)
+			{
+				child = -1 - (int)BuildLeaf(rangeBegin, rangeEnd);
+				numBlocks = (rangeEnd - rangeBegin + 3) / 4;
+			}
+			else
+			{
+				child = BuildNode(rangeBegin, rangeEnd);
+			}
+		}
+
+		// Building children may have reallocated the nodes
+		Node& node = nodes[nodeIndex];
+		node.minX[i] = min.x;
+		node.minY[i] = min.y;
+		node.minZ[i] = min.z;
+		node.maxX[i] = max.x;
+		node.maxY[i] = max.y;
+		node.maxZ[i] = max.z;
+		node.children[i] = child;
+		node.numBlocks[i] = numBlocks;
+	}
+
+	return nodeIndex;
+}
+
+unsigned int TriangleBVH::BuildLeaf(unsigned int begin, unsigned int end)
+{
+	const unsigned int firstBlock = (unsigned int)blocks.size();
+
+	for (unsigned int i = begin; i < end; i += 4)
+	{
+		// Unused triangles are degenerate, so they are never hit
+		TriangleBlock block = {};
+		for (unsigned int j = 0; j < 4 && i + j < end; j++)
+		{
+			const unsigned int triangle = buildTriangles[i + j].index;
+			const glm::vec3& a = vertices[triangle * 3];
+			const glm::vec3 edge1 = vertices[triangle * 3 + 1] - a;
+			const glm::vec3 edge2 = vertices[triangle * 3 + 2] - a;
+			for (unsigned int k = 0; k < 3; k++)
+			{
+				block.vertex[k][j] = a[k];
+				block.edge1[k][j] = edge1[k];
+				block.edge2[k][j] = edge2[k];
+			}
+		}
+
+		blocks.push_back(block);
+	}
+
+	return firstBlock;
+}
+
+bool TriangleBVH::IsOccluded(const glm::vec3& origin, const glm::vec3& direction,
+	float maxDistance) const
+{
+	return Trace<true>(origin, direction, maxDistance);
+}
+
+bool TriangleBVH::Intersect(const glm::vec3& origin, const glm::vec3& direction,
+	float& distance) const
+{
+	return Trace<false>(origin, direction, distance);
+}
+
+template<bool IsAnyHit>
+bool TriangleBVH::Trace(const glm::vec3& origin, const glm::vec3& direction,
+	float& distance) const
+{
+	if (nodes.empty())
+	{
+		return false;
+	}
+
+	const glm::vec3 inverseDirection = 1.0f / direction;
+	bool isHit = false;
+
+	unsigned int stack[MAX_STACK_SIZE];
+	unsigned int stackSize = 0;
+	stack[stackSize++] = 0;
+
+#if defined(GLENGINE_SSE2)
+	const __m128 originX = _mm_set1_ps(origin.x);
+	const __m128 originY = _mm_set1_ps(origin.y);
+	const __m128 originZ = _mm_set1_ps(origin.z);
+	const __m128 directionX = _mm_set1_ps(direction.x);
+	const __m128 directionY = _mm_set1_ps(direction.y);
+	const __m128 directionZ = _mm_set1_ps(direction.z);
+	const __m128 inverseX = _mm_set1_ps(inverseDirection.x);
+	const __m128 inverseY = _mm_set1_ps(inverseDirection.y);
+	const __m128 inverseZ = _mm_set1_ps(inverseDirection.z);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 epsilon = _mm_set1_ps(1e-12f);
+	const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+#endif
+
+	while (stackSize > 0)
+	{
+		const Node& node = nodes[stack[--stackSize]];
+
+		// Slab test against all 4 children
+#if defined(GLENGINE_SSE2)
+		const __m128 maxDistance = _mm_set1_ps(distance);
+		const __m128 x0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.minX), originX), inverseX);
+		const __m128 x1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.maxX), originX), inverseX);
+		const __m128 y0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.minY), originY), inverseY);
+		const __m128 y1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.maxY), originY), inverseY);
+		const __m128 z0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.minZ), originZ), inverseZ);
+		const __m128 z1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.maxZ), originZ), inverseZ);
+
+		const __m128 entryDistance = _mm_max_ps(
+			_mm_max_ps(_mm_min_ps(x0, x1), _mm_min_ps(y0, y1)),
+			_mm_max_ps(_mm_min_ps(z0, z1), zero));
+		const __m128 exitDistance = _mm_min_ps(
+			_mm_min_ps(_mm_max_ps(x0, x1), _mm_max_ps(y0, y1)),
+			_mm_min_ps(_mm_max_ps(z0, z1), maxDistance));
+		const int hitMask = _mm_movemask_ps(_mm_cmple_ps(entryDistance, exitDistance));
+#else
+		int hitMask = 0;
+		for (unsigned int i = 0; i < 4; i++)
+		{
+			const glm::vec3 t0 = (glm::vec3(node.minX[i], node.minY[i], node.minZ[i]) - origin) *
+				inverseDirection;
+			const glm::vec3 t1 = (glm::vec3(node.maxX[i], node.maxY[i], node.maxZ[i]) - origin) *
+				inverseDirection;
+			const glm::vec3 tMin = glm::min(t0, t1);
+			const glm::vec3 tMax = glm::max(t0, t1);
+			const float entryDistance = std::max(std::max(tMin.x, tMin.y),
+				std::max(tMin.z, 0.0f));
+			const float exitDistance = std::min(std::min(tMax.x, tMax.y),
+				std::min(tMax.z, distance));
+			hitMask |= (entryDistance <= exitDistance ? 1 : 0) << i;
+		}
+#endif
+
+		for (unsigned int i = 0; i < 4; i++)
+		{
+			if ((hitMask & (1 << i)) == 0)
+			{
+				continue;
+			}
+
+			const int child = node.children[i];
+			if (child >= 0)
+			{
+				if (stackSize < MAX_STACK_SIZE)
+				{
+					stack[stackSize++] = (unsigned int)child;
+				}
+				continue;
+			}
+
+			const unsigned int firstBlock = (unsigned int)(-1 - child);
+			for (unsigned int j = firstBlock; j < firstBlock + node.numBlocks[i]; j++)
+			{
+				const TriangleBlock& block = blocks[j];
+
+				// Moller-Trumbore against 4 triangles at once
+#if defined(GLENGINE_SSE2)
+				const __m128 edge1X = _mm_loadu_ps(block.edge1[0]);
+				const __m128 edge1Y = _mm_loadu_ps(block.edge1[1]);
+				const __m128 edge1Z = _mm_loadu_ps(block.edge1[2]);
+				const __m128 edge2X = _mm_loadu_ps(block.edge2[0]);
+				const __m128 edge2Y = _mm_loadu_ps(block.edge2[1]);
+				const __m128 edge2Z = _mm_loadu_ps(block.edge2[2]);
+
+				const __m128 pX = _mm_sub_ps(_mm_mul_ps(directionY, edge2Z),
+					_mm_mul_ps(directionZ, edge2Y));
+				const __m128 pY = _mm_sub_ps(_mm_mul_ps(directionZ, edge2X),
+					_mm_mul_ps(directionX, edge2Z));
+				const __m128 pZ = _mm_sub_ps(_mm_mul_ps(directionX, edge2Y),
+					_mm_mul_ps(directionY, edge2X));
+				const __m128 determinant = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edge1X, pX),
+					_mm_mul_ps(edge1Y, pY)), _mm_mul_ps(edge1Z, pZ));
+				const __m128 inverseDeterminant = _mm_div_ps(one, determinant);
+
+				const __m128 tX = _mm_sub_ps(originX, _mm_loadu_ps(block.vertex[0]));
+				const __m128 tY = _mm_sub_ps(originY, _mm_loadu_ps(block.vertex[1]));
+				const __m128 tZ = _mm_sub_ps(originZ, _mm_loadu_ps(block.vertex[2]));
+				const __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tX, pX),
+					_mm_mul_ps(tY, pY)), _mm_mul_ps(tZ, pZ)), inverseDeterminant);
+
+				const __m128 qX = _mm_sub_ps(_mm_mul_ps(tY, edge1Z), _mm_mul_ps(tZ, edge1Y));
+				const __m128 qY = _mm_sub_ps(_mm_mul_ps(tZ, edge1X), _mm_mul_ps(tX, edge1Z));
+				const __m128 qZ = _mm_sub_ps(_mm_mul_ps(tX, edge1Y), _mm_mul_ps(tY, edge1X));
+				const __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(directionX, qX),
+					_mm_mul_ps(directionY, qY)), _mm_mul_ps(directionZ, qZ)), inverseDeterminant);
+				const __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(edge2X, qX),
+					_mm_mul_ps(edge2Y, qY)), _mm_mul_ps(edge2Z, qZ)), inverseDeterminant);
+
+				__m128 isInside = _mm_cmpgt_ps(_mm_and_ps(determinant, absMask), epsilon);
+				isInside = _mm_and_ps(isInside, _mm_cmpge_ps(u, zero));
+				isInside = _mm_and_ps(isInside, _mm_cmpge_ps(v, zero));
+				isInside = _mm_and_ps(isInside, _mm_cmple_ps(_mm_add_ps(u, v), one));
+				isInside = _mm_and_ps(isInside, _mm_cmpgt_ps(t, zero));
+				isInside = _mm_and_ps(isInside, _mm_cmplt_ps(t, _mm_set1_ps(distance)));
+
+				const int triangleMask = _mm_movemask_ps(isInside);
+				if (triangleMask == 0)
+				{
+					continue;
+				}
+
+				if (IsAnyHit)
+				{
+					return true;
+				}
+
+				float distances[4];
+				_mm_storeu_ps(distances, t);
+				for (unsigned int k = 0; k < 4; k++)
+				{
+					if ((triangleMask & (1 << k)) != 0 && distances[k] < distance)
+					{
+						distance = distances[k];
+					}
+				}
+				isHit = true;
+#else
+				for (unsigned int k = 0; k < 4; k++)
+				{
+					const glm::vec3 edge1(block.edge1[0][k], block.edge1[1][k], block.edge1[2][k]);
+					const glm::vec3 edge2(block.edge2[0][k], block.edge2[1][k], block.edge2[2][k]);
+					const glm::vec3 p = glm::cross(direction, edge2);
+					const float determinant = glm::dot(edge1, p);
+					if (std::abs(determinant) <= 1e-12f)
+					{
+						continue;
+					}
+
+					const float inverseDeterminant = 1.0f / determinant;
+					const glm::vec3 toOrigin = origin -
+						glm::vec3(block.vertex[0][k], block.vertex[1][k], block.vertex[2][k]);
+					const float u = glm::dot(toOrigin, p) * inverseDeterminant;
+					const glm::vec3 q = glm::cross(toOrigin, edge1);
+					const float v = glm::dot(direction, q) * inverseDeterminant;
+					const float t = glm::dot(edge2, q) * inverseDeterminant;
+					if (u < 0.0f || v < 0.0f || u + v > 1.0f || t <= 0.0f || t >= distance)
+					{
+						continue;
+					}
+
+					if (IsAnyHit)
+					{
+						return true;
+					}
+
+					distance = t;
+					isHit = true;
+				}
+#endif
+			}
+		}
+	}
+
+	return isHit;
+}
@@ -0,0 +1,116 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include <GLM/glm.hpp>
+
+#include <span>
+#include <vector>
+
+/**
+ * @brief Bounding volume hierarchy over static triangles, for tracing rays on the CPU, such as
+ * when baking lighting.
+ *
+ * Every node has 4 children whose bounds are stored as structure of arrays, so a ray is tested
+ * against all of them at once with SIMD. Leaf triangles are likewise stored in blocks of 4 with
+ * precomputed edges, and intersected 4 at a time. The tree is built top down, splitting with the
+ * surface area heuristic over binned triangle centroids.
+ *
+ * Tracing is read only, so any number of threads may trace rays at once once the tree is built.
+ */
+class TriangleBVH
+{
+public:
+	TriangleBVH() {}
+	virtual ~TriangleBVH() {}
+
+	/**
+	 * @brief Adds triangles to the scene. Build must be called before tracing.
+	 * @param positions Vertex positions, 3 floats per vertex.
+	 * @param indices Triangle list indices.
+	 * @param transform Transform from the positions' space to the scene's.
+	 */
+	void AddTriangles(std::span<const float> positions, std::span<const unsigned int> indices,
+		const glm::mat4& transform);
+
+	/** @brief Builds the hierarchy over every triangle added so far. */
+	void Build();
+
+	/**
+	 * @brief Tests if a ray hits any triangle, stopping at the first hit found.
+	 * @param origin Origin of the ray.
+	 * @param direction Direction of the ray. Distances are in multiples of its length.
+	 * @param maxDistance Hits at this distance or further are ignored.
+	 * @return Whether the ray hit a triangle.
+	 */
+	bool IsOccluded(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const;
+
+	/**
+	 * @brief Finds the closest triangle hit by a ray.
+	 * @param origin Origin of the ray.
+	 * @param direction Direction of the ray. Distances are in multiples of its length.
+	 * @param distance Hits at this distance or further are ignored. Set to the distance of the
+	 *		closest hit, if any.
+	 * @return Whether the ray hit a triangle.
+	 */
+	bool Intersect(const glm::vec3& origin, const glm::vec3& direction, float& distance) const;
+
+	inline unsigned int GetNumTriangles() const { return (unsigned int)(vertices.size() / 3); }
+	inline unsigned int GetNumNodes() const { return (unsigned int)nodes.size(); }
+
+private:
+	// Disallow copy and assign
+	TriangleBVH(const TriangleBVH& other) = delete;
+	void operator=(const TriangleBVH& other) = delete;
+
+	/**
+	 * @brief Node with 4 children. Children are inner nodes if their index is non-negative,
+	 *		otherwise leaves of numBlocks triangle blocks starting at block -1 - index. Unused
+	 *		children are empty leaves with inverted bounds.
+	 */
+	struct Node
+	{
+		float minX[4], minY[4], minZ[4];
+		float maxX[4], maxY[4], maxZ[4];
+		int children[4];
+		unsigned int numBlocks[4];
+	};
+
+	/** @brief 4 triangles, stored as their first vertex and the edges from it to the others. */
+	struct TriangleBlock
+	{
+		float vertex[3][4];
+		float edge1[3][4];
+		float edge2[3][4];
+	};
+
+	/** @brief Bounds and centroid of a triangle, used while building. */
+	struct BuildTriangle
+	{
+		glm::vec3 min;
+		glm::vec3 max;
+		glm::vec3 centroid;
+		unsigned int index;
+	};
+
+	/**
+	 * @brief Splits a range of triangles in two.
+	 * @return End of the first half, or begin if the range should become a leaf.
+	 */
+	unsigned int Split(unsigned int begin, unsigned int end);
+
+	/** @return Index of a new node over a range of triangles. */
+	int BuildNode(unsigned int begin, unsigned int end);
+
+	/** @return Index of the first of the blocks storing a range of triangles. */
+	unsigned int BuildLeaf(unsigned int begin, unsigned int end);
+
+	template<bool IsAnyHit>
+	bool Trace(const glm::vec3& origin, const glm::vec3& direction, float& distance) const;
+
+	// 3 vertices per triangle, in scene space
+	std::vector<glm::vec3> vertices;
+	std::vector<Node> nodes;
+	std::vector<TriangleBlock> blocks;
+	std::vector<BuildTriangle> buildTriangles;
+};
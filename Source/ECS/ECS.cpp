@@ -25,7 +25,7 @@
  */
 
 #include "ECS.h"
-#include <iostream>
+#include "Log.h"
 #include <algorithm> // std::max
 #include <cstring> // std::memcpy
 
@@ -77,7 +77,7 @@ EntityHandle ECS::MakeEntity(BaseECSComponent** entityComponents, const unsigned
 		// Check if componentID is actually valid
 		if (!BaseECSComponent::IsTypeValid(componentIDs[i]))
 		{
-			std::cerr << "'" << componentIDs[i] << "' is not a valid component type." << std::endl;
+			Log::Error("'{}' is not a valid component type.", componentIDs[i]);
 			// Abort; delete the new entity and return a null entity handle
 			delete newEntity;
 			return nullptr;
@@ -217,7 +217,17 @@ void ECS::RemoveEntity(EntityHandle handle)
 	// Make sure all components attached to the entity are deleted
 	for (unsigned int i = 0; i < entity.size(); i++)
 	{
-		DeleteComponent(entity[i].first, entity[i].second);
+		UpdateIndices(entity[i].first, handle, nullptr);
+
+		// Shared components are only deleted once their group is empty
+		if (BaseECSComponent::IsTypeShared(entity[i].first))
+		{
+			RemoveFromSharedGroup(handle, entity[i].first, entity[i].second);
+		}
+		else
+		{
+			DeleteComponent(entity[i].first, entity[i].second);
+		}
 	}
 
 	// All components are gone; the entity can now be safely removed from the entities list...
@@ -256,13 +266,35 @@ void ECS::UpdateSystems(ECSSystemList& systems, float deltaTime)
 	std::vector<BaseECSComponent*> componentStorage;
 	std::vector<std::vector<unsigned char>*> componentArrays;
 
+	// No system is holding pointers to blobs yet, so blobs can safely be moved
+	blobArena.CompactIfFragmented();
+
 	// Iterate over all systems in the system list
 	for (unsigned int i = 0; i < systems.size(); i++)
 	{
 		const std::vector<unsigned int>& componentTypes = systems[i]->GetComponentTypes();
+		const std::vector<unsigned int>& componentFlags = systems[i]->GetComponentFlags();
+
+		// Find the first non-optional shared component type, if any, to group entities by
+		unsigned int sharedIndex = (unsigned int)-1;
+		for (unsigned int j = 0; j < componentTypes.size(); j++)
+		{
+			if (BaseECSComponent::IsTypeShared(componentTypes[j]) &&
+				(componentFlags[j] & BaseECSSystem::FLAG_OPTIONAL) == 0)
+			{
+				sharedIndex = j;
+				break;
+			}
+		}
 
+		// If the system is working with a shared component, update it one group at a time
+		if (sharedIndex != (unsigned int)-1)
+		{
+			UpdateSystemWithSharedComponent(i, systems, deltaTime, componentTypes, sharedIndex,
+				componentStorage, componentArrays);
+		}
 		// If the system has only one component type
-		if (componentTypes.size() == 1)
+		else if (componentTypes.size() == 1)
 		{
 			// Find the memory size of the component type
 			size_t typeSize = BaseECSComponent::GetTypeSize(componentTypes[0]);
@@ -379,6 +411,80 @@ void ECS::UpdateSystemWithMultipleComponents(unsigned int index, ECSSystemList&
 	}
 }
 
+void ECS::UpdateSystemWithSharedComponent(unsigned int index, ECSSystemList& systems,
+	float deltaTime, const std::vector<unsigned int>& componentTypes, unsigned int sharedIndex,
+	std::vector<BaseECSComponent*>& componentStorage,
+	std::vector<std::vector<unsigned char>*>& componentArrays)
+{
+	const std::vector<unsigned int>& componentFlags = systems[index]->GetComponentFlags();
+	const unsigned int numComponentTypes = componentTypes.size();
+
+	componentArrays.resize(std::max(componentArrays.size(), componentTypes.size()));
+	for (unsigned int i = 0; i < numComponentTypes; i++)
+	{
+		componentArrays[i] = &components[componentTypes[i]];
+	}
+
+	// The shared values; one per group
+	std::vector<unsigned char>& sharedArray = *componentArrays[sharedIndex];
+	const size_t sharedTypeSize = BaseECSComponent::GetTypeSize(componentTypes[sharedIndex]);
+	SharedComponentGroups& groups = sharedComponents[componentTypes[sharedIndex]];
+
+	// Iterate over all groups
+	for (unsigned int group = 0; group < groups.entities.size(); group++)
+	{
+		BaseECSComponent* sharedComponent = (BaseECSComponent*)&sharedArray[group * sharedTypeSize];
+		const std::vector<EntityHandle>& groupEntities = groups.entities[group];
+
+		// Gather the components of every entity in the group, one entity after another
+		componentStorage.resize(std::max(componentStorage.size(),
+			groupEntities.size() * numComponentTypes));
+
+		unsigned int numEntities = 0;
+		for (EntityHandle entity : groupEntities)
+		{
+			BaseECSComponent** entityStorage = &componentStorage[numEntities * numComponentTypes];
+			std::vector<std::pair<unsigned int, unsigned int>>& entityComponents =
+				HandleToEntity(entity);
+
+			// Does the entity have all components
+			bool isValid = true;
+			for (unsigned int j = 0; j < numComponentTypes; j++)
+			{
+				// Already known; every entity in the group shares it
+				if (j == sharedIndex)
+				{
+					entityStorage[j] = sharedComponent;
+					continue;
+				}
+
+				entityStorage[j] = GetComponentInternal(entityComponents, *componentArrays[j],
+					componentTypes[j]);
+
+				// If the component type is not optional in this system, then this entity is not
+				// valid and should be ignored
+				if (entityStorage[j] == nullptr &&
+					((componentFlags[j] & BaseECSSystem::FLAG_OPTIONAL) == 0))
+				{
+					isValid = false;
+					break;
+				}
+			}
+
+			// Keep the components of valid entities; the next entity overwrites them otherwise
+			if (isValid)
+			{
+				numEntities++;
+			}
+		}
+
+		if (numEntities > 0)
+		{
+			systems[index]->UpdateGroup(deltaTime, componentStorage.data(), numEntities);
+		}
+	}
+}
+
 unsigned int ECS::FindLeastCommonComponent(const std::vector<unsigned int>& componentTypes,
 	const std::vector<unsigned int>& componentFlags)
 {
@@ -434,6 +540,7 @@ void ECS::DeleteComponent(unsigned int componentID, unsigned int index)
 	BaseECSComponent* sourceComponent = (BaseECSComponent*)&array[sourceIndex];
 
 	// Call the free function on the component being deleted
+	FreeComponentBlobs(componentID, destinationComponent);
 	freeFunction(destinationComponent);
 
 	// Special case where the component being deleted is the final element of the array
@@ -471,6 +578,139 @@ void ECS::DeleteComponent(unsigned int componentID, unsigned int index)
 	array.resize(sourceIndex);
 }
 
+void ECS::AddIndex(BaseECSIndex* index)
+{
+	const unsigned int componentID = index->GetComponentType();
+	indices[componentID].push_back(index);
+
+	std::vector<unsigned char>& array = components[componentID];
+	const size_t typeSize = BaseECSComponent::GetTypeSize(componentID);
+
+	// Shared components do not know their entities; the groups do
+	if (BaseECSComponent::IsTypeShared(componentID))
+	{
+		SharedComponentGroups& groups = sharedComponents[componentID];
+		for (unsigned int group = 0; group < groups.entities.size(); group++)
+		{
+			for (EntityHandle entity : groups.entities[group])
+			{
+				index->OnAdd(entity, (BaseECSComponent*)&array[group * typeSize]);
+			}
+		}
+		return;
+	}
+
+	for (size_t i = 0; i < array.size(); i += typeSize)
+	{
+		BaseECSComponent* component = (BaseECSComponent*)&array[i];
+		index->OnAdd(component->entity, component);
+	}
+}
+
+void ECS::RemoveIndex(BaseECSIndex* index)
+{
+	std::vector<BaseECSIndex*>& typeIndices = indices[index->GetComponentType()];
+	typeIndices.erase(std::remove(typeIndices.begin(), typeIndices.end(), index),
+		typeIndices.end());
+}
+
+void ECS::UpdateIndices(unsigned int componentID, EntityHandle handle,
+	const BaseECSComponent* component)
+{
+	const std::unordered_map<unsigned int, std::vector<BaseECSIndex*>>::iterator it =
+		indices.find(componentID);
+	if (it == indices.end())
+	{
+		return;
+	}
+
+	for (BaseECSIndex* index : it->second)
+	{
+		if (component != nullptr)
+		{
+			index->OnAdd(handle, component);
+		}
+		else
+		{
+			index->OnRemove(handle);
+		}
+	}
+}
+
+void ECS::FreeComponentBlobs(unsigned int componentID, BaseECSComponent* component)
+{
+	const std::unordered_map<unsigned int, std::vector<size_t>>::iterator it =
+		blobFields.find(componentID);
+	if (it == blobFields.end())
+	{
+		return;
+	}
+
+	for (size_t offset : it->second)
+	{
+		blobArena.Free(*(ECSBlobHandle*)((unsigned char*)component + offset));
+	}
+}
+
+void ECS::RemoveFromSharedGroup(EntityHandle handle, unsigned int componentID, unsigned int index)
+{
+	SharedComponentGroups& groups = sharedComponents[componentID];
+	const size_t typeSize = BaseECSComponent::GetTypeSize(componentID);
+	const unsigned int group = index / typeSize;
+
+	// Remove the entity from its group, by moving the last entity of the group in its place
+	std::vector<EntityHandle>& groupEntities = groups.entities[group];
+	const std::unordered_map<EntityHandle, unsigned int>::iterator it =
+		groups.entityIndices.find(handle);
+	const unsigned int entityIndex = it->second;
+	groups.entityIndices.erase(it);
+
+	if (entityIndex != groupEntities.size() - 1)
+	{
+		groupEntities[entityIndex] = groupEntities.back();
+		groups.entityIndices[groupEntities[entityIndex]] = entityIndex;
+	}
+	groupEntities.pop_back();
+
+	// The shared value is still in use by other entities
+	if (!groupEntities.empty())
+	{
+		return;
+	}
+
+	// The group is empty; delete its value, moving the value of the last group in its place
+	std::vector<unsigned char>& array = components[componentID];
+	const unsigned int sourceIndex = array.size() - typeSize;
+
+	BaseECSComponent* destinationComponent = (BaseECSComponent*)&array[index];
+	BaseECSComponent* sourceComponent = (BaseECSComponent*)&array[sourceIndex];
+	FreeComponentBlobs(componentID, destinationComponent);
+	BaseECSComponent::GetTypeFreeFunction(componentID)(destinationComponent);
+
+	if (index != sourceIndex)
+	{
+		std::memcpy(destinationComponent, sourceComponent, typeSize);
+
+		// Every entity of the moved group refers to the value by its index; update them
+		const unsigned int sourceGroup = sourceIndex / typeSize;
+		for (EntityHandle entity : groups.entities[sourceGroup])
+		{
+			for (std::pair<unsigned int, unsigned int>& component : HandleToEntity(entity))
+			{
+				if (component.first == componentID)
+				{
+					component.second = index;
+					break;
+				}
+			}
+		}
+		groups.entities[group] = std::move(groups.entities[sourceGroup]);
+	}
+
+	groups.entities.pop_back();
+	array.resize(sourceIndex);
+}
+
 bool ECS::RemoveComponentInternal(EntityHandle handle, unsigned int componentID)
 {
 	// Get a reference to the entity which the component is being removed from
@@ -482,10 +722,19 @@ bool ECS::RemoveComponentInternal(EntityHandle handle, unsigned int componentID)
 		// If the component ID matches the ID of the component to remove
 		if (componentID == entityComponents[i].first)
 		{
+			UpdateIndices(componentID, handle, nullptr);
+
 			// Delete the component
 			// Note that this only deletes the component at it's index in the components array
 			// The component <type ID, index> pair still needs to be removed from the entity
-			DeleteComponent(entityComponents[i].first, entityComponents[i].second);
+			if (BaseECSComponent::IsTypeShared(componentID))
+			{
+				RemoveFromSharedGroup(handle, componentID, entityComponents[i].second);
+			}
+			else
+			{
+				DeleteComponent(entityComponents[i].first, entityComponents[i].second);
+			}
 
 			// Swap the component being removed with the final component in the vector/array,
 			// and then delete the final element
@@ -516,6 +765,45 @@ void ECS::AddComponentInternal(EntityHandle handle,
 
 	newPair.first = componentID;
 
+	// Shared components are only created if no equal value exists yet; the entity is added to the
+	// group of the value
+	if (BaseECSComponent::IsTypeShared(componentID))
+	{
+		std::vector<unsigned char>& array = components[componentID];
+		SharedComponentGroups& groups = sharedComponents[componentID];
+		const size_t typeSize = BaseECSComponent::GetTypeSize(componentID);
+		const ECSComponentCompareFunction compareFunction =
+			BaseECSComponent::GetTypeCompareFunction(componentID);
+
+		// Shared components are meant for values common to many entities, so there are few
+		// groups to search
+		unsigned int index = array.size();
+		for (unsigned int i = 0; i < array.size(); i += typeSize)
+		{
+			if (compareFunction((BaseECSComponent*)&array[i], component))
+			{
+				index = i;
+				break;
+			}
+		}
+
+		// No equal value; create a new group
+		if (index == array.size())
+		{
+			index = createFunction(array, nullptr, component);
+			groups.entities.emplace_back();
+		}
+
+		std::vector<EntityHandle>& groupEntities = groups.entities[index / typeSize];
+		groups.entityIndices[handle] = groupEntities.size();
+		groupEntities.push_back(handle);
+
+		newPair.second = index;
+		entity.push_back(newPair);
+		UpdateIndices(componentID, handle, (BaseECSComponent*)&array[index]);
+		return;
+	}
+
 	// The create function returns the location/index of the component created in the memory array
 	// See ECSComponentCreate
 	//
@@ -526,6 +814,8 @@ void ECS::AddComponentInternal(EntityHandle handle,
 
 	// Add the newly created component to our entity
 	entity.push_back(newPair);
+	UpdateIndices(componentID, handle,
+		(BaseECSComponent*)&components[componentID][newPair.second]);
 }
 
 BaseECSComponent* ECS::GetComponentInternal(
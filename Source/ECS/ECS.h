@@ -28,6 +28,8 @@
 
 #include "ECSComponent.h"
 #include "ECSSystem.h"
+#include "ECSBlobArena.h"
+#include "ECSIndex.h"
 
 #include <unordered_map>
 #include <vector>
@@ -143,6 +145,12 @@ private:
  *   components which define an object in the game. Entities can only have one component of a given
  *   type (duplicate components are not allowed).
  * 
+ * - A shared component is stored once for all entities with an equal value, which form a group.
+ *   See ECSSharedComponent.
+ * 
+ * - Variable-length payloads of components are stored in the ECS's blob arena, and referred to
+ *   by handles, so components stay fixed-size and relocatable with memcpy.
+ * 
  * Internal versions of certain methods in ECS are used because the type name is not known at
  * compile time.
  */
@@ -220,7 +228,7 @@ public:
 	 */
 	inline void AddComponent(EntityHandle entity, Component* component)
 	{
-		AddComponentInternal(HandleToEntity(entity), Component::ID, component);
+		AddComponentInternal(entity, HandleToEntity(entity), Component::ID, component);
 
 		// Now that the component is created, dispatch the add component event to all listeners
 		// in the ECS...
@@ -321,6 +329,83 @@ public:
 		return GetComponentInternal(HandleToEntity(entity), components[componentID], componentID);
 	}
 
+	/**
+	 * Gets the memory of all components of a type, stored one after another. Useful for
+	 * inspecting or serializing the state of the ECS.
+	 * 
+	 * @param componentID The ID of the component type.
+	 * 
+	 * @return The components, each BaseECSComponent::GetTypeSize(componentID) bytes long.
+	 */
+	inline const std::vector<unsigned char>& GetComponentMemory(unsigned int componentID)
+	{
+		return components[componentID];
+	}
+
+	// Index methods
+
+	/**
+	 * Adds a secondary index over a component type. The index is filled with the components
+	 * already in the ECS, and kept up to date as components of the type are added and removed.
+	 * 
+	 * @see BaseECSIndex
+	 * 
+	 * @param index The index to add. Must outlive the ECS, or be removed first.
+	 */
+	void AddIndex(BaseECSIndex* index);
+
+	/**
+	 * Removes a secondary index from the ECS. The index is no longer updated.
+	 * 
+	 * @param index The index to remove.
+	 */
+	void RemoveIndex(BaseECSIndex* index);
+
+	template<class Component>
+	/**
+	 * Updates the secondary indices of a component type after a component was modified.
+	 * 
+	 * @param entity Handle to the entity whose component was modified.
+	 */
+	inline void MarkChanged(EntityHandle entity)
+	{
+		const std::unordered_map<unsigned int, std::vector<BaseECSIndex*>>::iterator it =
+			indices.find(Component::ID);
+		if (it == indices.end())
+		{
+			return;
+		}
+
+		BaseECSComponent* component = GetComponentByType(entity, Component::ID);
+		for (BaseECSIndex* index : it->second)
+		{
+			index->OnChange(entity, component);
+		}
+	}
+
+	// Blob methods
+
+	/**
+	 * Gets the arena for variable-length component payloads. Pointers to blobs are valid until
+	 * the next blob allocation, or the next call to UpdateSystems, which compacts the arena when
+	 * it becomes fragmented.
+	 */
+	inline ECSBlobArena& GetBlobArena() { return blobArena; }
+
+	/**
+	 * Registers a blob handle field of a component type, so its blob is freed along with the
+	 * component.
+	 * 
+	 * @param field Pointer to the field, such as &PathComponent::waypoints.
+	 */
+	template<class Component>
+	inline void RegisterBlobField(ECSBlobHandle Component::* field)
+	{
+		Component component;
+		blobFields[Component::ID].push_back((unsigned char*)&(component.*field) -
+			(unsigned char*)&component);
+	}
+
 	// System methods
 
 	/**
@@ -332,9 +417,33 @@ public:
 	void UpdateSystems(ECSSystemList& systems, float deltaTime);
 
 private:
+	/** @brief Groups of entities with an equal value of a shared component type. */
+	struct SharedComponentGroups
+	{
+		// Entities of every group. The index of a group is the index of its shared value in the
+		// component type's memory array, divided by the size of the component type.
+		std::vector<std::vector<EntityHandle>> entities;
+
+		// Index of every entity within its group, for efficient removal
+		std::unordered_map<EntityHandle, unsigned int> entityIndices;
+	};
+
 	// map<id, memory>
+	// For shared component types, the memory holds one value per group
 	std::unordered_map<unsigned int, std::vector<unsigned char>> components;
 
+	// map<id, groups>, for shared component types only
+	std::unordered_map<unsigned int, SharedComponentGroups> sharedComponents;
+
+	// Variable-length payloads of components
+	ECSBlobArena blobArena;
+
+	// map<id, byte offsets of blob handle fields>
+	std::unordered_map<unsigned int, std::vector<size_t>> blobFields;
+
+	// map<id, secondary indices>
+	std::unordered_map<unsigned int, std::vector<BaseECSIndex*>> indices;
+
 	// vector<pair<index, entity>>
 	// The index is stored in the pair because it allows for efficient element removal
 	//
@@ -390,6 +499,35 @@ private:
 	 */
 	void DeleteComponent(unsigned int componentID, unsigned int index);
 
+	/**
+	 * Used internally for notifying the secondary indices of a component type when a component
+	 * is added to, or removed from an entity.
+	 * 
+	 * @param componentID The ID of the component type.
+	 * @param handle The handle of the entity.
+	 * @param component The added component, or nullptr if the component is being removed.
+	 */
+	void UpdateIndices(unsigned int componentID, EntityHandle handle,
+		const BaseECSComponent* component);
+
+	/**
+	 * Used internally for freeing the blobs of a component, before it is deleted.
+	 * 
+	 * @param componentID The ID of the component type.
+	 * @param component The component.
+	 */
+	void FreeComponentBlobs(unsigned int componentID, BaseECSComponent* component);
+
+	/**
+	 * Used internally for removing an entity from the group of a shared component. The shared
+	 * value is deleted once no entity is left in the group.
+	 * 
+	 * @param handle The handle of the entity.
+	 * @param componentID The ID of the shared component type.
+	 * @param index The index of the shared value in the components vector/array.
+	 */
+	void RemoveFromSharedGroup(EntityHandle handle, unsigned int componentID, unsigned int index);
+
 	/**
 	 * Used internally for removing a component from an entity.
 	 * 
@@ -444,6 +582,26 @@ private:
 		std::vector<BaseECSComponent*>& componentStorage,
 		std::vector<std::vector<unsigned char>*>& componentArrays);
 
+	/**
+	 * Used internally for updating a system working with a shared component, one group of
+	 * entities at a time.
+	 * 
+	 * @param index Index of the system in the systems list to update.
+	 * @param systems The systems list, used for looking up the system to update.
+	 * @param deltaTime How much time has passed since the previous update.
+	 * @param componentTypes The component types with which the system is working with.
+	 * @param sharedIndex Index, in the component types, of the shared component type to group
+	 *		entities by.
+	 * @param componentStorage Vector reference used to avoid repeatedly allocating. Used for
+	 *		storing pointers to the components of every valid entity in a group.
+	 * @param componentArrays Vector reference used to avoid repeatedly allocating. Used for
+	 *		storing the location of the memory/data for components.
+	 */
+	void UpdateSystemWithSharedComponent(unsigned int index, ECSSystemList& systems,
+		float deltaTime, const std::vector<unsigned int>& componentTypes, unsigned int sharedIndex,
+		std::vector<BaseECSComponent*>& componentStorage,
+		std::vector<std::vector<unsigned char>*>& componentArrays);
+
 	/**
 	 * Finds the least commonly occuring component from the list of component types specified. 
 	 * Optional components will be ignored.
@@ -0,0 +1,194 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#include "ECSBlobArena.h"
+
+#include <cstring>
+
+ECSBlobHandle ECSBlobArena::Allocate(size_t size, const void* data)
+{
+	ECSBlobHandle handle;
+	if (freeSlots.empty())
+	{
+		handle.index = (unsigned int)slots.size();
+		slots.emplace_back();
+	}
+	else
+	{
+		handle.index = freeSlots.back();
+		freeSlots.pop_back();
+	}
+
+	Slot& slot = slots[handle.index];
+	AllocateBlock(slot, size);
+
+	if (data != nullptr && size > 0)
+	{
+		std::memcpy(GetData(handle), data, size);
+	}
+
+	return handle;
+}
+
+void ECSBlobArena::Resize(ECSBlobHandle handle, size_t size)
+{
+	Slot& slot = slots[handle.index];
+
+	// Still fits into the block
+	if (size <= slot.capacity)
+	{
+		slot.size = (unsigned int)size;
+		return;
+	}
+
+	const Slot previousSlot = slot;
+	AllocateBlock(slot, size);
+
+	// The pages may have been reallocated, so look up both blocks after allocating
+	std::memcpy(pages[slot.block.page].data() + slot.block.offset,
+		pages[previousSlot.block.page].data() + previousSlot.block.offset, previousSlot.size);
+
+	FreeBlock(previousSlot);
+}
+
+void ECSBlobArena::Free(ECSBlobHandle handle)
+{
+	if (!handle.IsValid())
+	{
+		return;
+	}
+
+	Slot& slot = slots[handle.index];
+	FreeBlock(slot);
+	slot.isFree = true;
+	freeSlots.push_back(handle.index);
+}
+
+void ECSBlobArena::Compact()
+{
+	std::vector<std::vector<unsigned char>> previousPages;
+	previousPages.swap(pages);
+
+	for (std::vector<Block>& blocks : freeBlocks)
+	{
+		blocks.clear();
+	}
+	numAllocatedBytes = 0;
+	currentPage = NO_PAGE;
+	pageOffset = 0;
+
+	// Blobs are copied in slot order, so blobs allocated together stay together
+	for (Slot& slot : slots)
+	{
+		if (slot.isFree)
+		{
+			continue;
+		}
+
+		const Block previousBlock = slot.block;
+		slot.block = AllocateFromPages(slot.capacity);
+		std::memcpy(pages[slot.block.page].data() + slot.block.offset,
+			previousPages[previousBlock.page].data() + previousBlock.offset, slot.size);
+	}
+}
+
+bool ECSBlobArena::CompactIfFragmented(float maxUnusedFraction)
+{
+	// Not worth compacting less than a page
+	if (numAllocatedBytes <= PAGE_SIZE ||
+		(float)(numAllocatedBytes - numLiveBytes) <= (float)numAllocatedBytes * maxUnusedFraction)
+	{
+		return false;
+	}
+
+	Compact();
+	return true;
+}
+
+unsigned char ECSBlobArena::GetSizeClass(size_t size)
+{
+	for (unsigned char sizeClass = 0; sizeClass < NUM_SIZE_CLASSES; sizeClass++)
+	{
+		if (size <= MIN_BLOCK_SIZE << sizeClass)
+		{
+			return sizeClass;
+		}
+	}
+
+	return LARGE_SIZE_CLASS;
+}
+
+void ECSBlobArena::AllocateBlock(Slot& slot, size_t size)
+{
+	slot.size = (unsigned int)size;
+	slot.sizeClass = GetSizeClass(size);
+	slot.isFree = false;
+
+	if (slot.sizeClass == LARGE_SIZE_CLASS)
+	{
+		slot.capacity = (unsigned int)((size + MIN_BLOCK_SIZE - 1) & ~(MIN_BLOCK_SIZE - 1));
+		slot.block = AllocateFromPages(slot.capacity);
+	}
+	else
+	{
+		slot.capacity = (unsigned int)(MIN_BLOCK_SIZE << slot.sizeClass);
+
+		// Reuse a freed block of the same size class
+		std::vector<Block>& blocks = freeBlocks[slot.sizeClass];
+		if (blocks.empty())
+		{
+			slot.block = AllocateFromPages(slot.capacity);
+		}
+		else
+		{
+			slot.block = blocks.back();
+			blocks.pop_back();
+		}
+	}
+
+	numLiveBytes += slot.capacity;
+}
+
+void ECSBlobArena::FreeBlock(const Slot& slot)
+{
+	// Large blocks are only reclaimed by compaction
+	if (slot.sizeClass != LARGE_SIZE_CLASS)
+	{
+		freeBlocks[slot.sizeClass].push_back(slot.block);
+	}
+
+	numLiveBytes -= slot.capacity;
+}
+
+ECSBlobArena::Block ECSBlobArena::AllocateFromPages(size_t capacity)
+{
+	Block block;
+
+	// Blobs larger than a page get a page of their own
+	if (capacity > PAGE_SIZE)
+	{
+		block.page = (unsigned int)pages.size();
+		block.offset = 0;
+		pages.emplace_back(capacity);
+		numAllocatedBytes += capacity;
+		return block;
+	}
+
+	if (currentPage == NO_PAGE || pageOffset + capacity > PAGE_SIZE)
+	{
+		// The rest of the current page is left unused until compaction
+		if (currentPage != NO_PAGE)
+		{
+			numAllocatedBytes += PAGE_SIZE - pageOffset;
+		}
+
+		currentPage = (unsigned int)pages.size();
+		pages.emplace_back(PAGE_SIZE);
+		pageOffset = 0;
+	}
+
+	block.page = currentPage;
+	block.offset = (unsigned int)pageOffset;
+	pageOffset += capacity;
+	numAllocatedBytes += capacity;
+	return block;
+}
@@ -0,0 +1,134 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include <vector>
+
+/**
+ * @brief Handle to a variable-length payload in an ECSBlobArena. Trivially copyable, so
+ *		components holding handles can still be relocated with memcpy.
+ */
+struct ECSBlobHandle
+{
+	static constexpr unsigned int INVALID_INDEX = 0xFFFFFFFF;
+
+	// Index of the blob in the arena's slot table
+	unsigned int index = INVALID_INDEX;
+
+	inline bool IsValid() const { return index != INVALID_INDEX; }
+};
+
+/**
+ * @brief Paged arena for variable-length component payloads, such as paths or lists, which
+ *		would otherwise be heap allocated vectors inside components.
+ *
+ * Blobs are allocated from large pages. Small blobs are rounded up to a power of two size class,
+ * and freed blocks of each class are kept on a freelist for reuse. Larger blobs are allocated as
+ * they are, and their blocks are only reclaimed by compaction, which copies all live blobs into
+ * fresh pages in slot order. Handles refer to blobs through a slot table, so they stay valid
+ * when blobs move; pointers returned by GetData are only valid until the next allocation,
+ * resize, or compaction.
+ */
+class ECSBlobArena
+{
+public:
+	ECSBlobArena() : numAllocatedBytes(0), numLiveBytes(0), currentPage(NO_PAGE), pageOffset(0) {}
+
+	/**
+	 * @brief Allocates a blob.
+	 * @param size Size of the blob in bytes.
+	 * @param data Data to copy into the blob, or nullptr to leave it uninitialized.
+	 * @return Handle to the blob.
+	 */
+	ECSBlobHandle Allocate(size_t size, const void* data = nullptr);
+
+	/**
+	 * @brief Changes the size of a blob, keeping its contents up to the smaller of the sizes. The
+	 *		handle stays the same.
+	 * @param handle Handle to the blob.
+	 * @param size New size of the blob in bytes.
+	 */
+	void Resize(ECSBlobHandle handle, size_t size);
+
+	/**
+	 * @brief Frees a blob. Invalid handles are ignored.
+	 * @param handle Handle to the blob.
+	 */
+	void Free(ECSBlobHandle handle);
+
+	/** @brief Copies all live blobs into fresh pages, reclaiming all unused memory. */
+	void Compact();
+
+	/**
+	 * @brief Compacts the arena if too much of its memory is unused. Cheap enough to call every
+	 *		frame.
+	 * @param maxUnusedFraction Fraction of allocated memory which may be unused.
+	 * @return Whether the arena was compacted.
+	 */
+	bool CompactIfFragmented(float maxUnusedFraction = 0.5f);
+
+	inline unsigned char* GetData(ECSBlobHandle handle)
+	{
+		const Slot& slot = slots[handle.index];
+		return pages[slot.block.page].data() + slot.block.offset;
+	}
+
+	inline size_t GetSize(ECSBlobHandle handle) const { return slots[handle.index].size; }
+
+	/** @brief Gets a blob as an array of trivially copyable elements. */
+	template<typename T>
+	inline T* Get(ECSBlobHandle handle) { return (T*)GetData(handle); }
+
+	/** @brief Gets the number of elements in a blob holding an array. */
+	template<typename T>
+	inline size_t GetCount(ECSBlobHandle handle) const { return GetSize(handle) / sizeof(T); }
+
+	inline size_t GetNumAllocatedBytes() const { return numAllocatedBytes; }
+	inline size_t GetNumLiveBytes() const { return numLiveBytes; }
+
+private:
+	// Disallow copy and assign
+	ECSBlobArena(const ECSBlobArena& other) = delete;
+	void operator=(const ECSBlobArena& other) = delete;
+
+	static constexpr size_t PAGE_SIZE = 1 << 16;
+	// Every block is aligned to, and a multiple of, the smallest size class
+	static constexpr size_t MIN_BLOCK_SIZE = 16;
+	// Size classes are MIN_BLOCK_SIZE << i; blocks larger than the last class are not pooled
+	static constexpr unsigned int NUM_SIZE_CLASSES = 9;
+	static constexpr unsigned char LARGE_SIZE_CLASS = 0xFF;
+	static constexpr unsigned int NO_PAGE = 0xFFFFFFFF;
+
+	struct Block
+	{
+		unsigned int page;
+		unsigned int offset;
+	};
+
+	struct Slot
+	{
+		Block block;
+		unsigned int size;
+		unsigned int capacity;
+		unsigned char sizeClass;
+		bool isFree;
+	};
+
+	static unsigned char GetSizeClass(size_t size);
+
+	void AllocateBlock(Slot& slot, size_t size);
+	void FreeBlock(const Slot& slot);
+	Block AllocateFromPages(size_t capacity);
+
+	std::vector<std::vector<unsigned char>> pages;
+	std::vector<Slot> slots;
+	std::vector<unsigned int> freeSlots;
+	std::vector<Block> freeBlocks[NUM_SIZE_CLASSES];
+
+	// Bytes taken from pages, and bytes in blocks of live blobs
+	size_t numAllocatedBytes;
+	size_t numLiveBytes;
+	// Page which small blobs are allocated from, and the offset of its next free byte
+	unsigned int currentPage;
+	size_t pageOffset;
+};
@@ -26,17 +26,17 @@
 
 #include "ECSComponent.h"
 
-std::vector<std::tuple<ECSComponentCreateFunction, ECSComponentFreeFunction, size_t>>*
-	BaseECSComponent::componentTypes;
+std::vector<std::tuple<ECSComponentCreateFunction, ECSComponentFreeFunction, size_t,
+	ECSComponentCompareFunction>>* BaseECSComponent::componentTypes;
 
 unsigned int BaseECSComponent::RegisterComponentType(ECSComponentCreateFunction createFunction, 
-	ECSComponentFreeFunction freeFunction, size_t size)
+	ECSComponentFreeFunction freeFunction, size_t size, ECSComponentCompareFunction compareFunction)
 {
 	// If the component types array has not been initialized
 	if (componentTypes == nullptr)
 	{
 		componentTypes = new std::vector<std::tuple<ECSComponentCreateFunction,
-			ECSComponentFreeFunction, size_t>>();
+			ECSComponentFreeFunction, size_t, ECSComponentCompareFunction>>();
 	}
 
 	// The ID starts at zero.
@@ -46,7 +46,7 @@ unsigned int BaseECSComponent::RegisterComponentType(ECSComponentCreateFunction
 	
 	// Add the component's parameters to the lookup array
 	componentTypes->push_back(std::tuple<ECSComponentCreateFunction, ECSComponentFreeFunction,
-		size_t>(createFunction, freeFunction, size));
+		size_t, ECSComponentCompareFunction>(createFunction, freeFunction, size, compareFunction));
 
 	return componentID;
 }
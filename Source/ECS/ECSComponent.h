@@ -43,6 +43,10 @@ typedef unsigned int(*ECSComponentCreateFunction)(std::vector<unsigned char>& me
 /** @brief Pointer to the component free function. */
 typedef void (*ECSComponentFreeFunction)(BaseECSComponent* component);
 
+/** @brief Pointer to the shared component compare function. */
+typedef bool (*ECSComponentCompareFunction)(const BaseECSComponent* a,
+	const BaseECSComponent* b);
+
 /** @brief Base struct which components derive from. */
 struct BaseECSComponent
 {
@@ -59,10 +63,14 @@ public:
 	 * 
 	 * @param size The size of the component type in bytes.
 	 * 
+	 * @param compareFunction Pointer to the function which compares two values of the component
+	 *		type for equality, if it is a shared component type, or nullptr otherwise.
+	 * 
 	 * @return The component ID of the newly registered component type.
 	 */
 	static unsigned int RegisterComponentType(ECSComponentCreateFunction createFunction,
-		ECSComponentFreeFunction freeFunction, size_t size);
+		ECSComponentFreeFunction freeFunction, size_t size,
+		ECSComponentCompareFunction compareFunction = nullptr);
 
 	// The entity which the component is attached to
 	EntityHandle entity = nullptr;
@@ -100,6 +108,25 @@ public:
 		return std::get<2>((*componentTypes)[id]);
 	}
 
+	/**
+	 * Gets the compare function for a given shared component type.
+	 *
+	 * @param id The ID of the component type to look up.
+	 * @return The compare function, or nullptr if the component type is not shared.
+	 */
+	inline static ECSComponentCompareFunction GetTypeCompareFunction(unsigned int id)
+	{
+		return std::get<3>((*componentTypes)[id]);
+	}
+
+	/**
+	 * @brief Determines if a component type is shared; see ECSSharedComponent.
+	 */
+	inline static bool IsTypeShared(unsigned int id)
+	{
+		return GetTypeCompareFunction(id) != nullptr;
+	}
+
 	/**
 	 * @brief Determines if a component type ID is within the range of registered component types.
 	 */
@@ -112,7 +139,7 @@ private:
 	// Lookup array for all the parameters of a given component type, index corresponds to
 	// component ID. This gives us a global index of all component types at runtime.
 	static std::vector<std::tuple<ECSComponentCreateFunction, ECSComponentFreeFunction,
-		size_t>>* componentTypes;
+		size_t, ECSComponentCompareFunction>>* componentTypes;
 };
 
 template<typename T>
@@ -132,6 +159,29 @@ struct ECSComponent : public BaseECSComponent
 };
 
 
+template<typename T>
+/**
+ * @brief Intermediary ECS component struct which shared components should inherit.
+ * 
+ * A shared component holds data common to many entities, such as the mesh they are drawn with.
+ * Rather than storing a copy per entity, the ECS stores every distinct value once, and groups the
+ * entities with an equal value (compared with operator==, which the component must define)
+ * together. Systems working with a shared component are updated one group at a time; see
+ * BaseECSSystem::UpdateGroup.
+ * 
+ * Modifying a shared component through GetComponent modifies it for the whole group. To change
+ * the value of a single entity, remove the component and add it again with the new value. The
+ * entity field of a shared component is always nullptr.
+ */
+struct ECSSharedComponent : public BaseECSComponent
+{
+	static const ECSComponentCreateFunction CREATE_FUNCTION;
+	static const ECSComponentFreeFunction FREE_FUNCTION;
+	static const ECSComponentCompareFunction COMPARE_FUNCTION;
+	static const unsigned int ID;
+	static const size_t SIZE;
+};
+
 template<typename Component>
 /**
  * This function defines how to create a component at runtime.
@@ -174,6 +224,19 @@ void ECSComponentFree(BaseECSComponent* component)
 	c->~Component();
 }
 
+template<typename Component>
+/**
+ * This function defines how to compare shared components at runtime.
+ *
+ * @param a The first component.
+ * @param b The second component.
+ * @return If the components are equal, and can therefore be shared.
+ */
+bool ECSComponentCompare(const BaseECSComponent* a, const BaseECSComponent* b)
+{
+	return *(const Component*)a == *(const Component*)b;
+}
+
 template<typename T>
 // Set the component ID for every individual component
 // RegisterComponentType returns the ID of the new component
@@ -192,4 +255,24 @@ const ECSComponentCreateFunction ECSComponent<T>::CREATE_FUNCTION(ECSComponentCr
 
 template<typename T>
 // How to free the component at runtime
-const ECSComponentFreeFunction ECSComponent<T>::FREE_FUNCTION(ECSComponentFree<T>);
\ No newline at end of file
+const ECSComponentFreeFunction ECSComponent<T>::FREE_FUNCTION(ECSComponentFree<T>);
+
+template<typename T>
+// Shared component types are registered along with their compare function, which identifies them
+// as shared
+const unsigned int ECSSharedComponent<T>::ID(BaseECSComponent::RegisterComponentType(
+	ECSComponentCreate<T>, ECSComponentFree<T>, sizeof(T), ECSComponentCompare<T>));
+
+template<typename T>
+const size_t ECSSharedComponent<T>::SIZE(sizeof(T));
+
+template<typename T>
+const ECSComponentCreateFunction ECSSharedComponent<T>::CREATE_FUNCTION(ECSComponentCreate<T>);
+
+template<typename T>
+const ECSComponentFreeFunction ECSSharedComponent<T>::FREE_FUNCTION(ECSComponentFree<T>);
+
+template<typename T>
+// How to compare shared components at runtime
+const ECSComponentCompareFunction ECSSharedComponent<T>::COMPARE_FUNCTION(
+	ECSComponentCompare<T>);
\ No newline at end of file
@@ -0,0 +1,285 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include "ECSComponent.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Base class of secondary indices, which find entities by a key computed from one of
+ *		their components, without scanning every component of the type.
+ *
+ * Indices are added to an ECS, which keeps them up to date as components of the type are added
+ * and removed. Components are modified in place, so the ECS cannot see changes to them; after
+ * changing an indexed field, call ECS::MarkChanged for the entity.
+ */
+class BaseECSIndex
+{
+public:
+	/** @param componentID The ID of the component type to index. */
+	BaseECSIndex(unsigned int componentID) : version(0), componentID(componentID) {}
+	virtual ~BaseECSIndex() {}
+
+	virtual void OnAdd(EntityHandle entity, const BaseECSComponent* component) = 0;
+	virtual void OnRemove(EntityHandle entity) = 0;
+	virtual void OnChange(EntityHandle entity, const BaseECSComponent* component) = 0;
+
+	inline unsigned int GetComponentType() const { return componentID; }
+
+	/**
+	 * @brief Gets the version of the index, which is incremented whenever an entity is added,
+	 *		removed, or changed. Query results can be cached for as long as it stays the same.
+	 */
+	inline unsigned int GetVersion() const { return version; }
+
+protected:
+	unsigned int version;
+
+private:
+	// Disallow copy and assign
+	BaseECSIndex(const BaseECSIndex& other) = delete;
+	void operator=(const BaseECSIndex& other) = delete;
+
+	unsigned int componentID;
+};
+
+/**
+ * @brief Index which finds all entities with a key equal to a value, such as all entities drawn
+ *		with a texture. Updated immediately on every change.
+ */
+template<class Component, typename Key>
+class ECSHashIndex : public BaseECSIndex
+{
+public:
+	typedef Key (*KeyFunction)(const Component& component);
+
+	/** @param keyFunction Computes the key of a component, usually by returning a field. */
+	ECSHashIndex(KeyFunction keyFunction) : BaseECSIndex(Component::ID), keyFunction(keyFunction)
+	{}
+
+	/**
+	 * @brief Finds all entities with a key.
+	 * @param key The key to look up.
+	 * @return The entities, in no particular order. Valid until the index changes.
+	 */
+	const std::vector<EntityHandle>& Find(const Key& key) const
+	{
+		static const std::vector<EntityHandle> NO_ENTITIES;
+
+		const auto it = buckets.find(key);
+		return it == buckets.end() ? NO_ENTITIES : it->second;
+	}
+
+	/** @see BaseECSIndex */
+	void OnAdd(EntityHandle entity, const BaseECSComponent* component) override
+	{
+		const Key key = keyFunction(*(const Component*)component);
+		std::vector<EntityHandle>& bucket = buckets[key];
+		entries[entity] = std::make_pair(key, (unsigned int)bucket.size());
+		bucket.push_back(entity);
+		version++;
+	}
+
+	/** @see BaseECSIndex */
+	void OnRemove(EntityHandle entity) override
+	{
+		const auto it = entries.find(entity);
+		if (it == entries.end())
+		{
+			return;
+		}
+
+		// Move the last entity of the bucket into the place of the removed one
+		const auto bucketIt = buckets.find(it->second.first);
+		std::vector<EntityHandle>& bucket = bucketIt->second;
+		const unsigned int position = it->second.second;
+		if (position != bucket.size() - 1)
+		{
+			bucket[position] = bucket.back();
+			entries[bucket[position]].second = position;
+		}
+		bucket.pop_back();
+
+		if (bucket.empty())
+		{
+			buckets.erase(bucketIt);
+		}
+		entries.erase(it);
+		version++;
+	}
+
+	/** @see BaseECSIndex */
+	void OnChange(EntityHandle entity, const BaseECSComponent* component) override
+	{
+		const auto it = entries.find(entity);
+		if (it != entries.end() && it->second.first == keyFunction(*(const Component*)component))
+		{
+			return;
+		}
+
+		OnRemove(entity);
+		OnAdd(entity, component);
+	}
+
+private:
+	KeyFunction keyFunction;
+
+	// Entities of every key
+	std::unordered_map<Key, std::vector<EntityHandle>> buckets;
+	// Key of every entity, and its position in the key's bucket
+	std::unordered_map<EntityHandle, std::pair<Key, unsigned int>> entries;
+};
+
+/**
+ * @brief Index which finds all entities with a key within a range, such as all rigidbodies
+ *		heavier than a mass, as a contiguous range of a sorted array.
+ *
+ * Changes are collected and merged into the array on the next query, so many changes in a frame
+ * cost one pass over the array plus sorting the changes, rather than one insertion each.
+ */
+template<class Component, typename Key>
+class ECSSortedIndex : public BaseECSIndex
+{
+public:
+	typedef Key (*KeyFunction)(const Component& component);
+	typedef std::pair<Key, EntityHandle> Entry;
+
+	/** @param keyFunction Computes the key of a component, usually by returning a field. */
+	ECSSortedIndex(KeyFunction keyFunction) : BaseECSIndex(Component::ID),
+		keyFunction(keyFunction) {}
+
+	/**
+	 * @brief Finds all entities with a key within a range.
+	 * @param minKey Smallest key to include.
+	 * @param maxKey Largest key to include.
+	 * @return Range of entries, sorted by key. Valid until the index changes.
+	 */
+	std::pair<const Entry*, const Entry*> FindRange(const Key& minKey, const Key& maxKey)
+	{
+		Flush();
+
+		const Entry* begin = entries.data();
+		const Entry* end = begin + entries.size();
+		const Entry* first = std::lower_bound(begin, end, minKey,
+			[](const Entry& entry, const Key& key) { return entry.first < key; });
+		const Entry* last = std::upper_bound(first, end, maxKey,
+			[](const Key& key, const Entry& entry) { return key < entry.first; });
+		return std::make_pair(first, last);
+	}
+
+	/** @brief Gets all entries, sorted by key. Valid until the index changes. */
+	const std::vector<Entry>& GetEntries()
+	{
+		Flush();
+		return entries;
+	}
+
+	/** @see BaseECSIndex */
+	void OnAdd(EntityHandle entity, const BaseECSComponent* component) override
+	{
+		pending[entity] = std::make_pair(true, keyFunction(*(const Component*)component));
+		version++;
+	}
+
+	/** @see BaseECSIndex */
+	void OnRemove(EntityHandle entity) override
+	{
+		pending[entity] = std::make_pair(false, Key());
+		version++;
+	}
+
+	/** @see BaseECSIndex */
+	void OnChange(EntityHandle entity, const BaseECSComponent* component) override
+	{
+		OnAdd(entity, component);
+	}
+
+private:
+	/** @brief Merges the pending changes into the sorted array. */
+	void Flush()
+	{
+		if (pending.empty())
+		{
+			return;
+		}
+
+		removedEntries.clear();
+		addedEntries.clear();
+
+		// Compare the latest state of every changed entity against its state in the array, so
+		// an entity changed many times is only moved once
+		for (const auto& change : pending)
+		{
+			const auto it = keys.find(change.first);
+			const bool wasIndexed = it != keys.end();
+			const bool isIndexed = change.second.first;
+			const Key& key = change.second.second;
+
+			if (wasIndexed && isIndexed && it->second == key)
+			{
+				continue;
+			}
+
+			if (wasIndexed)
+			{
+				removedEntries.push_back(std::make_pair(it->second, change.first));
+			}
+
+			if (isIndexed)
+			{
+				addedEntries.push_back(std::make_pair(key, change.first));
+				keys[change.first] = key;
+			}
+			else if (wasIndexed)
+			{
+				keys.erase(it);
+			}
+		}
+		pending.clear();
+
+		// Both lists are sorted, so the removed entries are skipped in one pass
+		if (!removedEntries.empty())
+		{
+			std::sort(removedEntries.begin(), removedEntries.end());
+
+			size_t write = 0;
+			size_t removed = 0;
+			for (size_t read = 0; read < entries.size(); read++)
+			{
+				if (removed < removedEntries.size() && entries[read] == removedEntries[removed])
+				{
+					removed++;
+					continue;
+				}
+				entries[write++] = entries[read];
+			}
+			entries.resize(write);
+		}
+
+		if (!addedEntries.empty())
+		{
+			std::sort(addedEntries.begin(), addedEntries.end());
+
+			const size_t middle = entries.size();
+			entries.insert(entries.end(), addedEntries.begin(), addedEntries.end());
+			std::inplace_merge(entries.begin(), entries.begin() + middle, entries.end());
+		}
+	}
+
+	KeyFunction keyFunction;
+
+	// Entries of all entities, sorted by key, then by entity
+	std::vector<Entry> entries;
+	// Key of every entity in the entries
+	std::unordered_map<EntityHandle, Key> keys;
+	// Latest state of every entity changed since the last query; whether it has the component,
+	// and its key
+	std::unordered_map<EntityHandle, std::pair<bool, Key>> pending;
+
+	std::vector<Entry> removedEntries;
+	std::vector<Entry> addedEntries;
+};
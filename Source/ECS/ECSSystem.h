@@ -53,6 +53,29 @@ public:
 	 */
 	virtual void UpdateComponents(float deltaTime, BaseECSComponent** components) {}
 
+	/**
+	 * Called every frame for each group of entities sharing a shared component, instead of
+	 * UpdateComponents, if the system is working with a non-optional shared component type. If
+	 * the system is working with several, entities are grouped by the first one. By default,
+	 * calls UpdateComponents for each entity in the group.
+	 * 
+	 * @see ECSSharedComponent
+	 * 
+	 * @param deltaTime How much time has passed since the previous update.
+	 * @param components Components of every entity in the group, one entity after another, each
+	 *		with as many components as GetComponentTypes. The shared component is the same for
+	 *		every entity.
+	 * @param numEntities Number of entities in the group.
+	 */
+	virtual void UpdateGroup(float deltaTime, BaseECSComponent** components,
+		unsigned int numEntities)
+	{
+		for (unsigned int i = 0; i < numEntities; i++)
+		{
+			UpdateComponents(deltaTime, components + i * componentTypes.size());
+		}
+	}
+
 	/**
 	 * Gets the component types with which the system is working with.
 	 * 
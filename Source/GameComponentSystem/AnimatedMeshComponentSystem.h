@@ -0,0 +1,60 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include "ECS/ECS.h"
+#include "TransformComponent.h"
+#include "GameRenderContext.h"
+
+/** @brief Component which defines a visible, skeletally animated mesh. */
+struct AnimatedMeshComponent : public ECSComponent<AnimatedMeshComponent>
+{
+	// The mesh to use, loaded with LoadSkinnedModels
+	VertexArray* mesh = nullptr;
+
+	// The texture to apply onto the mesh
+	Texture* texture = nullptr;
+
+	// The skeleton the mesh is bound to
+	const Skeleton* skeleton = nullptr;
+
+	// The animation to play
+	const AnimationClip* clip = nullptr;
+
+	// Current playback time, in seconds
+	float time = 0.0f;
+
+	// Playback speed multiplier
+	float speed = 1.0f;
+};
+
+/**
+ * @brief System which advances the animation of every animated mesh and queues it for rendering.
+ * Poses are evaluated for all entities at once when the render context is flushed.
+ */
+class AnimatedMeshSystem : public BaseECSSystem
+{
+public:
+	/**
+	 * @param context The game render context, which bridges the gap between the high-level and
+	 * low-level rendering commands
+	 */
+	AnimatedMeshSystem(GameRenderContext& context) : BaseECSSystem(), context(context)
+	{
+		AddComponentType(TransformComponent::ID);
+		AddComponentType(AnimatedMeshComponent::ID);
+	}
+
+	virtual void UpdateComponents(float deltaTime, BaseECSComponent** components)
+	{
+		TransformComponent* transform = (TransformComponent*)components[0];
+		AnimatedMeshComponent* mesh = (AnimatedMeshComponent*)components[1];
+
+		mesh->time += deltaTime * mesh->speed;
+
+		context.RenderSkinnedMesh(*mesh->mesh, *mesh->texture, transform->transform.GetModel(),
+			*mesh->skeleton, *mesh->clip, mesh->time);
+	}
+private:
+	GameRenderContext& context;
+};
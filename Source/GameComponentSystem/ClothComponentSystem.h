@@ -0,0 +1,70 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include "ECS/ECS.h"
+#include "TransformComponent.h"
+#include "ColliderComponent.h"
+#include "GameRenderContext.h"
+#include "Physics/ClothSolver.h"
+
+/** @brief Component which makes an entity a simulated piece of cloth. */
+struct ClothComponent : public ECSComponent<ClothComponent>
+{
+	// The cloth to simulate, which owns its deforming mesh
+	Cloth* cloth = nullptr;
+
+	// The texture to apply onto the cloth
+	Texture* texture = nullptr;
+};
+
+/**
+ * @brief System which queues every cloth for simulation and draws it. The cloth solver must be
+ * updated before the render context is flushed.
+ */
+class ClothSystem : public BaseECSSystem
+{
+public:
+	ClothSystem(ClothSolver& solver, GameRenderContext& context) : BaseECSSystem(),
+		solver(solver), context(context)
+	{
+		AddComponentType(ClothComponent::ID);
+	}
+
+	virtual void UpdateComponents(float deltaTime, BaseECSComponent** components)
+	{
+		ClothComponent* cloth = (ClothComponent*)components[0];
+
+		solver.AddCloth(*cloth->cloth);
+		// The cloth is simulated in world space
+		context.RenderMesh(cloth->cloth->GetVertexArray(), *cloth->texture, glm::mat4(1.0f));
+	}
+private:
+	ClothSolver& solver;
+	GameRenderContext& context;
+};
+
+/** @brief System which registers every sphere collider with the cloth solver. */
+class ClothColliderSystem : public BaseECSSystem
+{
+public:
+	ClothColliderSystem(ClothSolver& solver) : BaseECSSystem(), solver(solver)
+	{
+		AddComponentType(TransformComponent::ID);
+		AddComponentType(ColliderComponent::ID);
+	}
+
+	virtual void UpdateComponents(float deltaTime, BaseECSComponent** components)
+	{
+		TransformComponent* transform = (TransformComponent*)components[0];
+		ColliderComponent* collider = (ColliderComponent*)components[1];
+
+		if (const SphereCollider* sphere = std::get_if<SphereCollider>(&collider->collider))
+		{
+			solver.AddSphereCollider(transform->transform.GetPosition() + sphere->center,
+				sphere->radius);
+		}
+	}
+private:
+	ClothSolver& solver;
+};
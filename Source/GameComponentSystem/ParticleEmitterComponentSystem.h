@@ -0,0 +1,44 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include "ECS/ECS.h"
+#include "TransformComponent.h"
+#include "ParticleRenderContext.h"
+
+/**
+ * @brief Component which attaches a particle emitter to an entity. The particles themselves live
+ * in the emitter's pool, not in the ECS.
+ */
+struct ParticleEmitterComponent : public ECSComponent<ParticleEmitterComponent>
+{
+	ParticleEmitter* emitter = nullptr;
+
+	// Offset of the emitter from the entity position
+	glm::vec3 offset = glm::vec3(0.0f);
+};
+
+/** @brief System which simulates and draws the particles of every emitter each update. */
+class ParticleEmitterSystem : public BaseECSSystem
+{
+public:
+	/**
+	 * @param context The particle render context, which batches the particles of all emitters
+	 */
+	ParticleEmitterSystem(ParticleRenderContext& context) : BaseECSSystem(), context(context)
+	{
+		AddComponentType(TransformComponent::ID);
+		AddComponentType(ParticleEmitterComponent::ID);
+	}
+
+	virtual void UpdateComponents(float deltaTime, BaseECSComponent** components)
+	{
+		TransformComponent* transform = (TransformComponent*)components[0];
+		ParticleEmitterComponent* emitter = (ParticleEmitterComponent*)components[1];
+
+		emitter->emitter->Update(deltaTime, transform->transform.GetPosition() + emitter->offset);
+		context.RenderParticles(*emitter->emitter);
+	}
+private:
+	ParticleRenderContext& context;
+};
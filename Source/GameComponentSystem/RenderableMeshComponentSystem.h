@@ -30,14 +30,29 @@
 #include "TransformComponent.h"
 #include "GameRenderContext.h"
 
-/** @brief Component which defines the visible mesh of an entity. */
-struct RenderableMeshComponent : public ECSComponent<RenderableMeshComponent>
+/**
+ * @brief Component which defines the visible mesh of an entity. Shared by all entities with the
+ *		same mesh, texture and bounds, so they are drawn together as one group.
+ */
+struct RenderableMeshComponent : public ECSSharedComponent<RenderableMeshComponent>
 {
 	// The mesh to use
 	VertexArray* mesh = nullptr;
 
 	// The texture to apply onto the mesh
 	Texture* texture = nullptr;
+
+	// Bounds of the mesh in model space, used to skip the mesh when it is out of view
+	AABB bounds;
+
+	// Whether the mesh is culled against the view using its bounds
+	bool isCulled = false;
+
+	bool operator==(const RenderableMeshComponent& other) const
+	{
+		return mesh == other.mesh && texture == other.texture && bounds == other.bounds &&
+			isCulled == other.isCulled;
+	}
 };
 
 /** @brief System which draws visible mesh of the entity every update. */
@@ -59,8 +74,41 @@ public:
 		TransformComponent* transform = (TransformComponent*)components[0];
 		RenderableMeshComponent* mesh = (RenderableMeshComponent*)components[1];
 
-		context.RenderMesh(*mesh->mesh, *mesh->texture, transform->transform.GetModel());
+		if (mesh->isCulled)
+		{
+			context.RenderMesh(*mesh->mesh, *mesh->texture, transform->transform, mesh->bounds);
+		}
+		else
+		{
+			context.RenderMesh(*mesh->mesh, *mesh->texture, transform->transform);
+		}
+	}
+
+	virtual void UpdateGroup(float deltaTime, BaseECSComponent** components,
+		unsigned int numEntities)
+	{
+		// Every entity in the group shares the same mesh
+		RenderableMeshComponent* mesh = (RenderableMeshComponent*)components[1];
+
+		transforms.resize(numEntities);
+		for (unsigned int i = 0; i < numEntities; i++)
+		{
+			transforms[i] = &((TransformComponent*)components[i * 2])->transform;
+		}
+
+		if (mesh->isCulled)
+		{
+			context.RenderMeshes(*mesh->mesh, *mesh->texture, transforms.data(), numEntities,
+				mesh->bounds);
+		}
+		else
+		{
+			context.RenderMeshes(*mesh->mesh, *mesh->texture, transforms.data(), numEntities);
+		}
 	}
 private:
 	GameRenderContext& context;
+
+	// Transforms of the current group, kept to avoid repeatedly allocating
+	std::vector<const Transform*> transforms;
 };
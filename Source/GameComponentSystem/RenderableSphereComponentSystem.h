@@ -0,0 +1,67 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include "ECS/ECS.h"
+#include "TransformComponent.h"
+#include "SphereImpostorRenderContext.h"
+
+/**
+ * @brief Component which makes an entity visible as a sphere impostor, centered on its position.
+ *		Shared by all entities with the same texture and radius, so they are drawn together.
+ */
+struct RenderableSphereComponent : public ECSSharedComponent<RenderableSphereComponent>
+{
+	// The texture to wrap around the sphere
+	Texture* texture = nullptr;
+
+	// Radius of the sphere before the entity's scale is applied
+	float radius = 1.0f;
+
+	bool operator==(const RenderableSphereComponent& other) const
+	{
+		return texture == other.texture && radius == other.radius;
+	}
+};
+
+/** @brief System which draws the sphere of every entity each update. */
+class RenderableSphereSystem : public BaseECSSystem
+{
+public:
+	/** @param context The render context which draws the spheres. */
+	RenderableSphereSystem(SphereImpostorRenderContext& context) : BaseECSSystem(),
+		context(context)
+	{
+		AddComponentType(TransformComponent::ID);
+		AddComponentType(RenderableSphereComponent::ID);
+	}
+
+	virtual void UpdateComponents(float deltaTime, BaseECSComponent** components)
+	{
+		TransformComponent* transform = (TransformComponent*)components[0];
+		RenderableSphereComponent* sphere = (RenderableSphereComponent*)components[1];
+
+		const Transform* transforms = &transform->transform;
+		context.RenderSpheres(*sphere->texture, &transforms, 1, sphere->radius);
+	}
+
+	virtual void UpdateGroup(float deltaTime, BaseECSComponent** components,
+		unsigned int numEntities)
+	{
+		// Every entity in the group shares the same sphere
+		RenderableSphereComponent* sphere = (RenderableSphereComponent*)components[1];
+
+		transforms.resize(numEntities);
+		for (unsigned int i = 0; i < numEntities; i++)
+		{
+			transforms[i] = &((TransformComponent*)components[i * 2])->transform;
+		}
+
+		context.RenderSpheres(*sphere->texture, transforms.data(), numEntities, sphere->radius);
+	}
+private:
+	SphereImpostorRenderContext& context;
+
+	// Transforms of the current group, kept to avoid repeatedly allocating
+	std::vector<const Transform*> transforms;
+};
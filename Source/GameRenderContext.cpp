@@ -25,30 +25,275 @@
  */
 
 #include "GameRenderContext.h"
+#include "SIMD.h"
+#include "Log.h"
+
+#include <cstring>
+
+// Size of the instance data of a skinned mesh, in vec4s: the transform matrix and the bone offset
+static const unsigned int SKINNED_INSTANCE_SIZE = 5;
+
+void GameRenderContext::RenderMesh(VertexArray& vertexArray, Texture& texture,
+	const Transform& transform, const AABB& localBounds, const glm::vec4* streams)
+{
+	const auto key = std::make_pair(&vertexArray, &texture);
+	const auto it = culledBucketIndices.emplace(key, (unsigned int)culledBucketKeys.size()).first;
+	if (it->second == culledBucketKeys.size())
+	{
+		culledBucketKeys.push_back(key);
+	}
+
+	culledTransforms.Add(transform);
+	culledBounds.push_back(localBounds);
+	culledBuckets.push_back(it->second);
+	culledStreamOffsets.push_back((unsigned int)culledStreams.size());
+	AppendStreams(culledStreams, streams, GetNumInstanceStreams(vertexArray));
+}
+
+void GameRenderContext::RenderMeshes(VertexArray& vertexArray, Texture& texture,
+	const Transform* const* transforms, size_t numTransforms, const AABB& localBounds,
+	const glm::vec4* streams)
+{
+	const auto key = std::make_pair(&vertexArray, &texture);
+	const auto it = culledBucketIndices.emplace(key, (unsigned int)culledBucketKeys.size()).first;
+	if (it->second == culledBucketKeys.size())
+	{
+		culledBucketKeys.push_back(key);
+	}
+
+	for (size_t i = 0; i < numTransforms; i++)
+	{
+		culledTransforms.Add(*transforms[i]);
+	}
+	culledBounds.insert(culledBounds.end(), numTransforms, localBounds);
+	culledBuckets.insert(culledBuckets.end(), numTransforms, it->second);
+
+	const unsigned int numStreams = GetNumInstanceStreams(vertexArray);
+	for (size_t i = 0; i < numTransforms; i++)
+	{
+		culledStreamOffsets.push_back((unsigned int)(culledStreams.size() + i * numStreams));
+	}
+	AppendStreams(culledStreams, streams, numStreams * numTransforms);
+}
 
 void GameRenderContext::Flush()
 {
+	CullMeshes();
+
+	const glm::mat4 viewProjection = camera.GetViewProjection();
+
 	Texture* currentTexture = nullptr;
 	for (auto it = meshRenderBuffer.begin(); it != meshRenderBuffer.end(); ++it)
 	{
 		VertexArray* vertexArray = it->first.first;
 		Texture* texture = it->first.second;
-		glm::mat4* transforms = it->second.data();
-		size_t numTransforms = it->second.size();
+		std::vector<glm::mat4>& models = it->second.models;
+		TransformBatch& transforms = it->second.transforms;
+		std::vector<glm::vec4>& modelStreams = it->second.modelStreams;
+		std::vector<glm::vec4>& transformStreams = it->second.transformStreams;
+
+		const size_t numModels = models.size();
+		const size_t numTransforms = numModels + transforms.GetNumTransforms();
 
 		if (numTransforms == 0) // No instances to draw
 		{
 			continue;
 		}
 
+		for (size_t i = 0; i < numModels; i++)
+		{
+			SIMD::MultiplyMat4(viewProjection, models[i], models[i]);
+		}
+
+		// Build the remaining matrices from the queued transforms, directly after the others
+		models.resize(numTransforms);
+		transforms.ComputeModels(viewProjection, models.data() + numModels);
+
 		if (texture != currentTexture)
 		{
 			shader.SetSampler("diffuse", *texture, sampler, 0);
 		}
 
-		// Index 4 is the list of instanced transform matrices
-		vertexArray->UpdateBuffer(4, transforms, numTransforms * sizeof(glm::mat4));
+		// Index 5 is the list of instanced transform matrices, each followed by its streams
+		const unsigned int numStreams = GetNumInstanceStreams(*vertexArray);
+		if (numStreams == 0)
+		{
+			vertexArray->UpdateBuffer(5, models.data(), numTransforms * sizeof(glm::mat4));
+		}
+		else
+		{
+			// Interleave the streams with the matrices, so the instances are uploaded at once
+			const size_t stride = 4 + numStreams;
+			instanceData.resize(numTransforms * stride);
+			for (size_t i = 0; i < numTransforms; i++)
+			{
+				const glm::vec4* streams = i < numModels ? &modelStreams[i * numStreams] :
+					&transformStreams[(i - numModels) * numStreams];
+				glm::vec4* instance = &instanceData[i * stride];
+				std::memcpy(instance, &models[i], sizeof(glm::mat4));
+				std::memcpy(instance + 4, streams, numStreams * sizeof(glm::vec4));
+			}
+
+			vertexArray->UpdateBuffer(5, instanceData.data(),
+				numTransforms * stride * sizeof(glm::vec4));
+			instanceData.clear();
+		}
+
 		Draw(shader, *vertexArray, drawParameters, numTransforms);
-		it->second.clear();
+		models.clear();
+		transforms.Clear();
+		modelStreams.clear();
+		transformStreams.clear();
+	}
+
+	FlushSkinnedMeshes();
+}
+
+void GameRenderContext::CullMeshes()
+{
+	const unsigned int numMeshes = culledTransforms.GetNumTransforms();
+	if (numMeshes == 0)
+	{
+		return;
 	}
+
+	// Build the model matrices and world bounds of all culled meshes in one batch
+	culledModels.resize(numMeshes);
+	culledTransforms.ComputeModels(culledModels.data());
+	AABB::TransformMany(culledBounds.data(), culledModels.data(), culledBounds.data(), numMeshes);
+
+	culler.Clear();
+	const unsigned int view = culler.AddView(Frustum(camera.GetViewProjection()));
+	for (unsigned int i = 0; i < numMeshes; i++)
+	{
+		culler.AddObject(culledBounds[i], culledBuckets[i]);
+	}
+	culler.Cull();
+
+	// Queue the visible meshes, which are already grouped by bucket
+	for (unsigned int bucket = 0; bucket < culledBucketKeys.size(); bucket++)
+	{
+		unsigned int numVisible;
+		const unsigned int* visible = culler.GetVisibleObjects(view, bucket, numVisible);
+		if (numVisible == 0)
+		{
+			continue;
+		}
+
+		MeshInstances& instances = meshRenderBuffer[culledBucketKeys[bucket]];
+		const unsigned int numStreams = GetNumInstanceStreams(*culledBucketKeys[bucket].first);
+		for (unsigned int i = 0; i < numVisible; i++)
+		{
+			instances.models.push_back(culledModels[visible[i]]);
+
+			const glm::vec4* streams = culledStreams.data() + culledStreamOffsets[visible[i]];
+			instances.modelStreams.insert(instances.modelStreams.end(), streams,
+				streams + numStreams);
+		}
+	}
+
+	culledTransforms.Clear();
+	culledBounds.clear();
+	culledBuckets.clear();
+	culledStreams.clear();
+	culledStreamOffsets.clear();
+	culledBucketKeys.clear();
+	culledBucketIndices.clear();
+}
+
+void GameRenderContext::FlushSkinnedMeshes()
+{
+	if (skinnedMeshRenderBuffer.empty())
+	{
+		return;
+	}
+
+	if (skinnedShader == nullptr)
+	{
+		Log::Error("Skinned meshes were rendered without a skinned shader");
+		skinnedMeshRenderBuffer.clear();
+		animator.Clear();
+		return;
+	}
+
+	// Evaluate the poses of all queued meshes in one batch
+	animator.Update();
+
+	const glm::mat4 viewProjection = camera.GetViewProjection();
+	// Bone matrices are uploaded together for as many instances as the bone buffer can hold,
+	// which is normally all of them, then each mesh among those instances is drawn at once
+	const size_t maxBoneMatrices = boneBuffer->GetMaxSize() / sizeof(glm::mat4);
+
+	for (auto it = skinnedMeshRenderBuffer.begin(); it != skinnedMeshRenderBuffer.end(); ++it)
+	{
+		std::vector<glm::mat4>& models = it->second.models;
+		std::vector<unsigned int>& animatorInstances = it->second.animatorInstances;
+
+		for (size_t i = 0; i < models.size(); i++)
+		{
+			const unsigned int numBones = animator.GetNumBones(animatorInstances[i]);
+			if (bonePalettes.size() + numBones > maxBoneMatrices)
+			{
+				DrawSkinnedBatches();
+			}
+
+			if (skinnedBatches.empty() || skinnedBatches.back().mesh != it->first)
+			{
+				const size_t firstInstance = skinnedInstanceData.size() / SKINNED_INSTANCE_SIZE;
+				skinnedBatches.push_back({ it->first, firstInstance, 0 });
+			}
+			skinnedBatches.back().numInstances++;
+
+			// Each instance is its transform matrix, followed by the offset of its bone matrices
+			glm::vec4* instance = &*skinnedInstanceData.insert(skinnedInstanceData.end(),
+				SKINNED_INSTANCE_SIZE, glm::vec4(0.0f));
+			SIMD::MultiplyMat4(&viewProjection[0][0], &models[i][0][0], &instance[0][0]);
+			instance[4].x = (float)bonePalettes.size();
+
+			const glm::mat4* skinningMatrices = animator.GetSkinningMatrices(animatorInstances[i]);
+			bonePalettes.insert(bonePalettes.end(), skinningMatrices, skinningMatrices + numBones);
+		}
+
+		models.clear();
+		animatorInstances.clear();
+	}
+
+	DrawSkinnedBatches();
+	animator.Clear();
+}
+
+void GameRenderContext::DrawSkinnedBatches()
+{
+	if (skinnedBatches.empty())
+	{
+		return;
+	}
+
+	// One upload for the bone matrices of every batch
+	boneBuffer->Update(bonePalettes.data(), bonePalettes.size() * sizeof(glm::mat4));
+	skinnedShader->SetTextureBuffer("bones", *boneBuffer, 1);
+
+	Texture* currentTexture = nullptr;
+	for (const SkinnedBatch& batch : skinnedBatches)
+	{
+		VertexArray* vertexArray = batch.mesh.first;
+		Texture* texture = batch.mesh.second;
+		if (texture != currentTexture)
+		{
+			skinnedShader->SetSampler("diffuse", *texture, sampler, 0);
+			currentTexture = texture;
+		}
+
+		// Index 6 is the list of instanced transform matrices of skinned meshes, each followed by
+		// its bone offset
+		const glm::vec4* instances =
+			&skinnedInstanceData[batch.firstInstance * SKINNED_INSTANCE_SIZE];
+		vertexArray->UpdateBuffer(6, instances,
+			batch.numInstances * SKINNED_INSTANCE_SIZE * sizeof(glm::vec4));
+		Draw(*skinnedShader, *vertexArray, drawParameters, batch.numInstances);
+	}
+
+	skinnedBatches.clear();
+	bonePalettes.clear();
+	skinnedInstanceData.clear();
 }
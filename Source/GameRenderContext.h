@@ -28,29 +28,226 @@
 
 #include "Rendering/RenderContext.h"
 #include "Rendering/Camera.h"
+#include "Rendering/ViewCuller.h"
+#include "Animation/Animator.h"
+#include "TransformBatch.h"
 
 #include <map>
 #include <utility>
 
+/**
+ * @brief Draws meshes, batching every instance of the same mesh and texture into one instanced
+ * draw.
+ *
+ * Besides its transform, each instance may carry extra data for the shader, such as a tint or an
+ * animation phase, so instances which vary in it still share a batch. A mesh declares these
+ * streams by the size of its instanced element (see LoadModels): the transform matrix is followed
+ * by any number of streams of 4 floats, interleaved per instance in one buffer. Shaders read the
+ * streams as vec4 attributes starting at the location after the transform, so 9 onwards for
+ * meshes laid out as by LoadModels.
+ */
 class GameRenderContext : public RenderContext
 {
 public:
+	// Floats of the transform matrix at the start of every instance
+	static constexpr unsigned int TRANSFORM_SIZE = 16;
+
 	GameRenderContext(RenderDevice& device, RenderTarget& target,
 		RenderDevice::DrawParameters& drawParameters, Shader& shader, Sampler& sampler,
 		Camera& camera) : RenderContext(device, target, drawParameters), shader(shader), 
 		sampler(sampler), camera(camera) {}
 
-	inline void RenderMesh(VertexArray& vertexArray, Texture& texture, const glm::mat4& transform)
+	/** @return Number of instance streams of a mesh, besides its transform. */
+	static inline unsigned int GetNumInstanceStreams(const VertexArray& vertexArray)
+	{
+		return vertexArray.GetInstanceSize() > TRANSFORM_SIZE ?
+			(vertexArray.GetInstanceSize() - TRANSFORM_SIZE) / 4 : 0;
+	}
+
+	/**
+	 * @brief Queues a mesh by its model matrix.
+	 * @param vertexArray Mesh to render.
+	 * @param texture Texture to apply onto the mesh.
+	 * @param transform Model matrix of the mesh.
+	 * @param streams Instance streams of the mesh, or nullptr to zero them.
+	 */
+	inline void RenderMesh(VertexArray& vertexArray, Texture& texture, const glm::mat4& transform,
+		const glm::vec4* streams = nullptr)
+	{
+		MeshInstances& instances = meshRenderBuffer[std::make_pair(&vertexArray, &texture)];
+		instances.models.push_back(transform);
+		AppendStreams(instances.modelStreams, streams, GetNumInstanceStreams(vertexArray));
+	}
+
+	/**
+	 * @brief Queues a mesh by its transform. The model matrices of all queued transforms are
+	 *		built together in one batch when flushing.
+	 * @param vertexArray Mesh to render.
+	 * @param texture Texture to apply onto the mesh.
+	 * @param transform Transform of the mesh.
+	 * @param streams Instance streams of the mesh, or nullptr to zero them.
+	 */
+	inline void RenderMesh(VertexArray& vertexArray, Texture& texture, const Transform& transform,
+		const glm::vec4* streams = nullptr)
+	{
+		MeshInstances& instances = meshRenderBuffer[std::make_pair(&vertexArray, &texture)];
+		instances.transforms.Add(transform);
+		AppendStreams(instances.transformStreams, streams, GetNumInstanceStreams(vertexArray));
+	}
+
+	/**
+	 * @brief Queues a mesh which is only drawn if its bounds are in view of the camera. All
+	 *		culled meshes are tested against the view in one batch when flushing.
+	 * @param vertexArray Mesh to render.
+	 * @param texture Texture to apply onto the mesh.
+	 * @param transform Transform of the mesh.
+	 * @param localBounds Bounds of the mesh in model space.
+	 * @param streams Instance streams of the mesh, or nullptr to zero them.
+	 */
+	void RenderMesh(VertexArray& vertexArray, Texture& texture, const Transform& transform,
+		const AABB& localBounds, const glm::vec4* streams = nullptr);
+
+	/**
+	 * @brief Queues many instances of the same mesh at once, looking up its batch only once.
+	 * @param vertexArray Mesh to render.
+	 * @param texture Texture to apply onto the mesh.
+	 * @param transforms Array of pointers to the transform of every instance.
+	 * @param numTransforms Number of instances.
+	 * @param streams Instance streams of every instance in turn, or nullptr to zero them.
+	 */
+	inline void RenderMeshes(VertexArray& vertexArray, Texture& texture,
+		const Transform* const* transforms, size_t numTransforms,
+		const glm::vec4* streams = nullptr)
+	{
+		MeshInstances& instances = meshRenderBuffer[std::make_pair(&vertexArray, &texture)];
+		for (size_t i = 0; i < numTransforms; i++)
+		{
+			instances.transforms.Add(*transforms[i]);
+		}
+		AppendStreams(instances.transformStreams, streams,
+			GetNumInstanceStreams(vertexArray) * numTransforms);
+	}
+
+	/**
+	 * @brief Queues many instances of the same mesh at once, which are only drawn if their bounds
+	 *		are in view of the camera. The culling bucket of the mesh is looked up only once.
+	 * @param vertexArray Mesh to render.
+	 * @param texture Texture to apply onto the mesh.
+	 * @param transforms Array of pointers to the transform of every instance.
+	 * @param numTransforms Number of instances.
+	 * @param localBounds Bounds of the mesh in model space.
+	 * @param streams Instance streams of every instance in turn, or nullptr to zero them.
+	 */
+	void RenderMeshes(VertexArray& vertexArray, Texture& texture,
+		const Transform* const* transforms, size_t numTransforms, const AABB& localBounds,
+		const glm::vec4* streams = nullptr);
+
+	/**
+	 * @brief Queues an animated mesh to be skinned on the GPU. Poses of all queued meshes are
+	 *		evaluated together when flushing, their bone matrices uploaded at once, and every
+	 *		instance of the same mesh and texture drawn in one instanced draw. Requires a skinned
+	 *		shader to be set.
+	 * @param vertexArray Mesh, loaded with LoadSkinnedModels.
+	 * @param texture Texture to apply onto the mesh.
+	 * @param transform Model transform.
+	 * @param skeleton Skeleton the mesh is bound to.
+	 * @param clip Animation to play.
+	 * @param time Playback time of the animation, in seconds.
+	 */
+	inline void RenderSkinnedMesh(VertexArray& vertexArray, Texture& texture,
+		const glm::mat4& transform, const Skeleton& skeleton, const AnimationClip& clip, float time)
 	{
-		meshRenderBuffer[std::make_pair(&vertexArray, &texture)].push_back(
-			camera.GetViewProjection() * transform);
+		SkinnedMeshInstances& instances =
+			skinnedMeshRenderBuffer[std::make_pair(&vertexArray, &texture)];
+		instances.models.push_back(transform);
+		instances.animatorInstances.push_back(animator.AddInstance(skeleton, clip, time));
+	}
+
+	/**
+	 * @brief Sets the shader used for skinned meshes.
+	 * @param skinnedShader Shader reading bone matrices from a "bones" samplerBuffer, starting at
+	 *		the offset in the instance stream after the transform (see LoadSkinnedModels).
+	 * @param boneBuffer Texture buffer the bone matrices of all skinned meshes are uploaded to.
+	 */
+	inline void SetSkinnedShader(Shader& skinnedShader, TextureBuffer& boneBuffer)
+	{
+		this->skinnedShader = &skinnedShader;
+		this->boneBuffer = &boneBuffer;
 	}
 
 	void Flush();
 
 private:
+	struct MeshInstances
+	{
+		// Instances queued with a model matrix
+		std::vector<glm::mat4> models;
+		// Instances queued with a transform, converted to model matrices when flushing
+		TransformBatch transforms;
+		// Instance streams of the instances above, in the same order. Empty without streams.
+		std::vector<glm::vec4> modelStreams;
+		std::vector<glm::vec4> transformStreams;
+	};
+
+	struct SkinnedMeshInstances
+	{
+		std::vector<glm::mat4> models;
+		// Animator instance of each of the instances above
+		std::vector<unsigned int> animatorInstances;
+	};
+
+	/** @brief Instances of a skinned mesh whose bone matrices are in the bone buffer. */
+	struct SkinnedBatch
+	{
+		std::pair<VertexArray*, Texture*> mesh;
+		size_t firstInstance;
+		unsigned int numInstances;
+	};
+
+	/** @brief Appends streams to a list, or zeros if there are none. */
+	static inline void AppendStreams(std::vector<glm::vec4>& list, const glm::vec4* streams,
+		size_t count)
+	{
+		if (streams)
+		{
+			list.insert(list.end(), streams, streams + count);
+		}
+		else
+		{
+			list.resize(list.size() + count, glm::vec4(0.0f));
+		}
+	}
+
+	void CullMeshes();
+	void FlushSkinnedMeshes();
+	void DrawSkinnedBatches();
+
 	Shader& shader;
 	Sampler& sampler;
 	Camera& camera;
-	std::map<std::pair<VertexArray*, Texture*>, std::vector<glm::mat4>> meshRenderBuffer;
+	std::map<std::pair<VertexArray*, Texture*>, MeshInstances> meshRenderBuffer;
+	// Staging buffer interleaving model matrices with instance streams, reused every draw
+	std::vector<glm::vec4> instanceData;
+
+	// Meshes queued with bounds; the visible ones are moved into meshRenderBuffer when flushing
+	ViewCuller culler;
+	TransformBatch culledTransforms;
+	std::vector<glm::mat4> culledModels;
+	std::vector<AABB> culledBounds;
+	std::vector<unsigned int> culledBuckets;
+	// Instance streams of all culled meshes, and where each mesh's streams start
+	std::vector<glm::vec4> culledStreams;
+	std::vector<unsigned int> culledStreamOffsets;
+	std::vector<std::pair<VertexArray*, Texture*>> culledBucketKeys;
+	std::map<std::pair<VertexArray*, Texture*>, unsigned int> culledBucketIndices;
+
+	Shader* skinnedShader = nullptr;
+	TextureBuffer* boneBuffer = nullptr;
+	Animator animator;
+	std::map<std::pair<VertexArray*, Texture*>, SkinnedMeshInstances> skinnedMeshRenderBuffer;
+	// Bone matrices of the instances of skinnedBatches, staged for one upload
+	std::vector<glm::mat4> bonePalettes;
+	// Instance data of skinnedBatches, each transform matrix followed by its bone offset
+	std::vector<glm::vec4> skinnedInstanceData;
+	std::vector<SkinnedBatch> skinnedBatches;
 };
@@ -0,0 +1,112 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#include "HLODScene.h"
+#include "Baking/HLODBuilder.h"
+#include "Log.h"
+
+#include <cstring>
+
+// Clusters switch back to their meshes only when this much closer than the switch distance, so
+// a viewer standing at the switch distance does not make them flicker between the two
+static const float SWITCH_HYSTERESIS = 0.9f;
+
+HLODScene::HLODScene(RenderDevice& device, float switchDistance) : device(device),
+	switchDistance(switchDistance), numProxiesDrawn(0) {}
+
+HLODScene::~HLODScene()
+{
+	for (Cluster& cluster : clusters)
+	{
+		delete cluster.proxy;
+		delete cluster.atlas;
+	}
+}
+
+void HLODScene::AddMesh(VertexArray& vertexArray, Texture& texture, const Transform& transform,
+	const AABB& localBounds)
+{
+	meshes.push_back({ &vertexArray, &texture, transform, localBounds, false });
+}
+
+bool HLODScene::LoadProxies(const std::string& fileName)
+{
+	std::vector<HLODCluster> loaded;
+	if (!LoadHLOD(fileName, loaded, (unsigned int)meshes.size()))
+	{
+		return false;
+	}
+
+	for (HLODCluster& loadedCluster : loaded)
+	{
+		// Meshes belong to one cluster at most; any already claimed are left in their first
+		std::vector<unsigned int> members;
+		for (unsigned int member : loadedCluster.members)
+		{
+			if (!meshes[member].isClustered)
+			{
+				meshes[member].isClustered = true;
+				members.push_back(member);
+			}
+		}
+
+		if (members.empty() || loadedCluster.atlas.empty())
+		{
+			continue;
+		}
+
+		ArrayBitmap atlas(loadedCluster.atlasWidth, loadedCluster.atlasHeight);
+		std::memcpy(atlas.GetPixelArray(), loadedCluster.atlas.data(),
+			loadedCluster.atlas.size() * sizeof(int));
+
+		Cluster cluster;
+		cluster.bounds = loadedCluster.bounds;
+		cluster.members = std::move(members);
+		cluster.proxy = new VertexArray(device, loadedCluster.proxy,
+			RenderDevice::USAGE_STATIC_DRAW);
+		// Proxies are only seen from far away, so they need mipmaps
+		cluster.atlas = new Texture(device, atlas, RenderDevice::FORMAT_RGBA, true, false);
+		cluster.isShowingProxy = false;
+		clusters.push_back(cluster);
+	}
+
+	Log::Info("Loaded {} HLOD clusters for {} meshes", clusters.size(), meshes.size());
+	return true;
+}
+
+void HLODScene::Render(GameRenderContext& context, const glm::vec3& viewPosition)
+{
+	numProxiesDrawn = 0;
+
+	for (Cluster& cluster : clusters)
+	{
+		// Distance to the closest point of the cluster, so large clusters switch late enough
+		const glm::vec3 closest = glm::clamp(viewPosition, cluster.bounds.GetMinExtents(),
+			cluster.bounds.GetMaxExtents());
+		const float distance = glm::length(viewPosition - closest);
+
+		cluster.isShowingProxy = distance > switchDistance *
+			(cluster.isShowingProxy ? SWITCH_HYSTERESIS : 1.0f);
+
+		if (cluster.isShowingProxy)
+		{
+			// Proxies are in world space
+			context.RenderMesh(*cluster.proxy, *cluster.atlas, Transform(), cluster.bounds);
+			numProxiesDrawn++;
+		}
+		else
+		{
+			for (unsigned int member : cluster.members)
+			{
+				RenderMesh(context, meshes[member]);
+			}
+		}
+	}
+
+	for (const StaticMesh& mesh : meshes)
+	{
+		if (!mesh.isClustered)
+		{
+			RenderMesh(context, mesh);
+		}
+	}
+}
@@ -0,0 +1,90 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include "GameRenderContext.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Static content drawn with hierarchical LOD. Clusters of meshes built offline by
+ * HLODBuilder are replaced by their single proxy mesh once they are far enough from the viewer,
+ * so distant content costs one draw per cluster rather than one instance per mesh.
+ *
+ * Until proxies are loaded, every mesh is drawn as it is.
+ */
+class HLODScene
+{
+public:
+	/**
+	 * @param switchDistance Distance from the viewer to the bounds of a cluster beyond which its
+	 *		proxy is drawn instead of its meshes.
+	 */
+	HLODScene(RenderDevice& device, float switchDistance);
+	virtual ~HLODScene();
+
+	/**
+	 * @brief Adds a static mesh. Meshes must be added in the order they were added to the
+	 *		HLODBuilder, and before proxies are loaded.
+	 * @param vertexArray Mesh to render.
+	 * @param texture Texture to apply onto the mesh.
+	 * @param transform Transform of the mesh.
+	 * @param localBounds Bounds of the mesh in model space, used to cull it.
+	 */
+	void AddMesh(VertexArray& vertexArray, Texture& texture, const Transform& transform,
+		const AABB& localBounds);
+
+	/**
+	 * @brief Loads the proxies written by SaveHLOD for the meshes added so far.
+	 * @param fileName Path of the file.
+	 * @return Whether the proxies were loaded.
+	 */
+	bool LoadProxies(const std::string& fileName);
+
+	/**
+	 * @brief Queues every cluster, as its proxy or as its meshes depending on its distance.
+	 * @param context Context to draw with.
+	 * @param viewPosition Position of the viewer in world space.
+	 */
+	void Render(GameRenderContext& context, const glm::vec3& viewPosition);
+
+	inline void SetSwitchDistance(float distance) { switchDistance = distance; }
+	inline float GetSwitchDistance() const { return switchDistance; }
+	inline unsigned int GetNumProxiesDrawn() const { return numProxiesDrawn; }
+
+private:
+	// Disallow copy and assign
+	HLODScene(const HLODScene& other) = delete;
+	void operator=(const HLODScene& other) = delete;
+
+	struct StaticMesh
+	{
+		VertexArray* vertexArray;
+		Texture* texture;
+		Transform transform;
+		AABB localBounds;
+		bool isClustered;
+	};
+
+	struct Cluster
+	{
+		AABB bounds;
+		std::vector<unsigned int> members;
+		VertexArray* proxy;
+		Texture* atlas;
+		bool isShowingProxy;
+	};
+
+	/** @brief Queues a mesh as it is. */
+	inline void RenderMesh(GameRenderContext& context, const StaticMesh& mesh)
+	{
+		context.RenderMesh(*mesh.vertexArray, *mesh.texture, mesh.transform, mesh.localBounds);
+	}
+
+	RenderDevice& device;
+	float switchDistance;
+	unsigned int numProxiesDrawn;
+	std::vector<StaticMesh> meshes;
+	std::vector<Cluster> clusters;
+};
@@ -107,17 +107,16 @@ void InteractionWorld::ProcessInteractions(float deltaTime)
 	// Remove entitiesToRemove and update entitiesToUpdate
 	RemoveAndUpdateEntities();
 
+	// Bring the world bounds of moved entities up to date
+	UpdateWorldBounds();
+
 	std::vector<std::pair<EntityHandle, const AABB>> data;
 	float min =  std::numeric_limits<float>::infinity();
 	float max = -std::numeric_limits<float>::infinity();
 
 	for (const EntityInternal& entity : entities)
 	{
-		// Get the collider component of the entity
-		const auto colliderComponent = ecs.GetComponent<ColliderComponent>(entity.handle);
-
-		const AABB transformedAABB = colliderComponent->aabb.Translate(
-			ecs.GetComponent<TransformComponent>(entity.handle)->transform.GetPosition());
+		const AABB& transformedAABB = entity.worldBounds;
 
 		data.emplace_back(entity.handle, transformedAABB);
 
@@ -183,6 +182,53 @@ void InteractionWorld::ProcessInteractions(float deltaTime)
 	}
 }
 
+void InteractionWorld::UpdateWorldBounds()
+{
+	transformBatch.Clear();
+	dirtyBounds.clear();
+	dirtyEntities.clear();
+
+	// Find entities whose transform or local bounds changed since the previous update
+	for (size_t i = 0; i < entities.size(); i++)
+	{
+		EntityInternal& entity = entities[i];
+		const Transform& transform =
+			ecs.GetComponent<TransformComponent>(entity.handle)->transform;
+		const AABB& localBounds = ecs.GetComponent<ColliderComponent>(entity.handle)->aabb;
+
+		if (!entity.isBoundsDirty && transform == entity.transform &&
+			localBounds.GetMinExtents() == entity.localBounds.GetMinExtents() &&
+			localBounds.GetMaxExtents() == entity.localBounds.GetMaxExtents())
+		{
+			continue;
+		}
+
+		entity.transform = transform;
+		entity.localBounds = localBounds;
+		entity.isBoundsDirty = false;
+
+		transformBatch.Add(transform);
+		dirtyBounds.push_back(localBounds);
+		dirtyEntities.push_back(i);
+	}
+
+	if (dirtyEntities.empty())
+	{
+		return;
+	}
+
+	// Build the model matrices, then the world bounds, of all moved entities in one batch
+	dirtyModels.resize(dirtyEntities.size());
+	transformBatch.ComputeModels(dirtyModels.data());
+	AABB::TransformMany(dirtyBounds.data(), dirtyModels.data(), dirtyBounds.data(),
+		dirtyBounds.size());
+
+	for (size_t i = 0; i < dirtyEntities.size(); i++)
+	{
+		entities[dirtyEntities[i]].worldBounds = dirtyBounds[i];
+	}
+}
+
 void InteractionWorld::ProcessInteraction(float deltaTime, const EntityInternal& interactor,
 	const EntityInternal& interactee, const CollisionPoints& points) const
 {
@@ -29,6 +29,7 @@
 #include "ECS/ECS.h"
 #include "GameComponentSystem/TransformComponent.h"
 #include "GameComponentSystem/ColliderComponent.h"
+#include "TransformBatch.h"
 
 #include <vector>
 
@@ -143,6 +144,13 @@ private:
 
 		// The indices of the interactions in which this entity is the interactee
 		std::vector<unsigned int> interactees;
+
+		// Transform and local bounds the world bounds were computed from
+		// The world bounds are only recomputed when either of these change
+		Transform transform;
+		AABB localBounds;
+		AABB worldBounds;
+		bool isBoundsDirty = true;
 	};
 
 	std::vector<EntityInternal> entities;
@@ -159,6 +167,18 @@ private:
 
 	std::vector<Interaction*> interactions;
 
+	// Scratch space for recomputing the world bounds of entities which moved, in one batch
+	TransformBatch transformBatch;
+	std::vector<glm::mat4> dirtyModels;
+	std::vector<AABB> dirtyBounds;
+	std::vector<size_t> dirtyEntities;
+
+	/**
+	 * Recomputes the world bounds of all entities whose transform or local bounds changed since
+	 * the previous update. Bounds account for the rotation and scale of the entity.
+	 */
+	void UpdateWorldBounds();
+
 	ECS& ecs;
 
 	void ProcessInteraction(float deltaTime, const EntityInternal& interactor,
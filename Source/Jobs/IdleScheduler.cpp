@@ -0,0 +1,186 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#include "IdleScheduler.h"
+#include "Timing.h"
+#include "Log.h"
+
+#include <algorithm>
+
+// Time kept free at the end of the frame, for presenting
+static const double SAFETY_MARGIN = 0.001;
+// Frames a task may go without running before it is reported as starved
+static const unsigned long long STARVATION_FRAMES = 300;
+// Weight of the latest measurement when lowering the estimated step time
+static const double STEP_TIME_WEIGHT = 0.25;
+
+IdleScheduler::IdleScheduler(JobSystem& jobSystem, double targetFrameTime) :
+	jobSystem(jobSystem), targetFrameTime(targetFrameTime),
+	frameStartTime(Timing::GetPreciseTime()), frameIndex(0) {}
+
+IdleScheduler::~IdleScheduler()
+{
+	jobSystem.Wait(workerSteps);
+
+	for (QueuedTask* task : tasks)
+	{
+		delete task;
+	}
+}
+
+void IdleScheduler::Add(const std::string& name, IdleTask task, int priority, TaskThread thread,
+	double estimatedStepTime)
+{
+	QueuedTask* queuedTask = new QueuedTask{ name, std::move(task), priority, thread,
+		estimatedStepTime, frameIndex, false, false };
+
+	// Insert after every task of the same or higher priority
+	const std::vector<QueuedTask*>::iterator it = std::upper_bound(tasks.begin(), tasks.end(),
+		priority, [](int value, const QueuedTask* other) { return value > other->priority; });
+	tasks.insert(it, queuedTask);
+}
+
+void IdleScheduler::BeginFrame()
+{
+	frameStartTime = Timing::GetPreciseTime();
+	frameIndex++;
+}
+
+void IdleScheduler::Update()
+{
+	const double frameEndTime = frameStartTime + targetFrameTime - SAFETY_MARGIN;
+
+	// Worker steps are only collected once all of them are done, so they are never waited on
+	const bool canStartWorkerSteps = workerSteps.IsDone();
+	if (canStartWorkerSteps)
+	{
+		CollectWorkerSteps();
+	}
+
+	// Without any workers, worker tasks run on the main thread
+	const bool hasWorkers = jobSystem.GetNumThreads() > 1;
+
+	// Start worker steps first, so they run alongside the main thread steps
+	unsigned int numFreeWorkers = canStartWorkerSteps && hasWorkers ?
+		jobSystem.GetNumThreads() - 1 : 0;
+	for (QueuedTask* task : tasks)
+	{
+		if (numFreeWorkers == 0)
+		{
+			break;
+		}
+
+		const double budget = frameEndTime - Timing::GetPreciseTime();
+		if (task->thread != THREAD_WORKER || task->stepTime > budget)
+		{
+			continue;
+		}
+
+		task->isRunning = true;
+		jobSystem.Submit([task, budget]() { RunStep(*task, budget); }, &workerSteps);
+		numFreeWorkers--;
+	}
+
+	for (size_t i = 0; i < tasks.size();)
+	{
+		QueuedTask* task = tasks[i];
+		const double budget = frameEndTime - Timing::GetPreciseTime();
+		if (budget <= 0.0)
+		{
+			break;
+		}
+
+		if ((task->thread == THREAD_WORKER && hasWorkers) || task->stepTime > budget)
+		{
+			i++;
+			continue;
+		}
+
+		RunStep(*task, budget);
+		task->lastRunFrame = frameIndex;
+
+		if (task->isComplete)
+		{
+			delete task;
+			tasks.erase(tasks.begin() + i);
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	ReportStarvedTasks();
+}
+
+unsigned int IdleScheduler::GetNumStarvedTasks() const
+{
+	unsigned int numStarved = 0;
+	for (const QueuedTask* task : tasks)
+	{
+		if (!task->isRunning && frameIndex - task->lastRunFrame >= STARVATION_FRAMES)
+		{
+			numStarved++;
+		}
+	}
+
+	return numStarved;
+}
+
+void IdleScheduler::RunStep(QueuedTask& task, double budget)
+{
+	const double startTime = Timing::GetPreciseTime();
+	task.isComplete = task.task(budget);
+	const double duration = Timing::GetPreciseTime() - startTime;
+
+	// A step which overran its budget cannot be interrupted, so it needs at least that long.
+	// Steps which stayed within their budget may have been cut short, so they can only lower
+	// the estimate.
+	if (duration > budget)
+	{
+		task.stepTime = duration;
+	}
+	else if (duration < task.stepTime)
+	{
+		task.stepTime += (duration - task.stepTime) * STEP_TIME_WEIGHT;
+	}
+}
+
+void IdleScheduler::CollectWorkerSteps()
+{
+	for (size_t i = 0; i < tasks.size();)
+	{
+		QueuedTask* task = tasks[i];
+		if (!task->isRunning)
+		{
+			i++;
+			continue;
+		}
+
+		task->isRunning = false;
+		task->lastRunFrame = frameIndex;
+
+		if (task->isComplete)
+		{
+			delete task;
+			tasks.erase(tasks.begin() + i);
+		}
+		else
+		{
+			i++;
+		}
+	}
+}
+
+void IdleScheduler::ReportStarvedTasks() const
+{
+	for (const QueuedTask* task : tasks)
+	{
+		const unsigned long long numWaitingFrames = frameIndex - task->lastRunFrame;
+		if (!task->isRunning && numWaitingFrames > 0 &&
+			numWaitingFrames % STARVATION_FRAMES == 0)
+		{
+			Log::Warning("Idle task '{}' has not run for {} frames; its steps take {} ms",
+				task->name, numWaitingFrames, task->stepTime * 1000.0);
+		}
+	}
+}
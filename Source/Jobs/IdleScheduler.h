@@ -0,0 +1,113 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include "JobSystem.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Runs background work, such as uploads and compaction, in the time left over at the end
+ * of each frame, so it never pushes a frame past its target time.
+ *
+ * Work is split into steps, each given the time left in the frame and expected to stay within
+ * it. Tasks run in order of priority. A step which overruns its budget is assumed to be
+ * uninterruptible, and the task only starts another once that much time is left. Worker thread
+ * steps may finish in a later frame, and are collected without waiting. Tasks which have not
+ * been able to run for a long time are reported as starved.
+ */
+class IdleScheduler
+{
+public:
+	/**
+	 * @brief Step of background work.
+	 * @param budget Seconds the step may take.
+	 * @return true once the work is complete, false to be called again in a later frame.
+	 */
+	typedef std::function<bool(double budget)> IdleTask;
+
+	/** @brief Thread a task runs on. Tasks doing rendering work must run on the main thread. */
+	enum TaskThread
+	{
+		THREAD_MAIN,
+		THREAD_WORKER
+	};
+
+	/**
+	 * @param jobSystem Job system to run worker thread tasks on.
+	 * @param targetFrameTime Time each frame should take, in seconds.
+	 */
+	IdleScheduler(JobSystem& jobSystem, double targetFrameTime = 1.0 / 60.0);
+
+	/** @brief Waits for running worker steps, then destroys all unfinished tasks. */
+	virtual ~IdleScheduler();
+
+	/**
+	 * @brief Queues background work.
+	 * @param name Name of the task, used when reporting starvation.
+	 * @param task Function called for each step of the work.
+	 * @param priority Tasks with a higher priority run first.
+	 * @param thread Thread the task runs on.
+	 * @param estimatedStepTime Expected duration of a step in seconds, until one is measured.
+	 */
+	void Add(const std::string& name, IdleTask task, int priority = 0,
+		TaskThread thread = THREAD_MAIN, double estimatedStepTime = 0.0005);
+
+	/** @brief Marks the start of a frame. Should be called at the top of the main loop. */
+	void BeginFrame();
+
+	/**
+	 * @brief Runs task steps in the time left before the target frame time. Should be called
+	 *		once all of the frame's work is done, before presenting.
+	 */
+	void Update();
+
+	inline void SetTargetFrameTime(double time) { targetFrameTime = time; }
+	inline double GetTargetFrameTime() const { return targetFrameTime; }
+
+	/** @return Number of queued tasks, including those running on a worker. */
+	inline size_t GetNumTasks() const { return tasks.size(); }
+
+	/** @return Number of tasks which have not been able to run for too long. */
+	unsigned int GetNumStarvedTasks() const;
+
+private:
+	// Disallow copy and assign
+	IdleScheduler(const IdleScheduler& other) = delete;
+	void operator=(const IdleScheduler& other) = delete;
+
+	struct QueuedTask
+	{
+		std::string name;
+		IdleTask task;
+		int priority;
+		TaskThread thread;
+		// Shortest time a step needs, in seconds
+		double stepTime;
+		// Frame in which the task last finished a step, or was queued
+		unsigned long long lastRunFrame;
+		// Whether a step is running on a worker
+		bool isRunning;
+		bool isComplete;
+	};
+
+	static void RunStep(QueuedTask& task, double budget);
+
+	/** @brief Removes completed worker tasks, once all worker steps have finished. */
+	void CollectWorkerSteps();
+
+	/** @brief Reports tasks which have waited a multiple of the starvation limit. */
+	void ReportStarvedTasks() const;
+
+	JobSystem& jobSystem;
+	JobCounter workerSteps;
+
+	// Ordered by decreasing priority, then by when they were added
+	std::vector<QueuedTask*> tasks;
+
+	double targetFrameTime;
+	double frameStartTime;
+	unsigned long long frameIndex;
+};
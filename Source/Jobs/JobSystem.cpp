@@ -0,0 +1,135 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#include "JobSystem.h"
+
+JobSystem::JobSystem(unsigned int numWorkers) : isRunning(true)
+{
+	if (numWorkers == 0)
+	{
+		const unsigned int numHardwareThreads = std::thread::hardware_concurrency();
+		numWorkers = numHardwareThreads > 1 ? numHardwareThreads - 1 : 1;
+	}
+
+	for (unsigned int i = 0; i < numWorkers; i++)
+	{
+		workers.emplace_back(&JobSystem::WorkerLoop, this);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		isRunning = false;
+	}
+	condition.notify_all();
+
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+}
+
+void JobSystem::Submit(Job job, JobCounter* counter)
+{
+	if (counter)
+	{
+		counter->count.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queue.push_back({ std::move(job), counter });
+	}
+	condition.notify_one();
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+	while (!counter.IsDone())
+	{
+		if (!TryRunJob())
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+void JobSystem::ParallelFor(unsigned int count, unsigned int batchSize,
+	const std::function<void(unsigned int, unsigned int)>& function)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	batchSize = batchSize > 0 ? batchSize : 1;
+
+	// Run everything inline if there is only one batch; no need to involve the workers
+	if (count <= batchSize)
+	{
+		function(0, count);
+		return;
+	}
+
+	JobCounter counter;
+	for (unsigned int begin = batchSize; begin < count; begin += batchSize)
+	{
+		const unsigned int end = begin + batchSize < count ? begin + batchSize : count;
+		Submit([&function, begin, end]() { function(begin, end); }, &counter);
+	}
+
+	// The calling thread takes the first batch
+	function(0, batchSize);
+	Wait(counter);
+}
+
+void JobSystem::WorkerLoop()
+{
+	while (true)
+	{
+		QueuedJob queuedJob;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [this]() { return !isRunning || !queue.empty(); });
+
+			if (queue.empty()) // Only possible when shutting down
+			{
+				return;
+			}
+
+			queuedJob = std::move(queue.front());
+			queue.pop_front();
+		}
+
+		RunJob(queuedJob);
+	}
+}
+
+bool JobSystem::TryRunJob()
+{
+	QueuedJob queuedJob;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (queue.empty())
+		{
+			return false;
+		}
+
+		queuedJob = std::move(queue.front());
+		queue.pop_front();
+	}
+
+	RunJob(queuedJob);
+	return true;
+}
+
+void JobSystem::RunJob(QueuedJob& queuedJob)
+{
+	queuedJob.job();
+
+	if (queuedJob.counter)
+	{
+		queuedJob.counter->count.fetch_sub(1, std::memory_order_release);
+	}
+}
@@ -0,0 +1,86 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** @brief Tracks the number of unfinished jobs in a group. */
+struct JobCounter
+{
+	std::atomic<unsigned int> count{ 0 };
+
+	inline bool IsDone() const { return count.load(std::memory_order_acquire) == 0; }
+};
+
+/**
+ * @brief Pool of worker threads which execute jobs from a shared queue. Threads waiting on a job
+ * counter help execute queued jobs rather than sleeping, so waiting from within a job is safe.
+ */
+class JobSystem
+{
+public:
+	typedef std::function<void()> Job;
+
+	/**
+	 * @param numWorkers Number of worker threads to create. If 0, one less than the number of
+	 *		hardware threads is used, leaving a thread for the caller.
+	 */
+	explicit JobSystem(unsigned int numWorkers = 0);
+	virtual ~JobSystem();
+
+	/**
+	 * @brief Queues a job for execution on a worker thread.
+	 * @param job Job to execute.
+	 * @param counter Optional counter, incremented now and decremented once the job completes.
+	 */
+	void Submit(Job job, JobCounter* counter = nullptr);
+
+	/** @brief Executes queued jobs on the calling thread until the counter reaches zero. */
+	void Wait(JobCounter& counter);
+
+	/**
+	 * @brief Splits a range into batches, and executes them in parallel. Blocks until all batches
+	 *		have completed; the calling thread takes part in the work.
+	 * @param count Number of items in the range.
+	 * @param batchSize Maximum number of items per batch.
+	 * @param function Function called for each batch with the range [begin, end).
+	 */
+	void ParallelFor(unsigned int count, unsigned int batchSize,
+		const std::function<void(unsigned int, unsigned int)>& function);
+
+	/** @return Number of threads doing work, including the calling thread. */
+	inline unsigned int GetNumThreads() const { return (unsigned int)workers.size() + 1; }
+
+private:
+	// Disallow copy and assign
+	JobSystem(const JobSystem& other) = delete;
+	void operator=(const JobSystem& other) = delete;
+
+	struct QueuedJob
+	{
+		Job job;
+		JobCounter* counter;
+	};
+
+	void WorkerLoop();
+
+	/**
+	 * @brief Executes a single queued job on the calling thread, if there is one.
+	 * @return true if a job was executed.
+	 */
+	bool TryRunJob();
+
+	static void RunJob(QueuedJob& queuedJob);
+
+	std::vector<std::thread> workers;
+	std::deque<QueuedJob> queue;
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool isRunning;
+};
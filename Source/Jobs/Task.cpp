@@ -0,0 +1,169 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#include "Task.h"
+
+#include <algorithm>
+#include <mutex>
+#include <new>
+
+// Task frames are pooled in size classes of FRAME_SIZE_STEP bytes; larger frames use the heap
+static const size_t FRAME_SIZE_STEP = 64;
+static const size_t NUM_FRAME_SIZE_CLASSES = 32;
+
+/** @brief Freed task frames of every size class, kept for reuse. */
+struct TaskFramePool
+{
+	std::mutex mutex;
+	std::vector<void*> frames[NUM_FRAME_SIZE_CLASSES];
+
+	~TaskFramePool()
+	{
+		for (std::vector<void*>& sizeClassFrames : frames)
+		{
+			for (void* frame : sizeClassFrames)
+			{
+				::operator delete(frame);
+			}
+		}
+	}
+};
+
+static TaskFramePool framePool;
+
+void* Task::promise_type::operator new(size_t size)
+{
+	const size_t sizeClass = (size - 1) / FRAME_SIZE_STEP;
+	if (sizeClass >= NUM_FRAME_SIZE_CLASSES)
+	{
+		return ::operator new(size);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(framePool.mutex);
+		std::vector<void*>& frames = framePool.frames[sizeClass];
+		if (!frames.empty())
+		{
+			void* frame = frames.back();
+			frames.pop_back();
+			return frame;
+		}
+	}
+
+	return ::operator new((sizeClass + 1) * FRAME_SIZE_STEP);
+}
+
+void Task::promise_type::operator delete(void* frame, size_t size)
+{
+	const size_t sizeClass = (size - 1) / FRAME_SIZE_STEP;
+	if (sizeClass >= NUM_FRAME_SIZE_CLASSES)
+	{
+		::operator delete(frame);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(framePool.mutex);
+	framePool.frames[sizeClass].push_back(frame);
+}
+
+TaskScheduler::~TaskScheduler()
+{
+	// Jobs may still be writing into the frames of the tasks waiting on them
+	for (JobWait& jobWait : jobWaits)
+	{
+		jobSystem.Wait(*jobWait.counter);
+		delete jobWait.counter;
+	}
+
+	for (Task::Handle handle : tasks)
+	{
+		handle.destroy();
+	}
+}
+
+void TaskScheduler::Start(Task task)
+{
+	Task::Handle handle = task.Release();
+	if (!handle)
+	{
+		return;
+	}
+
+	handle.promise().scheduler = this;
+	handle.resume();
+
+	if (handle.done())
+	{
+		handle.destroy();
+	}
+	else
+	{
+		tasks.push_back(handle);
+	}
+}
+
+void TaskScheduler::Update(float deltaTime)
+{
+	time += deltaTime;
+
+	// Collect every task which can be resumed before resuming any, so tasks which wait again
+	// are not resumed twice in the same update
+	resumed.swap(nextFrame);
+
+	while (!timers.empty() && timers.top().first <= time)
+	{
+		resumed.push_back(timers.top().second);
+		timers.pop();
+	}
+
+	for (size_t i = 0; i < jobWaits.size();)
+	{
+		if (jobWaits[i].counter->IsDone())
+		{
+			resumed.push_back(jobWaits[i].handle);
+			delete jobWaits[i].counter;
+			jobWaits[i] = jobWaits.back();
+			jobWaits.pop_back();
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	if (resumed.empty())
+	{
+		return;
+	}
+
+	for (std::coroutine_handle<> handle : resumed)
+	{
+		handle.resume();
+	}
+	resumed.clear();
+
+	// Destroy the finished tasks
+	tasks.erase(std::remove_if(tasks.begin(), tasks.end(), [](Task::Handle handle)
+	{
+		if (handle.done())
+		{
+			handle.destroy();
+			return true;
+		}
+		return false;
+	}), tasks.end());
+}
+
+void TaskScheduler::ResumeAfterJobs(std::coroutine_handle<> handle,
+	std::vector<JobSystem::Job> jobs)
+{
+	JobWait jobWait;
+	jobWait.counter = new JobCounter();
+	jobWait.handle = handle;
+
+	for (JobSystem::Job& job : jobs)
+	{
+		jobSystem.Submit(std::move(job), jobWait.counter);
+	}
+
+	jobWaits.push_back(jobWait);
+}
@@ -0,0 +1,243 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include "JobSystem.h"
+#include "Log.h"
+
+#include <coroutine>
+#include <exception>
+#include <queue>
+#include <utility>
+#include <vector>
+
+class TaskScheduler;
+
+/**
+ * @brief Coroutine which can wait for frames, time, or jobs without blocking the frame, written
+ *		as straight-line code instead of a state machine in a system.
+ *
+ * A task does not run until it is started by a TaskScheduler, which then owns it. Tasks can
+ * co_await other tasks, which run on the same scheduler. Frames of tasks are allocated from a
+ * pool, so starting a task does not allocate once the pool is warm.
+ */
+class Task
+{
+public:
+	struct promise_type
+	{
+		TaskScheduler* scheduler = nullptr;
+		// Task awaiting this one, resumed once this one finishes
+		std::coroutine_handle<> continuation;
+
+		inline Task get_return_object()
+		{
+			return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+		}
+
+		inline std::suspend_always initial_suspend() noexcept { return {}; }
+
+		struct FinalAwaiter
+		{
+			inline bool await_ready() noexcept { return false; }
+			inline void await_resume() noexcept {}
+
+			inline std::coroutine_handle<> await_suspend(
+				std::coroutine_handle<promise_type> handle) noexcept
+			{
+				const std::coroutine_handle<> continuation = handle.promise().continuation;
+				return continuation ? continuation : std::noop_coroutine();
+			}
+		};
+
+		inline FinalAwaiter final_suspend() noexcept { return {}; }
+		inline void return_void() {}
+		inline void unhandled_exception()
+		{
+			Log::Error("Unhandled exception in a task");
+			// Terminating skips the log writer, so write out everything logged so far
+			Log::Flush();
+			std::terminate();
+		}
+
+		static void* operator new(size_t size);
+		static void operator delete(void* frame, size_t size);
+	};
+
+	typedef std::coroutine_handle<promise_type> Handle;
+
+	Task() {}
+	Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+
+	Task& operator=(Task&& other) noexcept
+	{
+		if (handle)
+		{
+			handle.destroy();
+		}
+		handle = std::exchange(other.handle, nullptr);
+		return *this;
+	}
+
+	virtual ~Task()
+	{
+		if (handle)
+		{
+			handle.destroy();
+		}
+	}
+
+	/** @brief Runs another task to completion, on the same scheduler as the awaiting task. */
+	inline bool await_ready() const { return !handle || handle.done(); }
+	inline void await_resume() {}
+
+	inline std::coroutine_handle<> await_suspend(Handle awaitingHandle)
+	{
+		handle.promise().scheduler = awaitingHandle.promise().scheduler;
+		handle.promise().continuation = awaitingHandle;
+		return handle;
+	}
+
+	/** @brief Gives up ownership of the coroutine. */
+	inline Handle Release() { return std::exchange(handle, nullptr); }
+
+private:
+	// Disallow copy and assign
+	Task(const Task& other) = delete;
+	void operator=(const Task& other) = delete;
+
+	explicit Task(Handle handle) : handle(handle) {}
+
+	Handle handle;
+};
+
+/**
+ * @brief Runs tasks, and resumes them at a single point in the frame, once what they are waiting
+ *		for has completed.
+ *
+ * Tasks only ever run on the thread calling Start and Update, so they can safely touch the game
+ * state and the render device. Work on other threads is done by awaiting jobs.
+ */
+class TaskScheduler
+{
+public:
+	/** @param jobSystem Job system which awaited jobs are executed on. */
+	explicit TaskScheduler(JobSystem& jobSystem) : jobSystem(jobSystem), time(0.0f) {}
+
+	/** @brief Waits for awaited jobs, then destroys all unfinished tasks. */
+	virtual ~TaskScheduler();
+
+	/**
+	 * @brief Starts a task, running it until it first waits.
+	 * @param task Task to start; the scheduler takes ownership of it.
+	 */
+	void Start(Task task);
+
+	/**
+	 * @brief Resumes all tasks whose waits have completed. Should be called once every frame.
+	 * @param deltaTime How much time has passed since the previous update.
+	 */
+	void Update(float deltaTime);
+
+	/**
+	 * @brief Resumes a task on the next update.
+	 * @param handle Task to resume.
+	 */
+	inline void ResumeNextFrame(std::coroutine_handle<> handle) { nextFrame.push_back(handle); }
+
+	/**
+	 * @brief Resumes a task once a number of seconds have passed.
+	 * @param handle Task to resume.
+	 * @param seconds Time to wait.
+	 */
+	inline void ResumeAfter(std::coroutine_handle<> handle, float seconds)
+	{
+		timers.push(std::make_pair(time + seconds, handle));
+	}
+
+	/**
+	 * @brief Executes jobs on the job system, and resumes a task on the first update after all of
+	 *		them have completed.
+	 * @param handle Task to resume.
+	 * @param jobs Jobs to execute in parallel.
+	 */
+	void ResumeAfterJobs(std::coroutine_handle<> handle, std::vector<JobSystem::Job> jobs);
+
+	inline JobSystem& GetJobSystem() { return jobSystem; }
+	inline unsigned int GetNumTasks() const { return (unsigned int)tasks.size(); }
+
+private:
+	// Disallow copy and assign
+	TaskScheduler(const TaskScheduler& other) = delete;
+	void operator=(const TaskScheduler& other) = delete;
+
+	struct JobWait
+	{
+		JobCounter* counter;
+		std::coroutine_handle<> handle;
+	};
+
+	typedef std::pair<float, std::coroutine_handle<>> Timer;
+
+	struct TimerCompare
+	{
+		inline bool operator()(const Timer& a, const Timer& b) const { return a.first > b.first; }
+	};
+
+	JobSystem& jobSystem;
+	float time;
+
+	// Started tasks which have not finished
+	std::vector<Task::Handle> tasks;
+
+	std::vector<std::coroutine_handle<>> nextFrame;
+	std::priority_queue<Timer, std::vector<Timer>, TimerCompare> timers;
+	std::vector<JobWait> jobWaits;
+
+	// Tasks resumed in the current update
+	std::vector<std::coroutine_handle<>> resumed;
+};
+
+/** @brief Awaitable which resumes the task on the next frame. */
+struct NextFrame
+{
+	inline bool await_ready() const { return false; }
+	inline void await_resume() {}
+
+	inline void await_suspend(Task::Handle handle)
+	{
+		handle.promise().scheduler->ResumeNextFrame(handle);
+	}
+};
+
+/** @brief Awaitable which resumes the task after a number of seconds of frame time. */
+struct Seconds
+{
+	explicit Seconds(float seconds) : seconds(seconds) {}
+
+	inline bool await_ready() const { return seconds <= 0.0f; }
+	inline void await_resume() {}
+
+	inline void await_suspend(Task::Handle handle)
+	{
+		handle.promise().scheduler->ResumeAfter(handle, seconds);
+	}
+
+	float seconds;
+};
+
+/** @brief Awaitable which executes jobs in parallel, and resumes the task once all are done. */
+struct Jobs
+{
+	explicit Jobs(std::vector<JobSystem::Job> jobs) : jobs(std::move(jobs)) {}
+
+	inline bool await_ready() const { return jobs.empty(); }
+	inline void await_resume() {}
+
+	inline void await_suspend(Task::Handle handle)
+	{
+		handle.promise().scheduler->ResumeAfterJobs(handle, std::move(jobs));
+	}
+
+	std::vector<JobSystem::Job> jobs;
+};
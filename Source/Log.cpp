@@ -0,0 +1,420 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#include "Log.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Size of the ring buffer of every logging thread; must be a power of two
+static const size_t RING_BUFFER_SIZE = 1 << 16;
+// How often the background thread checks for new records
+static const std::chrono::milliseconds POLL_INTERVAL(5);
+// Repeats of the same message allowed per second before they are suppressed
+static const unsigned int MAX_MESSAGES_PER_SECOND = 10;
+
+/**
+ * @brief Ring buffer with a single producer, the logging thread, and a single consumer, the
+ *		background thread.
+ */
+struct LogRingBuffer
+{
+	unsigned char data[RING_BUFFER_SIZE];
+	// Total bytes written and read; wrapped into the buffer with a mask
+	std::atomic<size_t> writePosition{ 0 };
+	std::atomic<size_t> readPosition{ 0 };
+	// Records dropped because the buffer was full
+	std::atomic<unsigned int> numDropped{ 0 };
+	// Cleared once the thread exits; the buffer is freed after it is drained
+	std::atomic<bool> isThreadAlive{ true };
+
+	inline void Write(size_t position, const void* source, size_t size)
+	{
+		const size_t offset = position & (RING_BUFFER_SIZE - 1);
+		const size_t firstPart = std::min(size, RING_BUFFER_SIZE - offset);
+		std::memcpy(data + offset, source, firstPart);
+		std::memcpy(data, (const unsigned char*)source + firstPart, size - firstPart);
+	}
+
+	inline void Read(size_t position, void* destination, size_t size) const
+	{
+		const size_t offset = position & (RING_BUFFER_SIZE - 1);
+		const size_t firstPart = std::min(size, RING_BUFFER_SIZE - offset);
+		std::memcpy(destination, data + offset, firstPart);
+		std::memcpy((unsigned char*)destination + firstPart, data, size - firstPart);
+	}
+};
+
+/** @brief Owns the ring buffers, and the background thread which writes their records. */
+class LogWriter
+{
+public:
+	LogWriter() : output(stderr), isRunning(true), numFlushRequests(0), numFlushes(0)
+	{
+		thread = std::thread(&LogWriter::Run, this);
+	}
+
+	~LogWriter()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			isRunning = false;
+		}
+		condition.notify_all();
+		thread.join();
+
+		for (LogRingBuffer* buffer : buffers)
+		{
+			delete buffer;
+		}
+
+		if (output != stderr)
+		{
+			std::fclose(output);
+		}
+	}
+
+	LogRingBuffer* CreateBuffer()
+	{
+		LogRingBuffer* buffer = new LogRingBuffer();
+		std::lock_guard<std::mutex> lock(mutex);
+		buffers.push_back(buffer);
+		return buffer;
+	}
+
+	bool SetOutputFile(const std::string& fileName)
+	{
+		FILE* file = std::fopen(fileName.c_str(), "w");
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (output != stderr)
+		{
+			std::fclose(output);
+		}
+		output = file;
+		return true;
+	}
+
+	void Flush()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		const unsigned long long request = ++numFlushRequests;
+		condition.notify_all();
+		flushedCondition.wait(lock, [&]() { return numFlushes >= request || !isRunning; });
+	}
+
+private:
+	/** @brief Rate limiting state of a message. */
+	struct MessageState
+	{
+		const char* format = nullptr;
+		std::chrono::steady_clock::time_point windowStart;
+		unsigned int numMessages = 0;
+		unsigned int numSuppressed = 0;
+	};
+
+	void Run()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true)
+		{
+			const unsigned long long request = numFlushRequests;
+			const bool wasRunning = isRunning;
+
+			// Buffers are only added under the lock, and removed by this thread. Suppressed counts
+			// are written out on flushes and on the final drain, which may precede a crash or exit.
+			WriteRecords(request != numFlushes || !wasRunning);
+
+			numFlushes = request;
+			flushedCondition.notify_all();
+
+			if (!wasRunning)
+			{
+				break;
+			}
+
+			condition.wait_for(lock, POLL_INTERVAL, [&]()
+			{
+				return numFlushRequests != request || !isRunning;
+			});
+		}
+	}
+
+	/**
+	 * @param reportAllSuppressed Whether to write the counts of suppressed messages whose
+	 *		window has not yet ended, rather than waiting for it to end.
+	 */
+	void WriteRecords(bool reportAllSuppressed)
+	{
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		text.clear();
+
+		for (size_t i = 0; i < buffers.size();)
+		{
+			LogRingBuffer* buffer = buffers[i];
+
+			// Read the thread state first, so no record written before the thread exited is missed
+			const bool isThreadAlive = buffer->isThreadAlive.load(std::memory_order_acquire);
+			const size_t writePosition = buffer->writePosition.load(std::memory_order_acquire);
+			size_t readPosition = buffer->readPosition.load(std::memory_order_relaxed);
+
+			while (readPosition != writePosition)
+			{
+				unsigned int size;
+				buffer->Read(readPosition, &size, sizeof(size));
+				buffer->Read(readPosition, record, size);
+				readPosition += size;
+				FormatRecord(record, size, now);
+			}
+			buffer->readPosition.store(readPosition, std::memory_order_release);
+
+			const unsigned int numDropped = buffer->numDropped.exchange(0);
+			if (numDropped > 0)
+			{
+				text += "Warning: " + std::to_string(numDropped) +
+					" log messages were dropped; the log buffer was full\n";
+			}
+
+			if (!isThreadAlive)
+			{
+				delete buffer;
+				buffers[i] = buffers.back();
+				buffers.pop_back();
+			}
+			else
+			{
+				i++;
+			}
+		}
+
+		// Report how many messages were suppressed once their window has ended, and forget
+		// messages whose window has ended, so that distinct messages do not accumulate
+		for (auto it = messages.begin(); it != messages.end();)
+		{
+			MessageState& state = it->second;
+			const bool hasWindowEnded = now - state.windowStart >= std::chrono::seconds(1);
+			if (hasWindowEnded || reportAllSuppressed)
+			{
+				WriteSuppressed(state);
+			}
+			it = hasWindowEnded ? messages.erase(it) : std::next(it);
+		}
+
+		// One write per batch of records, on this thread only
+		if (!text.empty())
+		{
+			std::fwrite(text.data(), 1, text.size(), output);
+			std::fflush(output);
+		}
+	}
+
+	void WriteSuppressed(MessageState& state)
+	{
+		if (state.numSuppressed > 0)
+		{
+			text += "Warning: " + std::to_string(state.numSuppressed) +
+				" repeats of a message like \"" + std::string(state.format) +
+				"\" were suppressed\n";
+			state.numSuppressed = 0;
+		}
+	}
+
+	void FormatRecord(const unsigned char* data, size_t size,
+		std::chrono::steady_clock::time_point now)
+	{
+		const unsigned char* end = data + size;
+		data += sizeof(unsigned int);
+
+		// Only repeats of the same message are limited: the same level, format and arguments
+		const size_t key = std::hash<std::string_view>()(
+			std::string_view((const char*)data, end - data));
+
+		Log::Level level;
+		const char* format;
+		std::memcpy(&level, data, sizeof(level));
+		data += sizeof(level);
+		std::memcpy(&format, data, sizeof(format));
+		data += sizeof(format);
+
+		MessageState& state = messages[key];
+		if (state.format == nullptr || now - state.windowStart >= std::chrono::seconds(1))
+		{
+			WriteSuppressed(state);
+			state.format = format;
+			state.windowStart = now;
+			state.numMessages = 0;
+		}
+
+		if (++state.numMessages > MAX_MESSAGES_PER_SECOND)
+		{
+			state.numSuppressed++;
+			return;
+		}
+
+		if (level == Log::LEVEL_WARNING)
+		{
+			text += "Warning: ";
+		}
+		else if (level == Log::LEVEL_ERROR)
+		{
+			text += "Error: ";
+		}
+
+		for (const char* c = format; *c != '\0'; c++)
+		{
+			if (c[0] != '{' || c[1] != '}')
+			{
+				text += *c;
+				continue;
+			}
+
+			c++;
+			if (data < end)
+			{
+				FormatArgument(data);
+			}
+		}
+
+		text += '\n';
+	}
+
+	void FormatArgument(const unsigned char*& data)
+	{
+		const unsigned char type = *data++;
+		char number[32];
+
+		switch (type)
+		{
+		case Log::ARGUMENT_SIGNED:
+		{
+			long long value;
+			std::memcpy(&value, data, sizeof(value));
+			data += sizeof(value);
+			text += std::to_string(value);
+			break;
+		}
+		case Log::ARGUMENT_UNSIGNED:
+		{
+			unsigned long long value;
+			std::memcpy(&value, data, sizeof(value));
+			data += sizeof(value);
+			text += std::to_string(value);
+			break;
+		}
+		case Log::ARGUMENT_FLOAT:
+		{
+			double value;
+			std::memcpy(&value, data, sizeof(value));
+			data += sizeof(value);
+			std::snprintf(number, sizeof(number), "%g", value);
+			text += number;
+			break;
+		}
+		case Log::ARGUMENT_BOOL:
+			text += *data++ != 0 ? "true" : "false";
+			break;
+		case Log::ARGUMENT_CHAR:
+			text += (char)*data++;
+			break;
+		case Log::ARGUMENT_STRING:
+		{
+			unsigned short length;
+			std::memcpy(&length, data, sizeof(length));
+			data += sizeof(length);
+			text.append((const char*)data, length);
+			data += length;
+			break;
+		}
+		default:
+		{
+			const void* value;
+			std::memcpy(&value, data, sizeof(value));
+			data += sizeof(value);
+			std::snprintf(number, sizeof(number), "%p", value);
+			text += number;
+			break;
+		}
+		}
+	}
+
+	FILE* output;
+	std::vector<LogRingBuffer*> buffers;
+	// Messages are identified by a hash of their record, as formats are compared by address
+	std::unordered_map<size_t, MessageState> messages;
+
+	// Used by the background thread only
+	unsigned char record[RING_BUFFER_SIZE];
+	std::string text;
+
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::condition_variable flushedCondition;
+	bool isRunning;
+	unsigned long long numFlushRequests;
+	unsigned long long numFlushes;
+};
+
+static LogWriter& GetLogWriter()
+{
+	static LogWriter writer;
+	return writer;
+}
+
+/** @brief Ring buffer of the current thread, released when the thread exits. */
+struct ThreadLogBuffer
+{
+	LogRingBuffer* buffer = nullptr;
+
+	~ThreadLogBuffer()
+	{
+		if (buffer != nullptr)
+		{
+			buffer->isThreadAlive.store(false, std::memory_order_release);
+		}
+	}
+};
+
+static thread_local ThreadLogBuffer threadLogBuffer;
+
+bool Log::SetOutputFile(const std::string& fileName)
+{
+	return GetLogWriter().SetOutputFile(fileName);
+}
+
+void Log::Flush()
+{
+	GetLogWriter().Flush();
+}
+
+void Log::Submit(const Record& record)
+{
+	LogRingBuffer*& buffer = threadLogBuffer.buffer;
+	if (buffer == nullptr)
+	{
+		buffer = GetLogWriter().CreateBuffer();
+	}
+
+	const size_t writePosition = buffer->writePosition.load(std::memory_order_relaxed);
+	const size_t readPosition = buffer->readPosition.load(std::memory_order_acquire);
+	if (RING_BUFFER_SIZE - (writePosition - readPosition) < record.size)
+	{
+		buffer->numDropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	buffer->Write(writePosition, record.data, record.size);
+	buffer->writePosition.store(writePosition + record.size, std::memory_order_release);
+}
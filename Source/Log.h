@@ -0,0 +1,172 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+/**
+ * @brief Asynchronous logger. Logging records the format and arguments of a message in a ring
+ *		buffer owned by the calling thread, without locking or formatting; a background thread
+ *		formats the records and writes them to the output.
+ *
+ * Formats must be string literals, as records refer to them by address. Every "{}" in a format is
+ * replaced by the next argument. Supported arguments are integers, floating point numbers, enums,
+ * characters, strings and pointers. Messages are written in order per thread; messages from
+ * different threads may interleave. Messages repeated too often, with the same format and
+ * arguments, are suppressed, and a count of the suppressed repeats is written instead. If a
+ * thread's ring buffer is full, its messages are dropped rather than waiting.
+ */
+class Log
+{
+public:
+	enum Level : unsigned char
+	{
+		LEVEL_INFO,
+		LEVEL_WARNING,
+		LEVEL_ERROR
+	};
+
+	template<typename... Args>
+	static inline void Info(const char* format, const Args&... args)
+	{
+		Write(LEVEL_INFO, format, args...);
+	}
+
+	template<typename... Args>
+	static inline void Warning(const char* format, const Args&... args)
+	{
+		Write(LEVEL_WARNING, format, args...);
+	}
+
+	template<typename... Args>
+	static inline void Error(const char* format, const Args&... args)
+	{
+		Write(LEVEL_ERROR, format, args...);
+	}
+
+	/**
+	 * @brief Writes messages to a file instead of stderr.
+	 * @param fileName Path of the file; overwritten if it exists.
+	 * @return Whether the file could be opened.
+	 */
+	static bool SetOutputFile(const std::string& fileName);
+
+	/** @brief Blocks until every message logged before the call has been written. */
+	static void Flush();
+
+private:
+	friend class LogWriter;
+
+	enum ArgumentType : unsigned char
+	{
+		ARGUMENT_SIGNED,
+		ARGUMENT_UNSIGNED,
+		ARGUMENT_FLOAT,
+		ARGUMENT_BOOL,
+		ARGUMENT_CHAR,
+		ARGUMENT_STRING,
+		ARGUMENT_POINTER
+	};
+
+	// Largest record; longer strings are truncated
+	static constexpr size_t MAX_RECORD_SIZE = 1024;
+
+	/** @brief Record being encoded on the stack of the logging thread. */
+	struct Record
+	{
+		unsigned char data[MAX_RECORD_SIZE];
+		size_t size;
+	};
+
+	template<typename... Args>
+	static void Write(Level level, const char* format, const Args&... args)
+	{
+		Record record;
+		record.size = sizeof(unsigned int);
+		Append(record, &level, sizeof(level));
+		Append(record, &format, sizeof(format));
+		(WriteArgument(record, args), ...);
+
+		const unsigned int size = (unsigned int)record.size;
+		std::memcpy(record.data, &size, sizeof(size));
+		Submit(record);
+	}
+
+	static inline void Append(Record& record, const void* data, size_t size)
+	{
+		std::memcpy(record.data + record.size, data, size);
+		record.size += size;
+	}
+
+	template<typename T>
+	static void WriteArgument(Record& record, const T& argument)
+	{
+		// Large enough for the type, the largest value, and a string length
+		if (record.size + 16 > MAX_RECORD_SIZE)
+		{
+			return;
+		}
+
+		if constexpr (std::is_same_v<T, bool>)
+		{
+			WriteValue(record, ARGUMENT_BOOL, (unsigned char)argument);
+		}
+		else if constexpr (std::is_same_v<T, char>)
+		{
+			WriteValue(record, ARGUMENT_CHAR, argument);
+		}
+		else if constexpr (std::is_enum_v<T>)
+		{
+			WriteValue(record, ARGUMENT_SIGNED, (long long)argument);
+		}
+		else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+		{
+			WriteValue(record, ARGUMENT_SIGNED, (long long)argument);
+		}
+		else if constexpr (std::is_integral_v<T>)
+		{
+			WriteValue(record, ARGUMENT_UNSIGNED, (unsigned long long)argument);
+		}
+		else if constexpr (std::is_floating_point_v<T>)
+		{
+			WriteValue(record, ARGUMENT_FLOAT, (double)argument);
+		}
+		else if constexpr (std::is_same_v<T, std::string>)
+		{
+			WriteString(record, argument.c_str(), argument.size());
+		}
+		else if constexpr (std::is_convertible_v<const T&, const char*>)
+		{
+			const char* string = argument;
+			WriteString(record, string, string != nullptr ? std::strlen(string) : 0);
+		}
+		else
+		{
+			static_assert(std::is_pointer_v<T>, "Unsupported log argument type");
+			WriteValue(record, ARGUMENT_POINTER, (const void*)argument);
+		}
+	}
+
+	template<typename T>
+	static inline void WriteValue(Record& record, ArgumentType type, const T& value)
+	{
+		Append(record, &type, sizeof(type));
+		Append(record, &value, sizeof(value));
+	}
+
+	static inline void WriteString(Record& record, const char* string, size_t length)
+	{
+		const ArgumentType type = ARGUMENT_STRING;
+		const unsigned short clampedLength = (unsigned short)std::min(length,
+			MAX_RECORD_SIZE - record.size - sizeof(type) - sizeof(clampedLength));
+		Append(record, &type, sizeof(type));
+		Append(record, &clampedLength, sizeof(clampedLength));
+		Append(record, string, clampedLength);
+	}
+
+	/** @brief Copies a record into the ring buffer of the calling thread. */
+	static void Submit(const Record& record);
+};
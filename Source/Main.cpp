@@ -15,13 +15,27 @@
 #include "InteractionWorld.h"
 #include "Rendering/TextRenderer.h"
 #include "Rendering/Text.h"
+#include "Rendering/FrameQueueLimiter.h"
+#include "Rendering/FrameCapture.h"
 #include "Timing.h"
+#include "Log.h"
 #include "Events/Keycode.h"
+#include "Jobs/Task.h"
+#include "Jobs/IdleScheduler.h"
+#include "Replay/ReplayRecorder.h"
+#include "Replay/ReplayPlayer.h"
 
 #include "GameComponentSystem/TransformComponent.h"
 #include "GameComponentSystem/ColliderComponent.h"
 #include "GameComponentSystem/FreecamControlComponent.h"
 #include "GameComponentSystem/RenderableMeshComponentSystem.h"
+#include "GameComponentSystem/RenderableSphereComponentSystem.h"
+#include "GameComponentSystem/AnimatedMeshComponentSystem.h"
+#include "GameComponentSystem/ParticleEmitterComponentSystem.h"
+#include "GameComponentSystem/ClothComponentSystem.h"
+#include "Particles/ParticleBenchmark.h"
+#include "Baking/OcclusionBaker.h"
+#include "Baking/HLODBuilder.h"
 #include "GameComponentSystem/MotionComponentSystem.h"
 #include "GameComponentSystem/CameraComponentSystem.h"
 
@@ -109,13 +123,40 @@ public:
 // TODO refactor main
 int main(int argc, char** argv)
 {
+	if (argc > 1 && std::string(argv[1]) == "--benchmark-particles")
+	{
+		RunParticleBenchmark(1000000, 300);
+		return 0;
+	}
+
+	if (argc > 2 && std::string(argv[1]) == "--bake-occlusion")
+	{
+		return BakeModelOcclusion(argv[2]) ? 0 : 1;
+	}
+
+	if (argc > 3 && std::string(argv[1]) == "--build-hlod")
+	{
+		return BuildModelHLOD(argv[2], argv[3]) ? 0 : 1;
+	}
+
 	Application* application = Application::Create();
 	Window window(*application, DEFAULT_WIDTH, DEFAULT_HEIGHT, "GLEngine");
 	RenderDevice device(window);
 	Sampler sampler(device);
 
+	// Synchronize with the display, and allow at most two frames to be queued ahead of the GPU
+	// to keep input latency bounded
+	FrameQueueLimiter frameQueueLimiter(device, 2);
+	window.SetPresentMode(Window::PRESENT_VSYNC);
+	window.SetFrameQueueLimiter(&frameQueueLimiter);
+	// Keep released resources alive for as long as a queued frame may still use them
+	device.SetReleaseLatency(frameQueueLimiter.GetMaxQueuedFrames() + 1);
+
 	Shader shader(device, "./Assets/Shaders/BasicShader.glsl");
 	Shader shaderText(device, "./Assets/Shaders/TextShader.glsl");
+	Shader shaderSkinned(device, "./Assets/Shaders/SkinnedShader.glsl");
+	Shader shaderBillboard(device, "./Assets/Shaders/BillboardShader.glsl");
+	Shader shaderSphereImpostor(device, "./Assets/Shaders/SphereImpostorShader.glsl");
 
 	// Create a camera used for rendering
 	Camera camera(70.0f, (float)window.GetWidth() / (float)window.GetHeight(), 0.1f, 1000.0f, 
@@ -128,10 +169,43 @@ int main(int argc, char** argv)
 	drawParameters.shouldWriteDepth = true;
 
 	RenderTarget target(device);
+
+	// Optionally write every frame to numbered PNG files, without stalling the renderer
+	FrameCapture* frameCapture = nullptr;
+	if (argc > 2 && std::string(argv[1]) == "--capture")
+	{
+		frameCapture = new FrameCapture(device, target, argv[2], FrameCapture::FORMAT_PNG);
+	}
+
 	GameRenderContext gameRenderContext(device, target, drawParameters, shader, sampler, camera);
 
-	std::vector<IndexedModel> models = LoadModels("./Assets/Models/Sphere.obj");
-	VertexArray vertexArray(device, models[0], RenderDevice::USAGE_STATIC_DRAW);
+	// Bone matrices of every skinned mesh drawn in a frame, grown to fit as needed
+	TextureBuffer boneBuffer(device, Skeleton::MAX_BONES * sizeof(glm::mat4),
+		RenderDevice::USAGE_STREAM_DRAW);
+	gameRenderContext.SetSkinnedShader(shaderSkinned, boneBuffer);
+
+	// Particles are alpha blended, and do not write depth so they do not occlude each other
+	RenderDevice::DrawParameters particleDrawParameters;
+	particleDrawParameters.primitiveType = RenderDevice::PRIMITIVE_TRIANGLES;
+	particleDrawParameters.faceCulling = RenderDevice::FACE_CULL_NONE;
+	particleDrawParameters.depthFunc = RenderDevice::DRAW_FUNC_LESS;
+	particleDrawParameters.shouldWriteDepth = false;
+	particleDrawParameters.sourceBlend = RenderDevice::BLEND_FUNC_SRC_ALPHA;
+	particleDrawParameters.destBlend = RenderDevice::BLEND_FUNC_ONE_MINUS_SRC_ALPHA;
+	ParticleRenderContext particleRenderContext(device, target, particleDrawParameters,
+		shaderBillboard, sampler, camera);
+
+	// Spheres are ray traced on camera-facing quads, which face the camera whichever way their
+	// corners wind
+	RenderDevice::DrawParameters sphereDrawParameters = drawParameters;
+	sphereDrawParameters.faceCulling = RenderDevice::FACE_CULL_NONE;
+	SphereImpostorRenderContext sphereRenderContext(device, target, sphereDrawParameters,
+		shaderSphereImpostor, sampler, camera);
+#if defined(GLENGINE_SOFTWARE_RENDERER)
+	// The software device cannot shade impostors, so spheres are drawn as meshes instead
+	std::vector<IndexedModel> sphereModels = LoadModels("./Assets/Models/Sphere.obj");
+	VertexArray sphereVertexArray(device, sphereModels[0], RenderDevice::USAGE_STATIC_DRAW);
+#endif
 
 	// Load textures
 	Texture textureGreen(device, "./Assets/Textures/Green/texture_09.png",RenderDevice::FORMAT_RGBA,false,false);
@@ -153,8 +227,25 @@ int main(int argc, char** argv)
 	Text hwText(device, textRenderer, font, "Hello world!", Text::Anchor::CENTERED, style,
 		Transform());
 
+	// Worker threads, shared by all parallel systems
+	JobSystem jobSystem;
+	ClothSolver clothSolver(jobSystem);
+	// Runs coroutine tasks, such as scripted sequences and streaming loads
+	TaskScheduler taskScheduler(jobSystem);
+
 	// Create the ECS
 	ECS ecs;
+	// Runs background work in the time left at the end of each frame
+	IdleScheduler idleScheduler(jobSystem);
+	// Compact variable-length component data early, while there is time to spare, rather than
+	// when it becomes badly fragmented during a system update. Compaction cannot be split, so
+	// the task ignores its budget; the scheduler measures each step and only runs it again
+	// once a frame has that much time left.
+	idleScheduler.Add("Blob arena compaction", [&ecs](double /*budget*/)
+	{
+		ecs.GetBlobArena().CompactIfFragmented(0.25f);
+		return false;
+	});
 	// Systems which determine game logic
 	ECSSystemList mainSystems;
 	// Systems which determine rendering
@@ -192,7 +283,7 @@ int main(int argc, char** argv)
 	eventHandler.AddWindowResizeCallback(
 		[&window, &target, &camera, &textRenderer](unsigned int width, unsigned int height)
 		{
-			std::cout << "Window was resized to " << width << " " << height << std::endl;
+			Log::Info("Window was resized to {} {}", width, height);
 			
 			window.ChangeSize(width, height);
 			target.UpdateSize(width, height);
@@ -206,7 +297,15 @@ int main(int argc, char** argv)
 	ColliderComponent colliderComponent;
 	FreecamControlComponent freecamControlComponent;
 	CameraComponent cameraComponent;
-	RenderableMeshComponent renderableMeshComponent;
+#if defined(GLENGINE_SOFTWARE_RENDERER)
+	RenderableMeshComponent sphereComponent;
+	sphereComponent.mesh = &sphereVertexArray;
+	sphereComponent.bounds = AABB(glm::vec3(-1), glm::vec3(1));
+	sphereComponent.isCulled = true;
+#else
+	RenderableSphereComponent sphereComponent;
+	sphereComponent.radius = 1.0f;
+#endif
 	RigidbodyComponent rigidbodyComponent;
 	
 	// Create the player entity...
@@ -234,8 +333,7 @@ int main(int argc, char** argv)
 	// Finally, create the player!
 	ecs.MakeEntity(transformComponent, cameraComponent, freecamControlComponent);
 
-	renderableMeshComponent.mesh = &vertexArray;
-	renderableMeshComponent.texture = &textureRed;
+	sphereComponent.texture = &textureRed;
 
 	constexpr float spacing = 5.f;
 	for (unsigned int i = 0; i < 10; i++)
@@ -243,7 +341,7 @@ int main(int argc, char** argv)
 		for(unsigned int j = 0;j < 10;j++)
 		{
 			transformComponent.transform.SetPosition(glm::vec3(spacing * j + (i%2) * 2.5f, spacing * i, -18.f));
-			ecs.MakeEntity(transformComponent, colliderComponent, renderableMeshComponent);
+			ecs.MakeEntity(transformComponent, colliderComponent, sphereComponent);
 		}
 	}
 
@@ -256,33 +354,115 @@ int main(int argc, char** argv)
 	rigidbodyComponent.dynamicFriction = 0.f;
 	rigidbodyComponent.staticFriction = 0.f;
 	rigidbodyComponent.restitution = 1.f;
-	renderableMeshComponent.texture = &textureGreen;
-	ecs.MakeEntity(transformComponent, colliderComponent, rigidbodyComponent, renderableMeshComponent);
+	sphereComponent.texture = &textureGreen;
+	ecs.MakeEntity(transformComponent, colliderComponent, rigidbodyComponent, sphereComponent);
+
+	// Create a fountain of particles above the spheres
+	ParticleEmitterSettings fountainSettings;
+	fountainSettings.maxParticles = 20000;
+	fountainSettings.emissionRate = 2000.0f;
+	fountainSettings.spawnRadius = 0.5f;
+	fountainSettings.minVelocity = glm::vec3(-3.0f, 8.0f, -3.0f);
+	fountainSettings.maxVelocity = glm::vec3(3.0f, 14.0f, 3.0f);
+	fountainSettings.drag = 0.2f;
+	fountainSettings.startColor = glm::vec4(0.6f, 0.8f, 1.0f, 1.0f);
+	ParticleEmitter fountain(fountainSettings, textureGreen);
+
+	ParticleEmitterComponent particleEmitterComponent;
+	particleEmitterComponent.emitter = &fountain;
+	transformComponent.transform.SetPosition(glm::vec3(22.0f, 50.0f, -18.0f));
+	ecs.MakeEntity(transformComponent, particleEmitterComponent);
+
+	// Create a row of flags. The cloth of Flag.obj is a single quad, so a subdivided grid of the
+	// same proportions is simulated instead.
+	const IndexedModel flagModel = Cloth::CreateGridModel(0.825f, 0.619f, 24, 18);
+	std::vector<Cloth*> flags;
+	ClothComponent clothComponent;
+	clothComponent.texture = &textureRed;
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		const Transform flagTransform(glm::vec3(5.0f + 10.0f * i, 52.0f, -18.0f), glm::vec3(0.0f),
+			glm::vec3(5.0f));
+		// Pin the edge attached to the pole
+		flags.push_back(new Cloth(device, flagModel, flagTransform.GetModel(),
+			[](const glm::vec3& position) { return position.x == 0.0f; }));
+
+		clothComponent.cloth = flags.back();
+		ecs.MakeEntity(clothComponent);
+	}
 
 	// Create systems
 	PhysicsWorldSystem physicsWorldSystem;
 	FreecamControlSystem freecamControlSystem;
 	CameraSystem cameraSystem;
 	RenderableMeshSystem renderableMeshSystem(gameRenderContext);
+	RenderableSphereSystem renderableSphereSystem(sphereRenderContext);
+	AnimatedMeshSystem animatedMeshSystem(gameRenderContext);
+	ParticleEmitterSystem particleEmitterSystem(particleRenderContext);
+	ClothColliderSystem clothColliderSystem(clothSolver);
+	ClothSystem clothSystem(clothSolver, gameRenderContext);
 
 	mainSystems.AddSystem(physicsWorldSystem);
 	mainSystems.AddSystem(freecamControlSystem);
 	mainSystems.AddSystem(cameraSystem);
+	mainSystems.AddSystem(clothColliderSystem);
 	renderingPipeline.AddSystem(renderableMeshSystem);
+	renderingPipeline.AddSystem(renderableSphereSystem);
+	renderingPipeline.AddSystem(animatedMeshSystem);
+	renderingPipeline.AddSystem(particleEmitterSystem);
+	renderingPipeline.AddSystem(clothSystem);
+
+	// Optionally record the session, or play back a recorded session as a repeatable workload
+	ReplayRecorder* replayRecorder = nullptr;
+	ReplayPlayer* replayPlayer = nullptr;
+	if (argc > 2 && std::string(argv[1]) == "--record")
+	{
+		replayRecorder = new ReplayRecorder(argv[2], eventHandler, ecs);
+		replayRecorder->AddSnapshotField(&TransformComponent::transform);
+	}
+	else if (argc > 2 && std::string(argv[1]) == "--replay")
+	{
+		replayPlayer = new ReplayPlayer(argv[2], ecs);
+		// Play back as fast as possible
+		window.SetPresentMode(Window::PRESENT_IMMEDIATE);
+	}
+
+	// Receives the live input while replaying, which is ignored
+	IApplicationEventHandler replayEventHandler;
 
 	// Time values used for calculating delta time
 	float currentTime = Timing::GetTime(), previousTime = currentTime;
+	const float startTime = currentTime;
 
 	// Game loop; keep updating until the window is closed
 	while (application->IsRunning())
 	{
+		idleScheduler.BeginFrame();
+
 		// Update time values
 		currentTime = Timing::GetTime();
 		float deltaTime = currentTime - previousTime;
 		previousTime = currentTime;
 
 		// Process application events; keypresses, mouse buttons/motion, window resizing, etc.
-		application->ProcessMessages(deltaTime, eventHandler);
+		if (replayPlayer != nullptr)
+		{
+			// Replace the measured delta time and input with the recorded ones
+			if (!replayPlayer->NextFrame(deltaTime, eventHandler))
+			{
+				break;
+			}
+			application->ProcessMessages(deltaTime, replayEventHandler);
+		}
+		else if (replayRecorder != nullptr)
+		{
+			replayRecorder->BeginFrame(deltaTime);
+			application->ProcessMessages(deltaTime, *replayRecorder);
+		}
+		else
+		{
+			application->ProcessMessages(deltaTime, eventHandler);
+		}
 
 		while (!lockMouse.IsEmpty())
 		{
@@ -301,6 +481,9 @@ int main(int argc, char** argv)
 			}
 		}
 
+		// Resume the tasks whose waits have completed
+		taskScheduler.Update(deltaTime);
+
 		// Update all game logic systems
 		ecs.UpdateSystems(mainSystems, deltaTime);
 
@@ -313,7 +496,12 @@ int main(int argc, char** argv)
 		// Update the rendering pipeline
 		ecs.UpdateSystems(renderingPipeline, deltaTime);
 
+		// Simulate queued cloth in parallel, and upload the deformed meshes before drawing them
+		clothSolver.Update(deltaTime);
+
 		gameRenderContext.Flush();
+		sphereRenderContext.Flush();
+		particleRenderContext.Flush();
 	
 		style[1].color.a = abs(sin(Timing::GetTime() * 2));
 		hwText.SetStyle(style);
@@ -328,8 +516,44 @@ int main(int argc, char** argv)
 
 		textRenderer.RenderText(hwText);
 
+		// Use the rest of the frame for background work
+		idleScheduler.Update();
+
+		// Read the frame back before the buffers are swapped
+		if (frameCapture != nullptr)
+		{
+			frameCapture->Capture();
+		}
+
+#if defined(GLENGINE_SOFTWARE_RENDERER)
+		// Copy the rasterized frame to the window surface
+		device.Present();
+#endif
+
 		// Swap buffers
 		window.Present();
+		device.EndFrame();
+	}
+
+	// Deliver the frames still in flight
+	delete frameCapture;
+
+	if (replayPlayer != nullptr)
+	{
+		const float replayTime = Timing::GetTime() - startTime;
+		const unsigned int numFrames = replayPlayer->GetNumFrames();
+		std::cout << "Replayed " << numFrames << " frames in " << replayTime << " s ("
+			<< (numFrames > 0 ? replayTime * 1000.0f / numFrames : 0.0f) << " ms per frame), "
+			<< replayPlayer->GetNumDivergences() << " diverged snapshots" << std::endl;
+	}
+
+	// Writes the end of the recording
+	delete replayRecorder;
+	delete replayPlayer;
+
+	for (Cloth* flag : flags)
+	{
+		delete flag;
 	}
 
 	delete application;
@@ -0,0 +1,81 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#include "ParticleRenderContext.h"
+
+ParticleRenderContext::ParticleRenderContext(RenderDevice& device, RenderTarget& target,
+	RenderDevice::DrawParameters& drawParameters, Shader& shader, Sampler& sampler,
+	Camera& camera) : RenderContext(device, target, drawParameters), shader(shader),
+	sampler(sampler), camera(camera),
+	quad(device, CreateQuadModel(), RenderDevice::USAGE_STATIC_DRAW),
+	cameraBuffer(device, 2 * sizeof(glm::mat4), RenderDevice::USAGE_STREAM_DRAW) {}
+
+IndexedModel ParticleRenderContext::CreateQuadModel()
+{
+	IndexedModel model;
+	model.AllocateElement(2); // Corner
+	model.SetInstancedElementStartIndex(1); // Begin instanced data
+	model.AllocateElement(4); // Position and size
+	model.AllocateElement(4); // Color
+
+	model.AddElement2f(0, -0.5f, -0.5f);
+	model.AddElement2f(0, 0.5f, -0.5f);
+	model.AddElement2f(0, 0.5f, 0.5f);
+	model.AddElement2f(0, -0.5f, 0.5f);
+
+	model.AddIndices3i(0, 1, 2);
+	model.AddIndices3i(0, 2, 3);
+	return model;
+}
+
+void ParticleRenderContext::Flush()
+{
+	if (emitterRenderBuffer.empty())
+	{
+		return;
+	}
+
+	const glm::mat4 cameraData[2] = { camera.GetView(), camera.GetProjection() };
+	cameraBuffer.Update(cameraData);
+	shader.SetUniformBuffer("Camera", cameraBuffer);
+
+	for (auto it = emitterRenderBuffer.begin(); it != emitterRenderBuffer.end(); ++it)
+	{
+		Texture* texture = it->first;
+		std::vector<ParticleEmitter*>& emitters = it->second;
+
+		// Gather the particles of every emitter using this texture
+		size_t numParticles = 0;
+		for (ParticleEmitter* emitter : emitters)
+		{
+			numParticles += emitter->GetPool().GetPaddedNumParticles();
+		}
+
+		if (positionsAndSizes.size() < numParticles * 4)
+		{
+			positionsAndSizes.resize(numParticles * 4);
+			colors.resize(numParticles * 4);
+		}
+
+		size_t offset = 0;
+		for (ParticleEmitter* emitter : emitters)
+		{
+			emitter->WriteInstanceData(&positionsAndSizes[offset * 4], &colors[offset * 4]);
+			// Padding is overwritten by the next emitter
+			offset += emitter->GetNumParticles();
+		}
+
+		emitters.clear();
+
+		if (offset == 0) // No instances to draw
+		{
+			continue;
+		}
+
+		shader.SetSampler("diffuse", *texture, sampler, 0);
+
+		// Index 1 is the position and size of each particle, index 2 is the color
+		quad.UpdateBuffer(1, positionsAndSizes.data(), offset * 4 * sizeof(float));
+		quad.UpdateBuffer(2, colors.data(), offset * 4 * sizeof(float));
+		Draw(shader, quad, drawParameters, (unsigned int)offset);
+	}
+}
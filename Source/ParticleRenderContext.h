@@ -0,0 +1,48 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include "Rendering/RenderContext.h"
+#include "Rendering/Camera.h"
+#include "Particles/ParticleEmitter.h"
+
+#include <map>
+#include <vector>
+
+/**
+ * @brief Draws particles as camera-facing billboards. All emitters sharing a texture are merged
+ * into a single instanced draw, with instance data streamed to the GPU every frame.
+ */
+class ParticleRenderContext : public RenderContext
+{
+public:
+	/**
+	 * @param shader Billboard shader, with a "Camera" uniform block holding the view and
+	 *		projection matrices.
+	 */
+	ParticleRenderContext(RenderDevice& device, RenderTarget& target,
+		RenderDevice::DrawParameters& drawParameters, Shader& shader, Sampler& sampler,
+		Camera& camera);
+
+	inline void RenderParticles(ParticleEmitter& emitter)
+	{
+		emitterRenderBuffer[&emitter.GetTexture()].push_back(&emitter);
+	}
+
+	void Flush();
+
+private:
+	/** @brief Creates a unit quad centered on the origin, with 2 instanced elements. */
+	static IndexedModel CreateQuadModel();
+
+	Shader& shader;
+	Sampler& sampler;
+	Camera& camera;
+	VertexArray quad;
+	UniformBuffer cameraBuffer;
+	std::map<Texture*, std::vector<ParticleEmitter*>> emitterRenderBuffer;
+
+	// Staging buffers for instance data, reused every frame
+	std::vector<float> positionsAndSizes;
+	std::vector<float> colors;
+};
@@ -0,0 +1,78 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#include "ParticleBenchmark.h"
+#include "ParticlePool.h"
+#include "Timing.h"
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+void RunParticleBenchmark(unsigned int numParticles, unsigned int numFrames)
+{
+	constexpr float deltaTime = 1.0f / 60.0f;
+	const glm::vec3 gravity(0.0f, -9.8f, 0.0f);
+
+	ParticlePool pool(numParticles);
+	// Instance data is written 4 particles at a time, so leave room for padding
+	std::vector<float> positionsAndSizes((((size_t)numParticles + 3) & ~(size_t)3) * 4);
+	std::vector<float> colors(positionsAndSizes.size());
+
+	std::minstd_rand random;
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	// Respawns particles until the pool is full again
+	auto refill = [&]()
+	{
+		unsigned int firstIndex;
+		const unsigned int count = pool.Allocate(numParticles, firstIndex);
+		for (unsigned int i = firstIndex; i < firstIndex + count; i++)
+		{
+			pool.positionX[i] = 0.0f;
+			pool.positionY[i] = 0.0f;
+			pool.positionZ[i] = 0.0f;
+			pool.velocityX[i] = unit(random) * 2.0f - 1.0f;
+			pool.velocityY[i] = unit(random) * 5.0f;
+			pool.velocityZ[i] = unit(random) * 2.0f - 1.0f;
+			pool.age[i] = 0.0f;
+			pool.lifetime[i] = 0.5f + unit(random) * 1.5f;
+		}
+	};
+
+	refill();
+
+	double emitTime = 0.0, simulateTime = 0.0, compactTime = 0.0, writeTime = 0.0;
+	for (unsigned int frame = 0; frame < numFrames; frame++)
+	{
+		double start = Timing::GetPreciseTime();
+		pool.Compact();
+		double end = Timing::GetPreciseTime();
+		compactTime += end - start;
+
+		start = end;
+		refill();
+		end = Timing::GetPreciseTime();
+		emitTime += end - start;
+
+		start = end;
+		pool.Simulate(deltaTime, gravity, 0.1f);
+		end = Timing::GetPreciseTime();
+		simulateTime += end - start;
+
+		start = end;
+		pool.WriteInstanceData(positionsAndSizes.data(), colors.data(), 0.5f, 0.1f,
+			glm::vec4(1.0f), glm::vec4(1.0f, 1.0f, 1.0f, 0.0f));
+		end = Timing::GetPreciseTime();
+		writeTime += end - start;
+	}
+
+	const double toMilliseconds = 1000.0 / (double)numFrames;
+	std::cout << "Particle benchmark: " << numParticles << " particles, " << numFrames
+		<< " frames" << std::endl;
+	std::cout << "  Compact:  " << compactTime * toMilliseconds << " ms/frame" << std::endl;
+	std::cout << "  Emit:     " << emitTime * toMilliseconds << " ms/frame" << std::endl;
+	std::cout << "  Simulate: " << simulateTime * toMilliseconds << " ms/frame" << std::endl;
+	std::cout << "  Write:    " << writeTime * toMilliseconds << " ms/frame" << std::endl;
+	std::cout << "  Total:    " << (compactTime + emitTime + simulateTime + writeTime)
+		* toMilliseconds << " ms/frame" << std::endl;
+}
@@ -0,0 +1,12 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+/**
+ * @brief Measures the CPU cost of the particle pipeline (emission, simulation, compaction and
+ * instance data generation) and prints the average time per frame of each stage. No rendering
+ * is done, so this can run without a window.
+ * @param numParticles Number of live particles to maintain.
+ * @param numFrames Number of frames to simulate.
+ */
+void RunParticleBenchmark(unsigned int numParticles, unsigned int numFrames);
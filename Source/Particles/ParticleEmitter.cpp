@@ -0,0 +1,48 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#include "ParticleEmitter.h"
+
+void ParticleEmitter::Update(float deltaTime, const glm::vec3& position)
+{
+	pool.Compact();
+
+	// Carry over fractional particles so low emission rates still spawn over time
+	emissionAccumulator += settings.emissionRate * deltaTime;
+	const unsigned int numToEmit = (unsigned int)emissionAccumulator;
+	emissionAccumulator -= (float)numToEmit;
+
+	Burst(numToEmit, position);
+
+	pool.Simulate(deltaTime, settings.gravity, settings.drag);
+}
+
+void ParticleEmitter::Burst(unsigned int count, const glm::vec3& position)
+{
+	unsigned int firstIndex;
+	const unsigned int numAllocated = pool.Allocate(count, firstIndex);
+
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::uniform_real_distribution<float> signedUnit(-1.0f, 1.0f);
+
+	for (unsigned int i = firstIndex; i < firstIndex + numAllocated; i++)
+	{
+		glm::vec3 offset(0.0f);
+		if (settings.spawnRadius > 0.0f)
+		{
+			offset = glm::vec3(signedUnit(random), signedUnit(random), signedUnit(random))
+				* settings.spawnRadius;
+		}
+
+		const glm::vec3 velocity = glm::mix(settings.minVelocity, settings.maxVelocity,
+			glm::vec3(unit(random), unit(random), unit(random)));
+
+		pool.positionX[i] = position.x + offset.x;
+		pool.positionY[i] = position.y + offset.y;
+		pool.positionZ[i] = position.z + offset.z;
+		pool.velocityX[i] = velocity.x;
+		pool.velocityY[i] = velocity.y;
+		pool.velocityZ[i] = velocity.z;
+		pool.age[i] = 0.0f;
+		pool.lifetime[i] = glm::mix(settings.minLifetime, settings.maxLifetime, unit(random));
+	}
+}
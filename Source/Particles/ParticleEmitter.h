@@ -0,0 +1,87 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include "ParticlePool.h"
+#include "Rendering/Texture.h"
+
+#include <GLM/glm.hpp>
+
+#include <random>
+
+/** @brief Describes how an emitter spawns particles, and how they behave over their lifetime. */
+struct ParticleEmitterSettings
+{
+	unsigned int maxParticles = 10000;
+	// Particles spawned per second
+	float emissionRate = 100.0f;
+	// Particles are spawned at a random point within this radius of the emitter
+	float spawnRadius = 0.0f;
+
+	float minLifetime = 1.0f;
+	float maxLifetime = 2.0f;
+	glm::vec3 minVelocity = glm::vec3(-1.0f, 1.0f, -1.0f);
+	glm::vec3 maxVelocity = glm::vec3(1.0f, 5.0f, 1.0f);
+
+	glm::vec3 gravity = glm::vec3(0.0f, -9.8f, 0.0f);
+	float drag = 0.0f;
+
+	// Size and color are interpolated from start to end over the lifetime of each particle
+	float startSize = 0.5f;
+	float endSize = 0.1f;
+	glm::vec4 startColor = glm::vec4(1.0f);
+	glm::vec4 endColor = glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+};
+
+/**
+ * @brief Spawns and simulates a pool of particles. Emitters sharing a texture are drawn together
+ * by the particle render context.
+ */
+class ParticleEmitter
+{
+public:
+	/**
+	 * @param settings Emission and simulation settings.
+	 * @param texture Texture applied to every particle, which acts as the emitter's material.
+	 */
+	ParticleEmitter(const ParticleEmitterSettings& settings, Texture& texture) :
+		settings(settings), pool(settings.maxParticles), texture(&texture),
+		emissionAccumulator(0.0f) {}
+
+	/**
+	 * @brief Removes dead particles, emits new particles according to the emission rate, then
+	 *		simulates all particles.
+	 * @param deltaTime Time since the last update.
+	 * @param position Position of the emitter in the world.
+	 */
+	void Update(float deltaTime, const glm::vec3& position);
+
+	/**
+	 * @brief Immediately spawns a number of particles.
+	 * @param count Number of particles to spawn.
+	 * @param position Position of the emitter in the world.
+	 */
+	void Burst(unsigned int count, const glm::vec3& position);
+
+	inline void WriteInstanceData(float* positionsAndSizes, float* colors) const
+	{
+		pool.WriteInstanceData(positionsAndSizes, colors, settings.startSize, settings.endSize,
+			settings.startColor, settings.endColor);
+	}
+
+	inline ParticleEmitterSettings& GetSettings() { return settings; }
+	inline ParticlePool& GetPool() { return pool; }
+	inline Texture& GetTexture() { return *texture; }
+	inline unsigned int GetNumParticles() const { return pool.GetNumParticles(); }
+
+private:
+	// Disallow copy and assign
+	ParticleEmitter(const ParticleEmitter& other) = delete;
+	void operator=(const ParticleEmitter& other) = delete;
+
+	ParticleEmitterSettings settings;
+	ParticlePool pool;
+	Texture* texture;
+	float emissionAccumulator;
+	std::minstd_rand random;
+};
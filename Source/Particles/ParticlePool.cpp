@@ -0,0 +1,191 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#include "ParticlePool.h"
+#include "SIMD.h"
+
+ParticlePool::ParticlePool(unsigned int maxParticles) : numParticles(0),
+	maxParticles(maxParticles)
+{
+	const size_t paddedSize = ((size_t)maxParticles + 3) & ~(size_t)3;
+	positionX.resize(paddedSize);
+	positionY.resize(paddedSize);
+	positionZ.resize(paddedSize);
+	velocityX.resize(paddedSize);
+	velocityY.resize(paddedSize);
+	velocityZ.resize(paddedSize);
+	age.resize(paddedSize);
+	lifetime.resize(paddedSize);
+}
+
+unsigned int ParticlePool::Allocate(unsigned int count, unsigned int& firstIndex)
+{
+	const unsigned int allocated = glm::min(count, maxParticles - numParticles);
+	firstIndex = numParticles;
+	numParticles += allocated;
+	return allocated;
+}
+
+void ParticlePool::Simulate(float deltaTime, const glm::vec3& gravity, float drag)
+{
+	const unsigned int count = GetPaddedNumParticles();
+	const float damping = 1.0f / (1.0f + drag * deltaTime);
+
+#if defined(GLENGINE_SSE2)
+	const __m128 dt = _mm_set1_ps(deltaTime);
+	const __m128 dampingFactor = _mm_set1_ps(damping);
+	const __m128 gravityX = _mm_set1_ps(gravity.x * deltaTime);
+	const __m128 gravityY = _mm_set1_ps(gravity.y * deltaTime);
+	const __m128 gravityZ = _mm_set1_ps(gravity.z * deltaTime);
+
+	for (unsigned int i = 0; i < count; i += 4)
+	{
+		const __m128 vx = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&velocityX[i]), gravityX),
+			dampingFactor);
+		const __m128 vy = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&velocityY[i]), gravityY),
+			dampingFactor);
+		const __m128 vz = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&velocityZ[i]), gravityZ),
+			dampingFactor);
+		_mm_storeu_ps(&velocityX[i], vx);
+		_mm_storeu_ps(&velocityY[i], vy);
+		_mm_storeu_ps(&velocityZ[i], vz);
+
+		_mm_storeu_ps(&positionX[i], _mm_add_ps(_mm_loadu_ps(&positionX[i]), _mm_mul_ps(vx, dt)));
+		_mm_storeu_ps(&positionY[i], _mm_add_ps(_mm_loadu_ps(&positionY[i]), _mm_mul_ps(vy, dt)));
+		_mm_storeu_ps(&positionZ[i], _mm_add_ps(_mm_loadu_ps(&positionZ[i]), _mm_mul_ps(vz, dt)));
+
+		_mm_storeu_ps(&age[i], _mm_add_ps(_mm_loadu_ps(&age[i]), dt));
+	}
+#else
+	const glm::vec3 gravityStep = gravity * deltaTime;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		velocityX[i] = (velocityX[i] + gravityStep.x) * damping;
+		velocityY[i] = (velocityY[i] + gravityStep.y) * damping;
+		velocityZ[i] = (velocityZ[i] + gravityStep.z) * damping;
+
+		positionX[i] += velocityX[i] * deltaTime;
+		positionY[i] += velocityY[i] * deltaTime;
+		positionZ[i] += velocityZ[i] * deltaTime;
+
+		age[i] += deltaTime;
+	}
+#endif
+}
+
+void ParticlePool::Compact()
+{
+	const unsigned int count = GetPaddedNumParticles();
+	unsigned int write = 0;
+
+	for (unsigned int i = 0; i < count; i += 4)
+	{
+		// Find which of the 4 particles are alive, ignoring padding past the last particle
+		const unsigned int numValid = glm::min(numParticles - i, 4u);
+#if defined(GLENGINE_SSE2)
+		unsigned int aliveMask = (unsigned int)_mm_movemask_ps(
+			_mm_cmplt_ps(_mm_loadu_ps(&age[i]), _mm_loadu_ps(&lifetime[i])));
+#else
+		unsigned int aliveMask = 0;
+		for (unsigned int j = 0; j < 4; j++)
+		{
+			aliveMask |= (age[i + j] < lifetime[i + j] ? 1u : 0u) << j;
+		}
+#endif
+		aliveMask &= (1u << numValid) - 1;
+
+		// Nothing has died yet, so every particle is already in place
+		if (aliveMask == 0xF && write == i)
+		{
+			write += 4;
+			continue;
+		}
+
+		for (unsigned int j = 0; j < 4; j++)
+		{
+			if ((aliveMask & (1u << j)) == 0)
+			{
+				continue;
+			}
+
+			const unsigned int read = i + j;
+			positionX[write] = positionX[read];
+			positionY[write] = positionY[read];
+			positionZ[write] = positionZ[read];
+			velocityX[write] = velocityX[read];
+			velocityY[write] = velocityY[read];
+			velocityZ[write] = velocityZ[read];
+			age[write] = age[read];
+			lifetime[write] = lifetime[read];
+			write++;
+		}
+	}
+
+	numParticles = write;
+}
+
+void ParticlePool::WriteInstanceData(float* positionsAndSizes, float* colors, float startSize,
+	float endSize, const glm::vec4& startColor, const glm::vec4& endColor) const
+{
+	const unsigned int count = GetPaddedNumParticles();
+
+#if defined(GLENGINE_SSE2)
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 sizeStart = _mm_set1_ps(startSize);
+	const __m128 sizeDelta = _mm_set1_ps(endSize - startSize);
+	const __m128 colorStart[4] = { _mm_set1_ps(startColor.r), _mm_set1_ps(startColor.g),
+		_mm_set1_ps(startColor.b), _mm_set1_ps(startColor.a) };
+	const glm::vec4 colorDeltaValue = endColor - startColor;
+	const __m128 colorDelta[4] = { _mm_set1_ps(colorDeltaValue.r),
+		_mm_set1_ps(colorDeltaValue.g), _mm_set1_ps(colorDeltaValue.b),
+		_mm_set1_ps(colorDeltaValue.a) };
+
+	for (unsigned int i = 0; i < count; i += 4)
+	{
+		// Normalized age; 0 when spawned, 1 when dead
+		const __m128 t = _mm_min_ps(_mm_div_ps(_mm_loadu_ps(&age[i]),
+			_mm_max_ps(_mm_loadu_ps(&lifetime[i]), _mm_set1_ps(1e-6f))), one);
+
+		__m128 x = _mm_loadu_ps(&positionX[i]);
+		__m128 y = _mm_loadu_ps(&positionY[i]);
+		__m128 z = _mm_loadu_ps(&positionZ[i]);
+		__m128 size = _mm_add_ps(sizeStart, _mm_mul_ps(sizeDelta, t));
+
+		__m128 r = _mm_add_ps(colorStart[0], _mm_mul_ps(colorDelta[0], t));
+		__m128 g = _mm_add_ps(colorStart[1], _mm_mul_ps(colorDelta[1], t));
+		__m128 b = _mm_add_ps(colorStart[2], _mm_mul_ps(colorDelta[2], t));
+		__m128 a = _mm_add_ps(colorStart[3], _mm_mul_ps(colorDelta[3], t));
+
+		// Convert from SoA to the interleaved layout expected by the vertex shader
+		_MM_TRANSPOSE4_PS(x, y, z, size);
+		_MM_TRANSPOSE4_PS(r, g, b, a);
+
+		float* positionOutput = positionsAndSizes + i * 4;
+		_mm_storeu_ps(positionOutput, x);
+		_mm_storeu_ps(positionOutput + 4, y);
+		_mm_storeu_ps(positionOutput + 8, z);
+		_mm_storeu_ps(positionOutput + 12, size);
+
+		float* colorOutput = colors + i * 4;
+		_mm_storeu_ps(colorOutput, r);
+		_mm_storeu_ps(colorOutput + 4, g);
+		_mm_storeu_ps(colorOutput + 8, b);
+		_mm_storeu_ps(colorOutput + 12, a);
+	}
+#else
+	for (unsigned int i = 0; i < count; i++)
+	{
+		const float t = glm::min(age[i] / glm::max(lifetime[i], 1e-6f), 1.0f);
+		const glm::vec4 color = startColor + (endColor - startColor) * t;
+
+		positionsAndSizes[i * 4 + 0] = positionX[i];
+		positionsAndSizes[i * 4 + 1] = positionY[i];
+		positionsAndSizes[i * 4 + 2] = positionZ[i];
+		positionsAndSizes[i * 4 + 3] = startSize + (endSize - startSize) * t;
+
+		colors[i * 4 + 0] = color.r;
+		colors[i * 4 + 1] = color.g;
+		colors[i * 4 + 2] = color.b;
+		colors[i * 4 + 3] = color.a;
+	}
+#endif
+}
@@ -0,0 +1,66 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include <GLM/glm.hpp>
+
+#include <vector>
+
+/**
+ * @brief Structure of arrays (SoA) storage for particles, kept outside of the ECS. Each attribute
+ * lives in its own contiguous stream, padded to a multiple of 4 so the simulation kernels can
+ * always process 4 particles at a time. Live particles are always packed at the front.
+ */
+struct ParticlePool
+{
+	/** @param maxParticles Maximum number of live particles. */
+	explicit ParticlePool(unsigned int maxParticles);
+
+	/**
+	 * @brief Allocates particles at the end of the pool. The caller is responsible for
+	 *		initializing all attributes of the new particles.
+	 * @param count Number of particles requested.
+	 * @param firstIndex Receives the index of the first new particle.
+	 * @return Number of particles allocated, which may be less than requested if the pool is full.
+	 */
+	unsigned int Allocate(unsigned int count, unsigned int& firstIndex);
+
+	/**
+	 * @brief Integrates the motion of all particles and advances their age.
+	 * @param deltaTime How much time to integrate over.
+	 * @param gravity Acceleration applied to all particles.
+	 * @param drag Linear drag coefficient; velocity is damped by 1 / (1 + drag * deltaTime).
+	 */
+	void Simulate(float deltaTime, const glm::vec3& gravity, float drag);
+
+	/** @brief Removes dead particles, preserving the order of live particles. */
+	void Compact();
+
+	/**
+	 * @brief Evaluates the size and color curves of all particles, and writes them out as
+	 *		interleaved instance data.
+	 * @param positionsAndSizes Output of 4 floats per particle; x, y, z, size.
+	 * @param colors Output of 4 floats per particle; r, g, b, a.
+	 */
+	void WriteInstanceData(float* positionsAndSizes, float* colors, float startSize,
+		float endSize, const glm::vec4& startColor, const glm::vec4& endColor) const;
+
+	inline unsigned int GetNumParticles() const { return numParticles; }
+	inline unsigned int GetMaxParticles() const { return maxParticles; }
+
+	/** @return Number of particles, rounded up to the SIMD width. */
+	inline unsigned int GetPaddedNumParticles() const { return (numParticles + 3) & ~3u; }
+
+	std::vector<float> positionX;
+	std::vector<float> positionY;
+	std::vector<float> positionZ;
+	std::vector<float> velocityX;
+	std::vector<float> velocityY;
+	std::vector<float> velocityZ;
+	std::vector<float> age;
+	std::vector<float> lifetime;
+
+private:
+	unsigned int numParticles;
+	unsigned int maxParticles;
+};
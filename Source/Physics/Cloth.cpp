@@ -0,0 +1,469 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#include "Cloth.h"
+#include "SIMD.h"
+
+#include <cmath>
+#include <map>
+#include <tuple>
+#include <utility>
+
+static constexpr float EPSILON = 1e-6f;
+
+Cloth::Cloth(RenderDevice& device, const IndexedModel& model, const glm::mat4& transform,
+	const std::function<bool(const glm::vec3&)>& isPinned, const ClothSettings& settings) :
+	settings(settings), vertexArray(device, model, RenderDevice::USAGE_DYNAMIC_DRAW),
+	numParticles(0)
+{
+	const std::span<const float> positions = model.GetElement(0);
+	const unsigned int numVertices = (unsigned int)positions.size() / 3;
+
+	// Weld vertices which share a position (split by texture coordinate/normal seams)
+	std::map<std::tuple<float, float, float>, unsigned int> particleLookup;
+	std::vector<glm::vec3> localPositions;
+	vertexParticles.resize(numVertices);
+	for (unsigned int i = 0; i < numVertices; i++)
+	{
+		const std::tuple<float, float, float> key(positions[i * 3], positions[i * 3 + 1],
+			positions[i * 3 + 2]);
+
+		auto it = particleLookup.find(key);
+		if (it == particleLookup.end())
+		{
+			it = particleLookup.emplace(key, (unsigned int)localPositions.size()).first;
+			localPositions.push_back(glm::vec3(std::get<0>(key), std::get<1>(key), std::get<2>(key)));
+		}
+		vertexParticles[i] = it->second;
+	}
+
+	numParticles = (unsigned int)localPositions.size();
+	vertexPositions.resize(positions.size());
+	vertexNormals.resize(positions.size());
+
+	// Pad to a multiple of 4; padding particles have no mass, so they never move
+	const size_t paddedSize = ((size_t)numParticles + 3) & ~(size_t)3;
+	positionX.resize(paddedSize);
+	positionY.resize(paddedSize);
+	positionZ.resize(paddedSize);
+	inverseMass.resize(paddedSize);
+
+	for (unsigned int i = 0; i < numParticles; i++)
+	{
+		const glm::vec3 worldPosition = glm::vec3(transform * glm::vec4(localPositions[i], 1.0f));
+		positionX[i] = worldPosition.x;
+		positionY[i] = worldPosition.y;
+		positionZ[i] = worldPosition.z;
+		inverseMass[i] = isPinned(localPositions[i]) ? 0.0f : 1.0f;
+	}
+
+	previousX = positionX;
+	previousY = positionY;
+	previousZ = positionZ;
+
+	// Every edge becomes a stretch constraint. Triangles sharing an edge also get a bend
+	// constraint between their opposite vertices.
+	const std::span<const unsigned int> indices = model.GetIndices();
+	std::map<std::pair<unsigned int, unsigned int>, std::vector<unsigned int>> edges;
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		for (unsigned int j = 0; j < 3; j++)
+		{
+			particleIndices.push_back(vertexParticles[indices[i + j]]);
+		}
+
+		for (unsigned int j = 0; j < 3; j++)
+		{
+			unsigned int a = vertexParticles[indices[i + j]];
+			unsigned int b = vertexParticles[indices[i + (j + 1) % 3]];
+			const unsigned int opposite = vertexParticles[indices[i + (j + 2) % 3]];
+			if (a > b)
+			{
+				std::swap(a, b);
+			}
+			edges[std::make_pair(a, b)].push_back(opposite);
+		}
+	}
+
+	std::vector<unsigned long long> particleColors(numParticles, 0);
+	for (auto it = edges.begin(); it != edges.end(); ++it)
+	{
+		AddConstraint(it->first.first, it->first.second, settings.stretchStiffness, particleColors);
+	}
+
+	for (auto it = edges.begin(); it != edges.end(); ++it)
+	{
+		const std::vector<unsigned int>& opposites = it->second;
+		if (opposites.size() != 2 || opposites[0] == opposites[1])
+		{
+			continue;
+		}
+
+		const std::pair<unsigned int, unsigned int> bendEdge = opposites[0] < opposites[1]
+			? std::make_pair(opposites[0], opposites[1])
+			: std::make_pair(opposites[1], opposites[0]);
+		if (edges.count(bendEdge) == 0)
+		{
+			AddConstraint(bendEdge.first, bendEdge.second, settings.bendStiffness, particleColors);
+		}
+	}
+
+	for (ConstraintBatch& batch : batches)
+	{
+		const size_t paddedBatchSize = ((size_t)batch.numConstraints + 3) & ~(size_t)3;
+		batch.particleA.resize(paddedBatchSize, 0);
+		batch.particleB.resize(paddedBatchSize, 0);
+		batch.restLength.resize(paddedBatchSize, 0.0f);
+		batch.stiffness.resize(paddedBatchSize, 0.0f);
+	}
+
+	UpdateNormals();
+}
+
+void Cloth::AddConstraint(unsigned int a, unsigned int b, float stiffness,
+	std::vector<unsigned long long>& particleColors)
+{
+	if (a == b || (inverseMass[a] == 0.0f && inverseMass[b] == 0.0f))
+	{
+		return;
+	}
+
+	// Greedy colouring; use the first batch which neither particle is part of yet
+	const unsigned long long usedColors = particleColors[a] | particleColors[b];
+	unsigned int color = 0;
+	while (color < 63 && (usedColors & (1ull << color)) != 0)
+	{
+		color++;
+	}
+
+	particleColors[a] |= 1ull << color;
+	particleColors[b] |= 1ull << color;
+
+	if (batches.size() <= color)
+	{
+		batches.resize(color + 1);
+	}
+
+	const glm::vec3 delta(positionX[b] - positionX[a], positionY[b] - positionY[a],
+		positionZ[b] - positionZ[a]);
+
+	ConstraintBatch& batch = batches[color];
+	batch.particleA.push_back(a);
+	batch.particleB.push_back(b);
+	batch.restLength.push_back(glm::length(delta));
+	batch.stiffness.push_back(stiffness);
+	batch.numConstraints++;
+}
+
+void Cloth::Step(float timeStep, const ClothSphereCollider* spheres, unsigned int numSpheres)
+{
+	Integrate(timeStep);
+
+	for (unsigned int i = 0; i < settings.numIterations; i++)
+	{
+		for (const ConstraintBatch& batch : batches)
+		{
+			SolveBatch(batch);
+		}
+	}
+
+	SolveCollisions(spheres, numSpheres);
+	UpdateNormals();
+}
+
+void Cloth::UpdateVertexArray()
+{
+	for (size_t i = 0; i < vertexParticles.size(); i++)
+	{
+		const unsigned int particle = vertexParticles[i];
+		vertexPositions[i * 3] = positionX[particle];
+		vertexPositions[i * 3 + 1] = positionY[particle];
+		vertexPositions[i * 3 + 2] = positionZ[particle];
+		vertexNormals[i * 3] = particleNormals[particle * 3];
+		vertexNormals[i * 3 + 1] = particleNormals[particle * 3 + 1];
+		vertexNormals[i * 3 + 2] = particleNormals[particle * 3 + 2];
+	}
+
+	// Index 0 is the vertex positions, and index 2 the normals
+	vertexArray.UpdateBuffer(0, vertexPositions.data(), vertexPositions.size() * sizeof(float));
+	vertexArray.UpdateBuffer(2, vertexNormals.data(), vertexNormals.size() * sizeof(float));
+}
+
+void Cloth::UpdateNormals()
+{
+	// Normals are generated over the welded particles, so they stay smooth across seams
+	particlePositions.resize((size_t)numParticles * 3);
+	particleNormals.resize((size_t)numParticles * 3);
+	for (unsigned int i = 0; i < numParticles; i++)
+	{
+		particlePositions[i * 3] = positionX[i];
+		particlePositions[i * 3 + 1] = positionY[i];
+		particlePositions[i * 3 + 2] = positionZ[i];
+	}
+
+	normalGenerator.CalculateNormals(particlePositions, particleIndices, particleNormals);
+}
+
+void Cloth::Integrate(float timeStep)
+{
+	const unsigned int count = (unsigned int)positionX.size();
+	const glm::vec3 acceleration = settings.gravity * timeStep * timeStep;
+
+#if defined(GLENGINE_SSE2)
+	const __m128 damping = _mm_set1_ps(settings.damping);
+	const __m128 accelerationX = _mm_set1_ps(acceleration.x);
+	const __m128 accelerationY = _mm_set1_ps(acceleration.y);
+	const __m128 accelerationZ = _mm_set1_ps(acceleration.z);
+
+	for (unsigned int i = 0; i < count; i += 4)
+	{
+		// Pinned particles (no inverse mass) keep their position
+		const __m128 isMovable = _mm_cmpgt_ps(_mm_loadu_ps(&inverseMass[i]), _mm_setzero_ps());
+
+		const __m128 x = _mm_loadu_ps(&positionX[i]);
+		const __m128 y = _mm_loadu_ps(&positionY[i]);
+		const __m128 z = _mm_loadu_ps(&positionZ[i]);
+
+		// x' = x + (x - previous) * damping + a * dt^2
+		const __m128 newX = _mm_add_ps(_mm_add_ps(x, _mm_mul_ps(
+			_mm_sub_ps(x, _mm_loadu_ps(&previousX[i])), damping)), accelerationX);
+		const __m128 newY = _mm_add_ps(_mm_add_ps(y, _mm_mul_ps(
+			_mm_sub_ps(y, _mm_loadu_ps(&previousY[i])), damping)), accelerationY);
+		const __m128 newZ = _mm_add_ps(_mm_add_ps(z, _mm_mul_ps(
+			_mm_sub_ps(z, _mm_loadu_ps(&previousZ[i])), damping)), accelerationZ);
+
+		_mm_storeu_ps(&previousX[i], x);
+		_mm_storeu_ps(&previousY[i], y);
+		_mm_storeu_ps(&previousZ[i], z);
+
+		_mm_storeu_ps(&positionX[i], _mm_or_ps(_mm_and_ps(isMovable, newX),
+			_mm_andnot_ps(isMovable, x)));
+		_mm_storeu_ps(&positionY[i], _mm_or_ps(_mm_and_ps(isMovable, newY),
+			_mm_andnot_ps(isMovable, y)));
+		_mm_storeu_ps(&positionZ[i], _mm_or_ps(_mm_and_ps(isMovable, newZ),
+			_mm_andnot_ps(isMovable, z)));
+	}
+#else
+	for (unsigned int i = 0; i < count; i++)
+	{
+		const glm::vec3 position(positionX[i], positionY[i], positionZ[i]);
+		const glm::vec3 previous(previousX[i], previousY[i], previousZ[i]);
+
+		previousX[i] = position.x;
+		previousY[i] = position.y;
+		previousZ[i] = position.z;
+
+		if (inverseMass[i] > 0.0f)
+		{
+			const glm::vec3 newPosition = position + (position - previous) * settings.damping
+				+ acceleration;
+			positionX[i] = newPosition.x;
+			positionY[i] = newPosition.y;
+			positionZ[i] = newPosition.z;
+		}
+	}
+#endif
+}
+
+void Cloth::SolveBatch(const ConstraintBatch& batch)
+{
+	const unsigned int* particleA = batch.particleA.data();
+	const unsigned int* particleB = batch.particleB.data();
+
+#if defined(GLENGINE_SSE2)
+	const __m128 epsilon = _mm_set1_ps(EPSILON);
+
+	for (unsigned int i = 0; i < batch.numConstraints; i += 4)
+	{
+		const unsigned int* a = particleA + i;
+		const unsigned int* b = particleB + i;
+
+		// Gather the particles of 4 constraints
+		const __m128 ax = _mm_set_ps(positionX[a[3]], positionX[a[2]], positionX[a[1]],
+			positionX[a[0]]);
+		const __m128 ay = _mm_set_ps(positionY[a[3]], positionY[a[2]], positionY[a[1]],
+			positionY[a[0]]);
+		const __m128 az = _mm_set_ps(positionZ[a[3]], positionZ[a[2]], positionZ[a[1]],
+			positionZ[a[0]]);
+		const __m128 bx = _mm_set_ps(positionX[b[3]], positionX[b[2]], positionX[b[1]],
+			positionX[b[0]]);
+		const __m128 by = _mm_set_ps(positionY[b[3]], positionY[b[2]], positionY[b[1]],
+			positionY[b[0]]);
+		const __m128 bz = _mm_set_ps(positionZ[b[3]], positionZ[b[2]], positionZ[b[1]],
+			positionZ[b[0]]);
+		const __m128 wa = _mm_set_ps(inverseMass[a[3]], inverseMass[a[2]], inverseMass[a[1]],
+			inverseMass[a[0]]);
+		const __m128 wb = _mm_set_ps(inverseMass[b[3]], inverseMass[b[2]], inverseMass[b[1]],
+			inverseMass[b[0]]);
+
+		const __m128 dx = _mm_sub_ps(bx, ax);
+		const __m128 dy = _mm_sub_ps(by, ay);
+		const __m128 dz = _mm_sub_ps(bz, az);
+		const __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx),
+			_mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+
+		// Correction along the constraint, split between both particles by inverse mass
+		const __m128 denominator = _mm_mul_ps(length, _mm_add_ps(wa, wb));
+		const __m128 isValid = _mm_cmpgt_ps(denominator, epsilon);
+		const __m128 scale = _mm_and_ps(isValid, _mm_div_ps(
+			_mm_mul_ps(_mm_loadu_ps(&batch.stiffness[i]),
+				_mm_sub_ps(length, _mm_loadu_ps(&batch.restLength[i]))),
+			_mm_max_ps(denominator, epsilon)));
+
+		const __m128 scaleA = _mm_mul_ps(scale, wa);
+		const __m128 scaleB = _mm_mul_ps(scale, wb);
+
+		alignas(16) float results[6][4];
+		_mm_store_ps(results[0], _mm_add_ps(ax, _mm_mul_ps(dx, scaleA)));
+		_mm_store_ps(results[1], _mm_add_ps(ay, _mm_mul_ps(dy, scaleA)));
+		_mm_store_ps(results[2], _mm_add_ps(az, _mm_mul_ps(dz, scaleA)));
+		_mm_store_ps(results[3], _mm_sub_ps(bx, _mm_mul_ps(dx, scaleB)));
+		_mm_store_ps(results[4], _mm_sub_ps(by, _mm_mul_ps(dy, scaleB)));
+		_mm_store_ps(results[5], _mm_sub_ps(bz, _mm_mul_ps(dz, scaleB)));
+
+		// Scatter; padding constraints are skipped so they never overwrite real results
+		const unsigned int numValid = glm::min(batch.numConstraints - i, 4u);
+		for (unsigned int j = 0; j < numValid; j++)
+		{
+			positionX[a[j]] = results[0][j];
+			positionY[a[j]] = results[1][j];
+			positionZ[a[j]] = results[2][j];
+			positionX[b[j]] = results[3][j];
+			positionY[b[j]] = results[4][j];
+			positionZ[b[j]] = results[5][j];
+		}
+	}
+#else
+	for (unsigned int i = 0; i < batch.numConstraints; i++)
+	{
+		const unsigned int a = particleA[i];
+		const unsigned int b = particleB[i];
+
+		const glm::vec3 delta(positionX[b] - positionX[a], positionY[b] - positionY[a],
+			positionZ[b] - positionZ[a]);
+		const float length = glm::length(delta);
+		const float denominator = length * (inverseMass[a] + inverseMass[b]);
+		if (denominator <= EPSILON)
+		{
+			continue;
+		}
+
+		const glm::vec3 correction = delta * (batch.stiffness[i]
+			* (length - batch.restLength[i]) / denominator);
+		positionX[a] += correction.x * inverseMass[a];
+		positionY[a] += correction.y * inverseMass[a];
+		positionZ[a] += correction.z * inverseMass[a];
+		positionX[b] -= correction.x * inverseMass[b];
+		positionY[b] -= correction.y * inverseMass[b];
+		positionZ[b] -= correction.z * inverseMass[b];
+	}
+#endif
+}
+
+void Cloth::SolveCollisions(const ClothSphereCollider* spheres, unsigned int numSpheres)
+{
+	const unsigned int count = (unsigned int)positionX.size();
+
+	for (unsigned int s = 0; s < numSpheres; s++)
+	{
+		const glm::vec3& center = spheres[s].center;
+		const float radius = spheres[s].radius + settings.thickness;
+
+#if defined(GLENGINE_SSE2)
+		const __m128 centerX = _mm_set1_ps(center.x);
+		const __m128 centerY = _mm_set1_ps(center.y);
+		const __m128 centerZ = _mm_set1_ps(center.z);
+		const __m128 radiusValue = _mm_set1_ps(radius);
+		const __m128 radiusSquared = _mm_set1_ps(radius * radius);
+		const __m128 epsilon = _mm_set1_ps(EPSILON);
+
+		for (unsigned int i = 0; i < count; i += 4)
+		{
+			const __m128 x = _mm_loadu_ps(&positionX[i]);
+			const __m128 y = _mm_loadu_ps(&positionY[i]);
+			const __m128 z = _mm_loadu_ps(&positionZ[i]);
+			const __m128 dx = _mm_sub_ps(x, centerX);
+			const __m128 dy = _mm_sub_ps(y, centerY);
+			const __m128 dz = _mm_sub_ps(z, centerZ);
+			const __m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx),
+				_mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+			// Only movable particles inside the sphere are pushed out
+			const __m128 isInside = _mm_and_ps(
+				_mm_and_ps(_mm_cmplt_ps(distanceSquared, radiusSquared),
+					_mm_cmpgt_ps(distanceSquared, epsilon)),
+				_mm_cmpgt_ps(_mm_loadu_ps(&inverseMass[i]), _mm_setzero_ps()));
+
+			if (_mm_movemask_ps(isInside) == 0)
+			{
+				continue;
+			}
+
+			const __m128 scale = _mm_div_ps(radiusValue,
+				_mm_sqrt_ps(_mm_max_ps(distanceSquared, epsilon)));
+			_mm_storeu_ps(&positionX[i], _mm_or_ps(_mm_and_ps(isInside,
+				_mm_add_ps(centerX, _mm_mul_ps(dx, scale))), _mm_andnot_ps(isInside, x)));
+			_mm_storeu_ps(&positionY[i], _mm_or_ps(_mm_and_ps(isInside,
+				_mm_add_ps(centerY, _mm_mul_ps(dy, scale))), _mm_andnot_ps(isInside, y)));
+			_mm_storeu_ps(&positionZ[i], _mm_or_ps(_mm_and_ps(isInside,
+				_mm_add_ps(centerZ, _mm_mul_ps(dz, scale))), _mm_andnot_ps(isInside, z)));
+		}
+#else
+		for (unsigned int i = 0; i < count; i++)
+		{
+			const glm::vec3 delta = glm::vec3(positionX[i], positionY[i], positionZ[i]) - center;
+			const float distanceSquared = glm::dot(delta, delta);
+			if (inverseMass[i] == 0.0f || distanceSquared >= radius * radius
+				|| distanceSquared <= EPSILON)
+			{
+				continue;
+			}
+
+			const glm::vec3 position = center + delta * (radius / std::sqrt(distanceSquared));
+			positionX[i] = position.x;
+			positionY[i] = position.y;
+			positionZ[i] = position.z;
+		}
+#endif
+	}
+}
+
+IndexedModel Cloth::CreateGridModel(float width, float height, unsigned int resolutionX,
+	unsigned int resolutionY)
+{
+	IndexedModel model;
+	model.AllocateElement(3); // Positions
+	model.AllocateElement(2); // Texture Coordinates
+	model.AllocateElement(3); // Normals
+	model.AllocateElement(3); // Tangents
+	model.AllocateElement(1); // Ambient occlusion
+	model.SetInstancedElementStartIndex(5); // Begin instanced data
+	model.AllocateElement(16); // Transform matrix
+
+	for (unsigned int y = 0; y <= resolutionY; y++)
+	{
+		for (unsigned int x = 0; x <= resolutionX; x++)
+		{
+			const float u = (float)x / (float)resolutionX;
+			const float v = (float)y / (float)resolutionY;
+
+			model.AddElement3f(0, u * width, v * height, 0.0f);
+			model.AddElement2f(1, u, 1.0f - v);
+			model.AddElement3f(2, 0.0f, 0.0f, 1.0f);
+			model.AddElement3f(3, 1.0f, 0.0f, 0.0f);
+			model.AddElement1f(4, 0.0f);
+		}
+	}
+
+	const unsigned int rowSize = resolutionX + 1;
+	for (unsigned int y = 0; y < resolutionY; y++)
+	{
+		for (unsigned int x = 0; x < resolutionX; x++)
+		{
+			const unsigned int i = y * rowSize + x;
+			model.AddIndices3i(i, i + 1, i + rowSize + 1);
+			model.AddIndices3i(i, i + rowSize + 1, i + rowSize);
+		}
+	}
+
+	return model;
+}
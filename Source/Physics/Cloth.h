@@ -0,0 +1,138 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include "Rendering/VertexArray.h"
+#include "Rendering/TangentSpace.h"
+
+#include <GLM/glm.hpp>
+
+#include <functional>
+#include <vector>
+
+/** @brief Simulation parameters of a cloth. */
+struct ClothSettings
+{
+	glm::vec3 gravity = glm::vec3(0.0f, -9.8f, 0.0f);
+	// Fraction of velocity kept every step
+	float damping = 0.99f;
+	// Stiffness of stretch constraints (mesh edges), in [0, 1]
+	float stretchStiffness = 1.0f;
+	// Stiffness of bend constraints (across adjacent triangles), in [0, 1]
+	float bendStiffness = 0.2f;
+	// Number of constraint solver iterations per step
+	unsigned int numIterations = 8;
+	// Distance kept between the cloth and colliders
+	float thickness = 0.02f;
+};
+
+/** @brief Sphere which cloth particles collide with, in world space. */
+struct ClothSphereCollider
+{
+	glm::vec3 center;
+	float radius;
+};
+
+/**
+ * @brief Verlet cloth simulated over the vertices of a mesh. Vertices sharing a position are
+ * welded into a single particle, and every mesh edge becomes a distance constraint.
+ *
+ * Particles are stored as structure of arrays. Constraints are split into colour batches, where
+ * no two constraints of a batch share a particle, so each batch can be solved 4 constraints at a
+ * time with SIMD without any write conflicts.
+ *
+ * The cloth is simulated in world space, so it should be rendered with an identity transform.
+ */
+class Cloth
+{
+public:
+	/**
+	 * @param device Render device used to create the deforming vertex array.
+	 * @param model Model to simulate. Element 0 must be the vertex positions.
+	 * @param transform Initial model to world transform.
+	 * @param isPinned Called with the model space position of every particle; returns true if the
+	 *		particle should be held in place.
+	 * @param settings Simulation parameters.
+	 */
+	Cloth(RenderDevice& device, const IndexedModel& model, const glm::mat4& transform,
+		const std::function<bool(const glm::vec3&)>& isPinned,
+		const ClothSettings& settings = ClothSettings());
+
+	/**
+	 * @brief Advances the simulation by one step. Safe to call from any thread, as long as no
+	 *		other thread is accessing this cloth.
+	 * @param timeStep Time to advance by, in seconds.
+	 * @param spheres Array of spheres to collide with.
+	 * @param numSpheres Number of spheres.
+	 */
+	void Step(float timeStep, const ClothSphereCollider* spheres, unsigned int numSpheres);
+
+	/**
+	 * @brief Streams the simulated positions and normals into the vertex array. Must be called
+	 *		on the thread owning the render device.
+	 */
+	void UpdateVertexArray();
+
+	/**
+	 * @brief Creates a rectangular grid model in the XY plane, suitable for cloth.
+	 * @param width Width of the grid.
+	 * @param height Height of the grid.
+	 * @param resolutionX Number of quads along the width.
+	 * @param resolutionY Number of quads along the height.
+	 * @return Model with the same elements as LoadModels.
+	 */
+	static IndexedModel CreateGridModel(float width, float height, unsigned int resolutionX,
+		unsigned int resolutionY);
+
+	inline VertexArray& GetVertexArray() { return vertexArray; }
+	inline ClothSettings& GetSettings() { return settings; }
+	inline unsigned int GetNumParticles() const { return numParticles; }
+
+private:
+	// Disallow copy and assign
+	Cloth(const Cloth& other) = delete;
+	void operator=(const Cloth& other) = delete;
+
+	/** @brief Distance constraints which share no particles, padded to a multiple of 4. */
+	struct ConstraintBatch
+	{
+		std::vector<unsigned int> particleA;
+		std::vector<unsigned int> particleB;
+		std::vector<float> restLength;
+		std::vector<float> stiffness;
+		unsigned int numConstraints = 0;
+	};
+
+	void AddConstraint(unsigned int a, unsigned int b, float stiffness,
+		std::vector<unsigned long long>& particleColors);
+
+	void Integrate(float timeStep);
+	void SolveBatch(const ConstraintBatch& batch);
+	void SolveCollisions(const ClothSphereCollider* spheres, unsigned int numSpheres);
+	void UpdateNormals();
+
+	ClothSettings settings;
+	VertexArray vertexArray;
+	unsigned int numParticles;
+
+	std::vector<float> positionX;
+	std::vector<float> positionY;
+	std::vector<float> positionZ;
+	std::vector<float> previousX;
+	std::vector<float> previousY;
+	std::vector<float> previousZ;
+	std::vector<float> inverseMass;
+
+	std::vector<ConstraintBatch> batches;
+
+	// Triangles of the mesh, indexing particles rather than render vertices
+	std::vector<unsigned int> particleIndices;
+	std::vector<float> particlePositions;
+	std::vector<float> particleNormals;
+	TangentSpaceGenerator normalGenerator;
+
+	// Particle of each render vertex
+	std::vector<unsigned int> vertexParticles;
+	std::vector<float> vertexPositions;
+	std::vector<float> vertexNormals;
+};
@@ -0,0 +1,52 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#include "ClothSolver.h"
+#include "Timing.h"
+
+void ClothSolver::Update(float deltaTime)
+{
+	accumulator += deltaTime;
+
+	const double startTime = Timing::GetPreciseTime();
+	double stepDuration = 0.0;
+	unsigned int numSteps = 0;
+
+	while (accumulator >= timeStep && numSteps < maxSteps)
+	{
+		// Stop if another step would exceed the budget, judging by the cost of the last step
+		const double elapsed = Timing::GetPreciseTime() - startTime;
+		if (numSteps > 0 && elapsed + stepDuration > timeBudget)
+		{
+			break;
+		}
+
+		const double stepStart = Timing::GetPreciseTime();
+		jobSystem.ParallelFor((unsigned int)cloths.size(), 1,
+			[this](unsigned int begin, unsigned int end)
+			{
+				for (unsigned int i = begin; i < end; i++)
+				{
+					cloths[i]->Step(timeStep, spheres.data(), (unsigned int)spheres.size());
+				}
+			}
+		);
+		stepDuration = Timing::GetPreciseTime() - stepStart;
+
+		accumulator -= timeStep;
+		numSteps++;
+	}
+
+	// Drop whatever could not be simulated, instead of trying to catch up next frame
+	if (accumulator >= timeStep)
+	{
+		accumulator = 0.0f;
+	}
+
+	for (Cloth* cloth : cloths)
+	{
+		cloth->UpdateVertexArray();
+	}
+
+	cloths.clear();
+	spheres.clear();
+}
@@ -0,0 +1,58 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include "Cloth.h"
+#include "Jobs/JobSystem.h"
+
+#include <vector>
+
+/**
+ * @brief Steps every queued cloth in parallel on the job system. Cloths are advanced with a
+ * fixed time step; if stepping falls behind, or the time budget for a frame is exhausted, the
+ * remaining simulation time is dropped rather than carried over, so cloth never takes more than
+ * its share of a frame.
+ */
+class ClothSolver
+{
+public:
+	/**
+	 * @param jobSystem Job system to run the simulation on.
+	 * @param timeStep Fixed simulation time step, in seconds.
+	 * @param timeBudget Maximum time to spend simulating per update, in seconds.
+	 * @param maxSteps Maximum number of steps per update.
+	 */
+	ClothSolver(JobSystem& jobSystem, float timeStep = 1.0f / 60.0f, float timeBudget = 0.004f,
+		unsigned int maxSteps = 4) : jobSystem(jobSystem), timeStep(timeStep),
+		timeBudget(timeBudget), maxSteps(maxSteps), accumulator(0.0f) {}
+
+	/** @brief Queues a cloth to be simulated in the next update. */
+	inline void AddCloth(Cloth& cloth) { cloths.push_back(&cloth); }
+
+	/** @brief Adds a sphere which all cloths collide with in the next update. */
+	inline void AddSphereCollider(const glm::vec3& center, float radius)
+	{
+		spheres.push_back({ center, radius });
+	}
+
+	/**
+	 * @brief Simulates all queued cloths, uploads their vertices and clears the queues. Must be
+	 *		called on the thread owning the render device.
+	 * @param deltaTime Time since the last update.
+	 */
+	void Update(float deltaTime);
+
+private:
+	// Disallow copy and assign
+	ClothSolver(const ClothSolver& other) = delete;
+	void operator=(const ClothSolver& other) = delete;
+
+	JobSystem& jobSystem;
+	float timeStep;
+	float timeBudget;
+	unsigned int maxSteps;
+	float accumulator;
+
+	std::vector<Cloth*> cloths;
+	std::vector<ClothSphereCollider> spheres;
+};
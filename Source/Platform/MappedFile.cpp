@@ -0,0 +1,115 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile(const std::string& fileName) : data(nullptr), size(0), isOpen(false),
+	fileHandle(INVALID_HANDLE_VALUE), mappingHandle(nullptr)
+{
+	fileHandle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+	{
+		return;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize))
+	{
+		return;
+	}
+
+	size = (size_t)fileSize.QuadPart;
+	if (size == 0)
+	{
+		// Empty files cannot be mapped, but are still valid
+		isOpen = true;
+		return;
+	}
+
+	mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mappingHandle == nullptr)
+	{
+		return;
+	}
+
+	data = (const char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	isOpen = data != nullptr;
+}
+
+MappedFile::~MappedFile()
+{
+	if (data != nullptr)
+	{
+		UnmapViewOfFile(data);
+	}
+
+	if (mappingHandle != nullptr)
+	{
+		CloseHandle(mappingHandle);
+	}
+
+	if (fileHandle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(fileHandle);
+	}
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& fileName) : data(nullptr), size(0), isOpen(false),
+	fileHandle(nullptr), mappingHandle(nullptr)
+{
+	const int file = open(fileName.c_str(), O_RDONLY);
+	if (file == -1)
+	{
+		return;
+	}
+
+	struct stat fileStatus;
+	if (fstat(file, &fileStatus) == 0)
+	{
+		size = (size_t)fileStatus.st_size;
+		if (size == 0)
+		{
+			// Empty files cannot be mapped, but are still valid
+			isOpen = true;
+		}
+		else
+		{
+			void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+			if (mapping != MAP_FAILED)
+			{
+				// The file is read front to back
+				madvise(mapping, size, MADV_SEQUENTIAL);
+				data = (const char*)mapping;
+				isOpen = true;
+			}
+		}
+	}
+
+	// The mapping keeps the file open by itself
+	close(file);
+}
+
+MappedFile::~MappedFile()
+{
+	if (data != nullptr)
+	{
+		munmap((void*)data, size);
+	}
+}
+
+#endif
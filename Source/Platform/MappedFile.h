@@ -0,0 +1,37 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief Read only view of a whole file, mapped into memory by the operating system. Pages are
+ * read from disk as they are first touched, so large files can be parsed without copying them
+ * into memory first, and from several threads at once.
+ */
+class MappedFile
+{
+public:
+	/** @param fileName Path of the file to map. Check IsOpen to see whether it was mapped. */
+	explicit MappedFile(const std::string& fileName);
+	virtual ~MappedFile();
+
+	/** @return Whether the file was mapped. Empty files are open, with no data. */
+	inline bool IsOpen() const { return isOpen; }
+
+	inline const char* GetData() const { return data; }
+	inline size_t GetSize() const { return size; }
+
+private:
+	// Disallow copy and assign
+	MappedFile(const MappedFile& other) = delete;
+	void operator=(const MappedFile& other) = delete;
+
+	const char* data;
+	size_t size;
+	bool isOpen;
+	// Platform handles of the file and its mapping
+	void* fileHandle;
+	void* mappingHandle;
+};
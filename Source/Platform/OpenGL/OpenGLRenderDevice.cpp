@@ -25,12 +25,20 @@
  */
 
 #include "OpenGLRenderDevice.h"
+#include "Log.h"
 
 #include <string>
 #include <cstring> // std::memcpy
 #include <vector>
 #include <unordered_map>
-#include <iostream>
+#include <stdexcept>
+
+// Number of frames pooled resources are kept for while unused
+static const unsigned long long POOL_LIFETIME = 120;
+// Smallest buffer capacity; smaller buffers are rounded up to it
+static const size_t MIN_POOLED_BUFFER_SIZE = 256;
+// Larger buffers are allocated at their exact size, and deleted rather than pooled
+static const size_t MAX_POOLED_BUFFER_SIZE = 16 * 1024 * 1024;
 
 /**
  * @brief Compiles and adds an OpenGL shader to an OpenGL shader program.
@@ -65,16 +73,23 @@ static bool CheckShaderError(GLuint shader, int flag, bool isProgram,
 	const std::string& errorMessage);
 
 /**
- * @brief Fetches all uniform blocks and uniform variables from an OpenGL shader.
- * @note Non-sampler2D uniforms are currently unsupported.
+ * @brief Fetches all uniform blocks and sampler uniforms from an OpenGL shader.
+ * @note Only sampler2D and samplerBuffer uniforms are added to the sampler map.
  * @param shaderProgram Target shader program ID.
  * @param uniformMap Map to push uniform block names and locations to, for future lookup.
- * @param samplerMap Map to push sampler2D uniform names and locations to, for future lookup.
+ * @param samplerMap Map to push sampler uniform names and locations to, for future lookup.
  */
 static void AddShaderUniforms(GLuint shaderProgram, 
 	std::unordered_map<std::string, GLint>& uniformMap,
 	std::unordered_map<std::string, GLint>& samplerMap);
 
+/**
+ * @brief Rounds a buffer size up to the capacity buffers are allocated and pooled with.
+ * @param dataSize Size of the data in bytes.
+ * @return The next power of two, or the size itself if too large to be pooled.
+ */
+static size_t GetBufferCapacity(size_t dataSize);
+
 bool OpenGLRenderDevice::isInitialized = false;
 
 bool OpenGLRenderDevice::GlobalInit()
@@ -90,21 +105,19 @@ bool OpenGLRenderDevice::GlobalInit()
 	// Attempt to set core profile
 	if (SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE) != 0)
 	{
-		std::cerr << "Warning: Could not set core OpenGL profile" << std::endl;
+		Log::Warning("Could not set core OpenGL profile");
 		isInitialized = false;
 	}
 	// Attempt to set major version
 	if (SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, major) != 0)
 	{
-		std::cerr << "Error: Could not set major OpenGL version to " << major << ": "
-			<< SDL_GetError() << std::endl;
+		Log::Error("Could not set major OpenGL version to {}: {}", major, SDL_GetError());
 		isInitialized = false;
 	}
 	// Attempt to set minor version
 	if (SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, minor) != 0)
 	{
-		std::cerr << "Error: Could not set minor OpenGL version to " << minor << ": "
-			<< SDL_GetError() << std::endl;
+		Log::Error("Could not set minor OpenGL version to {}: {}", minor, SDL_GetError());
 		isInitialized = false;
 	}
 
@@ -114,6 +127,9 @@ bool OpenGLRenderDevice::GlobalInit()
 OpenGLRenderDevice::OpenGLRenderDevice(Window& window) : 
 	shaderVersion(""), 
 	version(0),
+	nextFenceID(1),
+	frameNumber(0),
+	releaseLatency(3),
 	boundFBO(0),
 	viewportFBO(0),
 	boundVAO(0),
@@ -143,7 +159,9 @@ OpenGLRenderDevice::OpenGLRenderDevice(Window& window) :
 	const GLenum result = glewInit();
 	if (result != GLEW_OK)
 	{
-		std::cerr << "Error: " << glewGetErrorString(result) << std::endl;
+		Log::Error("{}", (const char*)glewGetErrorString(result));
+		// Messages are written asynchronously, so make sure this one is before unwinding
+		Log::Flush();
 		throw std::runtime_error("Render device failed to initialize.");
 	}
 
@@ -162,9 +180,74 @@ OpenGLRenderDevice::OpenGLRenderDevice(Window& window) :
 OpenGLRenderDevice::~OpenGLRenderDevice()
 {
 	// Cleanup
+	for (auto it = fenceMap.begin(); it != fenceMap.end(); ++it)
+	{
+		glDeleteSync(it->second);
+	}
+
+	// Released resources are recycled first, then everything in the pools is deleted
+	for (const PendingRelease& release : pendingReleases)
+	{
+		DestroyResource(release);
+	}
+	for (auto it = bufferPool.begin(); it != bufferPool.end(); ++it)
+	{
+		for (const PooledResource& buffer : it->second)
+		{
+			glDeleteBuffers(1, &buffer.id);
+		}
+	}
+	for (auto it = texturePool.begin(); it != texturePool.end(); ++it)
+	{
+		for (const PooledResource& texture : it->second)
+		{
+			glDeleteTextures(1, &texture.id);
+		}
+	}
+
 	SDL_GL_DeleteContext(context);
 }
 
+void OpenGLRenderDevice::EndFrame()
+{
+	frameNumber++;
+
+	// Releases are queued in frame order, so only the front needs to be checked
+	while (!pendingReleases.empty() &&
+		pendingReleases.front().frame + releaseLatency <= frameNumber)
+	{
+		DestroyResource(pendingReleases.front());
+		pendingReleases.pop_front();
+	}
+
+	// Resources are added to the back of their pool and taken from the back, so the pool is
+	// ordered from least to most recently added; delete from the front while unused for too long
+	for (auto it = bufferPool.begin(); it != bufferPool.end(); ++it)
+	{
+		std::vector<PooledResource>& pool = it->second;
+		size_t numExpired = 0;
+		while (numExpired < pool.size() && pool[numExpired].frame + POOL_LIFETIME < frameNumber)
+		{
+			glDeleteBuffers(1, &pool[numExpired].id);
+			numExpired++;
+		}
+		pool.erase(pool.begin(), pool.begin() + numExpired);
+	}
+
+	for (auto it = texturePool.begin(); it != texturePool.end(); ++it)
+	{
+		std::vector<PooledResource>& pool = it->second;
+		size_t numExpired = 0;
+		while (numExpired < pool.size() && pool[numExpired].frame + POOL_LIFETIME < frameNumber)
+		{
+			glDeleteTextures(1, &pool[numExpired].id);
+			textureMap.erase(pool[numExpired].id);
+			numExpired++;
+		}
+		pool.erase(pool.begin(), pool.begin() + numExpired);
+	}
+}
+
 unsigned int OpenGLRenderDevice::CreateRenderTarget(unsigned int texture, unsigned int width, 
 	unsigned int height, FramebufferAttachment attachment, unsigned int attachmentNumber, 
 	unsigned int mipLevel)
@@ -208,12 +291,26 @@ unsigned int OpenGLRenderDevice::ReleaseRenderTarget(unsigned int fbo)
 		return 0;
 	}
 
-	// Delete framebuffer and associated data...
-	glDeleteFramebuffers(1, &fbo);
-	fboMap.erase(it);
+	// Delete the framebuffer once frames in flight are done with it
+	pendingReleases.push_back({ RESOURCE_RENDER_TARGET, fbo, frameNumber });
 	return 0;
 }
 
+void OpenGLRenderDevice::GetRenderTargetSize(unsigned int fbo, unsigned int& width,
+	unsigned int& height)
+{
+	const std::unordered_map<unsigned int, FBOData>::iterator it = fboMap.find(fbo);
+	if (it == fboMap.end())
+	{
+		width = 0;
+		height = 0;
+		return;
+	}
+
+	width = it->second.width;
+	height = it->second.height;
+}
+
 unsigned int OpenGLRenderDevice::CreateVertexArray(const float** vertexData, 
 	const unsigned int* vertexElementSizes, unsigned int numVertexComponents, 
 	unsigned int numInstanceComponents, unsigned int numVertices, const unsigned int* indices, 
@@ -230,7 +327,6 @@ unsigned int OpenGLRenderDevice::CreateVertexArray(const float** vertexData,
 	glGenVertexArrays(1, &vao);
 	SetVAO(vao);
 
-	glGenBuffers(numBuffers, buffers);
 	for (unsigned int i = 0, attribute = 0; i < numBuffers - 1; i++)
 	{
 		BufferUsage attributeUsage = usage;
@@ -251,9 +347,9 @@ unsigned int OpenGLRenderDevice::CreateVertexArray(const float** vertexData,
 			? elementSize * sizeof(float) 
 			: elementSize * sizeof(float) * numVertices;
 
-		glBindBuffer(GL_ARRAY_BUFFER, buffers[i]);
-		glBufferData(GL_ARRAY_BUFFER, dataSize, bufferData, attributeUsage);
-		bufferSizes[i] = dataSize;
+		// Leaves the buffer bound, for the attribute pointers below
+		buffers[i] = AcquireBuffer(GL_ARRAY_BUFFER, bufferData, dataSize, attributeUsage,
+			bufferSizes[i]);
 
 		// Because OpenGL doesn't support attributes with more than 4 elements, each set of 4 
 		// elements gets its own attribute.
@@ -302,10 +398,8 @@ unsigned int OpenGLRenderDevice::CreateVertexArray(const float** vertexData,
 
 	// Bind vertex array indices...
 	const size_t indicesSize = numIndices * sizeof(unsigned int);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[numBuffers - 1]);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indicesSize, indices, usage);
-
-	bufferSizes[numBuffers - 1] = indicesSize;
+	buffers[numBuffers - 1] = AcquireBuffer(GL_ELEMENT_ARRAY_BUFFER, indices, indicesSize, usage,
+		bufferSizes[numBuffers - 1]);
 
 	VertexArray vaoData;
 	vaoData.buffers = buffers;
@@ -357,8 +451,15 @@ void OpenGLRenderDevice::UpdateVertexArrayBuffer(unsigned int vao, unsigned int
 	}
 	else // More memory needs to be allocated for this buffer
 	{
-		glBufferData(GL_ARRAY_BUFFER, dataSize, data, usage);
-		vaoData->bufferSizes[bufferIndex] = dataSize;
+		// Round up like pooled buffers, so that growing buffers are reallocated less often and
+		// can be recycled when released
+		const size_t capacity = GetBufferCapacity(dataSize);
+		glBufferData(GL_ARRAY_BUFFER, capacity, capacity == dataSize ? data : nullptr, usage);
+		if (capacity != dataSize)
+		{
+			glBufferSubData(GL_ARRAY_BUFFER, 0, dataSize, data);
+		}
+		vaoData->bufferSizes[bufferIndex] = capacity;
 	}
 }
 
@@ -379,14 +480,8 @@ unsigned int OpenGLRenderDevice::ReleaseVertexArray(unsigned int vao)
 		return 0;
 	}
 
-	// Delete the VAO...
-	const VertexArray* vaoData = &it->second;
-	glDeleteVertexArrays(1, &vao);
-	glDeleteBuffers(vaoData->numBuffers, vaoData->buffers);
-	delete[] vaoData->buffers;
-	delete[] vaoData->bufferSizes;
-	vaoMap.erase(it);
-
+	// Delete the VAO once frames in flight are done with it
+	pendingReleases.push_back({ RESOURCE_VERTEX_ARRAY, vao, frameNumber });
 	return 0;
 }
 
@@ -429,7 +524,7 @@ static GLint GetOpenGLFormat(OpenGLRenderDevice::PixelFormat format)
 	case OpenGLRenderDevice::FORMAT_DEPTH: return GL_DEPTH_COMPONENT;
 	case OpenGLRenderDevice::FORMAT_DEPTH_AND_STENCIL: return GL_DEPTH_STENCIL;
 	default:
-		std::cerr << "Error: PixelFormat " << format << " is not a valid PixelFormat." << std::endl;
+		Log::Error("PixelFormat {} is not a valid PixelFormat.", format);
 		return 0;
 	}
 }
@@ -455,7 +550,7 @@ static GLint GetOpenGLInternalFormat(OpenGLRenderDevice::PixelFormat format, boo
 	case OpenGLRenderDevice::FORMAT_DEPTH: return GL_DEPTH_COMPONENT;
 	case OpenGLRenderDevice::FORMAT_DEPTH_AND_STENCIL: return GL_DEPTH_STENCIL;
 	default:
-		std::cerr << "Error: PixelFormat " << format << " is not a valid PixelFormat." << std::endl;
+		Log::Error("PixelFormat {} is not a valid PixelFormat.", format);
 		return 0;
 	}
 }
@@ -483,6 +578,34 @@ unsigned int OpenGLRenderDevice::CreateTexture2D(int width, int height, const vo
 		currentUnpackAlignment = unpackAlignment;
 	}
 
+	// Reuse a released texture of the same shape if there is one. Compressed textures are never
+	// pooled, as they cannot be updated from uncompressed data.
+	if (!compress)
+	{
+		const std::map<TextureShape, std::vector<PooledResource>>::iterator poolIt =
+			texturePool.find(TextureShape(width, height, glInternalFormat, generateMipmaps));
+
+		if (poolIt != texturePool.end() && !poolIt->second.empty())
+		{
+			textureHandle = poolIt->second.back().id;
+			poolIt->second.pop_back();
+
+			glBindTexture(textureTarget, textureHandle);
+			if (data != nullptr)
+			{
+				glTexSubImage2D(textureTarget, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE,
+					data);
+			}
+
+			if (generateMipmaps)
+			{
+				glGenerateMipmap(textureTarget);
+			}
+
+			return textureHandle;
+		}
+	}
+
 	glGenTextures(1, &textureHandle);
 	glBindTexture(textureTarget, textureHandle);
 	glTexParameterf(textureTarget, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -502,6 +625,14 @@ unsigned int OpenGLRenderDevice::CreateTexture2D(int width, int height, const vo
 		glTexParameteri(textureTarget, GL_TEXTURE_MAX_LEVEL, 0);
 	}
 
+	TextureData textureData;
+	textureData.width = width;
+	textureData.height = height;
+	textureData.internalFormat = glInternalFormat;
+	textureData.hasMipmaps = generateMipmaps;
+	textureData.isCompressed = compress;
+	textureMap[textureHandle] = textureData;
+
 	return textureHandle;
 }
 
@@ -513,17 +644,19 @@ unsigned int OpenGLRenderDevice::ReleaseTexture2D(unsigned int texture2D)
 		return 0;
 	}
 
-	glDeleteTextures(1, &texture2D);
+	// Recycle the texture once frames in flight are done with it
+	pendingReleases.push_back({ RESOURCE_TEXTURE, texture2D, frameNumber });
 	return 0;
 }
 
 unsigned int OpenGLRenderDevice::CreateUniformBuffer(const void* data, size_t dataSize, 
 	BufferUsage usage)
 {
-	unsigned int ubo;
-	glGenBuffers(1, &ubo);
-	glBindBuffer(GL_UNIFORM_BUFFER, ubo);
-	glBufferData(GL_UNIFORM_BUFFER, dataSize, data, usage);
+	BufferData bufferData;
+	bufferData.usage = usage;
+	const unsigned int ubo = AcquireBuffer(GL_UNIFORM_BUFFER, data, dataSize, usage,
+		bufferData.capacity);
+	uniformBufferMap[ubo] = bufferData;
 	return ubo;
 }
 
@@ -543,6 +676,126 @@ unsigned int OpenGLRenderDevice::ReleaseUniformBuffer(unsigned int buffer)
 		return 0;
 	}
 
+	// Recycle the buffer once frames in flight are done with it
+	pendingReleases.push_back({ RESOURCE_UNIFORM_BUFFER, buffer, frameNumber });
+	return 0;
+}
+
+unsigned int OpenGLRenderDevice::CreateTextureBuffer(const void* data, size_t dataSize,
+	BufferUsage usage)
+{
+	TextureBufferData textureBufferData;
+	textureBufferData.capacity = dataSize;
+	textureBufferData.usage = usage;
+	glGenBuffers(1, &textureBufferData.buffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, textureBufferData.buffer);
+	glBufferData(GL_TEXTURE_BUFFER, dataSize, data, usage);
+
+	unsigned int texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_BUFFER, texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, textureBufferData.buffer);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+	textureBufferMap[texture] = textureBufferData;
+	return texture;
+}
+
+void OpenGLRenderDevice::UpdateTextureBuffer(unsigned int textureBuffer, const void* data,
+	size_t dataSize)
+{
+	const std::unordered_map<unsigned int, TextureBufferData>::iterator it =
+		textureBufferMap.find(textureBuffer);
+	if (it == textureBufferMap.end())
+	{
+		return;
+	}
+
+	TextureBufferData& textureBufferData = it->second;
+	if (dataSize > textureBufferData.capacity)
+	{
+		textureBufferData.capacity = GetBufferCapacity(dataSize);
+	}
+
+	// Orphan the data store rather than writing over one that draws may still be reading. The
+	// texture refers to the buffer object, so it sees the new data store without being rebound.
+	glBindBuffer(GL_TEXTURE_BUFFER, textureBufferData.buffer);
+	glBufferData(GL_TEXTURE_BUFFER, textureBufferData.capacity, nullptr, textureBufferData.usage);
+	glBufferSubData(GL_TEXTURE_BUFFER, 0, dataSize, data);
+}
+
+unsigned int OpenGLRenderDevice::ReleaseTextureBuffer(unsigned int textureBuffer)
+{
+	// Texture buffer 0 is null, nothing to delete.
+	if (textureBuffer == 0)
+	{
+		return 0;
+	}
+
+	// Delete the texture buffer once frames in flight are done with it
+	pendingReleases.push_back({ RESOURCE_TEXTURE_BUFFER, textureBuffer, frameNumber });
+	return 0;
+}
+
+size_t OpenGLRenderDevice::GetMaxTextureBufferSize()
+{
+	// The limit is in texels, each of which is 4 floats
+	GLint maxTexels;
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+	return (size_t)maxTexels * 4 * sizeof(float);
+}
+
+unsigned int OpenGLRenderDevice::CreatePixelPackBuffer(size_t dataSize)
+{
+	unsigned int pbo;
+	glGenBuffers(1, &pbo);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+	// Written by the GPU, read once by the CPU
+	glBufferData(GL_PIXEL_PACK_BUFFER, dataSize, nullptr, GL_STREAM_READ);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	return pbo;
+}
+
+void OpenGLRenderDevice::ReadPixels(unsigned int fbo, unsigned int buffer, unsigned int width,
+	unsigned int height)
+{
+	SetFBO(fbo);
+
+	// With a pixel pack buffer bound, glReadPixels queues a copy into the buffer and returns
+	// without waiting for the GPU; the last parameter is an offset into the buffer
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+	glReadPixels(0, 0, (GLsizei)width, (GLsizei)height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+bool OpenGLRenderDevice::CopyPixelPackBuffer(unsigned int buffer, void* destination,
+	size_t dataSize)
+{
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+	const void* source = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)dataSize,
+		GL_MAP_READ_BIT);
+
+	if (source == nullptr)
+	{
+		Log::Error("Failed to map pixel pack buffer {}", buffer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		return false;
+	}
+
+	std::memcpy(destination, source, dataSize);
+	glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	return true;
+}
+
+unsigned int OpenGLRenderDevice::ReleasePixelPackBuffer(unsigned int buffer)
+{
+	// Pixel pack buffer 0 is null, nothing to delete.
+	if (buffer == 0)
+	{
+		return 0;
+	}
+
 	glDeleteBuffers(1, &buffer);
 	return 0;
 }
@@ -554,7 +807,7 @@ unsigned int OpenGLRenderDevice::CreateShaderProgram(const std::string& shaderTe
 	// Should never be 0 as shader 0 is null. Something went wrong...
 	if (shaderProgram == 0)
 	{
-		std::cerr << "Error creating shader program." << std::endl;
+		Log::Error("Could not create shader program.");
 		return (unsigned int)-1;
 	}
 
@@ -564,7 +817,7 @@ unsigned int OpenGLRenderDevice::CreateShaderProgram(const std::string& shaderTe
 	// We did not find #version. This is likely because the shader is missing #version; error.
 	if (defineInsertPosition == std::string::npos)
 	{
-		std::cerr << "Error: Shader program is missing #version directive." << std::endl;
+		Log::Error("Shader program is missing #version directive.");
 		return (unsigned int)-1;
 	}
 
@@ -623,6 +876,17 @@ void OpenGLRenderDevice::SetShaderSampler(unsigned int shader, const std::string
 	glUniform1i(shaderProgramMap[shader].samplerMap[samplerName], unit);
 }
 
+void OpenGLRenderDevice::SetShaderTextureBuffer(unsigned int shader,
+	const std::string& samplerName, unsigned int textureBuffer, unsigned int unit)
+{
+	SetShader(shader);
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_BUFFER, textureBuffer);
+	// Texture buffers are read with texelFetch, which ignores sampler objects
+	glBindSampler(unit, 0);
+	glUniform1i(shaderProgramMap[shader].samplerMap[samplerName], unit);
+}
+
 unsigned int OpenGLRenderDevice::ReleaseShaderProgram(unsigned int shader)
 {
 	// Shader program 0 is null, nothing to delete.
@@ -775,6 +1039,211 @@ void OpenGLRenderDevice::SetDrawParameters(const OpenGLRenderDevice::DrawParamet
 	SetDepthTest(drawParameters.shouldWriteDepth, drawParameters.depthFunc);
 }
 
+unsigned int OpenGLRenderDevice::CreateFence()
+{
+	GLsync sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	if (sync == 0)
+	{
+		Log::Error("Failed to create fence");
+		return 0;
+	}
+
+	unsigned int fence = nextFenceID++;
+	fenceMap[fence] = sync;
+	return fence;
+}
+
+bool OpenGLRenderDevice::WaitFence(unsigned int fence, uint64_t timeout)
+{
+	const std::unordered_map<unsigned int, GLsync>::iterator it = fenceMap.find(fence);
+	if (it == fenceMap.end())
+	{
+		return true;
+	}
+
+	// Flushing guarantees the fence itself reaches the GPU, otherwise the wait could never end
+	GLenum result = glClientWaitSync(it->second, GL_SYNC_FLUSH_COMMANDS_BIT, (GLuint64)timeout);
+	if (result == GL_WAIT_FAILED)
+	{
+		Log::Error("Failed to wait on fence {}", fence);
+		return true;
+	}
+	return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+}
+
+unsigned int OpenGLRenderDevice::ReleaseFence(unsigned int fence)
+{
+	const std::unordered_map<unsigned int, GLsync>::iterator it = fenceMap.find(fence);
+	if (it == fenceMap.end())
+	{
+		return 0;
+	}
+
+	glDeleteSync(it->second);
+	fenceMap.erase(it);
+	return 0;
+}
+
+static size_t GetBufferCapacity(size_t dataSize)
+{
+	if (dataSize > MAX_POOLED_BUFFER_SIZE)
+	{
+		return dataSize;
+	}
+
+	size_t capacity = MIN_POOLED_BUFFER_SIZE;
+	while (capacity < dataSize)
+	{
+		capacity *= 2;
+	}
+	return capacity;
+}
+
+unsigned int OpenGLRenderDevice::AcquireBuffer(GLenum target, const void* data, size_t dataSize,
+	BufferUsage usage, size_t& capacity)
+{
+	capacity = GetBufferCapacity(dataSize);
+
+	const std::map<BufferShape, std::vector<PooledResource>>::iterator poolIt =
+		bufferPool.find(BufferShape(capacity, usage));
+
+	unsigned int buffer;
+	if (poolIt != bufferPool.end() && !poolIt->second.empty())
+	{
+		// Reuse the most recently released buffer; its storage is already allocated
+		buffer = poolIt->second.back().id;
+		poolIt->second.pop_back();
+		glBindBuffer(target, buffer);
+	}
+	else
+	{
+		glGenBuffers(1, &buffer);
+		glBindBuffer(target, buffer);
+		glBufferData(target, capacity, capacity == dataSize ? data : nullptr, usage);
+		if (capacity == dataSize)
+		{
+			return buffer;
+		}
+	}
+
+	if (data != nullptr && dataSize > 0)
+	{
+		glBufferSubData(target, 0, dataSize, data);
+	}
+	return buffer;
+}
+
+void OpenGLRenderDevice::RecycleBuffer(unsigned int buffer, size_t capacity, BufferUsage usage)
+{
+	// Buffers at their exact size would rarely be requested again
+	if (capacity > MAX_POOLED_BUFFER_SIZE)
+	{
+		glDeleteBuffers(1, &buffer);
+		return;
+	}
+
+	bufferPool[BufferShape(capacity, usage)].push_back({ buffer, frameNumber });
+}
+
+void OpenGLRenderDevice::DestroyResource(const PendingRelease& release)
+{
+	switch (release.type)
+	{
+	case RESOURCE_VERTEX_ARRAY:
+	{
+		const std::unordered_map<unsigned int, VertexArray>::iterator it =
+			vaoMap.find(release.id);
+		if (it == vaoMap.end())
+		{
+			return;
+		}
+
+		const VertexArray* vaoData = &it->second;
+		glDeleteVertexArrays(1, &release.id);
+		// Deleting a bound VAO binds VAO 0, and the ID may be given to a new VAO
+		if (boundVAO == release.id)
+		{
+			boundVAO = 0;
+		}
+
+		for (unsigned int i = 0; i < vaoData->numBuffers; i++)
+		{
+			// Instance components are always dynamic; see CreateVertexArray
+			const bool isInstanceComponent = i >= vaoData->instanceComponentsStartIndex &&
+				i < vaoData->numBuffers - 1;
+			RecycleBuffer(vaoData->buffers[i], vaoData->bufferSizes[i],
+				isInstanceComponent ? USAGE_DYNAMIC_DRAW : vaoData->usage);
+		}
+
+		delete[] vaoData->buffers;
+		delete[] vaoData->bufferSizes;
+		vaoMap.erase(it);
+		break;
+	}
+	case RESOURCE_TEXTURE:
+	{
+		const std::unordered_map<unsigned int, TextureData>::iterator it =
+			textureMap.find(release.id);
+		if (it == textureMap.end() || it->second.isCompressed)
+		{
+			glDeleteTextures(1, &release.id);
+			if (it != textureMap.end())
+			{
+				textureMap.erase(it);
+			}
+			return;
+		}
+
+		const TextureData& textureData = it->second;
+		texturePool[TextureShape(textureData.width, textureData.height,
+			textureData.internalFormat, textureData.hasMipmaps)].push_back(
+				{ release.id, frameNumber });
+		break;
+	}
+	case RESOURCE_UNIFORM_BUFFER:
+	{
+		const std::unordered_map<unsigned int, BufferData>::iterator it =
+			uniformBufferMap.find(release.id);
+		if (it == uniformBufferMap.end())
+		{
+			glDeleteBuffers(1, &release.id);
+			return;
+		}
+
+		RecycleBuffer(release.id, it->second.capacity, it->second.usage);
+		uniformBufferMap.erase(it);
+		break;
+	}
+	case RESOURCE_TEXTURE_BUFFER:
+	{
+		const std::unordered_map<unsigned int, TextureBufferData>::iterator it =
+			textureBufferMap.find(release.id);
+		glDeleteTextures(1, &release.id);
+		if (it != textureBufferMap.end())
+		{
+			glDeleteBuffers(1, &it->second.buffer);
+			textureBufferMap.erase(it);
+		}
+		break;
+	}
+	case RESOURCE_RENDER_TARGET:
+		glDeleteFramebuffers(1, &release.id);
+		fboMap.erase(release.id);
+		if (boundFBO == release.id)
+		{
+			boundFBO = 0;
+		}
+		if (viewportFBO == release.id)
+		{
+			// Forces the viewport to be set again
+			viewportFBO = 0;
+			viewportWidth = 0;
+			viewportHeight = 0;
+		}
+		break;
+	}
+}
+
 void OpenGLRenderDevice::SetFBO(unsigned int fbo)
 {
 	// If the specified framebuffer object (FBO) is already bound, no change is needed.
@@ -1053,8 +1522,7 @@ std::string OpenGLRenderDevice::GetShaderVersion()
 	{
 		const int majorVersion = version / 100;
 		const int minorVersion = (version / 10) % 10;
-		std::cerr << "Error: OpenGL Version " << majorVersion << "." << minorVersion <<
-			"does not support shaders." << std::endl;
+		Log::Error("OpenGL Version {}.{} does not support shaders.", majorVersion, minorVersion);
 		return "";
 	}
 
@@ -1069,7 +1537,7 @@ bool AddShader(GLuint shaderProgram, const std::string& text, GLenum type,
 	// Should never be 0 as shader 0 is null. Something went wrong...
 	if (shader == 0)
 	{
-		std::cerr << "Error creating shader type " << type << std::endl;
+		Log::Error("Could not create shader type {}", type);
 		return false;
 	}
 
@@ -1091,8 +1559,7 @@ bool AddShader(GLuint shaderProgram, const std::string& text, GLenum type,
 		GLchar infoLog[1024]; // Error message string will always be 1024 in length
 
 		glGetShaderInfoLog(shader, 1024, NULL, infoLog);
-		std::cerr << "Error compiling shader type " << shader << ": '" << infoLog << " '"
-			<< std::endl;
+		Log::Error("Could not compile shader type {}: '{}'", shader, infoLog);
 		return false;
 	}
 
@@ -1156,7 +1623,7 @@ bool CheckShaderError(GLuint shader, int flag, bool isProgram, const std::string
 			glGetShaderInfoLog(shader, sizeof(error), NULL, error);
 		}
 
-		std::cerr << errorMessage << ": " << error << std::endl;
+		Log::Error("{}: {}", errorMessage, error);
 		return true;
 	}
 	return false;
@@ -1181,26 +1648,37 @@ void AddShaderUniforms(GLuint shaderProgram, std::unordered_map<std::string, GLi
 	}
 
 	// Get the number of active uniform variables for the program 
-	const GLint numUniforms = 0;
-	glGetProgramiv(shaderProgram, GL_ACTIVE_UNIFORMS, &numBlocks);
+	GLint numUniforms;
+	glGetProgramiv(shaderProgram, GL_ACTIVE_UNIFORMS, &numUniforms);
 
 	// Would get GL_ACTIVE_UNIFORM_MAX_LENGTH, but buggy on some drivers.
 	std::vector<GLchar> uniformName(256);
 	for (int uniform = 0; uniform < numUniforms; ++uniform)
 	{
+		// Members of uniform blocks are set through their block
+		const GLuint uniformIndex = uniform;
+		GLint blockIndex;
+		glGetActiveUniformsiv(shaderProgram, 1, &uniformIndex, GL_UNIFORM_BLOCK_INDEX,
+			&blockIndex);
+		if (blockIndex != -1)
+		{
+			continue;
+		}
+
 		GLint arraySize = 0;
 		GLenum type = 0;
 		GLsizei actualLength = 0;
 		glGetActiveUniform(shaderProgram, uniform, uniformName.size(),
 			&actualLength, &arraySize, &type, &uniformName[0]);
-		if (type != GL_SAMPLER_2D)
+		// Other uniforms are looked up by name when set, e.g. by SetShaderInt
+		if (type != GL_SAMPLER_2D && type != GL_SAMPLER_BUFFER)
 		{
-			std::cerr << "Error: Non-sampler2D uniforms currently unsupported!" << std::endl;
 			continue;
 		}
-		std::string name((char*)&uniformName[0], actualLength - 1);
-		// Since only sampler2D uniforms are supported, save it to our sampler map so that we can
-		// easily look up the uniform variable index of a sampler.
+		// The length excludes the null terminator
+		std::string name((char*)&uniformName[0], actualLength);
+		// Save it to our sampler map so that we can easily look up the uniform variable index of
+		// a sampler.
 		samplerMap[name] = glGetUniformLocation(shaderProgram, (char*)&uniformName[0]);
 	}
 }
@@ -34,6 +34,9 @@
 #include <vector>
 #include <string>
 #include <unordered_map>
+#include <map>
+#include <deque>
+#include <tuple>
 
 typedef SDL_GLContext DeviceContext;
 
@@ -42,6 +45,13 @@ typedef SDL_GLContext DeviceContext;
  * (prefixed with gl), refer to the documentation which can be found here:
  *		- https://www.khronos.org/opengl/
  *		- https://docs.gl/
+ *
+ * Released vertex arrays, textures, uniform buffers and framebuffers are not deleted right away,
+ * as frames still queued on the GPU may use them; they are kept until EndFrame has been called
+ * a number of times (see SetReleaseLatency). Buffers and uncompressed textures are then moved to
+ * recycling pools, so creating a resource of a recently released shape reuses its storage
+ * instead of allocating. Buffers are pooled by power of two capacity, and textures by size and
+ * format. Pooled resources which go unused for a couple of seconds worth of frames are deleted.
  */
 class OpenGLRenderDevice
 {
@@ -202,6 +212,19 @@ public:
 	OpenGLRenderDevice(Window& window);
 	virtual ~OpenGLRenderDevice();
 
+	/**
+	 * @brief Marks the end of a frame. Resources released at least the release latency frames ago
+	 *		are recycled or deleted, and pooled resources which went unused are deleted. Should be
+	 *		called once per frame, after presenting.
+	 */
+	void EndFrame();
+
+	/**
+	 * @param numFrames Number of frames released resources are kept alive for. Should be at least
+	 *		the number of frames the GPU may lag behind, e.g. the maximum number of queued frames.
+	 */
+	inline void SetReleaseLatency(unsigned int numFrames) { releaseLatency = numFrames; }
+
 	/** 
 	 * @brief Creates a framebuffer object (FBO) and attaches a texture image to the FBO.
 	 * @param texture The ID of the texture object whose image is to be attached.
@@ -226,12 +249,20 @@ public:
 	void UpdateRenderTarget(unsigned int fbo, unsigned int width, unsigned int height);
 
 	/**
-	 * @brief Releases a framebuffer object (FBO).
+	 * @brief Releases a framebuffer object (FBO). Deletion is deferred; see EndFrame.
 	 * @param fbo ID of the FBO to release.
 	 * @return FBO ID, 0, which is null.
 	 */
 	unsigned int ReleaseRenderTarget(unsigned int fbo);
 
+	/**
+	 * @brief Gets the size of a framebuffer.
+	 * @param fbo Target framebuffer object ID. 0 is the default framebuffer (the window).
+	 * @param width Set to the framebuffer width.
+	 * @param height Set to the framebuffer height.
+	 */
+	void GetRenderTargetSize(unsigned int fbo, unsigned int& width, unsigned int& height);
+
 	/**
 	 * @brief Creates a vertex array object (VAO) which contains one vertex buffer object (VBO).
 	 *		VBO data can be updated via UpdateVertexArrayBuffer.
@@ -263,6 +294,7 @@ public:
 
 	/**
 	 * @brief Releases a vertex array object (VAO) and any associated vertex buffer objects (VBOs).
+	 *		The VBOs are recycled once the GPU is done with them; see EndFrame.
 	 * @param vao ID of the VAO to release.
 	 * @return VAO ID, 0, which is null.
 	 */
@@ -309,7 +341,8 @@ public:
 		int unpackAlignment);
 
 	/**
-	 * @brief Releases a 2D texture object.
+	 * @brief Releases a 2D texture object. The texture is recycled once the GPU is done with it,
+	 *		unless it is compressed; see EndFrame.
 	 * @param texture2D ID of the texture to release.
 	 * @return Texture ID, 0, which is null.
 	 */
@@ -334,18 +367,89 @@ public:
 	void UpdateUniformBuffer(unsigned int buffer, const void* data, size_t dataSize);
 
 	/**
-	 * @brief Releases a uniform buffer object (UBO).
+	 * @brief Releases a uniform buffer object (UBO). The buffer is recycled once the GPU is done
+	 *		with it; see EndFrame.
 	 * @param buffer ID of the UBO to release.
 	 * @return UBO ID, 0, which is null.
 	 */
 	unsigned int ReleaseUniformBuffer(unsigned int buffer);
 
+	/**
+	 * @brief Creates a texture buffer, a buffer object read by shaders as a samplerBuffer of RGBA
+	 *		32 bit float texels. Unlike a uniform buffer, it can hold far more data than one
+	 *		uniform block; see GetMaxTextureBufferSize.
+	 * @param data A pointer to data that will be copied into the data store for initialization, or
+	 *		nullptr if no data is to be copied.
+	 * @param dataSize The size in bytes of the buffer.
+	 * @param usage Hint for how the texture buffer will be used.
+	 * @return ID of the texture the buffer is read through.
+	 */
+	unsigned int CreateTextureBuffer(const void* data, size_t dataSize, BufferUsage usage);
+
+	/**
+	 * @brief Replaces a texture buffer's contents/data. The previous data store is orphaned, so
+	 *		draws still reading it do not stall the update, and grown if the data does not fit.
+	 * @param textureBuffer ID of the target texture buffer.
+	 * @param data A pointer to data that will be copied into the data store.
+	 * @param dataSize The size in bytes of the data.
+	 */
+	void UpdateTextureBuffer(unsigned int textureBuffer, const void* data, size_t dataSize);
+
+	/**
+	 * @brief Releases a texture buffer. It is deleted once the GPU is done with it; see EndFrame.
+	 * @param textureBuffer ID of the texture buffer to release.
+	 * @return Texture buffer ID, 0, which is null.
+	 */
+	unsigned int ReleaseTextureBuffer(unsigned int textureBuffer);
+
+	/** @return The largest size in bytes of a texture buffer shaders can read in full. */
+	size_t GetMaxTextureBufferSize();
+
+	/**
+	 * @brief Creates a pixel pack buffer object (PBO), which receives pixels read back from a
+	 *		framebuffer without stalling the CPU.
+	 * @param dataSize The size in bytes of the buffer.
+	 * @return ID of the created PBO.
+	 */
+	unsigned int CreatePixelPackBuffer(size_t dataSize);
+
+	/**
+	 * @brief Starts reading the color of a framebuffer into a pixel pack buffer, as 8 bit RGBA
+	 *		rows from bottom to top. Returns immediately; the pixels are available once all
+	 *		commands issued before this call have completed (see CreateFence).
+	 * @param fbo Source framebuffer object ID.
+	 * @param buffer ID of the target PBO, of at least width * height * 4 bytes.
+	 * @param width Width of the region to read, from the lower left corner.
+	 * @param height Height of the region to read, from the lower left corner.
+	 */
+	void ReadPixels(unsigned int fbo, unsigned int buffer, unsigned int width,
+		unsigned int height);
+
+	/**
+	 * @brief Copies the contents of a pixel pack buffer into client memory. Blocks if the read
+	 *		into the buffer has not completed yet.
+	 * @param buffer ID of the source PBO.
+	 * @param destination Memory to copy to.
+	 * @param dataSize The number of bytes to copy.
+	 * @return Whether the buffer could be mapped and copied.
+	 */
+	bool CopyPixelPackBuffer(unsigned int buffer, void* destination, size_t dataSize);
+
+	/**
+	 * @brief Releases a pixel pack buffer object (PBO).
+	 * @param buffer ID of the PBO to release.
+	 * @return PBO ID, 0, which is null.
+	 */
+	unsigned int ReleasePixelPackBuffer(unsigned int buffer);
+
 
 	unsigned int CreateShaderProgram(const std::string& shaderText);
 	void SetShaderUniformBuffer(unsigned int shader, const std::string& uniformBufferName,
 		unsigned int buffer);
 	void SetShaderSampler(unsigned int shader, const std::string& samplerName, unsigned int texture, 
 		unsigned int sampler, unsigned int unit);
+	void SetShaderTextureBuffer(unsigned int shader, const std::string& samplerName,
+		unsigned int textureBuffer, unsigned int unit);
 	unsigned int ReleaseShaderProgram(unsigned int shader);
 
 	/**
@@ -451,6 +555,28 @@ public:
 	 */
 	void SetDrawParameters(const DrawParameters& drawParameters);
 
+	/**
+	 * @brief Inserts a fence (sync object) into the command stream. The fence is signaled once
+	 *		all commands issued before it have been completed by the GPU.
+	 * @return ID of the created fence.
+	 */
+	unsigned int CreateFence();
+
+	/**
+	 * @brief Blocks the calling thread until a fence is signaled or the timeout expires.
+	 * @param fence ID of the fence to wait on.
+	 * @param timeout Maximum time to wait, in nanoseconds. Use 0 to poll without blocking.
+	 * @return true if the fence was signaled (or does not exist), false if the wait timed out.
+	 */
+	bool WaitFence(unsigned int fence, uint64_t timeout);
+
+	/**
+	 * @brief Releases a fence.
+	 * @param fence ID of the fence to release.
+	 * @return Fence ID, 0, which is null.
+	 */
+	unsigned int ReleaseFence(unsigned int fence);
+
 private:
 	// Disallow copy and assign
 	OpenGLRenderDevice(const OpenGLRenderDevice& other) = delete;
@@ -479,6 +605,75 @@ private:
 		unsigned int height;
 	};
 
+	struct TextureData
+	{
+		int width;
+		int height;
+		GLint internalFormat;
+		bool hasMipmaps;
+		bool isCompressed;
+	};
+
+	struct BufferData
+	{
+		size_t capacity;
+		BufferUsage usage;
+	};
+
+	struct TextureBufferData
+	{
+		unsigned int buffer;
+		size_t capacity;
+		BufferUsage usage;
+	};
+
+	enum ResourceType
+	{
+		RESOURCE_VERTEX_ARRAY,
+		RESOURCE_TEXTURE,
+		RESOURCE_UNIFORM_BUFFER,
+		RESOURCE_TEXTURE_BUFFER,
+		RESOURCE_RENDER_TARGET,
+	};
+
+	/** @brief Resource waiting for the GPU to finish the frames which may use it. */
+	struct PendingRelease
+	{
+		ResourceType type;
+		unsigned int id;
+		unsigned long long frame;
+	};
+
+	/** @brief Resource in a recycling pool, and the frame it was added on. */
+	struct PooledResource
+	{
+		unsigned int id;
+		unsigned long long frame;
+	};
+
+	// Capacity and usage
+	typedef std::pair<size_t, BufferUsage> BufferShape;
+	// Width, height, internal format and whether there are mipmaps
+	typedef std::tuple<int, int, GLint, bool> TextureShape;
+
+	/**
+	 * @brief Creates a buffer object, or takes one from the recycling pool.
+	 * @param target Target to bind the buffer to, e.g. GL_ARRAY_BUFFER.
+	 * @param data Data to initialize the buffer with, or nullptr.
+	 * @param dataSize Size of the data in bytes.
+	 * @param usage Hint for how the buffer will be used.
+	 * @param capacity Set to the allocated size of the buffer, which may exceed the data size.
+	 * @return ID of the buffer, which is left bound to the target.
+	 */
+	unsigned int AcquireBuffer(GLenum target, const void* data, size_t dataSize, BufferUsage usage,
+		size_t& capacity);
+
+	/** @brief Returns a buffer no longer in use by the GPU to the pool, or deletes it. */
+	void RecycleBuffer(unsigned int buffer, size_t capacity, BufferUsage usage);
+
+	/** @brief Deletes or recycles a released resource, once the GPU is done with it. */
+	void DestroyResource(const PendingRelease& release);
+
 	void SetFBO(unsigned int fbo);
 	void SetViewport(unsigned int fbo);
 	void SetVAO(unsigned int vao);
@@ -503,6 +698,17 @@ private:
 	std::unordered_map<unsigned int, VertexArray> vaoMap;
 	std::unordered_map<unsigned int, FBOData> fboMap;
 	std::unordered_map<unsigned int, ShaderProgram> shaderProgramMap;
+	std::unordered_map<unsigned int, GLsync> fenceMap;
+	unsigned int nextFenceID;
+
+	std::unordered_map<unsigned int, TextureData> textureMap;
+	std::unordered_map<unsigned int, BufferData> uniformBufferMap;
+	std::unordered_map<unsigned int, TextureBufferData> textureBufferMap;
+	std::deque<PendingRelease> pendingReleases;
+	std::map<BufferShape, std::vector<PooledResource>> bufferPool;
+	std::map<TextureShape, std::vector<PooledResource>> texturePool;
+	unsigned long long frameNumber;
+	unsigned int releaseLatency;
 
 	unsigned int boundFBO;
 	unsigned int viewportFBO;
@@ -25,9 +25,9 @@
  */
 
 #include <SDL2/SDL.h>
-#include <iostream>
 
 #include "SDLApplication.h"
+#include "Log.h"
 
 unsigned int SDLApplication::numInstances = 0;
 
@@ -37,7 +37,7 @@ SDLApplication* SDLApplication::Create()
 	const unsigned int initialized = SDL_WasInit(flags);
 	if (initialized != flags && SDL_Init(flags) != 0)
 	{
-		std::cerr << "Error: SDL_Init: " << SDL_GetError() << std::endl;
+		Log::Error("SDL_Init: {}", SDL_GetError());
 		return nullptr;
 	}
 
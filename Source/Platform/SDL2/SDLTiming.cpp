@@ -33,6 +33,12 @@ float SDLTiming::GetTime()
 	return (float)SDL_GetTicks() / 1000.0f;
 }
 
+double SDLTiming::GetPreciseTime()
+{
+	static const double frequency = (double)SDL_GetPerformanceFrequency();
+	return (double)SDL_GetPerformanceCounter() / frequency;
+}
+
 void SDLTiming::Sleep(float seconds)
 {
 	SDL_Delay((unsigned int)(seconds * 1000.0f));
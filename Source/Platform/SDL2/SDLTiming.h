@@ -29,5 +29,14 @@
 struct SDLTiming
 {
 	static float GetTime();
+
+	/**
+	 * @brief High resolution timer, backed by the platform performance counter. Use this when
+	 *		measuring short intervals (frame times, present latency, etc.), where the millisecond
+	 *		resolution of GetTime is not enough.
+	 * @return Time in seconds, relative to an arbitrary starting point.
+	 */
+	static double GetPreciseTime();
+
 	static void Sleep(float seconds);
 };
@@ -25,20 +25,34 @@
  */
 
 #include "SDLWindow.h"
+#include "SDLTiming.h"
 #include "Rendering/RenderDevice.h"
+#include "Rendering/FrameQueueLimiter.h"
+#include "Log.h"
 
 #include <stdexcept>
 
 SDLWindow::SDLWindow(const Application& application, unsigned int width, unsigned int height, 
-	const std::string title) : width(width), height(height)
+	const std::string title) : width(width), height(height), presentMode(PRESENT_VSYNC),
+	frameQueueLimiter(nullptr), lastPresentTime(0.0)
 {
 	if (!RenderDevice::GlobalInit())
 	{
+		// Write out the reasons GlobalInit logged before unwinding
+		Log::Flush();
 		throw std::runtime_error("Render device could not be initialized.");
 	}
 
+#if defined(GLENGINE_SOFTWARE_RENDERER)
+	// The software renderer draws through the window surface, which SDL does not allow on a
+	// window with a GL context, and which needs no GL driver
+	window = SDL_CreateWindow(title.c_str(), SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+		width, height, SDL_WINDOW_RESIZABLE);
+	presentMode = PRESENT_IMMEDIATE;
+#else
 	window = SDL_CreateWindow(title.c_str(), SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
 		width, height, SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE);
+#endif
 }
 
 SDLWindow::~SDLWindow()
@@ -54,5 +68,66 @@ void SDLWindow::ChangeSize(unsigned int width, unsigned int height)
 
 void SDLWindow::Present()
 {
+	double startTime = SDLTiming::GetPreciseTime();
+
+#if !defined(GLENGINE_SOFTWARE_RENDERER)
 	SDL_GL_SwapWindow(window);
+#endif
+
+	if (frameQueueLimiter)
+	{
+		frameQueueLimiter->OnPresent();
+	}
+
+	double endTime = SDLTiming::GetPreciseTime();
+	presentStats.presentTime = endTime - startTime;
+
+	if (presentStats.numPresentedFrames > 0)
+	{
+		presentStats.frameTime = endTime - lastPresentTime;
+		presentStats.averageFrameTime = presentStats.numPresentedFrames == 1
+			? presentStats.frameTime
+			: presentStats.averageFrameTime * 0.9 + presentStats.frameTime * 0.1;
+	}
+
+	lastPresentTime = endTime;
+	presentStats.numPresentedFrames++;
+}
+
+bool SDLWindow::SetPresentMode(PresentMode mode)
+{
+#if defined(GLENGINE_SOFTWARE_RENDERER)
+	// The window surface is updated as soon as a frame is copied to it
+	return mode == PRESENT_IMMEDIATE;
+#else
+	int interval = 0;
+	switch (mode)
+	{
+	case PRESENT_IMMEDIATE:
+		interval = 0;
+		break;
+	case PRESENT_VSYNC:
+		interval = 1;
+		break;
+	case PRESENT_ADAPTIVE:
+		interval = -1;
+		break;
+	}
+
+	if (SDL_GL_SetSwapInterval(interval) == 0)
+	{
+		presentMode = mode;
+		return true;
+	}
+
+	if (mode == PRESENT_ADAPTIVE)
+	{
+		Log::Warning("Adaptive vsync is not supported, falling back to vsync");
+		SetPresentMode(PRESENT_VSYNC);
+		return false;
+	}
+
+	Log::Error("Could not set swap interval: {}", SDL_GetError());
+	return false;
+#endif
 }
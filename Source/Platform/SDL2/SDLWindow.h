@@ -33,9 +33,38 @@
 
 typedef SDL_Window* WindowHandle;
 
+class FrameQueueLimiter;
+
 class SDLWindow
 {
 public:
+	/**
+	 * IMMEDIATE: Buffers are swapped as soon as possible, which may cause tearing.
+	 * VSYNC: Buffer swaps are synchronized with the vertical retrace.
+	 * ADAPTIVE: Synchronized with the vertical retrace, unless a retrace was already missed, in
+	 *		which case buffers are swapped immediately. Not supported by all drivers.
+	 */
+	enum PresentMode
+	{
+		PRESENT_IMMEDIATE,
+		PRESENT_VSYNC,
+		PRESENT_ADAPTIVE,
+	};
+
+	/**
+	 * @brief Timing information on presented frames. All times are in seconds.
+	 */
+	struct PresentStats
+	{
+		// Time between the two most recent presents
+		double frameTime = 0.0;
+		// Time spent in the most recent present, including any wait on the frame queue limiter
+		double presentTime = 0.0;
+		// Exponential moving average of the frame time
+		double averageFrameTime = 0.0;
+		unsigned long long numPresentedFrames = 0;
+	};
+
 	SDLWindow(const Application& application, unsigned int width, unsigned int height,
 		const std::string title);
 
@@ -53,8 +82,37 @@ public:
 	 * @param height: New window height, which should reflect the current state.
 	 */
 	void ChangeSize(unsigned int width, unsigned int height);
+
+	/**
+	 * @brief Swaps the buffers of the window and records present timing. With the software
+	 *		renderer, the device copies each frame to the window surface itself, so this only
+	 *		records timing.
+	 */
 	void Present();
 
+	/**
+	 * @brief Sets the swap interval used when presenting. A render device (and thus a GL context)
+	 *		must have been created for this window beforehand. The software renderer presents
+	 *		through the window surface, which is never synchronized with the display, so only
+	 *		PRESENT_IMMEDIATE can be applied.
+	 * @param mode Present mode to use. If adaptive vsync is unsupported, vsync is used instead.
+	 * @return true if the requested mode was applied exactly.
+	 */
+	bool SetPresentMode(PresentMode mode);
+
+	/**
+	 * @brief Sets a limiter which bounds the number of frames queued ahead of the GPU. The limiter
+	 *		is waited on after every present.
+	 * @param frameQueueLimiter Limiter to use, or nullptr to let the driver decide.
+	 */
+	inline void SetFrameQueueLimiter(FrameQueueLimiter* frameQueueLimiter)
+	{
+		this->frameQueueLimiter = frameQueueLimiter;
+	}
+
+	inline PresentMode GetPresentMode() { return presentMode; }
+	inline const PresentStats& GetPresentStats() { return presentStats; }
+
 	inline unsigned int GetWidth() { return width; }
 	inline unsigned int GetHeight() { return height; }
 
@@ -66,4 +124,9 @@ private:
 	WindowHandle window;
 	unsigned int width;
 	unsigned int height;
+
+	PresentMode presentMode;
+	FrameQueueLimiter* frameQueueLimiter;
+	PresentStats presentStats;
+	double lastPresentTime;
 };
@@ -0,0 +1,1198 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#include "SoftwareRenderDevice.h"
+#include "SIMD.h"
+#include "Log.h"
+
+#include <GLM/glm.hpp>
+#include <SDL2/SDL.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+SoftwareRenderDevice::SoftwareRenderDevice(Window& window, unsigned int numWorkers) :
+	jobSystem(numWorkers), window(&window), nextID(1), nextFenceID(1)
+{
+	// The default framebuffer takes the size of the window
+	Framebuffer& framebuffer = framebufferMap[0];
+	framebuffer.texture = 0;
+	ResizeFramebuffer(framebuffer, window.GetWidth(), window.GetHeight());
+}
+
+unsigned int SoftwareRenderDevice::CreateRenderTarget(unsigned int texture, unsigned int width,
+	unsigned int height, FramebufferAttachment attachment, unsigned int /*attachmentNumber*/,
+	unsigned int /*mipLevel*/)
+{
+	const unsigned int fbo = nextID++;
+	Framebuffer& framebuffer = framebufferMap[fbo];
+
+	// Depth attachments are not needed; every framebuffer has its own depth buffer
+	framebuffer.texture = attachment == ATTACHMENT_COLOR ? texture : 0;
+	ResizeFramebuffer(framebuffer, width, height);
+
+	return fbo;
+}
+
+void SoftwareRenderDevice::UpdateRenderTarget(unsigned int fbo, unsigned int width,
+	unsigned int height)
+{
+	const std::unordered_map<unsigned int, Framebuffer>::iterator it = framebufferMap.find(fbo);
+	if (it == framebufferMap.end())
+	{
+		return;
+	}
+
+	// Pending triangles were binned for the old size
+	Resolve(it->second);
+	ResizeFramebuffer(it->second, width, height);
+}
+
+unsigned int SoftwareRenderDevice::ReleaseRenderTarget(unsigned int fbo)
+{
+	// Default framebuffer; should not be deleted.
+	if (fbo == 0) return 0;
+
+	framebufferMap.erase(fbo);
+	return 0;
+}
+
+void SoftwareRenderDevice::GetRenderTargetSize(unsigned int fbo, unsigned int& width,
+	unsigned int& height)
+{
+	const std::unordered_map<unsigned int, Framebuffer>::iterator it = framebufferMap.find(fbo);
+	if (it == framebufferMap.end())
+	{
+		width = 0;
+		height = 0;
+		return;
+	}
+
+	width = it->second.width;
+	height = it->second.height;
+}
+
+unsigned int SoftwareRenderDevice::CreateVertexArray(const float** vertexData,
+	const unsigned int* vertexElementSizes, unsigned int numVertexComponents,
+	unsigned int numInstanceComponents, unsigned int numVertices, const unsigned int* indices,
+	unsigned int numIndices, BufferUsage /*usage*/)
+{
+	const unsigned int numComponents = numVertexComponents + numInstanceComponents;
+
+	VertexArray vaoData;
+	vaoData.buffers.resize(numComponents);
+	vaoData.elementSizes.assign(vertexElementSizes, vertexElementSizes + numComponents);
+	vaoData.indices.assign(indices, indices + numIndices);
+	vaoData.instanceComponentsStartIndex = numVertexComponents;
+
+	for (unsigned int i = 0; i < numComponents; i++)
+	{
+		const unsigned int elementSize = vertexElementSizes[i];
+
+		// Instance components are written every frame; as with OpenGL, start them empty
+		if (i < numVertexComponents && vertexData != nullptr)
+		{
+			vaoData.buffers[i].assign(vertexData[i], vertexData[i] + elementSize * numVertices);
+		}
+
+		// Match the attribute locations of OpenGL, where every set of 4 floats takes a location
+		for (unsigned int offset = 0; offset < elementSize; offset += 4)
+		{
+			vaoData.locationElements.push_back(i);
+			vaoData.locationOffsets.push_back(offset);
+		}
+	}
+
+	const unsigned int vao = nextID++;
+	vaoMap[vao] = std::move(vaoData);
+	return vao;
+}
+
+void SoftwareRenderDevice::UpdateVertexArrayBuffer(unsigned int vao, unsigned int bufferIndex,
+	const void* data, size_t dataSize)
+{
+	const std::unordered_map<unsigned int, VertexArray>::iterator it = vaoMap.find(vao);
+	if (it == vaoMap.end() || bufferIndex >= it->second.buffers.size())
+	{
+		return;
+	}
+
+	// Vertex data is read while transforming, before Draw returns, so it can be replaced freely
+	std::vector<float>& buffer = it->second.buffers[bufferIndex];
+	buffer.resize(dataSize / sizeof(float));
+	std::memcpy(buffer.data(), data, buffer.size() * sizeof(float));
+}
+
+unsigned int SoftwareRenderDevice::ReleaseVertexArray(unsigned int vao)
+{
+	vaoMap.erase(vao);
+	return 0;
+}
+
+unsigned int SoftwareRenderDevice::CreateSampler(SamplerFilter minFilter, SamplerFilter magFilter,
+	SamplerWrapMode wrapU, SamplerWrapMode wrapV, float /*anisotropy*/)
+{
+	SamplerState sampler;
+	sampler.minFilter = minFilter;
+	sampler.magFilter = magFilter;
+	sampler.wrapU = wrapU;
+	sampler.wrapV = wrapV;
+
+	const unsigned int id = nextID++;
+	samplerMap[id] = sampler;
+	return id;
+}
+
+unsigned int SoftwareRenderDevice::ReleaseSampler(unsigned int sampler)
+{
+	samplerMap.erase(sampler);
+	return 0;
+}
+
+unsigned int SoftwareRenderDevice::CreateTexture2D(int width, int height, const void* data,
+	PixelFormat dataFormat, PixelFormat /*internalFormat*/, bool /*generateMipmaps*/,
+	bool /*compress*/, int /*packAlignment*/, int unpackAlignment)
+{
+	Texture2D texture;
+	texture.width = width;
+	texture.height = height;
+	texture.pixels.assign((size_t)width * height * 4, 0);
+
+	unsigned int numChannels = 0;
+	switch (dataFormat)
+	{
+	case FORMAT_R: numChannels = 1; break;
+	case FORMAT_RG: numChannels = 2; break;
+	case FORMAT_RGB: numChannels = 3; break;
+	case FORMAT_RGBA: numChannels = 4; break;
+	default: break;
+	}
+
+	if (data != nullptr && numChannels != 0)
+	{
+		// Rows of the source data start at a multiple of the unpack alignment
+		const size_t alignment = unpackAlignment > 0 ? (size_t)unpackAlignment : 4;
+		const size_t rowSize = ((size_t)width * numChannels + alignment - 1) / alignment * alignment;
+
+		// Missing channels are expanded as OpenGL does; green and blue to 0, alpha to 1
+		for (int y = 0; y < height; y++)
+		{
+			const uint8_t* source = (const uint8_t*)data + y * rowSize;
+			uint8_t* destination = &texture.pixels[(size_t)y * width * 4];
+			for (int x = 0; x < width; x++)
+			{
+				for (unsigned int channel = 0; channel < 4; channel++)
+				{
+					destination[x * 4 + channel] = channel < numChannels
+						? source[x * numChannels + channel]
+						: (channel == 3 ? 255 : 0);
+				}
+			}
+		}
+	}
+
+	const unsigned int id = nextID++;
+	textureMap[id] = std::move(texture);
+	return id;
+}
+
+unsigned int SoftwareRenderDevice::ReleaseTexture2D(unsigned int texture2D)
+{
+	// Binned triangles may still sample the texture
+	ResolveAll();
+	textureMap.erase(texture2D);
+	return 0;
+}
+
+unsigned int SoftwareRenderDevice::CreateUniformBuffer(const void* data, size_t dataSize,
+	BufferUsage /*usage*/)
+{
+	const unsigned int id = nextID++;
+	std::vector<uint8_t>& buffer = bufferMap[id];
+	buffer.resize(dataSize);
+	if (data != nullptr)
+	{
+		std::memcpy(buffer.data(), data, dataSize);
+	}
+	return id;
+}
+
+void SoftwareRenderDevice::UpdateUniformBuffer(unsigned int buffer, const void* data,
+	size_t dataSize)
+{
+	const std::unordered_map<unsigned int, std::vector<uint8_t>>::iterator it =
+		bufferMap.find(buffer);
+	if (it == bufferMap.end())
+	{
+		return;
+	}
+
+	it->second.resize(std::max(it->second.size(), dataSize));
+	std::memcpy(it->second.data(), data, dataSize);
+}
+
+unsigned int SoftwareRenderDevice::ReleaseUniformBuffer(unsigned int buffer)
+{
+	bufferMap.erase(buffer);
+	return 0;
+}
+
+unsigned int SoftwareRenderDevice::CreateTextureBuffer(const void* data, size_t dataSize,
+	BufferUsage usage)
+{
+	return CreateUniformBuffer(data, dataSize, usage);
+}
+
+void SoftwareRenderDevice::UpdateTextureBuffer(unsigned int textureBuffer, const void* data,
+	size_t dataSize)
+{
+	UpdateUniformBuffer(textureBuffer, data, dataSize);
+}
+
+unsigned int SoftwareRenderDevice::ReleaseTextureBuffer(unsigned int textureBuffer)
+{
+	return ReleaseUniformBuffer(textureBuffer);
+}
+
+unsigned int SoftwareRenderDevice::CreatePixelPackBuffer(size_t dataSize)
+{
+	return CreateUniformBuffer(nullptr, dataSize, USAGE_STREAM_READ);
+}
+
+void SoftwareRenderDevice::ReadPixels(unsigned int fbo, unsigned int buffer, unsigned int width,
+	unsigned int height)
+{
+	const std::unordered_map<unsigned int, std::vector<uint8_t>>::iterator bufferIt =
+		bufferMap.find(buffer);
+	const uint8_t* pixels = GetColorBuffer(fbo);
+	if (bufferIt == bufferMap.end() || pixels == nullptr)
+	{
+		return;
+	}
+
+	const Framebuffer& framebuffer = framebufferMap[fbo];
+	std::vector<uint8_t>& destination = bufferIt->second;
+
+	const unsigned int copyWidth = std::min(width, framebuffer.width);
+	const unsigned int copyHeight = std::min(height, framebuffer.height);
+	for (unsigned int y = 0; y < copyHeight; y++)
+	{
+		const size_t offset = (size_t)y * width * 4;
+		if (offset + copyWidth * 4 > destination.size())
+		{
+			break;
+		}
+		std::memcpy(&destination[offset], pixels + (size_t)y * framebuffer.width * 4,
+			copyWidth * 4);
+	}
+}
+
+bool SoftwareRenderDevice::CopyPixelPackBuffer(unsigned int buffer, void* destination,
+	size_t dataSize)
+{
+	const std::unordered_map<unsigned int, std::vector<uint8_t>>::iterator it =
+		bufferMap.find(buffer);
+	if (it == bufferMap.end() || it->second.size() < dataSize)
+	{
+		Log::Error("Failed to map pixel pack buffer {}", buffer);
+		return false;
+	}
+
+	std::memcpy(destination, it->second.data(), dataSize);
+	return true;
+}
+
+unsigned int SoftwareRenderDevice::ReleasePixelPackBuffer(unsigned int buffer)
+{
+	return ReleaseUniformBuffer(buffer);
+}
+
+unsigned int SoftwareRenderDevice::CreateShaderProgram(const std::string& shaderText)
+{
+	ShaderProgram program;
+	program.texture = 0;
+	program.sampler = 0;
+
+	// Recognize the shaders the fixed shading models are equivalent to
+	if (shaderText.find("texture0") != std::string::npos &&
+		shaderText.find("smoothstep") != std::string::npos)
+	{
+		program.shadingModel = SHADING_TEXT;
+	}
+	else if (shaderText.find("diffuse") != std::string::npos &&
+		shaderText.find("in mat4 transform") != std::string::npos &&
+		shaderText.find("samplerBuffer") == std::string::npos &&
+		shaderText.find("uniform Camera") == std::string::npos)
+	{
+		program.shadingModel = SHADING_BASIC;
+	}
+	else
+	{
+		Log::Warning("Shader is not supported by the software renderer; draws using it will be "
+			"skipped");
+		program.shadingModel = SHADING_UNSUPPORTED;
+	}
+
+	const unsigned int shader = nextID++;
+	shaderProgramMap[shader] = program;
+	return shader;
+}
+
+void SoftwareRenderDevice::SetShaderUniformBuffer(unsigned int /*shader*/,
+	const std::string& /*uniformBufferName*/, unsigned int /*buffer*/)
+{
+	// The fixed shading models do not use uniform blocks
+}
+
+void SoftwareRenderDevice::SetShaderSampler(unsigned int shader, const std::string& /*samplerName*/,
+	unsigned int texture, unsigned int sampler, unsigned int /*unit*/)
+{
+	const std::unordered_map<unsigned int, ShaderProgram>::iterator it =
+		shaderProgramMap.find(shader);
+	if (it == shaderProgramMap.end())
+	{
+		return;
+	}
+
+	// Both shading models sample a single texture
+	it->second.texture = texture;
+	it->second.sampler = sampler;
+}
+
+void SoftwareRenderDevice::SetShaderTextureBuffer(unsigned int /*shader*/,
+	const std::string& /*samplerName*/, unsigned int /*textureBuffer*/, unsigned int /*unit*/)
+{
+	// The fixed shading models do not read texture buffers
+}
+
+unsigned int SoftwareRenderDevice::ReleaseShaderProgram(unsigned int shader)
+{
+	shaderProgramMap.erase(shader);
+	return 0;
+}
+
+void SoftwareRenderDevice::Clear(unsigned int fbo, bool shouldClearColor, bool shouldClearDepth,
+	bool /*shouldClearStencil*/, float r, float g, float b, float a, unsigned int /*stencil*/)
+{
+	const std::unordered_map<unsigned int, Framebuffer>::iterator it = framebufferMap.find(fbo);
+	if (it == framebufferMap.end())
+	{
+		return;
+	}
+
+	Framebuffer& framebuffer = it->second;
+	if (shouldClearColor && shouldClearDepth)
+	{
+		// Everything drawn so far would be overwritten; skip rasterizing it
+		framebuffer.states.clear();
+		framebuffer.triangles.clear();
+		for (std::vector<unsigned int>& bin : framebuffer.tileBins)
+		{
+			bin.clear();
+		}
+	}
+	else
+	{
+		Resolve(framebuffer);
+	}
+
+	uint8_t* pixels = GetColorPixels(framebuffer);
+	if (shouldClearColor && pixels != nullptr)
+	{
+		const uint8_t color[4] = {
+			(uint8_t)(glm::clamp(r, 0.0f, 1.0f) * 255.0f + 0.5f),
+			(uint8_t)(glm::clamp(g, 0.0f, 1.0f) * 255.0f + 0.5f),
+			(uint8_t)(glm::clamp(b, 0.0f, 1.0f) * 255.0f + 0.5f),
+			(uint8_t)(glm::clamp(a, 0.0f, 1.0f) * 255.0f + 0.5f) };
+		uint32_t packedColor;
+		std::memcpy(&packedColor, color, sizeof(packedColor));
+		std::fill_n((uint32_t*)pixels, (size_t)framebuffer.width * framebuffer.height,
+			packedColor);
+	}
+
+	if (shouldClearDepth)
+	{
+		std::fill(framebuffer.depth.begin(), framebuffer.depth.end(), 1.0f);
+	}
+}
+
+void SoftwareRenderDevice::Draw(unsigned int fbo, unsigned int shader, unsigned int vao,
+	const DrawParameters& drawParameters, unsigned int numInstances, unsigned int numElements)
+{
+	const std::unordered_map<unsigned int, Framebuffer>::iterator framebufferIt =
+		framebufferMap.find(fbo);
+	const std::unordered_map<unsigned int, ShaderProgram>::iterator shaderIt =
+		shaderProgramMap.find(shader);
+	const std::unordered_map<unsigned int, VertexArray>::iterator vaoIt = vaoMap.find(vao);
+
+	if (numInstances == 0 || framebufferIt == framebufferMap.end() ||
+		shaderIt == shaderProgramMap.end() || vaoIt == vaoMap.end())
+	{
+		return;
+	}
+
+	const ShaderProgram& program = shaderIt->second;
+	if (program.shadingModel == SHADING_UNSUPPORTED ||
+		drawParameters.primitiveType != PRIMITIVE_TRIANGLES)
+	{
+		return;
+	}
+
+	Framebuffer& framebuffer = framebufferIt->second;
+	const VertexArray& vaoData = vaoIt->second;
+
+	// If the texture is being rendered to, its pixels must be final before it is sampled
+	ResolveTexture(program.texture);
+
+	DrawState state;
+	state.shadingModel = program.shadingModel;
+	const std::unordered_map<unsigned int, Texture2D>::iterator textureIt =
+		textureMap.find(program.texture);
+	state.texture = textureIt == textureMap.end() ? nullptr : &textureIt->second;
+	const std::unordered_map<unsigned int, SamplerState>::iterator samplerIt =
+		samplerMap.find(program.sampler);
+	state.sampler = samplerIt == samplerMap.end()
+		? SamplerState{ FILTER_NEAREST, FILTER_NEAREST, WRAP_REPEAT, WRAP_REPEAT }
+		: samplerIt->second;
+	state.depthFunc = drawParameters.depthFunc;
+	state.shouldWriteDepth = drawParameters.shouldWriteDepth;
+	state.sourceBlend = drawParameters.sourceBlend;
+	state.destBlend = drawParameters.destBlend;
+	state.scissorMinX = 0;
+	state.scissorMinY = 0;
+	state.scissorMaxX = (int)framebuffer.width - 1;
+	state.scissorMaxY = (int)framebuffer.height - 1;
+	if (drawParameters.useScissorTest)
+	{
+		state.scissorMinX = std::max(state.scissorMinX, (int)drawParameters.scissorStartX);
+		state.scissorMinY = std::max(state.scissorMinY, (int)drawParameters.scissorStartY);
+		state.scissorMaxX = std::min(state.scissorMaxX,
+			(int)(drawParameters.scissorStartX + drawParameters.scissorWidth) - 1);
+		state.scissorMaxY = std::min(state.scissorMaxY,
+			(int)(drawParameters.scissorStartY + drawParameters.scissorHeight) - 1);
+	}
+
+	if (state.scissorMinX > state.scissorMaxX || state.scissorMinY > state.scissorMaxY)
+	{
+		return;
+	}
+
+	unsigned int stateIndex = (unsigned int)framebuffer.states.size();
+	framebuffer.states.push_back(state);
+
+	// Fetches an attribute; attributes missing from the vertex array read as zeros
+	static const float zeros[16] = {};
+	const auto fetch = [&vaoData](unsigned int location, unsigned int vertex,
+		unsigned int instance, unsigned int numFloats) -> const float*
+	{
+		if (location >= vaoData.locationElements.size())
+		{
+			return zeros;
+		}
+
+		const unsigned int element = vaoData.locationElements[location];
+		const unsigned int elementSize = vaoData.elementSizes[element];
+		const size_t index = element >= vaoData.instanceComponentsStartIndex ? instance : vertex;
+		const size_t offset = index * elementSize + vaoData.locationOffsets[location];
+		if (offset + numFloats > vaoData.buffers[element].size())
+		{
+			return zeros;
+		}
+		return vaoData.buffers[element].data() + offset;
+	};
+
+	const bool isText = state.shadingModel == SHADING_TEXT;
+	const unsigned int transformLocation = isText ? 8 : 5;
+	const unsigned int varyingCount = isText ? 2 : 3;
+	const size_t numVertices = vaoData.elementSizes.empty() || vaoData.elementSizes[0] == 0
+		? 0
+		: vaoData.buffers[0].size() / vaoData.elementSizes[0];
+	const unsigned int numIndices = std::min(numElements, (unsigned int)vaoData.indices.size());
+
+	clipVertices.resize(numVertices);
+	for (unsigned int instance = 0; instance < numInstances; instance++)
+	{
+		glm::mat4 transform;
+		std::memcpy(&transform[0][0], fetch(transformLocation, 0, instance, 16), sizeof(transform));
+
+		if (isText)
+		{
+			// Text layers are constant across an instance, so each instance has its own state
+			if (instance > 0)
+			{
+				stateIndex = (unsigned int)framebuffer.states.size();
+				framebuffer.states.push_back(state);
+			}
+
+			DrawState& instanceState = framebuffer.states[stateIndex];
+			std::memcpy(instanceState.layerColors, fetch(2, 0, instance, 16),
+				sizeof(instanceState.layerColors));
+			std::memcpy(instanceState.layerSmoothing, fetch(6, 0, instance, 4),
+				sizeof(instanceState.layerSmoothing));
+			std::memcpy(instanceState.layerOffsets, fetch(7, 0, instance, 4),
+				sizeof(instanceState.layerOffsets));
+		}
+
+		// Vertex shader; transform every vertex once, then assemble triangles from the indices
+		for (unsigned int vertex = 0; vertex < numVertices; vertex++)
+		{
+			ClipVertex& clipVertex = clipVertices[vertex];
+
+			const float* position = fetch(0, vertex, instance, isText ? 2 : 3);
+			const glm::vec4 clipPosition = transform * glm::vec4(position[0], position[1],
+				isText ? 0.0f : position[2], 1.0f);
+			std::memcpy(clipVertex.position, &clipPosition[0], sizeof(clipVertex.position));
+
+			const float* textureCoordinate = fetch(1, vertex, instance, 2);
+			clipVertex.varyings[0] = textureCoordinate[0];
+			clipVertex.varyings[1] = textureCoordinate[1];
+
+			if (!isText)
+			{
+				clipVertex.varyings[2] = fetch(4, vertex, instance, 1)[0];
+			}
+		}
+
+		ClipVertex triangle[3];
+		for (unsigned int i = 0; i + 2 < numIndices; i += 3)
+		{
+			bool isValid = true;
+			for (unsigned int j = 0; j < 3; j++)
+			{
+				const unsigned int index = vaoData.indices[i + j];
+				if (index >= numVertices)
+				{
+					isValid = false;
+					break;
+				}
+				triangle[j] = clipVertices[index];
+			}
+
+			if (isValid)
+			{
+				ProcessTriangle(framebuffer, triangle, drawParameters.faceCulling, varyingCount,
+					stateIndex);
+			}
+		}
+	}
+}
+
+unsigned int SoftwareRenderDevice::CreateFence()
+{
+	return nextFenceID++;
+}
+
+bool SoftwareRenderDevice::WaitFence(unsigned int /*fence*/, uint64_t /*timeout*/)
+{
+	ResolveAll();
+	return true;
+}
+
+unsigned int SoftwareRenderDevice::ReleaseFence(unsigned int /*fence*/)
+{
+	return 0;
+}
+
+void SoftwareRenderDevice::Present()
+{
+	const uint8_t* pixels = GetColorBuffer(0);
+	SDL_Surface* surface = SDL_GetWindowSurface(window->GetWindowHandle());
+	if (pixels == nullptr || surface == nullptr)
+	{
+		return;
+	}
+
+	const Framebuffer& framebuffer = framebufferMap[0];
+	const int width = std::min((int)framebuffer.width, surface->w);
+	const int height = std::min((int)framebuffer.height, surface->h);
+	if (width <= 0 || height <= 0)
+	{
+		return;
+	}
+
+	// Framebuffer rows go from bottom to top, the window's from top to bottom
+	presentPixels.resize((size_t)width * height * 4);
+	for (int y = 0; y < height; y++)
+	{
+		std::memcpy(&presentPixels[(size_t)y * width * 4],
+			pixels + (size_t)(framebuffer.height - 1 - y) * framebuffer.width * 4, width * 4);
+	}
+
+	SDL_LockSurface(surface);
+	SDL_ConvertPixels(width, height, SDL_PIXELFORMAT_ABGR8888, presentPixels.data(), width * 4,
+		surface->format->format, surface->pixels, surface->pitch);
+	SDL_UnlockSurface(surface);
+	SDL_UpdateWindowSurface(window->GetWindowHandle());
+}
+
+const uint8_t* SoftwareRenderDevice::GetColorBuffer(unsigned int fbo)
+{
+	const std::unordered_map<unsigned int, Framebuffer>::iterator it = framebufferMap.find(fbo);
+	if (it == framebufferMap.end())
+	{
+		return nullptr;
+	}
+
+	Resolve(it->second);
+	return GetColorPixels(it->second);
+}
+
+void SoftwareRenderDevice::ResizeFramebuffer(Framebuffer& framebuffer, unsigned int width,
+	unsigned int height)
+{
+	framebuffer.width = width;
+	framebuffer.height = height;
+	if (framebuffer.texture == 0)
+	{
+		framebuffer.color.assign((size_t)width * height * 4, 0);
+	}
+
+	framebuffer.depthStride = (width + 3) & ~3u;
+	framebuffer.depth.assign((size_t)framebuffer.depthStride * height, 1.0f);
+
+	framebuffer.numTilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+	framebuffer.numTilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+	framebuffer.tileBins.resize((size_t)framebuffer.numTilesX * framebuffer.numTilesY);
+}
+
+uint8_t* SoftwareRenderDevice::GetColorPixels(Framebuffer& framebuffer)
+{
+	if (framebuffer.texture == 0)
+	{
+		return framebuffer.color.data();
+	}
+
+	const std::unordered_map<unsigned int, Texture2D>::iterator it =
+		textureMap.find(framebuffer.texture);
+	if (it == textureMap.end() || it->second.width < (int)framebuffer.width ||
+		it->second.height < (int)framebuffer.height)
+	{
+		return nullptr;
+	}
+	return it->second.pixels.data();
+}
+
+void SoftwareRenderDevice::ProcessTriangle(Framebuffer& framebuffer, const ClipVertex* vertices,
+	FaceCulling faceCulling, unsigned int varyingCount, unsigned int state)
+{
+	// Signed distances to the near plane (z = -w); positive in front
+	float distances[3];
+	unsigned int numInside = 0;
+	for (unsigned int i = 0; i < 3; i++)
+	{
+		distances[i] = vertices[i].position[2] + vertices[i].position[3];
+		numInside += distances[i] >= 0.0f ? 1 : 0;
+	}
+
+	if (numInside == 3)
+	{
+		BinTriangle(framebuffer, vertices[0], vertices[1], vertices[2], faceCulling, varyingCount,
+			state);
+		return;
+	}
+
+	if (numInside == 0)
+	{
+		return;
+	}
+
+	// Clip against the near plane (Sutherland-Hodgman); gives a triangle or a quad. The other
+	// planes do not need clipping, as triangles are only rasterized within the viewport.
+	ClipVertex polygon[4];
+	unsigned int numPolygonVertices = 0;
+	for (unsigned int i = 0; i < 3; i++)
+	{
+		const unsigned int next = (i + 1) % 3;
+		if (distances[i] >= 0.0f)
+		{
+			polygon[numPolygonVertices++] = vertices[i];
+		}
+
+		if ((distances[i] >= 0.0f) != (distances[next] >= 0.0f))
+		{
+			const float t = distances[i] / (distances[i] - distances[next]);
+			ClipVertex& vertex = polygon[numPolygonVertices++];
+			for (unsigned int j = 0; j < 4; j++)
+			{
+				vertex.position[j] = vertices[i].position[j] +
+					(vertices[next].position[j] - vertices[i].position[j]) * t;
+			}
+			for (unsigned int j = 0; j < varyingCount; j++)
+			{
+				vertex.varyings[j] = vertices[i].varyings[j] +
+					(vertices[next].varyings[j] - vertices[i].varyings[j]) * t;
+			}
+		}
+	}
+
+	for (unsigned int i = 1; i + 1 < numPolygonVertices; i++)
+	{
+		BinTriangle(framebuffer, polygon[0], polygon[i], polygon[i + 1], faceCulling,
+			varyingCount, state);
+	}
+}
+
+void SoftwareRenderDevice::BinTriangle(Framebuffer& framebuffer, const ClipVertex& a,
+	const ClipVertex& b, const ClipVertex& c, FaceCulling faceCulling, unsigned int varyingCount,
+	unsigned int state)
+{
+	const ClipVertex* vertices[3] = { &a, &b, &c };
+	float x[3];
+	float y[3];
+
+	Triangle triangle;
+	for (unsigned int i = 0; i < 3; i++)
+	{
+		const float w = vertices[i]->position[3];
+		if (w <= 1e-6f)
+		{
+			return;
+		}
+
+		// Perspective divide, then viewport transform
+		const float inverseW = 1.0f / w;
+		x[i] = (vertices[i]->position[0] * inverseW * 0.5f + 0.5f) * framebuffer.width;
+		y[i] = (vertices[i]->position[1] * inverseW * 0.5f + 0.5f) * framebuffer.height;
+		triangle.depth[i] = vertices[i]->position[2] * inverseW * 0.5f + 0.5f;
+		triangle.inverseW[i] = inverseW;
+
+		// Varyings are interpolated divided by w, for perspective correction
+		for (unsigned int j = 0; j < varyingCount; j++)
+		{
+			triangle.varyings[i][j] = vertices[i]->varyings[j] * inverseW;
+		}
+	}
+
+	// Counter-clockwise triangles are front facing
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if (area == 0.0f || faceCulling == FACE_CULL_FRONT_AND_BACK ||
+		(faceCulling == FACE_CULL_BACK && area < 0.0f) ||
+		(faceCulling == FACE_CULL_FRONT && area > 0.0f))
+	{
+		return;
+	}
+
+	// Make back facing triangles counter-clockwise, so edge functions are positive inside
+	if (area < 0.0f)
+	{
+		std::swap(x[1], x[2]);
+		std::swap(y[1], y[2]);
+		std::swap(triangle.depth[1], triangle.depth[2]);
+		std::swap(triangle.inverseW[1], triangle.inverseW[2]);
+		std::swap(triangle.varyings[1], triangle.varyings[2]);
+		area = -area;
+	}
+
+	// Edge i is opposite to vertex i; dividing by the area makes it the barycentric coordinate
+	// of vertex i
+	const float inverseArea = 1.0f / area;
+	for (unsigned int i = 0; i < 3; i++)
+	{
+		const unsigned int start = (i + 1) % 3;
+		const unsigned int end = (i + 2) % 3;
+		const float edgeA = y[start] - y[end];
+		const float edgeB = x[end] - x[start];
+
+		triangle.edgeA[i] = edgeA * inverseArea;
+		triangle.edgeB[i] = edgeB * inverseArea;
+		triangle.edgeC[i] = -(edgeA * x[start] + edgeB * y[start]) * inverseArea;
+
+		// Pixels exactly on an edge shared by two triangles belong to only one of them
+		const bool isTopLeft = edgeA > 0.0f || (edgeA == 0.0f && edgeB < 0.0f);
+		triangle.edgeThreshold[i] = isTopLeft ? 0.0f : FLT_MIN;
+	}
+
+	const DrawState& drawState = framebuffer.states[state];
+	const float minX = std::min({ x[0], x[1], x[2] });
+	const float maxX = std::max({ x[0], x[1], x[2] });
+	const float minY = std::min({ y[0], y[1], y[2] });
+	const float maxY = std::max({ y[0], y[1], y[2] });
+
+	// Clamp while still floating point; off-screen vertices may be far out of integer range
+	triangle.minX = (int)std::max(std::floor(minX), (float)drawState.scissorMinX);
+	triangle.maxX = (int)std::min(std::ceil(maxX), (float)drawState.scissorMaxX);
+	triangle.minY = (int)std::max(std::floor(minY), (float)drawState.scissorMinY);
+	triangle.maxY = (int)std::min(std::ceil(maxY), (float)drawState.scissorMaxY);
+	triangle.state = state;
+
+	if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+	{
+		return;
+	}
+
+	const unsigned int index = (unsigned int)framebuffer.triangles.size();
+	framebuffer.triangles.push_back(triangle);
+
+	for (unsigned int tileY = triangle.minY / TILE_SIZE; tileY <= triangle.maxY / TILE_SIZE;
+		tileY++)
+	{
+		for (unsigned int tileX = triangle.minX / TILE_SIZE; tileX <= triangle.maxX / TILE_SIZE;
+			tileX++)
+		{
+			framebuffer.tileBins[tileY * framebuffer.numTilesX + tileX].push_back(index);
+		}
+	}
+}
+
+void SoftwareRenderDevice::Resolve(Framebuffer& framebuffer)
+{
+	if (framebuffer.triangles.empty())
+	{
+		return;
+	}
+
+	// Tiles do not share pixels, so they can be rasterized in any order, on any thread
+	const unsigned int numTiles = framebuffer.numTilesX * framebuffer.numTilesY;
+	jobSystem.ParallelFor(numTiles, 1, [this, &framebuffer](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int tile = begin; tile < end; tile++)
+		{
+			RasterizeTile(framebuffer, tile % framebuffer.numTilesX, tile / framebuffer.numTilesX);
+		}
+	});
+
+	framebuffer.states.clear();
+	framebuffer.triangles.clear();
+	for (std::vector<unsigned int>& bin : framebuffer.tileBins)
+	{
+		bin.clear();
+	}
+}
+
+void SoftwareRenderDevice::ResolveAll()
+{
+	for (auto it = framebufferMap.begin(); it != framebufferMap.end(); ++it)
+	{
+		Resolve(it->second);
+	}
+}
+
+void SoftwareRenderDevice::ResolveTexture(unsigned int texture)
+{
+	if (texture == 0)
+	{
+		return;
+	}
+
+	for (auto it = framebufferMap.begin(); it != framebufferMap.end(); ++it)
+	{
+		if (it->second.texture == texture)
+		{
+			Resolve(it->second);
+		}
+	}
+}
+
+static inline int WrapCoordinate(int coordinate, int size,
+	SoftwareRenderDevice::SamplerWrapMode wrapMode)
+{
+	switch (wrapMode)
+	{
+	case SoftwareRenderDevice::WRAP_REPEAT:
+		coordinate %= size;
+		return coordinate < 0 ? coordinate + size : coordinate;
+	case SoftwareRenderDevice::WRAP_REPEAT_MIRROR:
+	{
+		int period = coordinate % (size * 2);
+		period = period < 0 ? period + size * 2 : period;
+		return period < size ? period : size * 2 - 1 - period;
+	}
+	case SoftwareRenderDevice::WRAP_CLAMP_MIRROR:
+		coordinate = coordinate < 0 ? -1 - coordinate : coordinate;
+		return std::min(coordinate, size - 1);
+	default:
+		return std::max(0, std::min(coordinate, size - 1));
+	}
+}
+
+static inline glm::vec4 FetchTexel(const uint8_t* pixels, int width, int x, int y)
+{
+	const uint8_t* texel = pixels + ((size_t)y * width + x) * 4;
+	return glm::vec4(texel[0], texel[1], texel[2], texel[3]) * (1.0f / 255.0f);
+}
+
+static inline float GetBlendFactor(SoftwareRenderDevice::BlendFunc blendFunc, float sourceAlpha,
+	float destAlpha)
+{
+	switch (blendFunc)
+	{
+	case SoftwareRenderDevice::BLEND_FUNC_SRC_ALPHA: return sourceAlpha;
+	case SoftwareRenderDevice::BLEND_FUNC_ONE_MINUS_SRC_ALPHA: return 1.0f - sourceAlpha;
+	case SoftwareRenderDevice::BLEND_FUNC_DST_ALPHA: return destAlpha;
+	case SoftwareRenderDevice::BLEND_FUNC_ONE_MINUS_DST_ALPHA: return 1.0f - destAlpha;
+	default: return 1.0f;
+	}
+}
+
+void SoftwareRenderDevice::RasterizeTile(Framebuffer& framebuffer, unsigned int tileX,
+	unsigned int tileY)
+{
+	const std::vector<unsigned int>& bin = framebuffer.tileBins[tileY * framebuffer.numTilesX +
+		tileX];
+	if (bin.empty())
+	{
+		return;
+	}
+
+	uint8_t* colorPixels = GetColorPixels(framebuffer);
+	if (colorPixels == nullptr)
+	{
+		return;
+	}
+
+	const int tileMinX = (int)(tileX * TILE_SIZE);
+	const int tileMinY = (int)(tileY * TILE_SIZE);
+	const int tileMaxX = std::min(tileMinX + (int)TILE_SIZE, (int)framebuffer.width) - 1;
+	const int tileMaxY = std::min(tileMinY + (int)TILE_SIZE, (int)framebuffer.height) - 1;
+
+	// Triangles are drawn in submission order, so blending and equal depths match the GPU
+	for (const unsigned int triangleIndex : bin)
+	{
+		const Triangle& triangle = framebuffer.triangles[triangleIndex];
+		const DrawState& state = framebuffer.states[triangle.state];
+
+		const int minX = std::max(triangle.minX, tileMinX);
+		const int maxX = std::min(triangle.maxX, tileMaxX);
+		const int minY = std::max(triangle.minY, tileMinY);
+		const int maxY = std::min(triangle.maxY, tileMaxY);
+
+		const Texture2D* texture = state.texture;
+		const bool isBlending = state.sourceBlend != BLEND_FUNC_NONE &&
+			state.destBlend != BLEND_FUNC_NONE;
+		const bool isLinear = state.sampler.magFilter == FILTER_LINEAR;
+		const unsigned int varyingCount = state.shadingModel == SHADING_TEXT ? 2 : 3;
+
+#if defined(GLENGINE_SSE2)
+		const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+		__m128 edgeA[3], edgeB[3], edgeC[3], threshold[3];
+		for (unsigned int i = 0; i < 3; i++)
+		{
+			edgeA[i] = _mm_set1_ps(triangle.edgeA[i]);
+			edgeB[i] = _mm_set1_ps(triangle.edgeB[i]);
+			edgeC[i] = _mm_set1_ps(triangle.edgeC[i]);
+			threshold[i] = _mm_set1_ps(triangle.edgeThreshold[i]);
+		}
+		const __m128 depth0 = _mm_set1_ps(triangle.depth[0]);
+		const __m128 depth1 = _mm_set1_ps(triangle.depth[1]);
+		const __m128 depth2 = _mm_set1_ps(triangle.depth[2]);
+#endif
+
+		for (int y = minY; y <= maxY; y++)
+		{
+			const float pixelY = (float)y + 0.5f;
+			float* depthRow = &framebuffer.depth[(size_t)y * framebuffer.depthStride];
+			uint8_t* colorRow = colorPixels + (size_t)y * framebuffer.width * 4;
+
+			// Spans start 4 aligned, so loads never run past the padding of the depth row
+			for (int x = minX & ~3; x <= maxX; x += 4)
+			{
+				// Lanes outside of the triangle's span
+				const unsigned int spanMask = (0xFu << std::max(minX - x, 0)) &
+					((1u << std::min(maxX - x + 1, 4)) - 1);
+
+				// Coverage and depth of 4 pixels at once
+				float barycentrics[3][4];
+				float depths[4];
+				unsigned int mask;
+
+#if defined(GLENGINE_SSE2)
+				const __m128 pixelX = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+				const __m128 pixelYs = _mm_set1_ps(pixelY);
+
+				__m128 coverage = _mm_castsi128_ps(_mm_set1_epi32(-1));
+				__m128 edges[3];
+				for (unsigned int i = 0; i < 3; i++)
+				{
+					edges[i] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edgeA[i], pixelX),
+						_mm_mul_ps(edgeB[i], pixelYs)), edgeC[i]);
+					coverage = _mm_and_ps(coverage, _mm_cmpge_ps(edges[i], threshold[i]));
+					_mm_storeu_ps(barycentrics[i], edges[i]);
+				}
+
+				mask = (unsigned int)_mm_movemask_ps(coverage) & spanMask;
+				if (mask == 0)
+				{
+					continue;
+				}
+
+				const __m128 depth = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edges[0], depth0),
+					_mm_mul_ps(edges[1], depth1)), _mm_mul_ps(edges[2], depth2));
+				const __m128 storedDepth = _mm_loadu_ps(depthRow + x);
+
+				__m128 depthPass;
+				switch (state.depthFunc)
+				{
+				case DRAW_FUNC_NEVER: depthPass = _mm_setzero_ps(); break;
+				case DRAW_FUNC_LESS: depthPass = _mm_cmplt_ps(depth, storedDepth); break;
+				case DRAW_FUNC_GREATER: depthPass = _mm_cmpgt_ps(depth, storedDepth); break;
+				case DRAW_FUNC_LEQUAL: depthPass = _mm_cmple_ps(depth, storedDepth); break;
+				case DRAW_FUNC_GEQUAL: depthPass = _mm_cmpge_ps(depth, storedDepth); break;
+				case DRAW_FUNC_EQUAL: depthPass = _mm_cmpeq_ps(depth, storedDepth); break;
+				case DRAW_FUNC_NOT_EQUAL: depthPass = _mm_cmpneq_ps(depth, storedDepth); break;
+				default: depthPass = _mm_castsi128_ps(_mm_set1_epi32(-1)); break;
+				}
+
+				mask &= (unsigned int)_mm_movemask_ps(depthPass);
+				_mm_storeu_ps(depths, depth);
+#else
+				mask = 0;
+				for (int lane = 0; lane < 4; lane++)
+				{
+					if ((spanMask & (1u << lane)) == 0)
+					{
+						continue;
+					}
+
+					const float pixelX = (float)(x + lane) + 0.5f;
+					bool isCovered = true;
+					for (unsigned int i = 0; i < 3; i++)
+					{
+						barycentrics[i][lane] = triangle.edgeA[i] * pixelX +
+							triangle.edgeB[i] * pixelY + triangle.edgeC[i];
+						isCovered &= barycentrics[i][lane] >= triangle.edgeThreshold[i];
+					}
+					if (!isCovered)
+					{
+						continue;
+					}
+
+					depths[lane] = barycentrics[0][lane] * triangle.depth[0] +
+						barycentrics[1][lane] * triangle.depth[1] +
+						barycentrics[2][lane] * triangle.depth[2];
+					const float storedDepth = depthRow[x + lane];
+
+					bool depthPass;
+					switch (state.depthFunc)
+					{
+					case DRAW_FUNC_NEVER: depthPass = false; break;
+					case DRAW_FUNC_LESS: depthPass = depths[lane] < storedDepth; break;
+					case DRAW_FUNC_GREATER: depthPass = depths[lane] > storedDepth; break;
+					case DRAW_FUNC_LEQUAL: depthPass = depths[lane] <= storedDepth; break;
+					case DRAW_FUNC_GEQUAL: depthPass = depths[lane] >= storedDepth; break;
+					case DRAW_FUNC_EQUAL: depthPass = depths[lane] == storedDepth; break;
+					case DRAW_FUNC_NOT_EQUAL: depthPass = depths[lane] != storedDepth; break;
+					default: depthPass = true; break;
+					}
+					mask |= (depthPass ? 1u : 0u) << lane;
+				}
+#endif
+
+				// Fragment shader, for the pixels which passed
+				for (unsigned int lane = 0; lane < 4; lane++)
+				{
+					if ((mask & (1u << lane)) == 0)
+					{
+						continue;
+					}
+
+					const int pixelIndex = x + (int)lane;
+					if (state.shouldWriteDepth)
+					{
+						depthRow[pixelIndex] = depths[lane];
+					}
+
+					const float lambda0 = barycentrics[0][lane];
+					const float lambda1 = barycentrics[1][lane];
+					const float lambda2 = barycentrics[2][lane];
+					const float w = 1.0f / (lambda0 * triangle.inverseW[0] +
+						lambda1 * triangle.inverseW[1] + lambda2 * triangle.inverseW[2]);
+
+					float varyings[MAX_VARYINGS];
+					for (unsigned int i = 0; i < varyingCount; i++)
+					{
+						varyings[i] = (lambda0 * triangle.varyings[0][i] +
+							lambda1 * triangle.varyings[1][i] +
+							lambda2 * triangle.varyings[2][i]) * w;
+					}
+
+					// Sample the texture from its base level
+					glm::vec4 sample(1.0f);
+					if (texture != nullptr && texture->width > 0 && texture->height > 0)
+					{
+						const float u = varyings[0] * texture->width;
+						const float v = varyings[1] * texture->height;
+						if (isLinear)
+						{
+							const float sampleX = u - 0.5f;
+							const float sampleY = v - 0.5f;
+							const int x0 = (int)std::floor(sampleX);
+							const int y0 = (int)std::floor(sampleY);
+							const float fractionX = sampleX - (float)x0;
+							const float fractionY = sampleY - (float)y0;
+
+							const int wrappedX0 = WrapCoordinate(x0, texture->width,
+								state.sampler.wrapU);
+							const int wrappedX1 = WrapCoordinate(x0 + 1, texture->width,
+								state.sampler.wrapU);
+							const int wrappedY0 = WrapCoordinate(y0, texture->height,
+								state.sampler.wrapV);
+							const int wrappedY1 = WrapCoordinate(y0 + 1, texture->height,
+								state.sampler.wrapV);
+
+							const uint8_t* pixels = texture->pixels.data();
+							const glm::vec4 bottom = glm::mix(
+								FetchTexel(pixels, texture->width, wrappedX0, wrappedY0),
+								FetchTexel(pixels, texture->width, wrappedX1, wrappedY0),
+								fractionX);
+							const glm::vec4 top = glm::mix(
+								FetchTexel(pixels, texture->width, wrappedX0, wrappedY1),
+								FetchTexel(pixels, texture->width, wrappedX1, wrappedY1),
+								fractionX);
+							sample = glm::mix(bottom, top, fractionY);
+						}
+						else
+						{
+							sample = FetchTexel(texture->pixels.data(), texture->width,
+								WrapCoordinate((int)std::floor(u), texture->width,
+									state.sampler.wrapU),
+								WrapCoordinate((int)std::floor(v), texture->height,
+									state.sampler.wrapV));
+						}
+					}
+
+					glm::vec4 color = sample;
+					if (state.shadingModel == SHADING_TEXT)
+					{
+						// Blend the layers over each other, as separate draws of each would
+						glm::vec3 premultiplied(0.0f);
+						float alpha = 0.0f;
+						for (unsigned int i = 0; i < MAX_TEXT_LAYERS; i++)
+						{
+							const float* layerColor = state.layerColors[i];
+							const float layerAlpha = layerColor[3] * glm::smoothstep(
+								state.layerOffsets[i] - state.layerSmoothing[i],
+								state.layerOffsets[i] + state.layerSmoothing[i], sample.r);
+							premultiplied = glm::vec3(layerColor[0], layerColor[1],
+								layerColor[2]) * layerAlpha + premultiplied * (1.0f - layerAlpha);
+							alpha = layerAlpha + alpha * (1.0f - layerAlpha);
+						}
+
+						color = glm::vec4(alpha > 0.0f ? premultiplied / alpha : glm::vec3(0.0f),
+							alpha);
+					}
+					else
+					{
+						// Varying 2 is the baked occlusion
+						color = glm::vec4(glm::vec3(color) * (1.0f - varyings[2]), color.a);
+					}
+
+					uint8_t* destination = colorRow + pixelIndex * 4;
+					if (isBlending)
+					{
+						const glm::vec4 destColor = glm::vec4(destination[0], destination[1],
+							destination[2], destination[3]) * (1.0f / 255.0f);
+						color = color * GetBlendFactor(state.sourceBlend, color.a, destColor.a) +
+							destColor * GetBlendFactor(state.destBlend, color.a, destColor.a);
+					}
+
+					color = glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f;
+					destination[0] = (uint8_t)color.r;
+					destination[1] = (uint8_t)color.g;
+					destination[2] = (uint8_t)color.b;
+					destination[3] = (uint8_t)color.a;
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,469 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include "Window.h"
+#include "Jobs/JobSystem.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief CPU implementation of the render device, for machines without a GPU. Exposes the same
+ * interface as OpenGLRenderDevice, so it can be selected by defining GLENGINE_SOFTWARE_RENDERER
+ * (see RenderDevice.h) without touching the rest of the engine.
+ *
+ * Draws are transformed and clipped immediately, then binned into screen tiles. Tiles are
+ * rasterized in parallel on a job system, 4 pixels at a time with SIMD edge functions, once the
+ * contents of the framebuffer are needed (read back, sampled, or presented). Triangles keep
+ * their submission order within a tile, so blending matches the GPU.
+ *
+ * Shaders are not compiled; each shader program is mapped to a fixed shading model equivalent to
+ * BasicShader.glsl (textured meshes) or TextShader.glsl (signed distance field text). Draws with
+ * any other shader are skipped. Only triangles are rasterized, and the stencil test is ignored.
+ */
+class SoftwareRenderDevice
+{
+public:
+	/** @see OpenGLRenderDevice::BufferUsage */
+	enum BufferUsage
+	{
+		USAGE_STATIC_DRAW,
+		USAGE_STREAM_DRAW,
+		USAGE_DYNAMIC_DRAW,
+
+		USAGE_STATIC_COPY,
+		USAGE_STREAM_COPY,
+		USAGE_DYNAMIC_COPY,
+
+		USAGE_STATIC_READ,
+		USAGE_STREAM_READ,
+		USAGE_DYNAMIC_READ,
+	};
+
+	enum SamplerFilter
+	{
+		FILTER_NEAREST,
+		FILTER_LINEAR,
+		FILTER_NEAREST_MIPMAP_NEAREST,
+		FILTER_LINEAR_MIPMAP_NEAREST,
+		FILTER_NEAREST_MIPMAP_LINEAR,
+		FILTER_LINEAR_MIPMAP_LINEAR,
+	};
+
+	enum SamplerWrapMode
+	{
+		WRAP_CLAMP,
+		WRAP_REPEAT,
+		WRAP_CLAMP_MIRROR,
+		WRAP_REPEAT_MIRROR,
+	};
+
+	enum PixelFormat
+	{
+		FORMAT_R,
+		FORMAT_RG,
+		FORMAT_RGB,
+		FORMAT_RGBA,
+		FORMAT_DEPTH,
+		FORMAT_DEPTH_AND_STENCIL,
+	};
+
+	enum PrimitiveType
+	{
+		PRIMITIVE_TRIANGLES,
+		PRIMITIVE_POINTS,
+		PRIMITIVE_LINE_STRIP,
+		PRIMITIVE_LINE_LOOP,
+		PRIMITIVE_LINES,
+		PRIMITIVE_LINE_STRIP_ADJACENCY,
+		PRIMITIVE_LINES_ADJACENCY,
+		PRIMITIVE_TRIANGLE_STRIP,
+		PRIMITIVE_TRIANGLE_FAN,
+		PRIMITIVE_TRIANGLE_STRIP_ADJACENCY,
+		PRIMITIVE_TRIANGLES_ADJACENCY,
+		PRIMITIVE_PATCHES,
+	};
+
+	enum FaceCulling
+	{
+		FACE_CULL_NONE,
+		FACE_CULL_BACK,
+		FACE_CULL_FRONT,
+		FACE_CULL_FRONT_AND_BACK,
+	};
+
+	enum DrawFunc
+	{
+		DRAW_FUNC_NEVER,
+		DRAW_FUNC_ALWAYS,
+		DRAW_FUNC_LESS,
+		DRAW_FUNC_GREATER,
+		DRAW_FUNC_LEQUAL,
+		DRAW_FUNC_GEQUAL,
+		DRAW_FUNC_EQUAL,
+		DRAW_FUNC_NOT_EQUAL,
+	};
+
+	enum FramebufferAttachment
+	{
+		ATTACHMENT_COLOR,
+		ATTACHMENT_DEPTH,
+		ATTACHMENT_STENCIL,
+	};
+
+	enum BlendFunc
+	{
+		BLEND_FUNC_NONE,
+		BLEND_FUNC_ONE,
+		BLEND_FUNC_SRC_ALPHA,
+		BLEND_FUNC_ONE_MINUS_SRC_ALPHA,
+		BLEND_FUNC_ONE_MINUS_DST_ALPHA,
+		BLEND_FUNC_DST_ALPHA,
+	};
+
+	enum StencilOp
+	{
+		STENCIL_KEEP,
+		STENCIL_ZERO,
+		STENCIL_REPLACE,
+		STENCIL_INCR,
+		STENCIL_INCR_WRAP,
+		STENCIL_DECR_WRAP,
+		STENCIL_DECR,
+		STENCIL_INVERT,
+	};
+
+	/** @see OpenGLRenderDevice::DrawParameters */
+	struct DrawParameters
+	{
+		PrimitiveType primitiveType = PRIMITIVE_TRIANGLES;
+		FaceCulling faceCulling = FACE_CULL_NONE;
+		DrawFunc depthFunc = DRAW_FUNC_ALWAYS;
+		bool shouldWriteDepth = true;
+		bool useStencilTest = false;
+		DrawFunc stencilFunc = DRAW_FUNC_ALWAYS;
+		unsigned int stencilTestMask = 0;
+		unsigned int stencilWriteMask = 0;
+		unsigned int stencilComparisonVal = 0;
+		StencilOp stencilFail = STENCIL_KEEP;
+		StencilOp stencilPassButDepthFail = STENCIL_KEEP;
+		StencilOp stencilPass = STENCIL_KEEP;
+		bool useScissorTest = false;
+		unsigned int scissorStartX = 0;
+		unsigned int scissorStartY = 0;
+		unsigned int scissorWidth = 0;
+		unsigned int scissorHeight = 0;
+		BlendFunc sourceBlend = BLEND_FUNC_NONE;
+		BlendFunc destBlend = BLEND_FUNC_NONE;
+	};
+
+	/** @brief Nothing to initialize globally. */
+	static bool GlobalInit() { return true; }
+
+	/**
+	 * @param window Window whose size the default framebuffer takes, and which Present copies
+	 *		the default framebuffer to.
+	 * @param numWorkers Number of rasterizer threads; see JobSystem.
+	 */
+	SoftwareRenderDevice(Window& window, unsigned int numWorkers = 0);
+	virtual ~SoftwareRenderDevice() {}
+
+	/**
+	 * @brief Draws finish before their resources are released, so nothing is deferred.
+	 * @see OpenGLRenderDevice::EndFrame
+	 */
+	void EndFrame() {}
+
+	/** @see OpenGLRenderDevice::SetReleaseLatency */
+	void SetReleaseLatency(unsigned int /*numFrames*/) {}
+
+	/** @see OpenGLRenderDevice::CreateRenderTarget */
+	unsigned int CreateRenderTarget(unsigned int texture, unsigned int width, unsigned int height,
+		FramebufferAttachment attachment, unsigned int attachmentNumber, unsigned int mipLevel);
+
+	/** @see OpenGLRenderDevice::UpdateRenderTarget */
+	void UpdateRenderTarget(unsigned int fbo, unsigned int width, unsigned int height);
+
+	/** @see OpenGLRenderDevice::ReleaseRenderTarget */
+	unsigned int ReleaseRenderTarget(unsigned int fbo);
+
+	/** @see OpenGLRenderDevice::GetRenderTargetSize */
+	void GetRenderTargetSize(unsigned int fbo, unsigned int& width, unsigned int& height);
+
+	/** @see OpenGLRenderDevice::CreateVertexArray */
+	unsigned int CreateVertexArray(const float** vertexData, const unsigned int* vertexElementSizes,
+		unsigned int numVertexComponents, unsigned int numInstanceComponents,
+		unsigned int numVertices, const unsigned int* indices, unsigned int numIndices,
+		BufferUsage usage);
+
+	/** @see OpenGLRenderDevice::UpdateVertexArrayBuffer */
+	void UpdateVertexArrayBuffer(unsigned int vao, unsigned int bufferIndex, const void* data,
+		size_t dataSize);
+
+	/** @see OpenGLRenderDevice::ReleaseVertexArray */
+	unsigned int ReleaseVertexArray(unsigned int vao);
+
+	/** @see OpenGLRenderDevice::CreateSampler. Mipmaps and anisotropy are not supported. */
+	unsigned int CreateSampler(SamplerFilter minFilter, SamplerFilter magFilter,
+		SamplerWrapMode wrapU, SamplerWrapMode wrapV, float anisotropy);
+
+	/** @see OpenGLRenderDevice::ReleaseSampler */
+	unsigned int ReleaseSampler(unsigned int sampler);
+
+	/** @see OpenGLRenderDevice::CreateTexture2D. Textures are always stored as 8 bit RGBA. */
+	unsigned int CreateTexture2D(int width, int height, const void* data, PixelFormat dataFormat,
+		PixelFormat internalFormat, bool generateMipmaps, bool compress, int packAlignment,
+		int unpackAlignment);
+
+	/** @see OpenGLRenderDevice::ReleaseTexture2D */
+	unsigned int ReleaseTexture2D(unsigned int texture2D);
+
+	/** @see OpenGLRenderDevice::CreateUniformBuffer */
+	unsigned int CreateUniformBuffer(const void* data, size_t dataSize, BufferUsage usage);
+
+	/** @see OpenGLRenderDevice::UpdateUniformBuffer */
+	void UpdateUniformBuffer(unsigned int buffer, const void* data, size_t dataSize);
+
+	/** @see OpenGLRenderDevice::ReleaseUniformBuffer */
+	unsigned int ReleaseUniformBuffer(unsigned int buffer);
+
+	/** @see OpenGLRenderDevice::CreateTextureBuffer */
+	unsigned int CreateTextureBuffer(const void* data, size_t dataSize, BufferUsage usage);
+
+	/** @see OpenGLRenderDevice::UpdateTextureBuffer */
+	void UpdateTextureBuffer(unsigned int textureBuffer, const void* data, size_t dataSize);
+
+	/** @see OpenGLRenderDevice::ReleaseTextureBuffer */
+	unsigned int ReleaseTextureBuffer(unsigned int textureBuffer);
+
+	/** @see OpenGLRenderDevice::GetMaxTextureBufferSize. Only limited by memory. */
+	size_t GetMaxTextureBufferSize() { return SIZE_MAX; }
+
+	/** @see OpenGLRenderDevice::CreatePixelPackBuffer */
+	unsigned int CreatePixelPackBuffer(size_t dataSize);
+
+	/** @see OpenGLRenderDevice::ReadPixels */
+	void ReadPixels(unsigned int fbo, unsigned int buffer, unsigned int width,
+		unsigned int height);
+
+	/** @see OpenGLRenderDevice::CopyPixelPackBuffer */
+	bool CopyPixelPackBuffer(unsigned int buffer, void* destination, size_t dataSize);
+
+	/** @see OpenGLRenderDevice::ReleasePixelPackBuffer */
+	unsigned int ReleasePixelPackBuffer(unsigned int buffer);
+
+	/**
+	 * @brief Creates a shader program, by matching the shader text to one of the fixed shading
+	 *		models.
+	 */
+	unsigned int CreateShaderProgram(const std::string& shaderText);
+	void SetShaderUniformBuffer(unsigned int shader, const std::string& uniformBufferName,
+		unsigned int buffer);
+	void SetShaderSampler(unsigned int shader, const std::string& samplerName, unsigned int texture,
+		unsigned int sampler, unsigned int unit);
+	void SetShaderTextureBuffer(unsigned int shader, const std::string& samplerName,
+		unsigned int textureBuffer, unsigned int unit);
+	unsigned int ReleaseShaderProgram(unsigned int shader);
+
+	// The fixed shading models take no uniforms besides their texture; these are accepted and
+	// ignored, so that callers work unchanged
+	void SetShaderInt(unsigned int /*shader*/, const std::string& /*name*/, int /*value*/) {}
+	void SetShaderIntArray(unsigned int /*shader*/, const std::string& /*name*/, int* /*values*/,
+		unsigned int /*numValues*/) {}
+	void SetShaderFloat(unsigned int /*shader*/, const std::string& /*name*/, float /*value*/) {}
+	void SetShaderFloat2(unsigned int /*shader*/, const std::string& /*name*/,
+		const float* /*values*/) {}
+	void SetShaderFloat3(unsigned int /*shader*/, const std::string& /*name*/,
+		const float* /*values*/) {}
+	void SetShaderFloat4(unsigned int /*shader*/, const std::string& /*name*/,
+		const float* /*values*/) {}
+	void SetShaderMat3(unsigned int /*shader*/, const std::string& /*name*/,
+		const float* /*values*/) {}
+	void SetShaderMat4(unsigned int /*shader*/, const std::string& /*name*/,
+		const float* /*values*/) {}
+
+	/** @see OpenGLRenderDevice::Clear */
+	void Clear(unsigned int fbo, bool shouldClearColor, bool shouldClearDepth,
+		bool shouldClearStencil, float r, float g, float b, float a, unsigned int stencil);
+
+	/** @see OpenGLRenderDevice::Draw */
+	void Draw(unsigned int fbo, unsigned int shader, unsigned int vao,
+		const DrawParameters& drawParameters, unsigned int numInstances, unsigned int numElements);
+
+	/** @see OpenGLRenderDevice::SetDrawParameters */
+	void SetDrawParameters(const DrawParameters& /*drawParameters*/) {}
+
+	/**
+	 * @brief Finishes all pending draws. Fences are therefore signaled as soon as they are
+	 *		waited on.
+	 */
+	unsigned int CreateFence();
+	bool WaitFence(unsigned int fence, uint64_t timeout);
+	unsigned int ReleaseFence(unsigned int fence);
+
+	/** @brief Finishes all pending draws, and copies the default framebuffer to the window. */
+	void Present();
+
+	/**
+	 * @brief Finishes the pending draws of a framebuffer, and returns its color buffer.
+	 * @param fbo Framebuffer object ID.
+	 * @return 8 bit RGBA pixels, rows from bottom to top, or nullptr if the FBO does not exist.
+	 */
+	const uint8_t* GetColorBuffer(unsigned int fbo);
+
+private:
+	// Disallow copy and assign
+	SoftwareRenderDevice(const SoftwareRenderDevice& other) = delete;
+	void operator=(const SoftwareRenderDevice& other) = delete;
+
+	enum ShadingModel
+	{
+		SHADING_UNSUPPORTED,
+		// Textured; BasicShader.glsl
+		SHADING_BASIC,
+		// Signed distance field text; TextShader.glsl
+		SHADING_TEXT,
+	};
+
+	// Interpolated values; texture coordinates, then occlusion for basic shading
+	static const unsigned int MAX_VARYINGS = 8;
+	// Layers composited by each instance of text; matches TextShader.glsl
+	static const unsigned int MAX_TEXT_LAYERS = 4;
+	static const unsigned int TILE_SIZE = 64;
+
+	struct Texture2D
+	{
+		int width;
+		int height;
+		std::vector<uint8_t> pixels;
+	};
+
+	struct SamplerState
+	{
+		SamplerFilter minFilter;
+		SamplerFilter magFilter;
+		SamplerWrapMode wrapU;
+		SamplerWrapMode wrapV;
+	};
+
+	struct VertexArray
+	{
+		std::vector<std::vector<float>> buffers;
+		std::vector<unsigned int> elementSizes;
+		std::vector<unsigned int> indices;
+		unsigned int instanceComponentsStartIndex;
+		// Element and offset within the element of every attribute location
+		std::vector<unsigned int> locationElements;
+		std::vector<unsigned int> locationOffsets;
+	};
+
+	struct ShaderProgram
+	{
+		ShadingModel shadingModel;
+		unsigned int texture;
+		unsigned int sampler;
+	};
+
+	/** @brief State a binned triangle is drawn with, shared by all triangles of a draw. */
+	struct DrawState
+	{
+		ShadingModel shadingModel;
+		const Texture2D* texture;
+		SamplerState sampler;
+		DrawFunc depthFunc;
+		bool shouldWriteDepth;
+		BlendFunc sourceBlend;
+		BlendFunc destBlend;
+		int scissorMinX;
+		int scissorMinY;
+		int scissorMaxX;
+		int scissorMaxY;
+		// Color, smoothing and offset of each text layer, from the bottom layer to the top
+		float layerColors[MAX_TEXT_LAYERS][4];
+		float layerSmoothing[MAX_TEXT_LAYERS];
+		float layerOffsets[MAX_TEXT_LAYERS];
+	};
+
+	/**
+	 * @brief Triangle in window coordinates, ready to be rasterized. Edge functions are
+	 *		normalized so that they evaluate to the barycentric coordinates of a pixel.
+	 */
+	struct Triangle
+	{
+		float edgeA[3];
+		float edgeB[3];
+		float edgeC[3];
+		// 0 for edges which own the pixels exactly on them (top-left rule), tiny otherwise
+		float edgeThreshold[3];
+		float depth[3];
+		float inverseW[3];
+		float varyings[3][MAX_VARYINGS];
+		int minX;
+		int minY;
+		int maxX;
+		int maxY;
+		unsigned int state;
+	};
+
+	/** @brief Vertex in clip space, before the perspective divide. */
+	struct ClipVertex
+	{
+		float position[4];
+		float varyings[MAX_VARYINGS];
+	};
+
+	struct Framebuffer
+	{
+		unsigned int width;
+		unsigned int height;
+		// Texture rendered to, or 0 for the framebuffer's own color buffer
+		unsigned int texture;
+		std::vector<uint8_t> color;
+		// Rows padded to a multiple of 4, so 4 pixels can always be loaded at once
+		std::vector<float> depth;
+		unsigned int depthStride;
+
+		std::vector<DrawState> states;
+		std::vector<Triangle> triangles;
+		std::vector<std::vector<unsigned int>> tileBins;
+		unsigned int numTilesX;
+		unsigned int numTilesY;
+	};
+
+	void ResizeFramebuffer(Framebuffer& framebuffer, unsigned int width, unsigned int height);
+	uint8_t* GetColorPixels(Framebuffer& framebuffer);
+
+	void ProcessTriangle(Framebuffer& framebuffer, const ClipVertex* vertices,
+		FaceCulling faceCulling, unsigned int varyingCount, unsigned int state);
+	void BinTriangle(Framebuffer& framebuffer, const ClipVertex& a, const ClipVertex& b,
+		const ClipVertex& c, FaceCulling faceCulling, unsigned int varyingCount,
+		unsigned int state);
+
+	/** @brief Rasterizes all binned triangles of a framebuffer, tiles in parallel. */
+	void Resolve(Framebuffer& framebuffer);
+	void ResolveAll();
+	void RasterizeTile(Framebuffer& framebuffer, unsigned int tileX, unsigned int tileY);
+
+	/** @brief Resolves the framebuffer which renders to a texture, if any. */
+	void ResolveTexture(unsigned int texture);
+
+	JobSystem jobSystem;
+	Window* window;
+
+	unsigned int nextID;
+	unsigned int nextFenceID;
+	std::unordered_map<unsigned int, Framebuffer> framebufferMap;
+	std::unordered_map<unsigned int, VertexArray> vaoMap;
+	std::unordered_map<unsigned int, Texture2D> textureMap;
+	std::unordered_map<unsigned int, SamplerState> samplerMap;
+	std::unordered_map<unsigned int, ShaderProgram> shaderProgramMap;
+	std::unordered_map<unsigned int, std::vector<uint8_t>> bufferMap;
+
+	// Scratch space for transformed vertices
+	std::vector<ClipVertex> clipVertices;
+	// Scratch space for the default framebuffer flipped into the window's row order
+	std::vector<uint8_t> presentPixels;
+};
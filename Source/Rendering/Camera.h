@@ -64,6 +64,12 @@ public:
 	 * @return The view projection matrix.
 	 */
 	inline glm::mat4 GetViewProjection() const
+	{
+		return perspective * GetView();
+	}
+
+	/** @return The view matrix; transforms from world space into camera space. */
+	inline glm::mat4 GetView() const
 	{
 		glm::vec3 forward = this->forward;
 
@@ -77,9 +83,12 @@ public:
 		up = glm::rotate(up, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
 		up = glm::rotate(up, glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
 
-		return perspective * glm::lookAt(position, position + forward, up);
+		return glm::lookAt(position, position + forward, up);
 	}
 
+	/** @return The projection matrix; transforms from camera space into clip space. */
+	inline const glm::mat4& GetProjection() const { return perspective; }
+
 	inline void SetPosition(const glm::vec3& position) { this->position = position; }
 	inline glm::vec3& GetPosition() { return position; }
 	
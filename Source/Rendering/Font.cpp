@@ -1,7 +1,7 @@
 /** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
 
 #include "Font.h"
-#include <iostream>
+#include "Log.h"
 
 #include <ft2build.h>
 #include <freetype/freetype.h>
@@ -14,7 +14,7 @@ Font::Font(FT_Library& ft, RenderDevice& device, const std::string& fileName,
 	FT_Face face;
 	if (FT_New_Face(ft, fileName.c_str(), 0, &face))
 	{
-		std::cerr << "Font loading failed for font: " << fileName << std::endl;
+		Log::Error("Font loading failed for font: {}", fileName);
 	}
 
 	FT_Set_Pixel_Sizes(face, 0, pixelSize);
@@ -26,13 +26,13 @@ Font::Font(FT_Library& ft, RenderDevice& device, const std::string& fileName,
 		// Load character glyph
 		if (FT_Load_Char(face, c, FT_LOAD_RENDER))
 		{
-			std::cerr << "Warning: Failed to load font glyph '" << c << "'" << std::endl;
+			Log::Warning("Failed to load font glyph '{}'", (char)c);
 			continue;
 		}
 
 		if (FT_Render_Glyph(face->glyph, FT_RENDER_MODE_SDF))
 		{
-			std::cerr << "Warning: Failed to render font glyph SDF '" << c << "'" << std::endl;
+			Log::Warning("Failed to render font glyph SDF '{}'", (char)c);
 		}
 
 		glm::ivec2 origin = texturePacker.PackTexture(face->glyph->bitmap.buffer,
@@ -0,0 +1,313 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#include "FrameCapture.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+
+FrameCapture::FrameCapture(RenderDevice& device, RenderTarget& target,
+	const std::string& filePrefix, Format format, unsigned int numBuffers) : device(&device),
+	target(&target)
+{
+	callback = [filePrefix, format](const CapturedFrame& frame)
+	{
+		char number[16];
+		std::snprintf(number, sizeof(number), "%06u", frame.frameNumber);
+
+		if (format == FORMAT_PNG)
+		{
+			WritePNG(filePrefix + number + ".png", frame);
+		}
+		else
+		{
+			WriteRaw(filePrefix + number + ".raw", frame);
+		}
+	};
+
+	Initialize(numBuffers);
+}
+
+FrameCapture::FrameCapture(RenderDevice& device, RenderTarget& target,
+	const FrameCallback& callback, unsigned int numBuffers) : device(&device), target(&target),
+	callback(callback)
+{
+	Initialize(numBuffers);
+}
+
+FrameCapture::~FrameCapture()
+{
+	Flush();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		isRunning = false;
+	}
+	frameAvailable.notify_all();
+	worker.join();
+
+	for (ReadbackBuffer& buffer : buffers)
+	{
+		buffer.fence = device->ReleaseFence(buffer.fence);
+		buffer.pixelPackBuffer = device->ReleasePixelPackBuffer(buffer.pixelPackBuffer);
+	}
+}
+
+void FrameCapture::Initialize(unsigned int numBuffers)
+{
+	buffers.resize(std::max(numBuffers, 1u));
+	nextBuffer = 0;
+	nextFrameNumber = 0;
+	isProcessing = false;
+	isRunning = true;
+	worker = std::thread(&FrameCapture::RunWorker, this);
+}
+
+void FrameCapture::Capture()
+{
+	ReadbackBuffer& buffer = buffers[nextBuffer];
+	nextBuffer = (nextBuffer + 1) % (unsigned int)buffers.size();
+
+	// The ring wrapped around; the frame read into this buffer is done by now
+	if (buffer.isPending)
+	{
+		Retrieve(buffer);
+	}
+
+	unsigned int width;
+	unsigned int height;
+	target->GetSize(width, height);
+
+	const size_t size = (size_t)width * height * 4;
+	if (size == 0)
+	{
+		return;
+	}
+
+	// The render target was resized
+	if (buffer.size != size)
+	{
+		device->ReleasePixelPackBuffer(buffer.pixelPackBuffer);
+		buffer.pixelPackBuffer = device->CreatePixelPackBuffer(size);
+		buffer.size = size;
+	}
+
+	device->ReadPixels(target->GetID(), buffer.pixelPackBuffer, width, height);
+	buffer.fence = device->CreateFence();
+	buffer.frameNumber = nextFrameNumber++;
+	buffer.width = width;
+	buffer.height = height;
+	buffer.isPending = true;
+}
+
+void FrameCapture::Flush()
+{
+	// Retrieve the pending frames from oldest to newest
+	for (size_t i = 0; i < buffers.size(); i++)
+	{
+		ReadbackBuffer& buffer = buffers[(nextBuffer + i) % buffers.size()];
+		if (buffer.isPending)
+		{
+			Retrieve(buffer);
+		}
+	}
+
+	std::unique_lock<std::mutex> lock(mutex);
+	queueEmpty.wait(lock, [this]() { return queue.empty() && !isProcessing; });
+}
+
+void FrameCapture::Retrieve(ReadbackBuffer& buffer)
+{
+	device->WaitFence(buffer.fence, std::numeric_limits<uint64_t>::max());
+	buffer.fence = device->ReleaseFence(buffer.fence);
+	buffer.isPending = false;
+
+	CapturedFrame frame;
+	frame.frameNumber = buffer.frameNumber;
+	frame.width = buffer.width;
+	frame.height = buffer.height;
+	frame.pixels.resize(buffer.size);
+
+	if (!device->CopyPixelPackBuffer(buffer.pixelPackBuffer, frame.pixels.data(), buffer.size))
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queue.push_back(std::move(frame));
+	}
+	frameAvailable.notify_one();
+}
+
+void FrameCapture::RunWorker()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true)
+	{
+		frameAvailable.wait(lock, [this]() { return !queue.empty() || !isRunning; });
+		if (queue.empty())
+		{
+			// Stopped, and every frame was delivered
+			return;
+		}
+
+		CapturedFrame frame = std::move(queue.front());
+		queue.pop_front();
+		isProcessing = true;
+		lock.unlock();
+
+		// OpenGL reads rows from bottom to top; flip them so the image is upright
+		const size_t rowSize = (size_t)frame.width * 4;
+		for (unsigned int y = 0; y < frame.height / 2; y++)
+		{
+			std::swap_ranges(frame.pixels.begin() + y * rowSize,
+				frame.pixels.begin() + (y + 1) * rowSize,
+				frame.pixels.begin() + (frame.height - 1 - y) * rowSize);
+		}
+
+		callback(frame);
+
+		lock.lock();
+		isProcessing = false;
+		if (queue.empty())
+		{
+			queueEmpty.notify_all();
+		}
+	}
+}
+
+bool FrameCapture::WriteRaw(const std::string& fileName, const CapturedFrame& frame)
+{
+	std::ofstream file(fileName, std::ios::binary);
+	if (!file)
+	{
+		Log::Error("Failed to open {} for writing", fileName);
+		return false;
+	}
+
+	file.write((const char*)frame.pixels.data(), (std::streamsize)frame.pixels.size());
+	return (bool)file;
+}
+
+static uint32_t UpdateCRC(uint32_t crc, const uint8_t* data, size_t size)
+{
+	struct CRCTable
+	{
+		CRCTable()
+		{
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				uint32_t value = i;
+				for (unsigned int j = 0; j < 8; j++)
+				{
+					value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+				}
+				values[i] = value;
+			}
+		}
+
+		uint32_t values[256];
+	};
+
+	// Built once, on first use, even if several workers encode at the same time
+	static const CRCTable table;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		crc = table.values[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return crc;
+}
+
+static void AppendBigEndian(std::vector<uint8_t>& output, uint32_t value)
+{
+	output.push_back((uint8_t)(value >> 24));
+	output.push_back((uint8_t)(value >> 16));
+	output.push_back((uint8_t)(value >> 8));
+	output.push_back((uint8_t)value);
+}
+
+static void WritePNGChunk(std::ofstream& file, const char* type, const std::vector<uint8_t>& data)
+{
+	std::vector<uint8_t> header;
+	AppendBigEndian(header, (uint32_t)data.size());
+	header.insert(header.end(), type, type + 4);
+
+	uint32_t crc = UpdateCRC(0xFFFFFFFFu, header.data() + 4, 4);
+	crc = UpdateCRC(crc, data.data(), data.size()) ^ 0xFFFFFFFFu;
+
+	std::vector<uint8_t> footer;
+	AppendBigEndian(footer, crc);
+
+	file.write((const char*)header.data(), (std::streamsize)header.size());
+	file.write((const char*)data.data(), (std::streamsize)data.size());
+	file.write((const char*)footer.data(), (std::streamsize)footer.size());
+}
+
+bool FrameCapture::WritePNG(const std::string& fileName, const CapturedFrame& frame)
+{
+	std::ofstream file(fileName, std::ios::binary);
+	if (!file)
+	{
+		Log::Error("Failed to open {} for writing", fileName);
+		return false;
+	}
+
+	static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	file.write((const char*)signature, sizeof(signature));
+
+	// 8 bits per channel, RGBA, no interlacing
+	std::vector<uint8_t> header;
+	AppendBigEndian(header, frame.width);
+	AppendBigEndian(header, frame.height);
+	header.insert(header.end(), { 8, 6, 0, 0, 0 });
+	WritePNGChunk(file, "IHDR", header);
+
+	// Every row starts with its filter type; 0 is no filter
+	const size_t rowSize = (size_t)frame.width * 4;
+	std::vector<uint8_t> scanlines;
+	scanlines.reserve((rowSize + 1) * frame.height);
+	for (unsigned int y = 0; y < frame.height; y++)
+	{
+		scanlines.push_back(0);
+		scanlines.insert(scanlines.end(), frame.pixels.begin() + y * rowSize,
+			frame.pixels.begin() + (y + 1) * rowSize);
+	}
+
+	// zlib stream of stored deflate blocks, of at most 65535 bytes each
+	std::vector<uint8_t> data;
+	data.reserve(scanlines.size() + scanlines.size() / 65535 * 5 + 16);
+	data.push_back(0x78);
+	data.push_back(0x01);
+
+	uint32_t adlerA = 1;
+	uint32_t adlerB = 0;
+	size_t offset = 0;
+	do {
+		const size_t blockSize = std::min(scanlines.size() - offset, (size_t)65535);
+		const bool isFinal = offset + blockSize == scanlines.size();
+
+		data.push_back(isFinal ? 1 : 0);
+		data.push_back((uint8_t)blockSize);
+		data.push_back((uint8_t)(blockSize >> 8));
+		data.push_back((uint8_t)~blockSize);
+		data.push_back((uint8_t)(~blockSize >> 8));
+		data.insert(data.end(), scanlines.begin() + offset, scanlines.begin() + offset + blockSize);
+
+		for (size_t i = offset; i < offset + blockSize; i++)
+		{
+			adlerA = (adlerA + scanlines[i]) % 65521;
+			adlerB = (adlerB + adlerA) % 65521;
+		}
+		offset += blockSize;
+	} while (offset < scanlines.size());
+
+	AppendBigEndian(data, (adlerB << 16) | adlerA);
+	WritePNGChunk(file, "IDAT", data);
+	WritePNGChunk(file, "IEND", std::vector<uint8_t>());
+
+	return (bool)file;
+}
@@ -0,0 +1,140 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include "RenderTarget.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/** @brief A frame read back from a render target. Pixels are 8 bit RGBA, rows top to bottom. */
+struct CapturedFrame
+{
+	unsigned int frameNumber = 0;
+	unsigned int width = 0;
+	unsigned int height = 0;
+	std::vector<uint8_t> pixels;
+};
+
+/**
+ * @brief Reads frames back from a render target, or the window, without stalling the pipeline.
+ *
+ * Every captured frame is read into the next pixel pack buffer of a ring, followed by a fence.
+ * A buffer is only copied to the CPU when the ring wraps around to it, by which point the GPU
+ * has long finished with it, so the copy does not wait. Copied frames are handed to a worker
+ * thread which encodes them, so the render thread never waits on file IO either.
+ *
+ * Frames are delivered in order. Works with any GL 3.0 implementation, including software
+ * rasterizers such as Mesa's llvmpipe on headless machines.
+ */
+class FrameCapture
+{
+public:
+	enum Format
+	{
+		// Uncompressed pixels, as in CapturedFrame
+		FORMAT_RAW,
+		// PNG with stored (uncompressed) deflate blocks; cheap to encode
+		FORMAT_PNG
+	};
+
+	// Called on the worker thread for every frame
+	using FrameCallback = std::function<void(const CapturedFrame&)>;
+
+	/**
+	 * @brief Creates a capture which writes every frame to a numbered file.
+	 * @param device Render device of the render target.
+	 * @param target Render target to read back; use RenderTarget(device) for the window.
+	 * @param filePrefix Prefix of the file names; the frame number and extension are appended.
+	 * @param format File format.
+	 * @param numBuffers Number of frames in flight before a frame is copied to the CPU.
+	 */
+	FrameCapture(RenderDevice& device, RenderTarget& target, const std::string& filePrefix,
+		Format format = FORMAT_PNG, unsigned int numBuffers = 3);
+
+	/**
+	 * @brief Creates a capture which hands every frame to a callback, for example to compare
+	 *		against a reference image.
+	 * @param device Render device of the render target.
+	 * @param target Render target to read back; use RenderTarget(device) for the window.
+	 * @param callback Called on the worker thread with every frame, in order.
+	 * @param numBuffers Number of frames in flight before a frame is copied to the CPU.
+	 */
+	FrameCapture(RenderDevice& device, RenderTarget& target, const FrameCallback& callback,
+		unsigned int numBuffers = 3);
+
+	/** @brief Delivers all frames still in flight, then stops the worker thread. */
+	virtual ~FrameCapture();
+
+	/**
+	 * @brief Captures the current contents of the render target. Call once the frame has been
+	 *		rendered; for the window, before it is presented.
+	 */
+	void Capture();
+
+	/**
+	 * @brief Delivers all frames in flight, blocking until the GPU has finished with them and the
+	 *		worker has processed them.
+	 */
+	void Flush();
+
+	/**
+	 * @brief Writes a frame as a PNG file.
+	 * @param fileName Path of the file.
+	 * @param frame Frame to write.
+	 * @return Whether the file could be written.
+	 */
+	static bool WritePNG(const std::string& fileName, const CapturedFrame& frame);
+
+	/**
+	 * @brief Writes the pixels of a frame to a file, without any header.
+	 * @param fileName Path of the file.
+	 * @param frame Frame to write.
+	 * @return Whether the file could be written.
+	 */
+	static bool WriteRaw(const std::string& fileName, const CapturedFrame& frame);
+
+	inline unsigned int GetNumCapturedFrames() const { return nextFrameNumber; }
+
+private:
+	// Disallow copy and assign
+	FrameCapture(const FrameCapture& other) = delete;
+	void operator=(const FrameCapture& other) = delete;
+
+	struct ReadbackBuffer
+	{
+		unsigned int pixelPackBuffer = 0;
+		size_t size = 0;
+		unsigned int fence = 0;
+		unsigned int frameNumber = 0;
+		unsigned int width = 0;
+		unsigned int height = 0;
+		bool isPending = false;
+	};
+
+	void Initialize(unsigned int numBuffers);
+	void Retrieve(ReadbackBuffer& buffer);
+	void RunWorker();
+
+	RenderDevice* device;
+	RenderTarget* target;
+	FrameCallback callback;
+
+	std::vector<ReadbackBuffer> buffers;
+	unsigned int nextBuffer;
+	unsigned int nextFrameNumber;
+
+	std::thread worker;
+	std::mutex mutex;
+	std::condition_variable frameAvailable;
+	std::condition_variable queueEmpty;
+	std::deque<CapturedFrame> queue;
+	bool isProcessing;
+	bool isRunning;
+};
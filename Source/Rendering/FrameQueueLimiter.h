@@ -0,0 +1,68 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include "RenderDevice.h"
+
+#include <deque>
+#include <cstdint>
+
+/**
+ * @brief Bounds the number of frames the driver is allowed to queue ahead of the GPU. A fence is
+ * inserted after every presented frame; before frame N may begin, the fence from frame N - k is
+ * waited on, where k is the maximum number of queued frames. This keeps input-to-display latency
+ * bounded, at the cost of some CPU/GPU parallelism for small values of k.
+ */
+class FrameQueueLimiter
+{
+public:
+	/**
+	 * @param device Render device to create fences with.
+	 * @param maxQueuedFrames Maximum number of frames that may be in flight at once. 1 fully
+	 *		synchronizes the CPU with the GPU every frame.
+	 */
+	FrameQueueLimiter(RenderDevice& device, unsigned int maxQueuedFrames) :
+		device(&device), maxQueuedFrames(maxQueuedFrames > 0 ? maxQueuedFrames : 1) {}
+
+	virtual ~FrameQueueLimiter()
+	{
+		for (unsigned int fence : fences)
+		{
+			device->ReleaseFence(fence);
+		}
+	}
+
+	/**
+	 * @brief Marks the end of a frame, and blocks until the number of frames in flight is within
+	 *		the limit. Should be called right after the buffers are swapped.
+	 */
+	void OnPresent()
+	{
+		fences.push_back(device->CreateFence());
+
+		while (fences.size() > maxQueuedFrames)
+		{
+			// Client waits take a finite timeout, not GL_TIMEOUT_IGNORED; the largest one is
+			// centuries long, so in practice this waits until the GPU reaches the fence
+			device->WaitFence(fences.front(), UINT64_MAX);
+			device->ReleaseFence(fences.front());
+			fences.pop_front();
+		}
+	}
+
+	inline void SetMaxQueuedFrames(unsigned int maxQueuedFrames)
+	{
+		this->maxQueuedFrames = maxQueuedFrames > 0 ? maxQueuedFrames : 1;
+	}
+
+	inline unsigned int GetMaxQueuedFrames() { return maxQueuedFrames; }
+
+private:
+	// Disallow copy and assign
+	FrameQueueLimiter(const FrameQueueLimiter& other) = delete;
+	void operator=(const FrameQueueLimiter& other) = delete;
+
+	RenderDevice* device;
+	unsigned int maxQueuedFrames;
+	std::deque<unsigned int> fences;
+};
@@ -0,0 +1,48 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include <GLM/glm.hpp>
+
+/**
+ * @brief The six planes bounding the volume visible through a view projection matrix. Each plane
+ * is stored as (normal, distance), with the normal pointing into the volume.
+ */
+struct Frustum
+{
+	enum Plane
+	{
+		PLANE_LEFT,
+		PLANE_RIGHT,
+		PLANE_BOTTOM,
+		PLANE_TOP,
+		PLANE_NEAR,
+		PLANE_FAR,
+		NUM_PLANES
+	};
+
+	Frustum() {}
+
+	/**
+	 * @brief Extracts the planes of a view projection matrix (Gribb and Hartmann's method).
+	 * @param viewProjection Matrix transforming from world space into clip space.
+	 */
+	Frustum(const glm::mat4& viewProjection)
+	{
+		const glm::mat4 rows = glm::transpose(viewProjection);
+
+		planes[PLANE_LEFT] = rows[3] + rows[0];
+		planes[PLANE_RIGHT] = rows[3] - rows[0];
+		planes[PLANE_BOTTOM] = rows[3] + rows[1];
+		planes[PLANE_TOP] = rows[3] - rows[1];
+		planes[PLANE_NEAR] = rows[3] + rows[2];
+		planes[PLANE_FAR] = rows[3] - rows[2];
+
+		for (glm::vec4& plane : planes)
+		{
+			plane /= glm::length(glm::vec3(plane));
+		}
+	}
+
+	glm::vec4 planes[NUM_PLANES];
+};
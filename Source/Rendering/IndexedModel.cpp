@@ -25,9 +25,11 @@
  */
 
 #include "IndexedModel.h"
+#include "TangentSpace.h"
 
 #include <glm/gtc/type_ptr.hpp>
 #include <cassert>
+#include <cstring> // std::memcpy
 
 unsigned int IndexedModel::CreateVertexArray(RenderDevice& device, 
 	RenderDevice::BufferUsage usage) const
@@ -48,79 +50,202 @@ unsigned int IndexedModel::CreateVertexArray(RenderDevice& device,
 
 	for (unsigned int i = 0; i < numVertexComponents; i++)
 	{
-		vertexDataVector.push_back(&(elements[i][0]));
+		vertexDataVector.push_back(GetElement(i).data());
 	}
 
 	const float** vertexData = vertexDataVector.data();
 	const unsigned int* vertexElementSizes = elementSizes.data();
 
-	unsigned int numVertices = elements[0].size() / vertexElementSizes[0];
-	unsigned int numIndices = indices.size();
+	unsigned int numVertices = GetElement(0).size() / vertexElementSizes[0];
+	const std::span<const unsigned int> vertexIndices = GetIndices();
 
 	return device.CreateVertexArray(vertexData, vertexElementSizes, numVertexComponents,
-		numInstanceComponents, numVertices, indices.data(), numIndices, usage);
+		numInstanceComponents, numVertices, vertexIndices.data(),
+		(unsigned int)vertexIndices.size(), usage);
 }
 
 void IndexedModel::AllocateElement(unsigned int elementSize)
 {
 	elementSizes.push_back(elementSize);
 	elements.push_back(std::vector<float>());
+	elementViews.push_back(std::span<const float>());
 }
 
 void IndexedModel::AddElement1f(unsigned int elementIndex, float e0)
 {
 	assert(elementIndex < elementSizes.size());
-	elements[elementIndex].push_back(e0);
+	GetOwnedElement(elementIndex).push_back(e0);
 }
 
 void IndexedModel::AddElement2f(unsigned int elementIndex, float e0, float e1)
 {
 	assert(elementIndex < elementSizes.size());
-	elements[elementIndex].push_back(e0);
-	elements[elementIndex].push_back(e1);
+	std::vector<float>& element = GetOwnedElement(elementIndex);
+	element.push_back(e0);
+	element.push_back(e1);
 }
 
 void IndexedModel::AddElement3f(unsigned int elementIndex, float e0, float e1, float e2)
 {
 	assert(elementIndex < elementSizes.size());
-	elements[elementIndex].push_back(e0);
-	elements[elementIndex].push_back(e1);
-	elements[elementIndex].push_back(e2);
+	std::vector<float>& element = GetOwnedElement(elementIndex);
+	element.push_back(e0);
+	element.push_back(e1);
+	element.push_back(e2);
 }
 
 void IndexedModel::AddElement4f(unsigned int elementIndex, float e0, float e1, float e2, float e3)
 {
 	assert(elementIndex < elementSizes.size());
-	elements[elementIndex].push_back(e0);
-	elements[elementIndex].push_back(e1);
-	elements[elementIndex].push_back(e2);
-	elements[elementIndex].push_back(e3);
+	std::vector<float>& element = GetOwnedElement(elementIndex);
+	element.push_back(e0);
+	element.push_back(e1);
+	element.push_back(e2);
+	element.push_back(e3);
 }
 
 void IndexedModel::AddIndices1i(unsigned int i0)
 {
-	indices.push_back(i0);
+	GetOwnedIndices().push_back(i0);
 }
 
 void IndexedModel::AddIndices2i(unsigned int i0, unsigned int i1)
 {
-	indices.push_back(i0);
-	indices.push_back(i1);
+	std::vector<unsigned int>& ownedIndices = GetOwnedIndices();
+	ownedIndices.push_back(i0);
+	ownedIndices.push_back(i1);
 }
 
 void IndexedModel::AddIndices3i(unsigned int i0, unsigned int i1, unsigned int i2)
 {
-	indices.push_back(i0);
-	indices.push_back(i1);
-	indices.push_back(i2);
+	std::vector<unsigned int>& ownedIndices = GetOwnedIndices();
+	ownedIndices.push_back(i0);
+	ownedIndices.push_back(i1);
+	ownedIndices.push_back(i2);
 }
 
 void IndexedModel::AddIndices4i(unsigned int i0, unsigned int i1, unsigned int i2, unsigned int i3)
 {
-	indices.push_back(i0);
-	indices.push_back(i1);
-	indices.push_back(i2);
-	indices.push_back(i3);
+	std::vector<unsigned int>& ownedIndices = GetOwnedIndices();
+	ownedIndices.push_back(i0);
+	ownedIndices.push_back(i1);
+	ownedIndices.push_back(i2);
+	ownedIndices.push_back(i3);
+}
+
+void IndexedModel::Reserve(size_t numVertices, size_t numIndices)
+{
+	const unsigned int numVertexElements = instancedElementsStartIndex == (unsigned int)-1
+		? (unsigned int)elementSizes.size() : instancedElementsStartIndex;
+
+	for (unsigned int i = 0; i < numVertexElements; i++)
+	{
+		std::vector<float>& element = GetOwnedElement(i);
+		element.reserve(element.size() + numVertices * elementSizes[i]);
+	}
+
+	std::vector<unsigned int>& ownedIndices = GetOwnedIndices();
+	ownedIndices.reserve(ownedIndices.size() + numIndices);
+}
+
+void IndexedModel::AppendElements(unsigned int elementIndex, const float* data, size_t count,
+	size_t stride)
+{
+	assert(elementIndex < elementSizes.size());
+	if (count == 0)
+	{
+		return;
+	}
+
+	const size_t elementSize = elementSizes[elementIndex];
+	float* destination = AppendElements(elementIndex, count);
+
+	if (stride == 0 || stride == elementSize)
+	{
+		std::memcpy(destination, data, count * elementSize * sizeof(float));
+		return;
+	}
+
+	for (size_t i = 0; i < count; i++)
+	{
+		std::memcpy(destination + i * elementSize, data + i * stride, elementSize * sizeof(float));
+	}
+}
+
+float* IndexedModel::AppendElements(unsigned int elementIndex, size_t count)
+{
+	assert(elementIndex < elementSizes.size());
+	std::vector<float>& element = GetOwnedElement(elementIndex);
+	const size_t start = element.size();
+	element.resize(start + count * elementSizes[elementIndex]);
+	return element.data() + start;
+}
+
+void IndexedModel::AppendIndices(const unsigned int* data, size_t count)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	std::memcpy(AppendIndices(count), data, count * sizeof(unsigned int));
+}
+
+unsigned int* IndexedModel::AppendIndices(size_t count)
+{
+	std::vector<unsigned int>& ownedIndices = GetOwnedIndices();
+	const size_t start = ownedIndices.size();
+	ownedIndices.resize(start + count);
+	return ownedIndices.data() + start;
+}
+
+void IndexedModel::AdoptElement(unsigned int elementIndex, std::vector<float>&& data)
+{
+	assert(elementIndex < elementSizes.size());
+	elements[elementIndex] = std::move(data);
+	elementViews[elementIndex] = std::span<const float>();
+}
+
+void IndexedModel::AdoptIndices(std::vector<unsigned int>&& data)
+{
+	indices = std::move(data);
+	indicesView = std::span<const unsigned int>();
+}
+
+void IndexedModel::SetElementView(unsigned int elementIndex, const float* data, size_t count)
+{
+	assert(elementIndex < elementSizes.size());
+	elements[elementIndex].clear();
+	elements[elementIndex].shrink_to_fit();
+	elementViews[elementIndex] = std::span<const float>(data, count * elementSizes[elementIndex]);
+}
+
+void IndexedModel::SetIndicesView(const unsigned int* data, size_t count)
+{
+	indices.clear();
+	indices.shrink_to_fit();
+	indicesView = std::span<const unsigned int>(data, count);
+}
+
+void IndexedModel::CalculateNormals(JobSystem* jobSystem)
+{
+	const size_t numVertices = GetElement(0).size() / 3;
+	std::vector<float>& normals = GetOwnedElement(2);
+	normals.resize(numVertices * 3);
+
+	TangentSpaceGenerator generator(jobSystem);
+	generator.CalculateNormals(GetElement(0), GetIndices(), normals);
+}
+
+void IndexedModel::CalculateTangents(JobSystem* jobSystem)
+{
+	const size_t numVertices = GetElement(0).size() / 3;
+	std::vector<float>& tangents = GetOwnedElement(3);
+	tangents.resize(numVertices * 3);
+
+	TangentSpaceGenerator generator(jobSystem);
+	generator.CalculateTangents(GetElement(0), GetElement(2), GetElement(1), GetIndices(),
+		tangents);
 }
 
 AABB IndexedModel::GetAABBForElementArray(unsigned int index)
@@ -130,39 +255,36 @@ AABB IndexedModel::GetAABBForElementArray(unsigned int index)
 		return AABB(); // Empty AABB as we lack 3D points
 	}
 
+	const std::span<const float> element = GetElement(index);
 	std::vector<glm::vec3> points;
-	for (unsigned int i = 0; i < elements[index].size() - 3; i += 3)
+	for (unsigned int i = 0; i < element.size() - 3; i += 3)
 	{
 		// Convert each set of 3 floats into a vec3
-		points.push_back(glm::make_vec3(elements[index].data() + i));
+		points.push_back(glm::make_vec3(element.data() + i));
 	}
 
 	return AABB(points);
 }
 
-/*void IndexedModel::CalculateNormals()
+std::vector<float>& IndexedModel::GetOwnedElement(unsigned int elementIndex)
 {
-	// Iterate over all triangles in the model
-	for (unsigned int i = 0; i < indices.size(); i += 3)
+	std::span<const float>& view = elementViews[elementIndex];
+	if (view.data() != nullptr)
 	{
-		// Get the three vertex indices of the triangle in the model
-		int i0 = indices[i];
-		int i1 = indices[i + 1];
-		int i2 = indices[i + 2];
-
-		// Calculate the normal of the triangle
-		glm::vec3 v1 = positions[i1] - positions[i0];
-		glm::vec3 v2 = positions[i2] - positions[i0];
+		elements[elementIndex].assign(view.begin(), view.end());
+		view = std::span<const float>();
+	}
 
-		glm::vec3 normal = glm::normalize(glm::cross(v1, v2));
+	return elements[elementIndex];
+}
 
-		// Set the normal for each vertex
-		normals[i0] += normal;
-		normals[i1] += normal;
-		normals[i2] += normal;
+std::vector<unsigned int>& IndexedModel::GetOwnedIndices()
+{
+	if (indicesView.data() != nullptr)
+	{
+		indices.assign(indicesView.begin(), indicesView.end());
+		indicesView = std::span<const unsigned int>();
 	}
 
-	// Iterate over all vertices and normalize the normal
-	for (unsigned int i = 0; i < positions.size(); i++)
-		normals[i] = glm::normalize(normals[i]);
-}*/
+	return indices;
+}
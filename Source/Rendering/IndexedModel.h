@@ -29,6 +29,11 @@
 #include "RenderDevice.h"
 #include "AABB.h"
 
+#include <span>
+#include <vector>
+
+class JobSystem;
+
 class IndexedModel
 {
 public:
@@ -48,18 +53,126 @@ public:
 	void AddIndices3i(unsigned int i0, unsigned int i1, unsigned int i2);
 	void AddIndices4i(unsigned int i0, unsigned int i1, unsigned int i2, unsigned int i3);
 
+	/**
+	 * @brief Reserves storage for the vertex elements and indices, so appending them does not
+	 *		reallocate. Must be called after the elements are allocated.
+	 * @param numVertices Number of vertices to reserve in every non-instanced element.
+	 * @param numIndices Number of indices to reserve.
+	 */
+	void Reserve(size_t numVertices, size_t numIndices);
+
+	/**
+	 * @brief Appends values to an element with a single copy.
+	 * @param elementIndex Index of the element.
+	 * @param data Values to copy; elementSize floats per value.
+	 * @param count Number of values to append.
+	 * @param stride Distance between consecutive values in data, in floats. 0 if the values are
+	 *		tightly packed.
+	 */
+	void AppendElements(unsigned int elementIndex, const float* data, size_t count,
+		size_t stride = 0);
+
+	/**
+	 * @brief Appends zeroed values to an element, to be written in place.
+	 * @param elementIndex Index of the element.
+	 * @param count Number of values to append.
+	 * @return First float of the appended values. Valid until the element is next modified.
+	 */
+	float* AppendElements(unsigned int elementIndex, size_t count);
+
+	/**
+	 * @brief Appends indices with a single copy.
+	 * @param data Indices to copy.
+	 * @param count Number of indices.
+	 */
+	void AppendIndices(const unsigned int* data, size_t count);
+
+	/**
+	 * @brief Appends zeroed indices, to be written in place.
+	 * @param count Number of indices.
+	 * @return First appended index. Valid until the indices are next modified.
+	 */
+	unsigned int* AppendIndices(size_t count);
+
+	/** @brief Replaces the values of an element with a buffer, without copying it. */
+	void AdoptElement(unsigned int elementIndex, std::vector<float>&& data);
+
+	/** @brief Replaces the indices with a buffer, without copying it. */
+	void AdoptIndices(std::vector<unsigned int>&& data);
+
+	/**
+	 * @brief Makes an element refer to values owned elsewhere, such as a memory mapped file,
+	 *		without copying them. The memory must outlive every use of the model. Modifying the
+	 *		element afterwards first copies the values into the model.
+	 * @param elementIndex Index of the element.
+	 * @param data Values; elementSize floats per value.
+	 * @param count Number of values.
+	 */
+	void SetElementView(unsigned int elementIndex, const float* data, size_t count);
+
+	/**
+	 * @brief Makes the indices refer to memory owned elsewhere, without copying them. The memory
+	 *		must outlive every use of the model. Modifying the indices afterwards first copies them
+	 *		into the model.
+	 * @param data Indices.
+	 * @param count Number of indices.
+	 */
+	void SetIndicesView(const unsigned int* data, size_t count);
+
+	/**
+	 * @brief Recalculates smooth normals from the positions and indices. Elements must be laid
+	 *		out as by LoadModels: positions, texture coordinates, normals, then tangents.
+	 * @param jobSystem Job system to spread large models over, or nullptr.
+	 */
+	void CalculateNormals(JobSystem* jobSystem = nullptr);
+
+	/**
+	 * @brief Recalculates tangents from the positions, texture coordinates, normals and indices.
+	 *		Elements must be laid out as by LoadModels.
+	 * @param jobSystem Job system to spread large models over, or nullptr.
+	 */
+	void CalculateTangents(JobSystem* jobSystem = nullptr);
+
 	AABB GetAABBForElementArray(unsigned int index);
 
-	inline unsigned int GetNumIndices() const { return indices.size(); }
+	inline unsigned int GetNumIndices() const { return (unsigned int)GetIndices().size(); }
+
+	inline std::span<const unsigned int> GetIndices() const
+	{
+		return indicesView.data() != nullptr ? indicesView :
+			std::span<const unsigned int>(indices);
+	}
+
+	inline std::span<const float> GetElement(unsigned int elementIndex) const
+	{
+		return elementViews[elementIndex].data() != nullptr ? elementViews[elementIndex] :
+			std::span<const float>(elements[elementIndex]);
+	}
 
 	inline void SetInstancedElementStartIndex(unsigned int elementIndex)
 	{
 		instancedElementsStartIndex = elementIndex;
 	}
 
+	/** @return Size of the first instanced element, or 0 if the model has no instanced data. */
+	inline unsigned int GetInstanceSize() const
+	{
+		return instancedElementsStartIndex < elementSizes.size() ?
+			elementSizes[instancedElementsStartIndex] : 0;
+	}
+
 private:
+	/** @brief Copies a viewed element into the model, so it can be modified. */
+	std::vector<float>& GetOwnedElement(unsigned int elementIndex);
+
+	/** @brief Copies viewed indices into the model, so they can be modified. */
+	std::vector<unsigned int>& GetOwnedIndices();
+
 	std::vector<unsigned int> indices;
 	std::vector<unsigned int> elementSizes;
 	std::vector<std::vector<float>> elements;
+	// Memory owned elsewhere, used instead of the vectors above when set
+	std::span<const unsigned int> indicesView;
+	std::vector<std::span<const float>> elementViews;
 	unsigned int instancedElementsStartIndex;
 };
@@ -25,16 +25,93 @@
  */
 
 #include "Mesh.h"
+#include "Log.h"
+#include "OBJLoader.h"
+#include "Baking/OcclusionBaker.h"
 #include <vector>
-#include <iostream>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <GLM/gtc/type_ptr.hpp>
 
 #include <Assimp/Importer.hpp>
 #include <Assimp/scene.h>
 #include <Assimp/postprocess.h>
 
-std::vector<IndexedModel> LoadModels(const std::string& fileName)
+/**
+ * @brief Adds the positions, texture coordinates, normals, tangents and indices of a mesh to a
+ * model, as elements 0 to 3.
+ */
+static void AddMeshData(const aiMesh* model, IndexedModel& newModel)
+{
+	static_assert(sizeof(aiVector3D) == 3 * sizeof(float), "aiVector3D must be 3 packed floats");
+	const unsigned int numVertices = model->mNumVertices;
+	newModel.Reserve(numVertices, (size_t)model->mNumFaces * 3);
+
+	// Copy the vertex arrays directly; texture coordinates are stored as 3D vectors
+	newModel.AppendElements(0, &model->mVertices[0].x, numVertices);
+	if (model->HasTextureCoords(0))
+	{
+		newModel.AppendElements(1, &model->mTextureCoords[0][0].x, numVertices, 3);
+	}
+	else
+	{
+		// If the model does not have texture coordinates set them to zero
+		newModel.AppendElements(1, numVertices);
+	}
+	newModel.AppendElements(2, &model->mNormals[0].x, numVertices);
+	if (model->HasTangentsAndBitangents())
+	{
+		newModel.AppendElements(3, &model->mTangents[0].x, numVertices);
+	}
+	else
+	{
+		// Tangents cannot be calculated without texture coordinates
+		newModel.AppendElements(3, numVertices);
+	}
+
+	// Loop over all faces in the model
+	unsigned int* indices = newModel.AppendIndices((size_t)model->mNumFaces * 3);
+	for (unsigned int j = 0; j < model->mNumFaces; j++)
+	{
+		const aiFace& face = model->mFaces[j];
+		// The model should be triangulated as we passed the aiProcess_Triangulate flag
+		assert(face.mNumIndices == 3);
+		indices[j * 3] = face.mIndices[0];
+		indices[j * 3 + 1] = face.mIndices[1];
+		indices[j * 3 + 2] = face.mIndices[2];
+	}
+}
+
+/** @return Whether a file name ends with an extension, ignoring case. */
+static bool HasExtension(const std::string& fileName, const std::string& extension)
+{
+	return fileName.size() >= extension.size() && std::equal(extension.begin(), extension.end(),
+		fileName.end() - extension.size(), [](char a, char b)
+		{
+			return std::tolower((unsigned char)a) == std::tolower((unsigned char)b);
+		});
+}
+
+std::vector<IndexedModel> LoadModels(const std::string& fileName, unsigned int numInstanceStreams)
 {
 	std::vector<IndexedModel> models;
+
+	// OBJ files are parsed directly, which is much faster than Assimp for large files
+	if (HasExtension(fileName, ".obj") && LoadOBJModels(fileName, numInstanceStreams, models))
+	{
+		if (models.empty())
+		{
+			Log::Error("No faces in mesh/file: {}", fileName);
+		}
+
+		LoadOcclusion(fileName + OCCLUSION_FILE_EXTENSION, models);
+		return models;
+	}
+
 	Assimp::Importer importer;
 
 	// Read our file
@@ -45,7 +122,7 @@ std::vector<IndexedModel> LoadModels(const std::string& fileName)
 	// Import failed
 	if (!scene)
 	{
-		std::cerr << "Unable to load mesh/file: " << fileName << std::endl;
+		Log::Error("Unable to load mesh/file: {}", fileName);
 		return models;
 	}
 
@@ -59,39 +136,370 @@ std::vector<IndexedModel> LoadModels(const std::string& fileName)
 		newModel.AllocateElement(2); // Texture Coordinates
 		newModel.AllocateElement(3); // Normals
 		newModel.AllocateElement(3); // Tangents
-		newModel.SetInstancedElementStartIndex(4); // Begin instanced data
-		newModel.AllocateElement(16); // Transform matrix
+		newModel.AllocateElement(1); // Ambient occlusion
+		newModel.SetInstancedElementStartIndex(5); // Begin instanced data
+		newModel.AllocateElement(16 + numInstanceStreams * 4); // Transform matrix and streams
 
-		const aiVector3D aiZeroVector(0.0f, 0.0f, 0.0f);
+		AddMeshData(model, newModel);
+		// Unoccluded until baked
+		newModel.AppendElements(4, model->mNumVertices);
 
-		// Loop over all vertices in the model
-		for (unsigned int j = 0; j < model->mNumVertices; j++)
+		models.push_back(std::move(newModel));
+	}
+
+	// Use baked ambient occlusion, if there is any
+	LoadOcclusion(fileName + OCCLUSION_FILE_EXTENSION, models);
+
+	return models;
+}
+
+/** @brief Converts a row-major Assimp matrix into a column-major GLM matrix. */
+static glm::mat4 ConvertMatrix(const aiMatrix4x4& matrix)
+{
+	return glm::transpose(glm::make_mat4(&matrix.a1));
+}
+
+/** @return true if the node, or any of its descendants, is a bone. */
+static bool ContainsBone(const aiNode* node, const std::unordered_set<std::string>& boneNames)
+{
+	if (boneNames.count(node->mName.C_Str()) != 0)
+	{
+		return true;
+	}
+
+	for (unsigned int i = 0; i < node->mNumChildren; i++)
+	{
+		if (ContainsBone(node->mChildren[i], boneNames))
 		{
-			const aiVector3D position = model->mVertices[j];
-			const aiVector3D normal = model->mNormals[j];
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @brief Adds a node and its descendants to the skeleton, depth first so that parents precede
+ * their children. Nodes which are neither bones nor ancestors of bones are skipped.
+ */
+static void AddSkeletonNodes(const aiNode* node, int parent,
+	const std::unordered_set<std::string>& boneNames, Skeleton& skeleton,
+	std::vector<aiMatrix4x4>& bindTransforms)
+{
+	if (!ContainsBone(node, boneNames))
+	{
+		return;
+	}
 
-			// If the model does not have texture coordinates set them to zero
-			const aiVector3D textureCoordinate = (model->HasTextureCoords(0) ? 
-				model->mTextureCoords[0][j] : aiZeroVector);
+	const int index = (int)skeleton.parents.size();
+	skeleton.boneNames.push_back(node->mName.C_Str());
+	skeleton.parents.push_back(parent);
+	skeleton.inverseBindPoses.push_back(glm::mat4(1.0f));
+	bindTransforms.push_back(node->mTransformation);
+
+	for (unsigned int i = 0; i < node->mNumChildren; i++)
+	{
+		AddSkeletonNodes(node->mChildren[i], index, boneNames, skeleton, bindTransforms);
+	}
+}
 
-			const aiVector3D tangent = model->mTangents[j];
+/** @brief Linearly interpolates a set of vector keys at a point in time, in ticks. */
+static aiVector3D SampleVectorKeys(const aiVectorKey* keys, unsigned int numKeys, double tick)
+{
+	if (numKeys == 1 || tick <= keys[0].mTime)
+	{
+		return keys[0].mValue;
+	}
 
-			newModel.AddElement3f(0, position.x, position.y, position.z);
-			newModel.AddElement2f(1, textureCoordinate.x, textureCoordinate.y);
-			newModel.AddElement3f(2, normal.x, normal.y, normal.z);
-			newModel.AddElement3f(3, tangent.x, tangent.y, tangent.z);
+	for (unsigned int i = 0; i + 1 < numKeys; i++)
+	{
+		if (tick < keys[i + 1].mTime)
+		{
+			const float alpha = (float)((tick - keys[i].mTime) / (keys[i + 1].mTime - keys[i].mTime));
+			return keys[i].mValue + (keys[i + 1].mValue - keys[i].mValue) * alpha;
 		}
+	}
+
+	return keys[numKeys - 1].mValue;
+}
 
-		// Loop over all faces in the model
-		for (unsigned int j = 0; j < model->mNumFaces; j++)
+/** @brief Spherically interpolates a set of rotation keys at a point in time, in ticks. */
+static aiQuaternion SampleQuaternionKeys(const aiQuatKey* keys, unsigned int numKeys, double tick)
+{
+	if (numKeys == 1 || tick <= keys[0].mTime)
+	{
+		return keys[0].mValue;
+	}
+
+	for (unsigned int i = 0; i + 1 < numKeys; i++)
+	{
+		if (tick < keys[i + 1].mTime)
 		{
-			const aiFace& face = model->mFaces[j];
-			// The model should be triangulated as we passed the aiProcess_Triangulate flag
-			assert(face.mNumIndices == 3);
-			newModel.AddIndices3i(face.mIndices[0], face.mIndices[1], face.mIndices[2]);
+			const float alpha = (float)((tick - keys[i].mTime) / (keys[i + 1].mTime - keys[i].mTime));
+			aiQuaternion result;
+			aiQuaternion::Interpolate(result, keys[i].mValue, keys[i + 1].mValue, alpha);
+			return result.Normalize();
 		}
+	}
+
+	return keys[numKeys - 1].mValue;
+}
+
+static inline int16_t QuantizeNormalized(float value)
+{
+	return (int16_t)std::lround(glm::clamp(value, -1.0f, 1.0f) * 32767.0f);
+}
 
-		models.push_back(newModel);
+/**
+ * @brief Computes the center and extent of a set of values, then quantizes each value as a
+ * normalized offset from the center.
+ */
+static void QuantizeRange(const glm::vec3* values, unsigned int numValues, unsigned int stride,
+	glm::vec4& center, glm::vec4& extent, int16_t* quantized, unsigned int quantizedStride)
+{
+	glm::vec3 minimum = values[0];
+	glm::vec3 maximum = values[0];
+	for (unsigned int i = 1; i < numValues; i++)
+	{
+		minimum = glm::min(minimum, values[i * stride]);
+		maximum = glm::max(maximum, values[i * stride]);
+	}
+
+	center = glm::vec4((minimum + maximum) * 0.5f, 0.0f);
+	extent = glm::vec4((maximum - minimum) * 0.5f, 0.0f);
+
+	for (unsigned int i = 0; i < numValues; i++)
+	{
+		int16_t* key = quantized + i * quantizedStride;
+		for (unsigned int j = 0; j < 3; j++)
+		{
+			key[j] = extent[j] > 0.0f
+				? QuantizeNormalized((values[i * stride][j] - center[j]) / extent[j])
+				: 0;
+		}
+		key[3] = 0;
+	}
+}
+
+/** @brief Resamples an Assimp animation at a fixed rate and quantizes it. */
+static AnimationClip LoadAnimationClip(const aiAnimation* animation, const Skeleton& skeleton,
+	const std::vector<aiMatrix4x4>& bindTransforms, float sampleRate)
+{
+	const unsigned int numBones = skeleton.GetNumBones();
+	const double ticksPerSecond = animation->mTicksPerSecond != 0.0
+		? animation->mTicksPerSecond
+		: 25.0;
+
+	AnimationClip clip;
+	clip.name = animation->mName.C_Str();
+	clip.duration = (float)(animation->mDuration / ticksPerSecond);
+	clip.sampleRate = sampleRate;
+	clip.numFrames = (unsigned int)std::ceil(clip.duration * sampleRate) + 1;
+	clip.numBones = numBones;
+
+	std::unordered_map<std::string, const aiNodeAnim*> channels;
+	for (unsigned int i = 0; i < animation->mNumChannels; i++)
+	{
+		channels[animation->mChannels[i]->mNodeName.C_Str()] = animation->mChannels[i];
+	}
+
+	// Sample the tracks into full precision, frame-major arrays first
+	const size_t numKeys = (size_t)clip.numFrames * numBones;
+	std::vector<glm::vec4> rotations(numKeys);
+	std::vector<glm::vec3> translations(numKeys);
+	std::vector<glm::vec3> scales(numKeys);
+
+	for (unsigned int bone = 0; bone < numBones; bone++)
+	{
+		aiVector3D bindScale, bindTranslation;
+		aiQuaternion bindRotation;
+		bindTransforms[bone].Decompose(bindScale, bindRotation, bindTranslation);
+
+		const auto channelIt = channels.find(skeleton.boneNames[bone]);
+		const aiNodeAnim* channel = channelIt != channels.end() ? channelIt->second : nullptr;
+
+		glm::vec4 previousRotation(0.0f);
+		for (unsigned int frame = 0; frame < clip.numFrames; frame++)
+		{
+			const double tick = glm::min((double)frame / sampleRate, (double)clip.duration)
+				* ticksPerSecond;
+
+			aiVector3D translation = bindTranslation;
+			aiQuaternion rotation = bindRotation;
+			aiVector3D scale = bindScale;
+			if (channel && channel->mNumPositionKeys > 0)
+			{
+				translation = SampleVectorKeys(channel->mPositionKeys, channel->mNumPositionKeys,
+					tick);
+			}
+			if (channel && channel->mNumRotationKeys > 0)
+			{
+				rotation = SampleQuaternionKeys(channel->mRotationKeys, channel->mNumRotationKeys,
+					tick);
+			}
+			if (channel && channel->mNumScalingKeys > 0)
+			{
+				scale = SampleVectorKeys(channel->mScalingKeys, channel->mNumScalingKeys, tick);
+			}
+
+			glm::vec4 quaternion = glm::normalize(
+				glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w));
+			// Keep consecutive keys in the same hemisphere, so interpolation takes the short path
+			if (glm::dot(quaternion, previousRotation) < 0.0f)
+			{
+				quaternion = -quaternion;
+			}
+			previousRotation = quaternion;
+
+			const size_t key = (size_t)frame * numBones + bone;
+			rotations[key] = quaternion;
+			translations[key] = glm::vec3(translation.x, translation.y, translation.z);
+			scales[key] = glm::vec3(scale.x, scale.y, scale.z);
+		}
+	}
+
+	// Quantize
+	clip.keys.resize(numKeys);
+	clip.translationCenters.resize(numBones);
+	clip.translationExtents.resize(numBones);
+	clip.scaleCenters.resize(numBones);
+	clip.scaleExtents.resize(numBones);
+
+	const unsigned int keyStride = sizeof(AnimationClip::Key) / sizeof(int16_t);
+	for (unsigned int bone = 0; bone < numBones; bone++)
+	{
+		QuantizeRange(&translations[bone], clip.numFrames, numBones,
+			clip.translationCenters[bone], clip.translationExtents[bone],
+			clip.keys[bone].translation, numBones * keyStride);
+		QuantizeRange(&scales[bone], clip.numFrames, numBones,
+			clip.scaleCenters[bone], clip.scaleExtents[bone],
+			clip.keys[bone].scale, numBones * keyStride);
+	}
+
+	for (size_t i = 0; i < numKeys; i++)
+	{
+		for (unsigned int j = 0; j < 4; j++)
+		{
+			clip.keys[i].rotation[j] = QuantizeNormalized(rotations[i][j]);
+		}
+	}
+
+	return clip;
+}
+
+std::vector<IndexedModel> LoadSkinnedModels(const std::string& fileName, Skeleton& skeleton,
+	std::vector<AnimationClip>& clips, float sampleRate)
+{
+	std::vector<IndexedModel> models;
+	Assimp::Importer importer;
+
+	const aiScene* scene = importer.ReadFile(fileName.c_str(), aiProcess_Triangulate |
+		aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace |
+		aiProcess_LimitBoneWeights);
+
+	// Import failed
+	if (!scene)
+	{
+		Log::Error("Unable to load mesh/file: {}", fileName);
+		return models;
+	}
+
+	// Build the skeleton from every node that is a bone, or an ancestor of one
+	std::unordered_set<std::string> boneNames;
+	for (unsigned int i = 0; i < scene->mNumMeshes; i++)
+	{
+		for (unsigned int j = 0; j < scene->mMeshes[i]->mNumBones; j++)
+		{
+			boneNames.insert(scene->mMeshes[i]->mBones[j]->mName.C_Str());
+		}
+	}
+
+	skeleton = Skeleton();
+	std::vector<aiMatrix4x4> bindTransforms;
+	AddSkeletonNodes(scene->mRootNode, -1, boneNames, skeleton, bindTransforms);
+	skeleton.globalInverseTransform = glm::inverse(ConvertMatrix(scene->mRootNode->mTransformation));
+
+	// Vertices would reference bones past the end of their palette
+	if (skeleton.GetNumBones() > Skeleton::MAX_BONES)
+	{
+		Log::Error("Unable to load mesh/file: {} has {} bones, more than the supported {}",
+			fileName, skeleton.GetNumBones(), Skeleton::MAX_BONES);
+		skeleton = Skeleton();
+		return models;
+	}
+
+	std::unordered_map<std::string, unsigned int> boneIndices;
+	for (unsigned int i = 0; i < skeleton.GetNumBones(); i++)
+	{
+		boneIndices[skeleton.boneNames[i]] = i;
+	}
+
+	for (unsigned int i = 0; i < scene->mNumMeshes; i++)
+	{
+		const aiMesh* model = scene->mMeshes[i];
+
+		IndexedModel newModel;
+		newModel.AllocateElement(3); // Positions
+		newModel.AllocateElement(2); // Texture Coordinates
+		newModel.AllocateElement(3); // Normals
+		newModel.AllocateElement(3); // Tangents
+		newModel.AllocateElement(4); // Bone indices
+		newModel.AllocateElement(4); // Bone weights
+		newModel.SetInstancedElementStartIndex(6); // Begin instanced data
+		newModel.AllocateElement(16 + 4); // Transform matrix and bone offset
+
+		AddMeshData(model, newModel);
+
+		// Gather the 4 most significant influences of each vertex
+		std::vector<glm::vec4> vertexBones(model->mNumVertices, glm::vec4(0.0f));
+		std::vector<glm::vec4> vertexWeights(model->mNumVertices, glm::vec4(0.0f));
+		for (unsigned int j = 0; j < model->mNumBones; j++)
+		{
+			const aiBone* bone = model->mBones[j];
+			const unsigned int boneIndex = boneIndices[bone->mName.C_Str()];
+			skeleton.inverseBindPoses[boneIndex] = ConvertMatrix(bone->mOffsetMatrix);
+
+			for (unsigned int k = 0; k < bone->mNumWeights; k++)
+			{
+				const aiVertexWeight& weight = bone->mWeights[k];
+				glm::vec4& weights = vertexWeights[weight.mVertexId];
+
+				// Replace the smallest influence, if this one is more significant
+				unsigned int slot = 0;
+				for (unsigned int l = 1; l < 4; l++)
+				{
+					if (weights[l] < weights[slot])
+					{
+						slot = l;
+					}
+				}
+
+				if (weight.mWeight > weights[slot])
+				{
+					weights[slot] = weight.mWeight;
+					vertexBones[weight.mVertexId][slot] = (float)boneIndex;
+				}
+			}
+		}
+
+		for (unsigned int j = 0; j < model->mNumVertices; j++)
+		{
+			glm::vec4& weights = vertexWeights[j];
+			const float totalWeight = weights.x + weights.y + weights.z + weights.w;
+			// Unweighted vertices follow the root bone
+			weights = totalWeight > 0.0f ? weights / totalWeight : glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
+		}
+
+		newModel.AppendElements(4, (const float*)vertexBones.data(), model->mNumVertices);
+		newModel.AppendElements(5, (const float*)vertexWeights.data(), model->mNumVertices);
+
+		models.push_back(std::move(newModel));
+	}
+
+	for (unsigned int i = 0; i < scene->mNumAnimations; i++)
+	{
+		clips.push_back(LoadAnimationClip(scene->mAnimations[i], skeleton, bindTransforms,
+			sampleRate));
 	}
 
 	return models;
@@ -28,6 +28,7 @@
 
 #include "AABB.h"
 #include "IndexedModel.h"
+#include "Animation/Skeleton.h"
 
 #include <GLM/glm.hpp>
 #include <GL/glew.h>
@@ -67,11 +68,36 @@ private:
 
 /**
  * Loads all meshes from a file.
+ * Each vertex has a position (element 0), texture coordinate (element 1), normal (element 2),
+ * tangent (element 3) and ambient occlusion (element 4). Occlusion is read from a file baked by
+ * BakeModelOcclusion next to the model, if there is one, and is otherwise zero. Instanced data
+ * begins at element 5: the transform matrix, followed by any extra instance streams of 4 floats
+ * each, interleaved in one buffer (see GameRenderContext).
+ * OBJ files are loaded by LoadOBJModels, and other formats, or OBJ files it cannot read, by Assimp.
  * 
  * @param fileName File path to the model.
+ * @param numInstanceStreams Number of instance streams besides the transform.
  * @returns A list of all meshes, in IndexedModel form.
  */
-std::vector<IndexedModel> LoadModels(const std::string& fileName);
+std::vector<IndexedModel> LoadModels(const std::string& fileName,
+	unsigned int numInstanceStreams = 0);
+
+/**
+ * Loads all meshes from a file, along with the skeleton they are bound to and all animations.
+ * Each vertex has the elements of LoadModels up to the tangent, then 4 bone indices
+ * (element 4) and 4 bone weights (element 5). Instanced data begins at element 6: the transform
+ * matrix, followed by a stream of 4 floats whose first is the offset of the instance's bone
+ * matrices (see GameRenderContext::RenderSkinnedMesh). Files whose skeleton has more than
+ * Skeleton::MAX_BONES bones are rejected, leaving the skeleton empty.
+ * 
+ * @param fileName File path to the model.
+ * @param skeleton Skeleton to fill with the bones of the file.
+ * @param clips List to append the animations of the file to, resampled and quantized.
+ * @param sampleRate Number of keys per second to resample animations at.
+ * @returns A list of all meshes, in IndexedModel form.
+ */
+std::vector<IndexedModel> LoadSkinnedModels(const std::string& fileName, Skeleton& skeleton,
+	std::vector<AnimationClip>& clips, float sampleRate = 30.0f);
 
 
 //class Mesh
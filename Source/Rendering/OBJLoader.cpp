@@ -0,0 +1,842 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#include "OBJLoader.h"
+#include "Platform/MappedFile.h"
+#include "Jobs/JobSystem.h"
+#include "SIMD.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+
+// Bytes of the file parsed per job
+static const size_t CHUNK_SIZE = 1 << 20;
+// Files from this size are worth starting threads for when no job system is given
+static const size_t MIN_PARALLEL_FILE_SIZE = 8 << 20;
+// Face corners hashed per job while merging vertices
+static const unsigned int CORNERS_PER_BATCH = 1 << 16;
+// Partitions of the vertex merge per thread, so uneven partitions still balance
+static const unsigned int PARTITIONS_PER_THREAD = 4;
+// Digits a 64 bit mantissa holds without overflowing
+static const int MAX_MANTISSA_DIGITS = 19;
+
+// Powers of ten which are exact as doubles
+static const double POWERS_OF_TEN[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+	1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+static const int MAX_EXACT_POWER_OF_TEN = 22;
+static const uint64_t INTEGER_POWERS_OF_TEN[] = { 1, 10, 100, 1000, 10000, 100000, 1000000,
+	10000000, 100000000 };
+
+enum OBJKeyword
+{
+	KEYWORD_NONE,
+	KEYWORD_POSITION,
+	KEYWORD_TEXTURE_COORDINATE,
+	KEYWORD_NORMAL,
+	KEYWORD_FACE,
+	KEYWORD_OBJECT,
+	KEYWORD_GROUP,
+	KEYWORD_MATERIAL
+};
+
+/** @brief Indices of the position, texture coordinate and normal of a face corner; -1 if absent. */
+struct OBJCorner
+{
+	int position;
+	int textureCoordinate;
+	int normal;
+
+	inline bool operator==(const OBJCorner& other) const
+	{
+		return position == other.position && textureCoordinate == other.textureCoordinate &&
+			normal == other.normal;
+	}
+};
+
+/** @brief Change of the object, group or material of the faces which follow it. */
+struct OBJMeshChange
+{
+	OBJKeyword keyword;
+	std::string name;
+	size_t firstCorner;
+};
+
+/** @brief Line aligned part of the file, parsed by one job. */
+struct OBJChunk
+{
+	const char* begin;
+	const char* end;
+	// Vertex data declared in the chunk, and before it
+	unsigned int numPositions;
+	unsigned int numTextureCoordinates;
+	unsigned int numNormals;
+	unsigned int firstPosition;
+	unsigned int firstTextureCoordinate;
+	unsigned int firstNormal;
+	// Triangulated faces, 3 corners each
+	std::vector<OBJCorner> corners;
+	std::vector<OBJMeshChange> changes;
+	unsigned int numInvalidFaces;
+};
+
+/** @brief Vertex data of the whole file, indexed by the corners of the faces. */
+struct OBJVertexData
+{
+	std::vector<float> positions;
+	std::vector<float> textureCoordinates;
+	std::vector<float> normals;
+};
+
+static void ParallelFor(JobSystem* jobSystem, unsigned int count, unsigned int batchSize,
+	const std::function<void(unsigned int, unsigned int)>& function)
+{
+	if (jobSystem != nullptr)
+	{
+		jobSystem->ParallelFor(count, batchSize, function);
+	}
+	else if (count > 0)
+	{
+		function(0, count);
+	}
+}
+
+static inline const char* SkipSpaces(const char* c, const char* end)
+{
+	while (c < end && (*c == ' ' || *c == '\t'))
+	{
+		c++;
+	}
+	return c;
+}
+
+static inline const char* FindLineEnd(const char* c, const char* end)
+{
+	// memchr is vectorized by the C library
+	const char* lineEnd = (const char*)std::memchr(c, '\n', (size_t)(end - c));
+	return lineEnd != nullptr ? lineEnd : end;
+}
+
+/**
+ * @brief Reads the keyword at the start of a line.
+ * @param c First character of the line. Set to the first argument after the keyword.
+ * @param lineEnd End of the line.
+ * @return The keyword, or KEYWORD_NONE for comments and statements which are not loaded.
+ */
+static OBJKeyword ReadKeyword(const char*& c, const char* lineEnd)
+{
+	c = SkipSpaces(c, lineEnd);
+	const char* keyword = c;
+	while (c < lineEnd && *c != ' ' && *c != '\t' && *c != '\r')
+	{
+		c++;
+	}
+	const size_t length = (size_t)(c - keyword);
+	c = SkipSpaces(c, lineEnd);
+
+	if (length == 1)
+	{
+		switch (keyword[0])
+		{
+		case 'v': return KEYWORD_POSITION;
+		case 'f': return KEYWORD_FACE;
+		case 'o': return KEYWORD_OBJECT;
+		case 'g': return KEYWORD_GROUP;
+		}
+	}
+	else if (length == 2 && keyword[0] == 'v')
+	{
+		switch (keyword[1])
+		{
+		case 't': return KEYWORD_TEXTURE_COORDINATE;
+		case 'n': return KEYWORD_NORMAL;
+		}
+	}
+	else if (length == 6 && std::memcmp(keyword, "usemtl", 6) == 0)
+	{
+		return KEYWORD_MATERIAL;
+	}
+	return KEYWORD_NONE;
+}
+
+#if defined(GLENGINE_SSE2)
+/** @return Number of consecutive digits at the start of 16 characters, minus '0'. */
+static inline unsigned int CountDigits(__m128i digits)
+{
+	// Only the digits are 9 or less, as the other characters wrapped around
+	const __m128i isDigit = _mm_cmpeq_epi8(_mm_subs_epu8(digits, _mm_set1_epi8(9)),
+		_mm_setzero_si128());
+	return (unsigned int)std::countr_one((unsigned int)_mm_movemask_epi8(isDigit));
+}
+
+/** @return The value of the first 8 of 16 digits, minus '0'. */
+static inline uint32_t ConvertEightDigits(__m128i digits)
+{
+	// Widen to 16 bits, then combine pairs of digits, then pairs of those
+	const __m128i wide = _mm_unpacklo_epi8(digits, _mm_setzero_si128());
+	const __m128i pairs = _mm_madd_epi16(wide, _mm_setr_epi16(10, 1, 10, 1, 10, 1, 10, 1));
+	const __m128i narrowPairs = _mm_packs_epi32(pairs, pairs);
+	const __m128i quads = _mm_madd_epi16(narrowPairs,
+		_mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1));
+	return (uint32_t)_mm_cvtsi128_si32(quads) * 10000 +
+		(uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(quads, 4));
+}
+#endif
+
+/**
+ * @brief Appends a run of decimal digits to a mantissa. Digits which do not fit are dropped.
+ * @param c First character. Set to the character after the digits.
+ * @param begin Start of the file; with SSE2, characters up to 8 before c may be read.
+ * @param end End of the file; with SSE2, up to 16 characters from c may be read.
+ * @param mantissa Mantissa to append to.
+ * @param numMantissaDigits Significant digits in the mantissa.
+ * @return Number of digits dropped, which the mantissa must be scaled up by.
+ */
+static inline int ParseDigits(const char*& c, const char* begin, const char* end,
+	uint64_t& mantissa, int& numMantissaDigits)
+{
+	int numDropped = 0;
+#if defined(GLENGINE_SSE2)
+	// Convert up to 8 digits at a time while the characters around them can be read
+	while (c - begin >= 8 && end - c >= 16 && numMantissaDigits + 8 <= MAX_MANTISSA_DIGITS)
+	{
+		const __m128i zeroCharacters = _mm_set1_epi8('0');
+		__m128i digits = _mm_sub_epi8(_mm_loadu_si128((const __m128i*)c), zeroCharacters);
+		const unsigned int numDigits = std::min(CountDigits(digits), 8u);
+		if (numDigits == 0)
+		{
+			return numDropped;
+		}
+
+		if (numDigits < 8)
+		{
+			// Reload so the run ends at the 8th character, and clear the characters before it
+			digits = _mm_sub_epi8(_mm_loadu_si128((const __m128i*)(c + numDigits - 8)),
+				zeroCharacters);
+			const __m128i isBeforeRun = _mm_cmpgt_epi8(_mm_set1_epi8((char)(8 - numDigits)),
+				_mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+			digits = _mm_andnot_si128(isBeforeRun, digits);
+		}
+
+		mantissa = mantissa * INTEGER_POWERS_OF_TEN[numDigits] + ConvertEightDigits(digits);
+		// Leading zeros are not significant
+		numMantissaDigits = mantissa == 0 ? 0 : numMantissaDigits + (int)numDigits;
+		c += numDigits;
+
+		if (numDigits < 8)
+		{
+			return numDropped;
+		}
+	}
+#endif
+	for (; c < end && *c >= '0' && *c <= '9'; c++)
+	{
+		if (numMantissaDigits < MAX_MANTISSA_DIGITS)
+		{
+			mantissa = mantissa * 10 + (uint64_t)(*c - '0');
+			numMantissaDigits += mantissa == 0 ? 0 : 1;
+		}
+		else
+		{
+			numDropped++;
+		}
+	}
+	return numDropped;
+}
+
+/**
+ * @brief Parses an optionally signed decimal integer. Values too large for an int are clamped.
+ * @param c First character. Set to the character after the integer.
+ * @param end End of the integer's line.
+ * @param value Parsed value.
+ * @return Whether there were any digits.
+ */
+static inline bool ParseInt(const char*& c, const char* end, int& value)
+{
+	const bool isNegative = c < end && *c == '-';
+	if (c < end && (*c == '-' || *c == '+'))
+	{
+		c++;
+	}
+
+	const char* digits = c;
+	int64_t magnitude = 0;
+	for (; c < end && *c >= '0' && *c <= '9'; c++)
+	{
+		magnitude = std::min(magnitude * 10 + (*c - '0'), (int64_t)INT32_MAX);
+	}
+
+	value = (int)(isNegative ? -magnitude : magnitude);
+	return c != digits;
+}
+
+/**
+ * @brief Parses a decimal number, such as "-1.25e-3". Anything else, such as "nan", reads as 0.
+ * @param c First character. Set to the character after the number.
+ * @param lineEnd End of the number's line.
+ * @param begin Start of the file.
+ * @param end End of the file.
+ */
+static float ParseFloat(const char*& c, const char* lineEnd, const char* begin, const char* end)
+{
+	const bool isNegative = c < lineEnd && *c == '-';
+	if (c < lineEnd && (*c == '-' || *c == '+'))
+	{
+		c++;
+	}
+
+	uint64_t mantissa = 0;
+	int numMantissaDigits = 0;
+	int exponent = ParseDigits(c, begin, end, mantissa, numMantissaDigits);
+	if (c < lineEnd && *c == '.')
+	{
+		c++;
+		const char* fraction = c;
+		exponent += ParseDigits(c, begin, end, mantissa, numMantissaDigits);
+		exponent -= (int)(c - fraction);
+	}
+
+	if (c < lineEnd && (*c == 'e' || *c == 'E'))
+	{
+		c++;
+		int explicitExponent;
+		if (ParseInt(c, lineEnd, explicitExponent))
+		{
+			exponent += std::clamp(explicitExponent, -1000, 1000);
+		}
+	}
+
+	double value = (double)mantissa;
+	if (value != 0.0 && exponent != 0)
+	{
+		const int magnitude = std::abs(exponent);
+		const double scale = magnitude <= MAX_EXACT_POWER_OF_TEN ? POWERS_OF_TEN[magnitude] :
+			std::pow(10.0, (double)magnitude);
+		value = exponent < 0 ? value / scale : value * scale;
+	}
+
+	return (float)(isNegative ? -value : value);
+}
+
+/**
+ * @brief Parses up to numValues numbers of a line. Missing numbers are 0.
+ * @param c First number.
+ * @param lineEnd End of the line.
+ * @param begin Start of the file.
+ * @param end End of the file.
+ * @param values Numbers to write.
+ */
+static inline void ParseFloats(const char* c, const char* lineEnd, const char* begin,
+	const char* end, float* values, unsigned int numValues)
+{
+	for (unsigned int i = 0; i < numValues; i++)
+	{
+		values[i] = ParseFloat(c, lineEnd, begin, end);
+		c = SkipSpaces(c, lineEnd);
+	}
+}
+
+/**
+ * @brief Converts an OBJ index into a 0 based index. Positive indices count from 1, and negative
+ *		ones count back from the last value declared.
+ * @param index Index in the file.
+ * @param numDeclared Number of values declared before the index.
+ * @param result Converted index.
+ * @return Whether the index refers to a declared value.
+ */
+static inline bool ResolveIndex(int index, unsigned int numDeclared, int& result)
+{
+	result = index > 0 ? index - 1 : (int)numDeclared + index;
+	return index != 0 && result >= 0 && (unsigned int)result < numDeclared;
+}
+
+/** @return Trimmed name of an object, group or material. */
+static std::string ReadName(const char* c, const char* lineEnd)
+{
+	const char* nameEnd = lineEnd;
+	while (nameEnd > c && (nameEnd[-1] == ' ' || nameEnd[-1] == '\t' || nameEnd[-1] == '\r'))
+	{
+		nameEnd--;
+	}
+	return std::string(c, nameEnd);
+}
+
+/** @brief Counts the vertex data declared in a chunk. */
+static void CountVertexData(OBJChunk& chunk)
+{
+	for (const char* line = chunk.begin; line < chunk.end;)
+	{
+		const char* lineEnd = FindLineEnd(line, chunk.end);
+		switch (ReadKeyword(line, lineEnd))
+		{
+		case KEYWORD_POSITION: chunk.numPositions++; break;
+		case KEYWORD_TEXTURE_COORDINATE: chunk.numTextureCoordinates++; break;
+		case KEYWORD_NORMAL: chunk.numNormals++; break;
+		default: break;
+		}
+		line = lineEnd < chunk.end ? lineEnd + 1 : lineEnd;
+	}
+}
+
+/**
+ * @brief Parses a face into triangles. Indices are resolved against the vertex data declared
+ *		before the face, which is only possible once every chunk has been counted.
+ * @return Whether the face was valid.
+ */
+static bool ParseFace(const char* c, const char* lineEnd, const unsigned int numDeclared[3],
+	std::vector<OBJCorner>& polygon, std::vector<OBJCorner>& corners)
+{
+	polygon.clear();
+	bool isValid = true;
+	int index;
+	while (ParseInt(c, lineEnd, index))
+	{
+		// Corners are "v", "v/vt", "v//vn" or "v/vt/vn"
+		OBJCorner corner = { -1, -1, -1 };
+		isValid &= ResolveIndex(index, numDeclared[0], corner.position);
+		if (c < lineEnd && *c == '/')
+		{
+			c++;
+			if (ParseInt(c, lineEnd, index))
+			{
+				isValid &= ResolveIndex(index, numDeclared[1], corner.textureCoordinate);
+			}
+			if (c < lineEnd && *c == '/')
+			{
+				c++;
+				if (ParseInt(c, lineEnd, index))
+				{
+					isValid &= ResolveIndex(index, numDeclared[2], corner.normal);
+				}
+			}
+		}
+
+		polygon.push_back(corner);
+		c = SkipSpaces(c, lineEnd);
+	}
+
+	if (!isValid || polygon.size() < 3)
+	{
+		return false;
+	}
+
+	for (size_t i = 1; i + 1 < polygon.size(); i++)
+	{
+		corners.push_back(polygon[0]);
+		corners.push_back(polygon[i]);
+		corners.push_back(polygon[i + 1]);
+	}
+	return true;
+}
+
+/**
+ * @brief Parses the vertex data of a chunk into the arrays of the whole file, after the data
+ *		of the chunks before it, and its faces into the chunk.
+ */
+static void ParseChunk(OBJChunk& chunk, const char* fileBegin, const char* fileEnd,
+	OBJVertexData& vertexData)
+{
+	// Vertex data declared up to the current line
+	unsigned int numDeclared[3] = { chunk.firstPosition, chunk.firstTextureCoordinate,
+		chunk.firstNormal };
+	std::vector<OBJCorner> polygon;
+
+	for (const char* line = chunk.begin; line < chunk.end;)
+	{
+		const char* lineEnd = FindLineEnd(line, chunk.end);
+		const char* c = line;
+		const OBJKeyword keyword = ReadKeyword(c, lineEnd);
+		switch (keyword)
+		{
+		case KEYWORD_POSITION:
+			ParseFloats(c, lineEnd, fileBegin, fileEnd,
+				&vertexData.positions[numDeclared[0]++ * 3], 3);
+			break;
+		case KEYWORD_TEXTURE_COORDINATE:
+		{
+			float* textureCoordinate = &vertexData.textureCoordinates[numDeclared[1]++ * 2];
+			ParseFloats(c, lineEnd, fileBegin, fileEnd, textureCoordinate, 2);
+			// Flipped, as Assimp does for LoadModels
+			textureCoordinate[1] = 1.0f - textureCoordinate[1];
+			break;
+		}
+		case KEYWORD_NORMAL:
+			ParseFloats(c, lineEnd, fileBegin, fileEnd,
+				&vertexData.normals[numDeclared[2]++ * 3], 3);
+			break;
+		case KEYWORD_FACE:
+			if (!ParseFace(c, lineEnd, numDeclared, polygon, chunk.corners))
+			{
+				chunk.numInvalidFaces++;
+			}
+			break;
+		case KEYWORD_OBJECT:
+		case KEYWORD_GROUP:
+		case KEYWORD_MATERIAL:
+			chunk.changes.push_back({ keyword, ReadName(c, lineEnd), chunk.corners.size() });
+			break;
+		default:
+			break;
+		}
+		line = lineEnd < chunk.end ? lineEnd + 1 : lineEnd;
+	}
+}
+
+static inline uint32_t HashCorner(const OBJCorner& corner)
+{
+	uint64_t hash = (uint64_t)(uint32_t)corner.position * 0x9E3779B97F4A7C15ull;
+	hash ^= (uint64_t)(uint32_t)corner.textureCoordinate * 0xC2B2AE3D27D4EB4Full;
+	hash ^= (uint64_t)(uint32_t)corner.normal * 0x165667B19E3779F9ull;
+	hash ^= hash >> 29;
+	hash *= 0xBF58476D1CE4E5B9ull;
+	return (uint32_t)(hash >> 32);
+}
+
+/** @return Partition of a hash; its high bits, as the low bits index the hash tables. */
+static inline unsigned int GetPartition(uint32_t hash, unsigned int numPartitions)
+{
+	return (unsigned int)(((uint64_t)hash * numPartitions) >> 32);
+}
+
+/**
+ * @brief Builds a model from the corners of a mesh, merging identical corners into one vertex.
+ *		Corners are hashed and scattered into partitions, and each partition is merged on its
+ *		own, so the merge needs no locks. Vertices are then numbered in the order of their first
+ *		corner, as a sequential merge would, so the order does not depend on the number of
+ *		partitions, and thus threads. Vertices and indices are written straight into the model.
+ */
+static IndexedModel BuildModel(const std::vector<OBJCorner>& corners,
+	const OBJVertexData& vertexData, unsigned int numInstanceStreams, JobSystem* jobSystem)
+{
+	IndexedModel model;
+	model.AllocateElement(3); // Positions
+	model.AllocateElement(2); // Texture Coordinates
+	model.AllocateElement(3); // Normals
+	model.AllocateElement(3); // Tangents
+	model.AllocateElement(1); // Ambient occlusion
+	model.SetInstancedElementStartIndex(5); // Begin instanced data
+	model.AllocateElement(16 + numInstanceStreams * 4); // Transform matrix and streams
+
+	const unsigned int numCorners = (unsigned int)corners.size();
+	const unsigned int numBlocks = (numCorners + CORNERS_PER_BATCH - 1) / CORNERS_PER_BATCH;
+	const unsigned int numPartitions = jobSystem != nullptr && numBlocks > 1 ?
+		jobSystem->GetNumThreads() * PARTITIONS_PER_THREAD : 1;
+
+	// Hash the corners, counting how many of each block fall in each partition
+	std::vector<uint32_t> hashes(numCorners);
+	std::vector<unsigned int> blockOffsets((size_t)numBlocks * numPartitions);
+	ParallelFor(jobSystem, numBlocks, 1, [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int block = begin; block < end; block++)
+		{
+			unsigned int* counts = &blockOffsets[(size_t)block * numPartitions];
+			const unsigned int last = std::min((block + 1) * CORNERS_PER_BATCH, numCorners);
+			for (unsigned int i = block * CORNERS_PER_BATCH; i < last; i++)
+			{
+				hashes[i] = HashCorner(corners[i]);
+				counts[GetPartition(hashes[i], numPartitions)]++;
+			}
+		}
+	});
+
+	// Turn the counts into offsets, so each partition lists its corners in order
+	std::vector<unsigned int> partitionStarts(numPartitions + 1);
+	unsigned int offset = 0;
+	for (unsigned int partition = 0; partition < numPartitions; partition++)
+	{
+		partitionStarts[partition] = offset;
+		for (unsigned int block = 0; block < numBlocks; block++)
+		{
+			const unsigned int count = blockOffsets[(size_t)block * numPartitions + partition];
+			blockOffsets[(size_t)block * numPartitions + partition] = offset;
+			offset += count;
+		}
+	}
+	partitionStarts[numPartitions] = offset;
+
+	std::vector<unsigned int> partitionCorners(numCorners);
+	ParallelFor(jobSystem, numBlocks, 1, [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int block = begin; block < end; block++)
+		{
+			unsigned int* offsets = &blockOffsets[(size_t)block * numPartitions];
+			const unsigned int last = std::min((block + 1) * CORNERS_PER_BATCH, numCorners);
+			for (unsigned int i = block * CORNERS_PER_BATCH; i < last; i++)
+			{
+				partitionCorners[offsets[GetPartition(hashes[i], numPartitions)]++] = i;
+			}
+		}
+	});
+
+	// Merge the corners of each partition, indexing them with vertices local to the partition.
+	// Each vertex is represented by its first corner.
+	unsigned int* indices = model.AppendIndices(numCorners);
+	std::vector<std::vector<unsigned int>> partitionVertices(numPartitions);
+	std::vector<char> isFirstCorner(numCorners, 0);
+	ParallelFor(jobSystem, numPartitions, 1, [&](unsigned int begin, unsigned int end)
+	{
+		std::vector<unsigned int> table;
+		for (unsigned int partition = begin; partition < end; partition++)
+		{
+			const unsigned int first = partitionStarts[partition];
+			const unsigned int last = partitionStarts[partition + 1];
+			std::vector<unsigned int>& vertices = partitionVertices[partition];
+
+			// Open addressing, at most half full; slots hold a vertex + 1, or 0 when empty
+			const unsigned int mask = std::bit_ceil(std::max((last - first) * 2, 2u)) - 1;
+			table.assign((size_t)mask + 1, 0);
+			for (unsigned int i = first; i < last; i++)
+			{
+				const unsigned int corner = partitionCorners[i];
+				unsigned int slot = hashes[corner] & mask;
+				while (table[slot] != 0 && !(corners[vertices[table[slot] - 1]] == corners[corner]))
+				{
+					slot = (slot + 1) & mask;
+				}
+
+				if (table[slot] == 0)
+				{
+					vertices.push_back(corner);
+					table[slot] = (unsigned int)vertices.size();
+					isFirstCorner[corner] = 1;
+				}
+				indices[corner] = table[slot] - 1;
+			}
+		}
+	});
+
+	// Number the vertices by their first corner; count them per block, then number each block
+	// after the blocks before it
+	std::vector<unsigned int> vertexStarts(numBlocks);
+	ParallelFor(jobSystem, numBlocks, 1, [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int block = begin; block < end; block++)
+		{
+			const unsigned int last = std::min((block + 1) * CORNERS_PER_BATCH, numCorners);
+			vertexStarts[block] = (unsigned int)std::count(isFirstCorner.begin() +
+				block * CORNERS_PER_BATCH, isFirstCorner.begin() + last, 1);
+		}
+	});
+
+	unsigned int numVertices = 0;
+	for (unsigned int block = 0; block < numBlocks; block++)
+	{
+		const unsigned int count = vertexStarts[block];
+		vertexStarts[block] = numVertices;
+		numVertices += count;
+	}
+
+	float* positions = model.AppendElements(0, numVertices);
+	float* textureCoordinates = model.AppendElements(1, numVertices);
+	float* normals = model.AppendElements(2, numVertices);
+	// Unoccluded until baked
+	model.AppendElements(3, numVertices);
+	model.AppendElements(4, numVertices);
+
+	// Write the vertices of each block after those of the blocks before it. The hashes are no
+	// longer needed, so they are reused to hold the vertex of each first corner.
+	std::vector<uint32_t>& cornerVertices = hashes;
+	std::vector<char> hasTextureCoordinates(numBlocks, 0);
+	std::vector<char> isMissingNormals(numBlocks, 0);
+	ParallelFor(jobSystem, numBlocks, 1, [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int block = begin; block < end; block++)
+		{
+			unsigned int vertex = vertexStarts[block];
+			const unsigned int last = std::min((block + 1) * CORNERS_PER_BATCH, numCorners);
+			for (unsigned int i = block * CORNERS_PER_BATCH; i < last; i++)
+			{
+				if (!isFirstCorner[i])
+				{
+					continue;
+				}
+
+				const OBJCorner& corner = corners[i];
+				cornerVertices[i] = vertex;
+				std::memcpy(&positions[vertex * 3], &vertexData.positions[corner.position * 3],
+					3 * sizeof(float));
+				if (corner.textureCoordinate >= 0)
+				{
+					std::memcpy(&textureCoordinates[vertex * 2],
+						&vertexData.textureCoordinates[corner.textureCoordinate * 2],
+						2 * sizeof(float));
+					hasTextureCoordinates[block] = 1;
+				}
+				if (corner.normal >= 0)
+				{
+					std::memcpy(&normals[vertex * 3], &vertexData.normals[corner.normal * 3],
+						3 * sizeof(float));
+				}
+				else
+				{
+					isMissingNormals[block] = 1;
+				}
+				vertex++;
+			}
+		}
+	});
+
+	// Replace the vertices local to each partition with the numbered ones
+	ParallelFor(jobSystem, numPartitions, 1, [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int partition = begin; partition < end; partition++)
+		{
+			const std::vector<unsigned int>& vertices = partitionVertices[partition];
+			for (unsigned int i = partitionStarts[partition]; i < partitionStarts[partition + 1];
+				i++)
+			{
+				const unsigned int corner = partitionCorners[i];
+				indices[corner] = cornerVertices[vertices[indices[corner]]];
+			}
+		}
+	});
+
+	const auto isSet = [](char flag) { return flag != 0; };
+	if (std::any_of(isMissingNormals.begin(), isMissingNormals.end(), isSet))
+	{
+		// Smooth normals over the whole mesh, as Assimp generates them
+		model.CalculateNormals(jobSystem);
+	}
+	if (std::any_of(hasTextureCoordinates.begin(), hasTextureCoordinates.end(), isSet))
+	{
+		model.CalculateTangents(jobSystem);
+	}
+
+	return model;
+}
+
+/** @brief Loads the meshes of a mapped OBJ file; see LoadOBJModels. */
+static void LoadOBJ(const MappedFile& file, const std::string& fileName,
+	unsigned int numInstanceStreams, std::vector<IndexedModel>& models, JobSystem* jobSystem)
+{
+	const char* data = file.GetData();
+	const char* fileEnd = data + file.GetSize();
+
+	std::vector<OBJChunk> chunks;
+	for (const char* begin = data; begin < fileEnd;)
+	{
+		const char* chunkEnd = begin + std::min(CHUNK_SIZE, (size_t)(fileEnd - begin));
+		chunkEnd = FindLineEnd(chunkEnd, fileEnd);
+		if (chunkEnd < fileEnd)
+		{
+			chunkEnd++;
+		}
+
+		OBJChunk chunk = {};
+		chunk.begin = begin;
+		chunk.end = chunkEnd;
+		chunks.push_back(std::move(chunk));
+		begin = chunkEnd;
+	}
+
+	// Count the vertex data of every chunk, so each knows where its data goes
+	const unsigned int numChunks = (unsigned int)chunks.size();
+	ParallelFor(jobSystem, numChunks, 1, [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int i = begin; i < end; i++)
+		{
+			CountVertexData(chunks[i]);
+		}
+	});
+
+	unsigned int numPositions = 0;
+	unsigned int numTextureCoordinates = 0;
+	unsigned int numNormals = 0;
+	for (OBJChunk& chunk : chunks)
+	{
+		chunk.firstPosition = numPositions;
+		chunk.firstTextureCoordinate = numTextureCoordinates;
+		chunk.firstNormal = numNormals;
+		numPositions += chunk.numPositions;
+		numTextureCoordinates += chunk.numTextureCoordinates;
+		numNormals += chunk.numNormals;
+	}
+
+	OBJVertexData vertexData;
+	vertexData.positions.resize((size_t)numPositions * 3);
+	vertexData.textureCoordinates.resize((size_t)numTextureCoordinates * 2);
+	vertexData.normals.resize((size_t)numNormals * 3);
+	ParallelFor(jobSystem, numChunks, 1, [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int i = begin; i < end; i++)
+		{
+			ParseChunk(chunks[i], data, fileEnd, vertexData);
+		}
+	});
+
+	// Gather the faces into one mesh per object, group and material, in the order they appear
+	std::map<std::string, unsigned int> meshIndices;
+	std::vector<std::vector<OBJCorner>> meshCorners;
+	std::string names[3];
+	unsigned int numInvalidFaces = 0;
+	for (OBJChunk& chunk : chunks)
+	{
+		size_t first = 0;
+		for (size_t i = 0; i <= chunk.changes.size(); i++)
+		{
+			const size_t last = i < chunk.changes.size() ? chunk.changes[i].firstCorner :
+				chunk.corners.size();
+			if (last > first)
+			{
+				const std::string key = names[0] + '\n' + names[1] + '\n' + names[2];
+				const auto it = meshIndices.emplace(key, (unsigned int)meshCorners.size()).first;
+				if (it->second == meshCorners.size())
+				{
+					meshCorners.emplace_back();
+				}
+
+				std::vector<OBJCorner>& mesh = meshCorners[it->second];
+				mesh.insert(mesh.end(), chunk.corners.begin() + first,
+					chunk.corners.begin() + last);
+			}
+
+			if (i < chunk.changes.size())
+			{
+				const OBJMeshChange& change = chunk.changes[i];
+				names[change.keyword - KEYWORD_OBJECT] = change.name;
+			}
+			first = last;
+		}
+
+		numInvalidFaces += chunk.numInvalidFaces;
+		// The corners are copied, so free them early for large files
+		std::vector<OBJCorner>().swap(chunk.corners);
+	}
+
+	if (numInvalidFaces > 0)
+	{
+		Log::Warning("Skipped {} faces with invalid indices in {}", numInvalidFaces, fileName);
+	}
+
+	for (const std::vector<OBJCorner>& corners : meshCorners)
+	{
+		models.push_back(BuildModel(corners, vertexData, numInstanceStreams, jobSystem));
+	}
+}
+
+bool LoadOBJModels(const std::string& fileName, unsigned int numInstanceStreams,
+	std::vector<IndexedModel>& models, JobSystem* jobSystem)
+{
+	MappedFile file(fileName);
+	if (!file.IsOpen())
+	{
+		return false;
+	}
+
+	// Starting threads takes longer than parsing small files
+	JobSystem* temporaryJobSystem = nullptr;
+	if (jobSystem == nullptr && file.GetSize() >= MIN_PARALLEL_FILE_SIZE)
+	{
+		temporaryJobSystem = new JobSystem();
+		jobSystem = temporaryJobSystem;
+	}
+
+	LoadOBJ(file, fileName, numInstanceStreams, models, jobSystem);
+
+	delete temporaryJobSystem;
+	return true;
+}
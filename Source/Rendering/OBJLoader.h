@@ -0,0 +1,33 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include "IndexedModel.h"
+
+#include <string>
+#include <vector>
+
+class JobSystem;
+
+/**
+ * @brief Loads all meshes of a Wavefront OBJ file, with the vertex layout of LoadModels. Faces
+ * are split into one mesh per object, group and material, as Assimp does, and triangulated as
+ * fans. Vertices sharing a position, texture coordinate and normal are merged. Normals are
+ * calculated if any face lacks them, and tangents whenever there are texture coordinates.
+ *
+ * The file is memory mapped and split into line aligned chunks which are parsed in parallel,
+ * then vertices are merged in parallel by hashing them into one partition per job. Vertices are
+ * still numbered in the order they first appear, as by Assimp, whatever the number of threads, so
+ * data baked per vertex (see BakeModelOcclusion) matches on every machine. Large files load
+ * several times faster than through Assimp.
+ *
+ * @param fileName Path of the file.
+ * @param numInstanceStreams Number of instance streams besides the transform.
+ * @param models Models to append the meshes to. Ambient occlusion is left at zero.
+ * @param jobSystem Job system to parse over, or nullptr to use a temporary one for large files
+ *		and the calling thread for small ones.
+ * @return Whether the file could be read. Files which can be read are never left to Assimp, so
+ *		malformed faces are skipped with a warning rather than failing the load.
+ */
+bool LoadOBJModels(const std::string& fileName, unsigned int numInstanceStreams,
+	std::vector<IndexedModel>& models, JobSystem* jobSystem = nullptr);
@@ -26,6 +26,12 @@
 
 #pragma once
 
+#if defined(GLENGINE_SOFTWARE_RENDERER)
+#include "Platform/Software/SoftwareRenderDevice.h"
+
+typedef SoftwareRenderDevice RenderDevice;
+#else
 #include "Platform/OpenGL/OpenGLRenderDevice.h"
 
-typedef OpenGLRenderDevice RenderDevice;
\ No newline at end of file
+typedef OpenGLRenderDevice RenderDevice;
+#endif
\ No newline at end of file
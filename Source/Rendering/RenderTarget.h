@@ -28,9 +28,9 @@
 
 #include "RenderDevice.h"
 #include "Texture.h"
+#include "Log.h"
 
 #include <stdexcept>
-#include <iostream>
 
 class RenderTarget
 {
@@ -71,19 +71,24 @@ public:
 	{
 		if (texture.IsCompressed())
 		{
-			std::cerr << "Error: Compressed textures cannot be used as render targets."
-				<< std::endl;
+			Log::Error("Compressed textures cannot be used as render targets.");
+			Log::Flush();
 
 			throw std::invalid_argument("Compressed textures cannot be used as render targets.");
 		}
 
 		if (texture.HasMipmaps())
 		{
-			std::cerr << "Warning: Rendering to a texture with mipmaps will not render to all "
-				"mipmap levels! Unexpected results may occur." << std::endl;
+			Log::Warning("Rendering to a texture with mipmaps will not render to all mipmap "
+				"levels! Unexpected results may occur.");
 		}
 	}
 
+	inline void GetSize(unsigned int& width, unsigned int& height)
+	{
+		device->GetRenderTargetSize(deviceID, width, height);
+	}
+
 	inline unsigned int GetID() { return deviceID; }
 
 private:
@@ -25,7 +25,7 @@
  */
 
 #include "Shader.h"
-#include <iostream>
+#include "Log.h"
 #include <fstream>
 #include <sstream>
 #include <filesystem>
@@ -84,8 +84,7 @@ static std::string LoadShader(const std::string& fileName, const std::string& in
 				// If quotes are missing, error
 				if (open == std::string::npos || close == std::string::npos)
 				{
-					std::cerr << "Unable to parse shader include keyword: " << fileName 
-						<< std::endl;
+					Log::Error("Unable to parse shader include keyword: {}", fileName);
 				}
 
 				// Get file name inside of quotes
@@ -99,7 +98,7 @@ static std::string LoadShader(const std::string& fileName, const std::string& in
 	}
 	else
 	{
-		std::cerr << "Unable to load shader: " << fileName << std::endl;
+		Log::Error("Unable to load shader: {}", fileName);
 	}
 
 	return ss.str();
@@ -28,6 +28,7 @@
 
 #include "RenderDevice.h"
 #include "UniformBuffer.h"
+#include "TextureBuffer.h"
 #include "Texture.h"
 #include "Sampler.h"
 
@@ -57,6 +58,11 @@ public:
 		device->SetShaderSampler(deviceID, name, texture.GetID(), sampler.GetID(), unit);
 	}
 
+	inline void SetTextureBuffer(const std::string& name, TextureBuffer& buffer, unsigned int unit)
+	{
+		device->SetShaderTextureBuffer(deviceID, name, buffer.GetID(), unit);
+	}
+
 	inline unsigned int GetID() { return deviceID; }
 
 private:
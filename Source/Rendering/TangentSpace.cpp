@@ -0,0 +1,465 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#include "TangentSpace.h"
+#include "Jobs/JobSystem.h"
+#include "SIMD.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Fewest triangles worth handing to another thread
+static const unsigned int MIN_TRIANGLES_PER_RANGE = 2048;
+// Vertices summed and normalized per job; a multiple of 4
+static const unsigned int VERTICES_PER_BATCH = 4096;
+
+static inline glm::vec3 LoadVec3(const float* values, unsigned int index)
+{
+	return glm::vec3(values[index * 3], values[index * 3 + 1], values[index * 3 + 2]);
+}
+
+static inline glm::vec2 LoadVec2(const float* values, unsigned int index)
+{
+	return glm::vec2(values[index * 2], values[index * 2 + 1]);
+}
+
+/** @brief Adds a vector to the accumulated X, Y and Z of a vertex. */
+static inline void Accumulate(float* accumulator, unsigned int stride, unsigned int vertex,
+	const glm::vec3& value)
+{
+	accumulator[vertex] += value.x;
+	accumulator[stride + vertex] += value.y;
+	accumulator[stride * 2 + vertex] += value.z;
+}
+
+/** @return A unit vector perpendicular to the normal, for vertices without a usable tangent. */
+static glm::vec3 GetPerpendicular(const glm::vec3& normal)
+{
+	const glm::vec3 axis = std::abs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) :
+		glm::vec3(0.0f, 1.0f, 0.0f);
+	return glm::normalize(axis - normal * glm::dot(normal, axis));
+}
+
+#if defined(GLENGINE_SSE2)
+/** @brief Gathers one component of a corner of 4 consecutive triangles. */
+static inline __m128 Gather(const float* values, unsigned int numComponents,
+	const unsigned int* corners, unsigned int corner, unsigned int component)
+{
+	return _mm_setr_ps(values[corners[corner] * numComponents + component],
+		values[corners[3 + corner] * numComponents + component],
+		values[corners[6 + corner] * numComponents + component],
+		values[corners[9 + corner] * numComponents + component]);
+}
+
+/** @brief Gathers the edges from the first corner to the others, for 4 consecutive triangles. */
+static inline void GatherEdges(const float* positions, const unsigned int* corners, __m128 edge1[3],
+	__m128 edge2[3])
+{
+	for (unsigned int i = 0; i < 3; i++)
+	{
+		const __m128 origin = Gather(positions, 3, corners, 0, i);
+		edge1[i] = _mm_sub_ps(Gather(positions, 3, corners, 1, i), origin);
+		edge2[i] = _mm_sub_ps(Gather(positions, 3, corners, 2, i), origin);
+	}
+}
+#endif
+
+/** @brief Adds the area weighted normal of each triangle in a range to its vertices. */
+static void AccumulateNormals(const float* positions, const unsigned int* indices,
+	unsigned int begin, unsigned int end, float* accumulator, unsigned int stride)
+{
+	unsigned int triangle = begin;
+
+#if defined(GLENGINE_SSE2)
+	for (; triangle + 4 <= end; triangle += 4)
+	{
+		const unsigned int* corners = indices + (size_t)triangle * 3;
+		__m128 edge1[3];
+		__m128 edge2[3];
+		GatherEdges(positions, corners, edge1, edge2);
+
+		// Twice the area of the triangle, along its normal
+		float normals[3][4];
+		_mm_storeu_ps(normals[0], _mm_sub_ps(_mm_mul_ps(edge1[1], edge2[2]),
+			_mm_mul_ps(edge1[2], edge2[1])));
+		_mm_storeu_ps(normals[1], _mm_sub_ps(_mm_mul_ps(edge1[2], edge2[0]),
+			_mm_mul_ps(edge1[0], edge2[2])));
+		_mm_storeu_ps(normals[2], _mm_sub_ps(_mm_mul_ps(edge1[0], edge2[1]),
+			_mm_mul_ps(edge1[1], edge2[0])));
+
+		for (unsigned int i = 0; i < 4; i++)
+		{
+			const glm::vec3 normal(normals[0][i], normals[1][i], normals[2][i]);
+			for (unsigned int j = 0; j < 3; j++)
+			{
+				Accumulate(accumulator, stride, corners[i * 3 + j], normal);
+			}
+		}
+	}
+#endif
+
+	for (; triangle < end; triangle++)
+	{
+		const unsigned int* corners = indices + (size_t)triangle * 3;
+		const glm::vec3 origin = LoadVec3(positions, corners[0]);
+		const glm::vec3 normal = glm::cross(LoadVec3(positions, corners[1]) - origin,
+			LoadVec3(positions, corners[2]) - origin);
+
+		for (unsigned int j = 0; j < 3; j++)
+		{
+			Accumulate(accumulator, stride, corners[j], normal);
+		}
+	}
+}
+
+/**
+ * @brief Adds the tangent of a triangle to each of its vertices, projected onto the tangent plane
+ *		of the vertex and weighted by the angle of the triangle at the vertex.
+ */
+static void AccumulateCornerTangents(const glm::vec3& faceTangent, const unsigned int* corners,
+	const float* positions, const float* normals, float* accumulator, unsigned int stride)
+{
+	for (unsigned int i = 0; i < 3; i++)
+	{
+		const unsigned int vertex = corners[i];
+		const glm::vec3 normal = LoadVec3(normals, vertex);
+		const glm::vec3 tangent = faceTangent - normal * glm::dot(normal, faceTangent);
+		const float tangentLength = glm::length(tangent);
+		if (tangentLength <= 0.0f)
+		{
+			continue;
+		}
+
+		// Angle between the edges leaving the vertex, within its tangent plane
+		const glm::vec3 position = LoadVec3(positions, vertex);
+		glm::vec3 edge1 = LoadVec3(positions, corners[(i + 1) % 3]) - position;
+		glm::vec3 edge2 = LoadVec3(positions, corners[(i + 2) % 3]) - position;
+		edge1 -= normal * glm::dot(normal, edge1);
+		edge2 -= normal * glm::dot(normal, edge2);
+		const float edgeLengths = glm::length(edge1) * glm::length(edge2);
+		if (edgeLengths <= 0.0f)
+		{
+			continue;
+		}
+
+		const float angle = std::acos(glm::clamp(glm::dot(edge1, edge2) / edgeLengths, -1.0f,
+			1.0f));
+		Accumulate(accumulator, stride, vertex, tangent * (angle / tangentLength));
+	}
+}
+
+/** @brief Adds the tangent of each triangle in a range to its vertices. */
+static void AccumulateTangents(const float* positions, const float* normals,
+	const float* textureCoordinates, const unsigned int* indices, unsigned int begin,
+	unsigned int end, float* accumulator, unsigned int stride)
+{
+	unsigned int triangle = begin;
+
+#if defined(GLENGINE_SSE2)
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+
+	for (; triangle + 4 <= end; triangle += 4)
+	{
+		const unsigned int* corners = indices + (size_t)triangle * 3;
+		__m128 edge1[3];
+		__m128 edge2[3];
+		GatherEdges(positions, corners, edge1, edge2);
+
+		const __m128 u0 = Gather(textureCoordinates, 2, corners, 0, 0);
+		const __m128 v0 = Gather(textureCoordinates, 2, corners, 0, 1);
+		const __m128 u1 = _mm_sub_ps(Gather(textureCoordinates, 2, corners, 1, 0), u0);
+		const __m128 v1 = _mm_sub_ps(Gather(textureCoordinates, 2, corners, 1, 1), v0);
+		const __m128 u2 = _mm_sub_ps(Gather(textureCoordinates, 2, corners, 2, 0), u0);
+		const __m128 v2 = _mm_sub_ps(Gather(textureCoordinates, 2, corners, 2, 1), v0);
+
+		// Only the sign of the determinant matters, as the tangent is normalized per vertex.
+		// Triangles with degenerate texture coordinates are masked out.
+		const __m128 determinant = _mm_sub_ps(_mm_mul_ps(u1, v2), _mm_mul_ps(u2, v1));
+		const __m128 sign = _mm_and_ps(_mm_or_ps(_mm_and_ps(determinant, signMask), one),
+			_mm_cmpneq_ps(determinant, _mm_setzero_ps()));
+
+		float tangents[3][4];
+		for (unsigned int i = 0; i < 3; i++)
+		{
+			_mm_storeu_ps(tangents[i], _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(edge1[i], v2),
+				_mm_mul_ps(edge2[i], v1)), sign));
+		}
+
+		for (unsigned int i = 0; i < 4; i++)
+		{
+			const glm::vec3 tangent(tangents[0][i], tangents[1][i], tangents[2][i]);
+			AccumulateCornerTangents(tangent, corners + i * 3, positions, normals, accumulator,
+				stride);
+		}
+	}
+#endif
+
+	for (; triangle < end; triangle++)
+	{
+		const unsigned int* corners = indices + (size_t)triangle * 3;
+		const glm::vec3 origin = LoadVec3(positions, corners[0]);
+		const glm::vec3 edge1 = LoadVec3(positions, corners[1]) - origin;
+		const glm::vec3 edge2 = LoadVec3(positions, corners[2]) - origin;
+
+		const glm::vec2 uvOrigin = LoadVec2(textureCoordinates, corners[0]);
+		const glm::vec2 uv1 = LoadVec2(textureCoordinates, corners[1]) - uvOrigin;
+		const glm::vec2 uv2 = LoadVec2(textureCoordinates, corners[2]) - uvOrigin;
+
+		const float determinant = uv1.x * uv2.y - uv2.x * uv1.y;
+		if (determinant == 0.0f)
+		{
+			continue;
+		}
+
+		const float sign = determinant < 0.0f ? -1.0f : 1.0f;
+		AccumulateCornerTangents((edge1 * uv2.y - edge2 * uv1.y) * sign, corners, positions,
+			normals, accumulator, stride);
+	}
+}
+
+/** @brief Sums the accumulated vectors of every range, for a vertex. */
+static inline glm::vec3 SumRanges(const float* accumulators, unsigned int numRanges,
+	unsigned int stride, unsigned int vertex)
+{
+	glm::vec3 sum(0.0f);
+	for (unsigned int i = 0; i < numRanges; i++)
+	{
+		const float* accumulator = accumulators + (size_t)i * 3 * stride;
+		sum += glm::vec3(accumulator[vertex], accumulator[stride + vertex],
+			accumulator[stride * 2 + vertex]);
+	}
+
+	return sum;
+}
+
+#if defined(GLENGINE_SSE2)
+/** @brief Sums the accumulated vectors of every range, for 4 consecutive vertices. */
+static inline void SumRanges(const float* accumulators, unsigned int numRanges,
+	unsigned int stride, unsigned int vertex, __m128 sum[3])
+{
+	sum[0] = _mm_setzero_ps();
+	sum[1] = _mm_setzero_ps();
+	sum[2] = _mm_setzero_ps();
+	for (unsigned int i = 0; i < numRanges; i++)
+	{
+		const float* accumulator = accumulators + (size_t)i * 3 * stride + vertex;
+		sum[0] = _mm_add_ps(sum[0], _mm_loadu_ps(accumulator));
+		sum[1] = _mm_add_ps(sum[1], _mm_loadu_ps(accumulator + stride));
+		sum[2] = _mm_add_ps(sum[2], _mm_loadu_ps(accumulator + stride * 2));
+	}
+}
+
+/** @return 1 / length of each vector, or 0 where the length is 0. */
+static inline __m128 InverseLength(const __m128 vector[3])
+{
+	const __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vector[0], vector[0]),
+		_mm_mul_ps(vector[1], vector[1])), _mm_mul_ps(vector[2], vector[2]));
+	return _mm_and_ps(_mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lengthSquared)),
+		_mm_cmpgt_ps(lengthSquared, _mm_setzero_ps()));
+}
+#endif
+
+/** @brief Writes the normalized sums of vertices in [begin, end). */
+static void ResolveNormals(const float* accumulators, unsigned int numRanges, unsigned int stride,
+	unsigned int begin, unsigned int end, unsigned int numVertices, float* normals)
+{
+	end = std::min(end, numVertices);
+	unsigned int vertex = begin;
+
+#if defined(GLENGINE_SSE2)
+	for (; vertex + 4 <= end; vertex += 4)
+	{
+		__m128 sum[3];
+		SumRanges(accumulators, numRanges, stride, vertex, sum);
+		const __m128 scale = InverseLength(sum);
+
+		float normal[3][4];
+		for (unsigned int i = 0; i < 3; i++)
+		{
+			_mm_storeu_ps(normal[i], _mm_mul_ps(sum[i], scale));
+		}
+
+		float* output = normals + (size_t)vertex * 3;
+		for (unsigned int i = 0; i < 4; i++)
+		{
+			output[i * 3] = normal[0][i];
+			output[i * 3 + 1] = normal[1][i];
+			output[i * 3 + 2] = normal[2][i];
+		}
+	}
+#endif
+
+	for (; vertex < end; vertex++)
+	{
+		const glm::vec3 sum = SumRanges(accumulators, numRanges, stride, vertex);
+		const float length = glm::length(sum);
+		const glm::vec3 normal = length > 0.0f ? sum / length : glm::vec3(0.0f);
+
+		normals[vertex * 3] = normal.x;
+		normals[vertex * 3 + 1] = normal.y;
+		normals[vertex * 3 + 2] = normal.z;
+	}
+}
+
+/**
+ * @brief Writes the sums of vertices in [begin, end), made perpendicular to the normal and
+ *		normalized.
+ */
+static void ResolveTangents(const float* accumulators, unsigned int numRanges,
+	unsigned int stride, unsigned int begin, unsigned int end, unsigned int numVertices,
+	const float* normals, float* tangents)
+{
+	end = std::min(end, numVertices);
+	unsigned int vertex = begin;
+
+#if defined(GLENGINE_SSE2)
+	for (; vertex + 4 <= end; vertex += 4)
+	{
+		__m128 tangent[3];
+		SumRanges(accumulators, numRanges, stride, vertex, tangent);
+
+		const float* normalInput = normals + (size_t)vertex * 3;
+		__m128 normal[3];
+		for (unsigned int i = 0; i < 3; i++)
+		{
+			normal[i] = _mm_setr_ps(normalInput[i], normalInput[3 + i], normalInput[6 + i],
+				normalInput[9 + i]);
+		}
+
+		// Gram-Schmidt orthogonalize against the normal
+		const __m128 projection = _mm_add_ps(_mm_add_ps(_mm_mul_ps(tangent[0], normal[0]),
+			_mm_mul_ps(tangent[1], normal[1])), _mm_mul_ps(tangent[2], normal[2]));
+		for (unsigned int i = 0; i < 3; i++)
+		{
+			tangent[i] = _mm_sub_ps(tangent[i], _mm_mul_ps(normal[i], projection));
+		}
+
+		const __m128 scale = InverseLength(tangent);
+		const int missingMask = _mm_movemask_ps(_mm_cmpeq_ps(scale, _mm_setzero_ps()));
+
+		float result[3][4];
+		for (unsigned int i = 0; i < 3; i++)
+		{
+			_mm_storeu_ps(result[i], _mm_mul_ps(tangent[i], scale));
+		}
+
+		float* output = tangents + (size_t)vertex * 3;
+		for (unsigned int i = 0; i < 4; i++)
+		{
+			glm::vec3 value(result[0][i], result[1][i], result[2][i]);
+			if ((missingMask & (1 << i)) != 0)
+			{
+				value = GetPerpendicular(LoadVec3(normals, vertex + i));
+			}
+
+			output[i * 3] = value.x;
+			output[i * 3 + 1] = value.y;
+			output[i * 3 + 2] = value.z;
+		}
+	}
+#endif
+
+	for (; vertex < end; vertex++)
+	{
+		const glm::vec3 normal = LoadVec3(normals, vertex);
+		glm::vec3 tangent = SumRanges(accumulators, numRanges, stride, vertex);
+		tangent -= normal * glm::dot(normal, tangent);
+
+		const float length = glm::length(tangent);
+		tangent = length > 0.0f ? tangent / length : GetPerpendicular(normal);
+
+		tangents[vertex * 3] = tangent.x;
+		tangents[vertex * 3 + 1] = tangent.y;
+		tangents[vertex * 3 + 2] = tangent.z;
+	}
+}
+
+TangentSpaceGenerator::TangentSpaceGenerator(JobSystem* jobSystem) : jobSystem(jobSystem),
+	numRanges(0), paddedNumVertices(0) {}
+
+void TangentSpaceGenerator::CalculateNormals(std::span<const float> positions,
+	std::span<const unsigned int> indices, std::span<float> normals)
+{
+	const unsigned int numVertices = (unsigned int)(positions.size() / 3);
+	const unsigned int numTriangles = (unsigned int)(indices.size() / 3);
+	const unsigned int trianglesPerRange = BeginAccumulation(numVertices, numTriangles);
+
+	ParallelFor(numTriangles, trianglesPerRange, [&](unsigned int begin, unsigned int end)
+	{
+		float* accumulator = GetAccumulator(begin / trianglesPerRange);
+		std::fill(accumulator, accumulator + (size_t)paddedNumVertices * 3, 0.0f);
+		AccumulateNormals(positions.data(), indices.data(), begin, end, accumulator,
+			paddedNumVertices);
+	});
+
+	ParallelFor(paddedNumVertices, VERTICES_PER_BATCH, [&](unsigned int begin, unsigned int end)
+	{
+		ResolveNormals(accumulators.data(), numRanges, paddedNumVertices, begin, end, numVertices,
+			normals.data());
+	});
+}
+
+void TangentSpaceGenerator::CalculateTangents(std::span<const float> positions,
+	std::span<const float> normals, std::span<const float> textureCoordinates,
+	std::span<const unsigned int> indices, std::span<float> tangents)
+{
+	const unsigned int numVertices = (unsigned int)(positions.size() / 3);
+	const unsigned int numTriangles = (unsigned int)(indices.size() / 3);
+	const unsigned int trianglesPerRange = BeginAccumulation(numVertices, numTriangles);
+
+	ParallelFor(numTriangles, trianglesPerRange, [&](unsigned int begin, unsigned int end)
+	{
+		float* accumulator = GetAccumulator(begin / trianglesPerRange);
+		std::fill(accumulator, accumulator + (size_t)paddedNumVertices * 3, 0.0f);
+		AccumulateTangents(positions.data(), normals.data(), textureCoordinates.data(),
+			indices.data(), begin, end, accumulator, paddedNumVertices);
+	});
+
+	ParallelFor(paddedNumVertices, VERTICES_PER_BATCH, [&](unsigned int begin, unsigned int end)
+	{
+		ResolveTangents(accumulators.data(), numRanges, paddedNumVertices, begin, end,
+			numVertices, normals.data(), tangents.data());
+	});
+}
+
+unsigned int TangentSpaceGenerator::BeginAccumulation(unsigned int numVertices,
+	unsigned int numTriangles)
+{
+	numRanges = 1;
+	if (jobSystem != nullptr && numTriangles >= MIN_TRIANGLES_PER_RANGE * 2)
+	{
+		numRanges = std::min(jobSystem->GetNumThreads(), numTriangles / MIN_TRIANGLES_PER_RANGE);
+	}
+
+	// Every range must be non-empty, as each range clears its own buffer
+	const unsigned int trianglesPerRange = std::max((numTriangles + numRanges - 1) / numRanges, 1u);
+	numRanges = std::max((numTriangles + trianglesPerRange - 1) / trianglesPerRange, 1u);
+
+	paddedNumVertices = (numVertices + 3) & ~3u;
+	const size_t size = (size_t)numRanges * 3 * paddedNumVertices;
+	if (accumulators.size() < size)
+	{
+		accumulators.resize(size);
+	}
+
+	// There are no ranges to clear the buffer
+	if (numTriangles == 0)
+	{
+		std::fill(accumulators.begin(), accumulators.begin() + size, 0.0f);
+	}
+
+	return trianglesPerRange;
+}
+
+void TangentSpaceGenerator::ParallelFor(unsigned int count, unsigned int batchSize,
+	const std::function<void(unsigned int, unsigned int)>& function)
+{
+	if (jobSystem != nullptr)
+	{
+		jobSystem->ParallelFor(count, batchSize, function);
+	}
+	else if (count > 0)
+	{
+		function(0, count);
+	}
+}
@@ -0,0 +1,83 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include <functional>
+#include <span>
+#include <vector>
+
+class JobSystem;
+
+/**
+ * @brief Generates smooth vertex normals and tangents for triangle meshes, such as procedural or
+ * deforming meshes which do not go through Assimp.
+ *
+ * Triangles are split into one range per thread, and each range accumulates into its own buffer,
+ * so no atomics are needed. The buffers are then summed and normalized 4 vertices at a time with
+ * SIMD. Buffers are kept between calls, so regenerating the normals of a deforming mesh every
+ * frame does not allocate.
+ */
+class TangentSpaceGenerator
+{
+public:
+	/**
+	 * @param jobSystem Job system to spread large meshes over, or nullptr to do all the work on
+	 *		the calling thread.
+	 */
+	explicit TangentSpaceGenerator(JobSystem* jobSystem = nullptr);
+	virtual ~TangentSpaceGenerator() {}
+
+	/**
+	 * @brief Calculates smooth vertex normals, averaging the normals of the triangles around each
+	 *		vertex weighted by their area.
+	 * @param positions Vertex positions, 3 floats per vertex.
+	 * @param indices Triangle list indices.
+	 * @param normals Normals to write, 3 floats per vertex. Vertices which are not part of any
+	 *		triangle get a zero normal.
+	 */
+	void CalculateNormals(std::span<const float> positions,
+		std::span<const unsigned int> indices, std::span<float> normals);
+
+	/**
+	 * @brief Calculates vertex tangents along increasing U, weighted as by MikkTSpace: the tangent
+	 *		of each triangle is projected onto the tangent plane of each of its vertices, and
+	 *		weighted by the angle of the triangle at that vertex. Triangles with degenerate texture
+	 *		coordinates do not contribute.
+	 * @param positions Vertex positions, 3 floats per vertex.
+	 * @param normals Vertex normals, 3 floats per vertex.
+	 * @param textureCoordinates Vertex texture coordinates, 2 floats per vertex.
+	 * @param indices Triangle list indices.
+	 * @param tangents Tangents to write, 3 floats per vertex. Always perpendicular to the normal.
+	 */
+	void CalculateTangents(std::span<const float> positions, std::span<const float> normals,
+		std::span<const float> textureCoordinates, std::span<const unsigned int> indices,
+		std::span<float> tangents);
+
+private:
+	// Disallow copy and assign
+	TangentSpaceGenerator(const TangentSpaceGenerator& other) = delete;
+	void operator=(const TangentSpaceGenerator& other) = delete;
+
+	/**
+	 * @brief Splits the triangles into ranges, and sizes the accumulation buffers to match.
+	 * @return Number of triangles per range.
+	 */
+	unsigned int BeginAccumulation(unsigned int numVertices, unsigned int numTriangles);
+
+	/** @return The X accumulation buffer of a range, followed by the Y and Z buffers. */
+	inline float* GetAccumulator(unsigned int range)
+	{
+		return accumulators.data() + (size_t)range * 3 * paddedNumVertices;
+	}
+
+	/** @brief Runs batches on the job system if there is one, otherwise on the calling thread. */
+	void ParallelFor(unsigned int count, unsigned int batchSize,
+		const std::function<void(unsigned int, unsigned int)>& function);
+
+	JobSystem* jobSystem;
+
+	// Per vertex X, Y and Z sums, padded to a multiple of 4 vertices, for every triangle range
+	std::vector<float> accumulators;
+	unsigned int numRanges;
+	unsigned int paddedNumVertices;
+};
@@ -7,7 +7,7 @@
 Text::Text(RenderDevice& device, TextRenderer& textRenderer, Font* font, const std::string& text,
 	Anchor anchor, const std::vector<Layer>& style, const Transform& transform) : device(&device), 
 	textRenderer(&textRenderer), font(font), text(text), anchor(anchor), style(style),
-	transform(transform)
+	transform(transform), isPackingLayers(true), numInstances(0), vertexArray(nullptr)
 {
 	GenerateVertexArray();
 }
@@ -23,9 +23,9 @@ void Text::GenerateVertexArray()
 	textModel.AllocateElement(2); // Positions
 	textModel.AllocateElement(2); // Texture Coordinates
 	textModel.SetInstancedElementStartIndex(2); // Begin instanced data
-	textModel.AllocateElement(4); // Color
-	textModel.AllocateElement(1); // Smoothing
-	textModel.AllocateElement(1); // Offset
+	textModel.AllocateElement(4 * MAX_PACKED_LAYERS); // Colors
+	textModel.AllocateElement(MAX_PACKED_LAYERS); // Smoothing
+	textModel.AllocateElement(MAX_PACKED_LAYERS); // Offsets
 	textModel.AllocateElement(16); // Transform Matrix
 
 	int x = 0, y = 0;
@@ -78,11 +78,16 @@ void Text::GenerateVertexArray()
 	UpdateStyleAndTransformation();
 }
 
-void Text::UpdateStyleAndTransformation()
+bool Text::CanPackLayers(const Layer& a, const Layer& b)
 {
-	unsigned int numInstances = style.size();
+	return a.transform.GetPosition() == b.transform.GetPosition() &&
+		a.transform.GetRotation() == b.transform.GetRotation() &&
+		a.transform.GetScale() == b.transform.GetScale();
+}
 
-    std::vector<glm::vec4> colors;
+void Text::UpdateStyleAndTransformation()
+{
+	std::vector<glm::vec4> colors;
 	std::vector<float> smoothing;
 	std::vector<float> offsets;
 	std::vector<glm::mat4> transforms;
@@ -121,19 +126,37 @@ void Text::UpdateStyleAndTransformation()
 		break;
 	}
 
-    for (const Layer& layer : style)
-    {
-        colors.push_back(layer.color);
-        smoothing.push_back(layer.smoothing);
-        offsets.push_back(layer.offset);
-
-        glm::mat4 finalTransform = textRenderer->GetProjection();
-        finalTransform *= anchorTransform.GetModel();
-        finalTransform *= transform.GetModel();
-        finalTransform *= centerTransform.GetModel();
-        finalTransform *= layer.transform.GetModel();
-        transforms.push_back(finalTransform);
-    }
+	// Each instance draws a run of consecutive layers with the same transform
+	const unsigned int maxLayersPerInstance = isPackingLayers ? MAX_PACKED_LAYERS : 1;
+	numInstances = 0;
+	unsigned int numPackedLayers = maxLayersPerInstance;
+	for (size_t i = 0; i < style.size(); i++)
+	{
+		const Layer& layer = style[i];
+		if (numPackedLayers == maxLayersPerInstance || !CanPackLayers(style[i - 1], layer))
+		{
+			// Unused layers are transparent. Their smoothing is never 0, so the shader's
+			// smoothstep stays defined.
+			colors.resize(colors.size() + MAX_PACKED_LAYERS, glm::vec4(0.0f));
+			smoothing.resize(smoothing.size() + MAX_PACKED_LAYERS, 1.0f);
+			offsets.resize(offsets.size() + MAX_PACKED_LAYERS, 0.5f);
+
+			glm::mat4 finalTransform = textRenderer->GetProjection();
+			finalTransform *= anchorTransform.GetModel();
+			finalTransform *= transform.GetModel();
+			finalTransform *= centerTransform.GetModel();
+			finalTransform *= layer.transform.GetModel();
+			transforms.push_back(finalTransform);
+
+			numInstances++;
+			numPackedLayers = 0;
+		}
+
+		const size_t slot = (size_t)(numInstances - 1) * MAX_PACKED_LAYERS + numPackedLayers++;
+		colors[slot] = layer.color;
+		smoothing[slot] = layer.smoothing;
+		offsets[slot] = layer.offset;
+	}
 
 	vertexArray->UpdateBuffer(2, colors.data(),     colors.size()     * sizeof(glm::vec4));
 	vertexArray->UpdateBuffer(3, smoothing.data(),  smoothing.size()  * sizeof(float));
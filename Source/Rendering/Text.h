@@ -11,9 +11,21 @@
 
 class TextRenderer;
 
+/**
+ * @brief A string drawn with a signed distance field font, styled as a stack of layers such as a
+ * shadow, an outline and a fill.
+ *
+ * Consecutive layers with the same transform are packed into one instance, up to
+ * MAX_PACKED_LAYERS at a time, and composited in the fragment shader, so the string is drawn once
+ * for all of them instead of once per layer. Layers with a transform of their own, such as a
+ * drop shadow, start a new instance, which keeps them below every glyph of the layers above.
+ */
 class Text
 {
 public:
+	// Most layers drawn by a single instance; matches TextShader.glsl
+	static constexpr unsigned int MAX_PACKED_LAYERS = 4;
+
 	enum class Anchor
 	{
 		CENTERED,
@@ -80,10 +92,25 @@ public:
 
 	inline Font* GetFont() { return font; }
 
+	/**
+	 * @brief Sets whether layers are packed into as few instances as possible. Otherwise every
+	 *		layer is drawn as an instance of the whole string.
+	 */
+	inline void SetLayerPacking(bool isPackingLayers)
+	{
+		this->isPackingLayers = isPackingLayers;
+		UpdateStyleAndTransformation();
+	}
+
+	inline bool IsLayerPacking() const { return isPackingLayers; }
+
 	inline VertexArray* GetVertexArray() { return vertexArray; }
 
 	inline unsigned int GetNumLayers() { return style.size(); }
 
+	/** @return Number of instances the layers are drawn with. */
+	inline unsigned int GetNumInstances() const { return numInstances; }
+
 private:
 	// Disallow copy and assign
 	Text(const Text& other) = delete;
@@ -92,6 +119,9 @@ private:
 	void GenerateVertexArray();
 	void UpdateStyleAndTransformation();
 
+	/** @return Whether two layers can be drawn by the same instance. */
+	static bool CanPackLayers(const Layer& a, const Layer& b);
+
 	RenderDevice* device;
 	TextRenderer* textRenderer;
 	std::string text;
@@ -102,6 +132,8 @@ private:
 
 	float textWidth;
 	float textHeight;
+	bool isPackingLayers;
+	unsigned int numInstances;
 
 	VertexArray* vertexArray;
 };
@@ -1,6 +1,7 @@
 /** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
 
 #include "TextRenderer.h"
+#include "Log.h"
 
 #include <GLM/gtc/type_ptr.hpp>
 
@@ -10,7 +11,7 @@ TextRenderer::TextRenderer(unsigned int width, unsigned int height, RenderDevice
 {
 	if (FT_Init_FreeType(&ft))
 	{
-		std::cerr << "FreeType failed to initialize!" << std::endl;
+		Log::Error("FreeType failed to initialize!");
 	}
 
 	projection = glm::ortho(0.0f, (float)width, 0.0f, (float)height);
@@ -28,7 +29,7 @@ void TextRenderer::RenderText(Text& text)
 		sampler.GetID(), 0);
 
 	device->Draw(target->GetID(), shader.GetID(), text.GetVertexArray()->GetID(), drawParameters,
-		text.GetNumLayers(), text.GetVertexArray()->GetNumIndices());
+		text.GetNumInstances(), text.GetVertexArray()->GetNumIndices());
 }
 
 TextRenderer::~TextRenderer()
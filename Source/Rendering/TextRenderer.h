@@ -6,7 +6,6 @@
 #include <freetype/freetype.h>
 #include <GLM/gtc/matrix_transform.hpp>
 #include <string>
-#include <iostream>
 
 #include "Font.h"
 #include "Shader.h"
@@ -25,7 +25,7 @@
  */
 
 #include "Texture.h"
-#include <iostream>
+#include "Log.h"
 #include <cstring> // std::memcpy
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -50,7 +50,7 @@ Texture::Texture(RenderDevice& device, const std::string& fileName,
 
 	if (imageData == nullptr)
 	{
-		std::cerr << "Texture loading failed for texture: " << fileName << std::endl;
+		Log::Error("Texture loading failed for texture: {}", fileName);
 	}
 
 	width = textureWidth;
@@ -0,0 +1,51 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include "RenderDevice.h"
+
+/**
+ * @brief Used to store large arrays of data for a shader program, which reads them as a
+ * samplerBuffer of RGBA float texels with texelFetch. Holds far more than a uniform buffer, so
+ * e.g. the bone matrices of every skinned mesh in a frame can be uploaded at once.
+ */
+class TextureBuffer
+{
+public:
+	/**
+	 * @param device Render device to use.
+	 * @param dataSize The initial size in bytes of the buffer.
+	 * @param usage Hints for what the user will be doing with the buffer.
+	 * @param data A pointer to data that will be copied into the data store for initialization, or
+	 *		nullptr if no data is to be copied.
+	 */
+	TextureBuffer(RenderDevice& device, size_t dataSize, RenderDevice::BufferUsage usage,
+		const void* data = nullptr) : device(&device)
+	{
+		deviceID = this->device->CreateTextureBuffer(data, dataSize, usage);
+	}
+
+	virtual ~TextureBuffer()
+	{
+		deviceID = device->ReleaseTextureBuffer(deviceID);
+	}
+
+	/** @brief Replaces the contents of the buffer, growing it if the data does not fit. */
+	void Update(const void* data, size_t dataSize)
+	{
+		device->UpdateTextureBuffer(deviceID, data, dataSize);
+	}
+
+	/** @return The largest size in bytes shaders can read in full. */
+	size_t GetMaxSize() { return device->GetMaxTextureBufferSize(); }
+
+	unsigned int GetID() { return deviceID; }
+
+private:
+	// Disallow copy and assign
+	TextureBuffer(const TextureBuffer& other) = delete;
+	void operator=(const TextureBuffer& other) = delete;
+
+	RenderDevice* device;
+	unsigned int deviceID;
+};
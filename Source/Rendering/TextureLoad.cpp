@@ -0,0 +1,44 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#include "TextureLoad.h"
+#include "Log.h"
+
+#include <cstring>
+
+#include "stb_image.h"
+
+void TextureLoad::await_suspend(Task::Handle handle)
+{
+	std::vector<JobSystem::Job> jobs;
+	jobs.push_back([this]()
+	{
+		int width, height, bytesPerPixel;
+		unsigned char* imageData = stbi_load(fileName.c_str(), &width, &height, &bytesPerPixel,
+			4);
+		if (imageData == nullptr)
+		{
+			return;
+		}
+
+		bitmap = new ArrayBitmap(width, height);
+		std::memcpy(bitmap->GetPixelArray(), imageData, (size_t)width * height * 4);
+		stbi_image_free(imageData);
+	});
+
+	handle.promise().scheduler->ResumeAfterJobs(handle, std::move(jobs));
+}
+
+Texture* TextureLoad::await_resume()
+{
+	if (bitmap == nullptr)
+	{
+		Log::Error("Texture loading failed for texture: {}", fileName);
+		return nullptr;
+	}
+
+	Texture* texture = new Texture(device, *bitmap, internalPixelFormat, generateMipmaps,
+		shouldCompress);
+	delete bitmap;
+	bitmap = nullptr;
+	return texture;
+}
@@ -0,0 +1,54 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include "Texture.h"
+#include "Jobs/Task.h"
+
+#include <string>
+
+/**
+ * @brief Awaitable which decodes a texture file on a worker thread, then creates the texture
+ *		when the task resumes, on the thread owning the render device.
+ *
+ * co_await returns the texture, which the caller owns, or nullptr if the file could not be
+ * loaded.
+ */
+class TextureLoad
+{
+public:
+	/** @see Texture */
+	TextureLoad(RenderDevice& device, const std::string& fileName,
+		RenderDevice::PixelFormat internalPixelFormat, bool generateMipmaps, bool shouldCompress) :
+		device(device), fileName(fileName), internalPixelFormat(internalPixelFormat),
+		generateMipmaps(generateMipmaps), shouldCompress(shouldCompress), bitmap(nullptr) {}
+
+	virtual ~TextureLoad() { delete bitmap; }
+
+	inline bool await_ready() const { return false; }
+
+	void await_suspend(Task::Handle handle);
+	Texture* await_resume();
+
+private:
+	// Disallow copy and assign
+	TextureLoad(const TextureLoad& other) = delete;
+	void operator=(const TextureLoad& other) = delete;
+
+	RenderDevice& device;
+	std::string fileName;
+	RenderDevice::PixelFormat internalPixelFormat;
+	bool generateMipmaps;
+	bool shouldCompress;
+
+	// Decoded on a worker thread
+	ArrayBitmap* bitmap;
+};
+
+/** @see TextureLoad */
+inline TextureLoad LoadTexture(RenderDevice& device, const std::string& fileName,
+	RenderDevice::PixelFormat internalPixelFormat = RenderDevice::FORMAT_RGBA,
+	bool generateMipmaps = true, bool shouldCompress = false)
+{
+	return TextureLoad(device, fileName, internalPixelFormat, generateMipmaps, shouldCompress);
+}
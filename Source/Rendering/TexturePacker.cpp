@@ -2,7 +2,10 @@
 
 #include "TexturePacker.h"
 
-TexturePacker::TexturePacker(glm::ivec2 initialSize)
+#include <cstring>
+
+TexturePacker::TexturePacker(glm::ivec2 initialSize, int bytesPerPixel) :
+	textureSize(0, 0), bytesPerPixel(bytesPerPixel)
 {
 	rootNode = std::shared_ptr<TextureNode>(new TextureNode(glm::ivec2(0, 0), initialSize));
 	ResizeBuffer(initialSize);
@@ -104,7 +107,7 @@ TexturePacker::TextureNode* TexturePacker::Pack(TextureNode* node, const glm::iv
 	}
 }
 
-glm::ivec2 TexturePacker::PackTexture(unsigned char* textureBuffer, const glm::ivec2& bufferSize)
+glm::ivec2 TexturePacker::PackTexture(const unsigned char* textureBuffer, const glm::ivec2& bufferSize)
 {
 	TextureNode* node = Pack(rootNode.get(), bufferSize);
 	if (node == NULL)
@@ -126,12 +129,10 @@ glm::ivec2 TexturePacker::PackTexture(unsigned char* textureBuffer, const glm::i
 	// Copy the texture to the texture atlas' buffer
 	for (int ly = 0; ly < bufferSize.y; ly++)
 	{
-		for (int lx = 0; lx < bufferSize.x; lx++)
-		{
-			int y = node->origin.y + ly;
-			int x = node->origin.x + lx;
-			buffer[y * textureSize.x + x] = textureBuffer[ly * bufferSize.x + lx];
-		}
+		const int y = node->origin.y + ly;
+		std::memcpy(&buffer[((size_t)y * textureSize.x + node->origin.x) * bytesPerPixel],
+			&textureBuffer[(size_t)ly * bufferSize.x * bytesPerPixel],
+			(size_t)bufferSize.x * bytesPerPixel);
 	}
 
 	return node->origin;
@@ -140,13 +141,12 @@ glm::ivec2 TexturePacker::PackTexture(unsigned char* textureBuffer, const glm::i
 void TexturePacker::ResizeBuffer(const glm::ivec2& newSize)
 {
 	std::vector<unsigned char> newBuffer;
-	newBuffer.resize(newSize.y * newSize.x);
-	for (unsigned int y = 0; y < textureSize.y; y++)
+	newBuffer.resize((size_t)newSize.y * newSize.x * bytesPerPixel);
+	for (int y = 0; y < textureSize.y; y++)
 	{
-		for (unsigned int x = 0; x < textureSize.x; x++)
-		{
-			newBuffer[y * newSize.x + x] = buffer[y * textureSize.x + x];
-		}
+		std::memcpy(&newBuffer[(size_t)y * newSize.x * bytesPerPixel],
+			&buffer[(size_t)y * textureSize.x * bytesPerPixel],
+			(size_t)textureSize.x * bytesPerPixel);
 	}
 
 	textureSize = newSize;
@@ -12,10 +12,14 @@
 class TexturePacker
 {
 public:
-	TexturePacker(glm::ivec2 initialSize);
+	/**
+	 * @param initialSize Initial size of the atlas, in pixels. Doubled whenever it is full.
+	 * @param bytesPerPixel Size of every pixel, such as 1 for glyphs or 4 for RGBA textures.
+	 */
+	TexturePacker(glm::ivec2 initialSize, int bytesPerPixel = 1);
 	virtual ~TexturePacker();
 
-	glm::ivec2 PackTexture(unsigned char* textureBuffer, const glm::ivec2& bufferSize);
+	glm::ivec2 PackTexture(const unsigned char* textureBuffer, const glm::ivec2& bufferSize);
 
 	inline unsigned char* GetBuffer() { return buffer.data(); }
 	inline glm::ivec2 GetTextureSize() { return textureSize; }
@@ -38,6 +42,7 @@ private:
 	void ResizeRootNode(const glm::ivec2& newSize);
 
 	glm::ivec2 textureSize;
+	int bytesPerPixel;
 	std::vector<unsigned char> buffer;
 	std::shared_ptr<TextureNode> rootNode;
 };
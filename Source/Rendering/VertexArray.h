@@ -33,7 +33,7 @@ class VertexArray
 {
 public:
 	VertexArray(RenderDevice& device, const IndexedModel& model, RenderDevice::BufferUsage usage) :
-		device(&device), numIndices(model.GetNumIndices())
+		device(&device), numIndices(model.GetNumIndices()), instanceSize(model.GetInstanceSize())
 	{
 		deviceID = model.CreateVertexArray(device, usage);
 	}
@@ -50,6 +50,7 @@ public:
 
 	inline unsigned int GetID() { return deviceID; }
 	inline unsigned int GetNumIndices() { return numIndices; }
+	inline unsigned int GetInstanceSize() const { return instanceSize; }
 
 private:
 	// Disallow copy and assign
@@ -59,4 +60,6 @@ private:
 	RenderDevice* device;
 	unsigned int deviceID;
 	unsigned int numIndices;
+	// Floats per instance in the first instanced buffer
+	unsigned int instanceSize;
 };
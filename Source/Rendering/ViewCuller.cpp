@@ -0,0 +1,213 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#include "ViewCuller.h"
+#include "SIMD.h"
+#include "Log.h"
+
+
+unsigned int ViewCuller::AddView(const Frustum& frustum)
+{
+	if (frusta.size() >= MAX_VIEWS)
+	{
+		Log::Warning("View culler is limited to {} views", MAX_VIEWS);
+		return MAX_VIEWS;
+	}
+
+	frusta.push_back(frustum);
+	return (unsigned int)frusta.size() - 1;
+}
+
+unsigned int ViewCuller::AddObject(const AABB& worldBounds, unsigned int bucket)
+{
+	const unsigned int index = numObjects++;
+	if (centerX.size() < numObjects)
+	{
+		const size_t paddedSize = ((size_t)numObjects * 2 + 3) & ~(size_t)3;
+		for (std::vector<float>* array : { &centerX, &centerY, &centerZ, &halfSizeX, &halfSizeY,
+			&halfSizeZ })
+		{
+			array->resize(paddedSize);
+		}
+		buckets.resize(paddedSize);
+		visibilityMasks.resize(paddedSize);
+	}
+
+	const glm::vec3 center = worldBounds.GetCenter();
+	const glm::vec3 halfSize = (worldBounds.GetMaxExtents() - worldBounds.GetMinExtents()) * 0.5f;
+
+	centerX[index] = center.x;
+	centerY[index] = center.y;
+	centerZ[index] = center.z;
+	halfSizeX[index] = halfSize.x;
+	halfSizeY[index] = halfSize.y;
+	halfSizeZ[index] = halfSize.z;
+	buckets[index] = bucket;
+	numBuckets = glm::max(numBuckets, bucket + 1);
+
+	return index;
+}
+
+void ViewCuller::Cull()
+{
+	ComputeVisibility();
+	BuildBuckets();
+}
+
+void ViewCuller::Clear()
+{
+	frusta.clear();
+	numObjects = 0;
+	numBuckets = 0;
+	visibleObjects.clear();
+	bucketOffsets.clear();
+}
+
+const unsigned int* ViewCuller::GetVisibleObjects(unsigned int view, unsigned int bucket,
+	unsigned int& numVisible) const
+{
+	if (view >= frusta.size() || bucket >= numBuckets)
+	{
+		numVisible = 0;
+		return nullptr;
+	}
+
+	const size_t offset = (size_t)view * (numBuckets + 1) + bucket;
+	numVisible = bucketOffsets[offset + 1] - bucketOffsets[offset];
+	return visibleObjects.data() + bucketOffsets[offset];
+}
+
+unsigned int ViewCuller::GetNumVisibleObjects(unsigned int view) const
+{
+	if (view >= frusta.size())
+	{
+		return 0;
+	}
+
+	const size_t offset = (size_t)view * (numBuckets + 1);
+	return bucketOffsets[offset + numBuckets] - bucketOffsets[offset];
+}
+
+void ViewCuller::ComputeVisibility()
+{
+	const unsigned int numViews = (unsigned int)frusta.size();
+
+	for (unsigned int i = 0; i < numObjects; i += 4)
+	{
+		uint32_t masks[4] = { 0, 0, 0, 0 };
+
+#if defined(GLENGINE_SSE2)
+		const __m128 signMask = _mm_set1_ps(-0.0f);
+		const __m128 x = _mm_loadu_ps(&centerX[i]);
+		const __m128 y = _mm_loadu_ps(&centerY[i]);
+		const __m128 z = _mm_loadu_ps(&centerZ[i]);
+		const __m128 halfX = _mm_loadu_ps(&halfSizeX[i]);
+		const __m128 halfY = _mm_loadu_ps(&halfSizeY[i]);
+		const __m128 halfZ = _mm_loadu_ps(&halfSizeZ[i]);
+
+		for (unsigned int view = 0; view < numViews; view++)
+		{
+			__m128 outside = _mm_setzero_ps();
+			for (const glm::vec4& plane : frusta[view].planes)
+			{
+				const __m128 normalX = _mm_set1_ps(plane.x);
+				const __m128 normalY = _mm_set1_ps(plane.y);
+				const __m128 normalZ = _mm_set1_ps(plane.z);
+
+				// Signed distance of the box center, and the projected half size of the box
+				__m128 distance = _mm_add_ps(_mm_mul_ps(normalX, x), _mm_set1_ps(plane.w));
+				distance = _mm_add_ps(distance, _mm_mul_ps(normalY, y));
+				distance = _mm_add_ps(distance, _mm_mul_ps(normalZ, z));
+
+				__m128 radius = _mm_mul_ps(_mm_andnot_ps(signMask, normalX), halfX);
+				radius = _mm_add_ps(radius, _mm_mul_ps(_mm_andnot_ps(signMask, normalY), halfY));
+				radius = _mm_add_ps(radius, _mm_mul_ps(_mm_andnot_ps(signMask, normalZ), halfZ));
+
+				// The box is entirely behind the plane
+				outside = _mm_or_ps(outside,
+					_mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+			}
+
+			const unsigned int visible = ~(unsigned int)_mm_movemask_ps(outside) & 0xF;
+			for (unsigned int j = 0; j < 4; j++)
+			{
+				masks[j] |= ((visible >> j) & 1u) << view;
+			}
+		}
+#else
+		for (unsigned int j = 0; j < 4; j++)
+		{
+			const glm::vec3 center(centerX[i + j], centerY[i + j], centerZ[i + j]);
+			const glm::vec3 halfSize(halfSizeX[i + j], halfSizeY[i + j], halfSizeZ[i + j]);
+
+			for (unsigned int view = 0; view < numViews; view++)
+			{
+				bool outside = false;
+				for (const glm::vec4& plane : frusta[view].planes)
+				{
+					const glm::vec3 normal = glm::vec3(plane);
+					const float distance = glm::dot(normal, center) + plane.w;
+					const float radius = glm::dot(glm::abs(normal), halfSize);
+					outside |= distance + radius < 0.0f;
+				}
+
+				masks[j] |= (outside ? 0u : 1u) << view;
+			}
+		}
+#endif
+
+		const unsigned int numValid = glm::min(numObjects - i, 4u);
+		for (unsigned int j = 0; j < numValid; j++)
+		{
+			visibilityMasks[i + j] = masks[j];
+		}
+	}
+}
+
+void ViewCuller::BuildBuckets()
+{
+	const unsigned int numViews = (unsigned int)frusta.size();
+	const size_t stride = (size_t)numBuckets + 1;
+
+	// Count the visible objects of each bucket of each view
+	bucketOffsets.assign(numViews * stride, 0);
+	for (unsigned int i = 0; i < numObjects; i++)
+	{
+		uint32_t mask = visibilityMasks[i];
+		for (unsigned int view = 0; mask != 0; view++, mask >>= 1)
+		{
+			bucketOffsets[view * stride + buckets[i]] += mask & 1u;
+		}
+	}
+
+	// Convert the counts into offsets
+	unsigned int total = 0;
+	for (unsigned int view = 0; view < numViews; view++)
+	{
+		for (unsigned int bucket = 0; bucket < stride; bucket++)
+		{
+			const unsigned int count = bucketOffsets[view * stride + bucket];
+			bucketOffsets[view * stride + bucket] = total;
+			total += count;
+		}
+	}
+
+	// Scatter the objects, in order; the offsets of each bucket advance to the next bucket
+	visibleObjects.resize(total);
+	for (unsigned int i = 0; i < numObjects; i++)
+	{
+		uint32_t mask = visibilityMasks[i];
+		for (unsigned int view = 0; mask != 0; view++, mask >>= 1)
+		{
+			if (mask & 1u)
+			{
+				visibleObjects[bucketOffsets[view * stride + buckets[i]]++] = i;
+			}
+		}
+	}
+
+	// Every offset now points to the start of the next bucket; shift them back by one
+	for (size_t i = bucketOffsets.size(); i-- > 0;)
+	{
+		bucketOffsets[i] = i == 0 ? 0 : bucketOffsets[i - 1];
+	}
+}
@@ -0,0 +1,98 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include "Frustum.h"
+#include "AABB.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Culls many objects against several views at once, such as the main camera and the
+ * cascades of a shadow map. Object bounds are stored as structure of arrays, and each group of 4
+ * objects is tested against every view while it is in registers, so the cost grows with
+ * objects * views at vector width, instead of rescanning all objects for each view.
+ *
+ * Every object belongs to a bucket (for example, a mesh and texture pair). After culling, the
+ * visible objects of each view are grouped by bucket, ready to be drawn.
+ */
+class ViewCuller
+{
+public:
+	static constexpr unsigned int MAX_VIEWS = 32;
+
+	ViewCuller() : numObjects(0), numBuckets(0) {}
+
+	/**
+	 * @brief Adds a view to cull against.
+	 * @param frustum Frustum of the view.
+	 * @return Index of the view, or MAX_VIEWS if there are already too many views.
+	 */
+	unsigned int AddView(const Frustum& frustum);
+
+	/**
+	 * @brief Adds an object to cull.
+	 * @param worldBounds World space bounds of the object.
+	 * @param bucket Draw bucket of the object.
+	 * @return Index of the object.
+	 */
+	unsigned int AddObject(const AABB& worldBounds, unsigned int bucket);
+
+	/** @brief Tests all objects against all views, and groups the visible objects by bucket. */
+	void Cull();
+
+	/** @brief Removes all views and objects. Storage is kept for reuse. */
+	void Clear();
+
+	/**
+	 * @brief Gets the visible objects of a view which belong to a bucket. Only valid after Cull.
+	 * @param view Index of the view.
+	 * @param bucket Draw bucket.
+	 * @param numVisible Set to the number of visible objects.
+	 * @return Array of object indices.
+	 */
+	const unsigned int* GetVisibleObjects(unsigned int view, unsigned int bucket,
+		unsigned int& numVisible) const;
+
+	/** @return The number of visible objects of a view, across all buckets. */
+	unsigned int GetNumVisibleObjects(unsigned int view) const;
+
+	/** @return Bit mask of the views an object is visible in. Only valid after Cull. */
+	inline uint32_t GetVisibilityMask(unsigned int object) const
+	{
+		return visibilityMasks[object];
+	}
+
+	inline unsigned int GetNumViews() const { return (unsigned int)frusta.size(); }
+	inline unsigned int GetNumObjects() const { return numObjects; }
+	inline unsigned int GetNumBuckets() const { return numBuckets; }
+
+private:
+	// Disallow copy and assign
+	ViewCuller(const ViewCuller& other) = delete;
+	void operator=(const ViewCuller& other) = delete;
+
+	void ComputeVisibility();
+	void BuildBuckets();
+
+	std::vector<Frustum> frusta;
+
+	unsigned int numObjects;
+	unsigned int numBuckets;
+
+	// Padded to a multiple of 4
+	std::vector<float> centerX;
+	std::vector<float> centerY;
+	std::vector<float> centerZ;
+	std::vector<float> halfSizeX;
+	std::vector<float> halfSizeY;
+	std::vector<float> halfSizeZ;
+	std::vector<unsigned int> buckets;
+	std::vector<uint32_t> visibilityMasks;
+
+	// Visible objects of all views, grouped by view, then bucket
+	std::vector<unsigned int> visibleObjects;
+	// Offsets into visibleObjects; numBuckets + 1 per view
+	std::vector<unsigned int> bucketOffsets;
+};
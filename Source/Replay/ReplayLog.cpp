@@ -0,0 +1,115 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#include "ReplayLog.h"
+
+#include <algorithm>
+
+// Number of unchanged bytes in a row which end a run of changed bytes; shorter gaps are cheaper
+// to store inside the run
+static const size_t MIN_UNCHANGED_RUN = 4;
+
+void ReplayLog::EncodeDelta(const std::vector<unsigned char>& previous,
+	const std::vector<unsigned char>& current, std::vector<unsigned char>& output)
+{
+	const size_t size = current.size();
+	const auto GetDelta = [&](size_t i) -> unsigned char
+	{
+		return i < previous.size() ? current[i] ^ previous[i] : current[i];
+	};
+
+	WriteVarint(output, size);
+
+	size_t i = 0;
+	while (i < size)
+	{
+		// Unchanged bytes
+		const size_t unchangedStart = i;
+		while (i < size && GetDelta(i) == 0)
+		{
+			i++;
+		}
+		WriteVarint(output, i - unchangedStart);
+
+		// Changed bytes, up to the next long enough run of unchanged ones
+		const size_t changedStart = i;
+		size_t changedEnd = i;
+		while (i < size)
+		{
+			if (GetDelta(i) != 0)
+			{
+				changedEnd = ++i;
+				continue;
+			}
+
+			size_t unchangedEnd = i;
+			while (unchangedEnd < size && GetDelta(unchangedEnd) == 0 &&
+				unchangedEnd - i < MIN_UNCHANGED_RUN)
+			{
+				unchangedEnd++;
+			}
+
+			if (unchangedEnd == size || unchangedEnd - i >= MIN_UNCHANGED_RUN)
+			{
+				break;
+			}
+			i = unchangedEnd;
+		}
+		i = changedEnd;
+
+		WriteVarint(output, changedEnd - changedStart);
+		for (size_t j = changedStart; j < changedEnd; j++)
+		{
+			output.push_back(GetDelta(j));
+		}
+	}
+}
+
+bool ReplayLog::DecodeDelta(const unsigned char*& data, const unsigned char* end,
+	std::vector<unsigned char>& previous)
+{
+	unsigned long long size;
+	if (!ReadVarint(data, end, size))
+	{
+		return false;
+	}
+
+	// Bytes past the end of the previous snapshot are stored as they are
+	previous.resize((size_t)size, 0);
+
+	size_t i = 0;
+	while (i < size)
+	{
+		unsigned long long numUnchanged, numChanged;
+		if (!ReadVarint(data, end, numUnchanged) || numUnchanged > size - i)
+		{
+			return false;
+		}
+		i += (size_t)numUnchanged;
+
+		if (!ReadVarint(data, end, numChanged) || numChanged > size - i ||
+			numChanged > (unsigned long long)(end - data))
+		{
+			return false;
+		}
+
+		for (size_t j = 0; j < numChanged; j++)
+		{
+			previous[i++] ^= *data++;
+		}
+	}
+
+	return true;
+}
+
+void ReplayLog::GatherField(ECS& ecs, const SnapshotField& field,
+	std::vector<unsigned char>& output)
+{
+	const std::vector<unsigned char>& memory = ecs.GetComponentMemory(field.componentID);
+	const size_t typeSize = BaseECSComponent::GetTypeSize(field.componentID);
+
+	output.resize(memory.size() / typeSize * field.size);
+	for (size_t i = field.offset, j = 0; i < memory.size(); i += typeSize, j += field.size)
+	{
+		std::copy(memory.begin() + i, memory.begin() + i + field.size, output.begin() + j);
+	}
+}
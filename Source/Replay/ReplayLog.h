@@ -0,0 +1,116 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include "ECS/ECS.h"
+
+#include <vector>
+
+/**
+ * @brief Binary format shared by ReplayRecorder and ReplayPlayer.
+ *
+ * A log starts with MAGIC and VERSION, followed by a stream of records. Every record starts with
+ * its RecordType. Each frame starts with a RECORD_FRAME record, followed by the snapshot and input
+ * records of that frame. Integers are stored as variable length integers, so most records take
+ * only a few bytes, and snapshots only store the bytes which changed since the previous snapshot.
+ */
+namespace ReplayLog
+{
+	// Identifies replay logs; "GLRP"
+	const unsigned int MAGIC = 0x50524C47;
+	const unsigned int VERSION = 1;
+
+	enum RecordType : unsigned char
+	{
+		// Delta time of the frame, as its bits XOR those of the previous frame
+		RECORD_FRAME,
+		// Key code and repeat flag
+		RECORD_KEY_DOWN,
+		RECORD_KEY_UP,
+		// Mouse button and number of clicks
+		RECORD_MOUSE_DOWN,
+		RECORD_MOUSE_UP,
+		// Position relative to the previous one, and motion
+		RECORD_MOUSE_MOVE,
+		// Window width and height
+		RECORD_WINDOW_RESIZE,
+		// Fields of components, relative to the previous snapshot
+		RECORD_SNAPSHOT,
+		// End of the log
+		RECORD_END
+	};
+
+	inline void WriteVarint(std::vector<unsigned char>& output, unsigned long long value)
+	{
+		while (value >= 0x80)
+		{
+			output.push_back((unsigned char)(value | 0x80));
+			value >>= 7;
+		}
+		output.push_back((unsigned char)value);
+	}
+
+	inline bool ReadVarint(const unsigned char*& data, const unsigned char* end,
+		unsigned long long& value)
+	{
+		value = 0;
+		for (unsigned int shift = 0; data < end && shift < 64; shift += 7)
+		{
+			const unsigned char byte = *data++;
+			value |= (unsigned long long)(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/** @brief Maps signed integers to unsigned ones, so small negative values stay small. */
+	inline unsigned long long ZigZagEncode(long long value)
+	{
+		return ((unsigned long long)value << 1) ^ (unsigned long long)(value >> 63);
+	}
+
+	inline long long ZigZagDecode(unsigned long long value)
+	{
+		return (long long)(value >> 1) ^ -(long long)(value & 1);
+	}
+
+	/**
+	 * @brief Encodes a snapshot relative to the previous one, as alternating runs of unchanged
+	 *		bytes and changed bytes XOR the previous ones.
+	 * @param previous Previous snapshot; empty if there is none.
+	 * @param current Snapshot to encode.
+	 * @param output Vector to append the encoded snapshot to.
+	 */
+	void EncodeDelta(const std::vector<unsigned char>& previous,
+		const std::vector<unsigned char>& current, std::vector<unsigned char>& output);
+
+	/**
+	 * @brief Decodes a snapshot written by EncodeDelta.
+	 * @param data Position in the log, advanced past the snapshot.
+	 * @param end End of the log.
+	 * @param previous Previous snapshot, which is replaced by the decoded one.
+	 * @return Whether the snapshot was valid.
+	 */
+	bool DecodeDelta(const unsigned char*& data, const unsigned char* end,
+		std::vector<unsigned char>& previous);
+
+	/** @brief Field of a component type which is part of snapshots. */
+	struct SnapshotField
+	{
+		unsigned int componentID;
+		// Byte offset of the field within the component
+		size_t offset;
+		size_t size;
+	};
+
+	/**
+	 * @brief Copies a field of all components of a type into a snapshot.
+	 * @param ecs ECS to copy from.
+	 * @param field Field to copy. Must be plain data, without any pointers or padding.
+	 * @param output Replaced with the snapshot.
+	 */
+	void GatherField(ECS& ecs, const SnapshotField& field, std::vector<unsigned char>& output);
+}
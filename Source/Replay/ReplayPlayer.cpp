@@ -0,0 +1,174 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#include "ReplayPlayer.h"
+#include "Log.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+ReplayPlayer::ReplayPlayer(const std::string& fileName, ECS& ecs) : ecs(ecs), position(nullptr),
+	end(nullptr), isValid(false), numFrames(0), numDivergences(0), previousDeltaTimeBits(0),
+	previousMouseX(0), previousMouseY(0)
+{
+	std::ifstream file(fileName, std::ios::binary);
+	if (!file.is_open())
+	{
+		Log::Error("Could not open replay file {}", fileName);
+		return;
+	}
+
+	log.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	position = log.data();
+	end = log.data() + log.size();
+
+	unsigned int magic = 0;
+	for (unsigned int i = 0; i < 4 && position < end; i++)
+	{
+		magic |= (unsigned int)*position++ << (i * 8);
+	}
+
+	unsigned long long version;
+	if (magic != ReplayLog::MAGIC || !ReplayLog::ReadVarint(position, end, version))
+	{
+		Log::Error("{} is not a replay file", fileName);
+		return;
+	}
+
+	if (version != ReplayLog::VERSION)
+	{
+		Log::Error("Unsupported replay file version {}", version);
+		return;
+	}
+
+	isValid = true;
+}
+
+bool ReplayPlayer::NextFrame(float& deltaTime, IApplicationEventHandler& eventHandler)
+{
+	if (!isValid || position == end || *position == ReplayLog::RECORD_END)
+	{
+		return false;
+	}
+
+	unsigned long long deltaTimeBits;
+	if (*position++ != ReplayLog::RECORD_FRAME ||
+		!ReplayLog::ReadVarint(position, end, deltaTimeBits))
+	{
+		Log::Error("Corrupt replay file at frame {}", numFrames);
+		isValid = false;
+		return false;
+	}
+
+	previousDeltaTimeBits ^= (unsigned int)deltaTimeBits;
+	std::memcpy(&deltaTime, &previousDeltaTimeBits, sizeof(deltaTime));
+
+	// Same order as the application; the handler is updated before the frame's events
+	eventHandler.Update();
+
+	while (position < end && *position != ReplayLog::RECORD_FRAME &&
+		*position != ReplayLog::RECORD_END)
+	{
+		if (!PlayRecord((ReplayLog::RecordType)*position++, eventHandler))
+		{
+			// Play the events read so far, but stop at the next frame
+			Log::Error("Corrupt replay file at frame {}", numFrames);
+			isValid = false;
+			break;
+		}
+	}
+
+	numFrames++;
+	return true;
+}
+
+bool ReplayPlayer::PlayRecord(ReplayLog::RecordType type, IApplicationEventHandler& eventHandler)
+{
+	unsigned long long values[4];
+
+	switch (type)
+	{
+	case ReplayLog::RECORD_KEY_DOWN:
+		if (!ReplayLog::ReadVarint(position, end, values[0])) return false;
+		eventHandler.OnKeyDown((unsigned int)(values[0] >> 1), (values[0] & 1) != 0);
+		return true;
+	case ReplayLog::RECORD_KEY_UP:
+		if (!ReplayLog::ReadVarint(position, end, values[0])) return false;
+		eventHandler.OnKeyUp((unsigned int)(values[0] >> 1), (values[0] & 1) != 0);
+		return true;
+	case ReplayLog::RECORD_MOUSE_DOWN:
+		if (!ReplayLog::ReadVarint(position, end, values[0]) || position == end) return false;
+		eventHandler.OnMouseDown((unsigned int)values[0], *position++);
+		return true;
+	case ReplayLog::RECORD_MOUSE_UP:
+		if (!ReplayLog::ReadVarint(position, end, values[0]) || position == end) return false;
+		eventHandler.OnMouseUp((unsigned int)values[0], *position++);
+		return true;
+	case ReplayLog::RECORD_MOUSE_MOVE:
+		for (unsigned int i = 0; i < 4; i++)
+		{
+			if (!ReplayLog::ReadVarint(position, end, values[i])) return false;
+		}
+		previousMouseX += (int)ReplayLog::ZigZagDecode(values[0]);
+		previousMouseY += (int)ReplayLog::ZigZagDecode(values[1]);
+		eventHandler.OnMouseMove((unsigned int)previousMouseX, (unsigned int)previousMouseY,
+			(int)ReplayLog::ZigZagDecode(values[2]), (int)ReplayLog::ZigZagDecode(values[3]));
+		return true;
+	case ReplayLog::RECORD_WINDOW_RESIZE:
+		if (!ReplayLog::ReadVarint(position, end, values[0]) ||
+			!ReplayLog::ReadVarint(position, end, values[1])) return false;
+		eventHandler.OnWindowResize((unsigned int)values[0], (unsigned int)values[1]);
+		return true;
+	case ReplayLog::RECORD_SNAPSHOT:
+		return CompareSnapshot();
+	default:
+		return false;
+	}
+}
+
+bool ReplayPlayer::CompareSnapshot()
+{
+	unsigned long long numFields;
+	if (!ReplayLog::ReadVarint(position, end, numFields) ||
+		numFields > (unsigned long long)(end - position))
+	{
+		return false;
+	}
+
+	// The same fields are recorded in every snapshot
+	recordedSnapshots.resize((size_t)numFields);
+
+	for (size_t i = 0; i < recordedSnapshots.size(); i++)
+	{
+		unsigned long long componentID, offset, size;
+		if (!ReplayLog::ReadVarint(position, end, componentID) ||
+			!ReplayLog::ReadVarint(position, end, offset) ||
+			!ReplayLog::ReadVarint(position, end, size) ||
+			!BaseECSComponent::IsTypeValid((unsigned int)componentID) ||
+			offset + size > BaseECSComponent::GetTypeSize((unsigned int)componentID))
+		{
+			return false;
+		}
+
+		if (!ReplayLog::DecodeDelta(position, end, recordedSnapshots[i]))
+		{
+			return false;
+		}
+
+		const ReplayLog::SnapshotField field = { (unsigned int)componentID, (size_t)offset,
+			(size_t)size };
+		ReplayLog::GatherField(ecs, field, snapshot);
+		if (snapshot != recordedSnapshots[i])
+		{
+			// Report the first divergence only; every later snapshot is likely to differ too
+			if (numDivergences == 0)
+			{
+				Log::Warning("Replay diverged from the recording at frame {}, in component type {}",
+					numFrames, componentID);
+			}
+			numDivergences++;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,65 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include "Events/IApplicationEventHandler.h"
+#include "ReplayLog.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Plays back a log written by ReplayRecorder, replacing the measured delta time and the
+ *		live input of every frame with the recorded ones.
+ *
+ * Frames are played back as fast as the game loop runs, so a recorded session becomes a
+ * repeatable workload for profiling. Snapshots in the log are compared against the ECS, and
+ * snapshots which differ are counted as divergences; a replay only reproduces the recording if
+ * the game was set up the same way, and its logic depends on nothing but delta time and input.
+ */
+class ReplayPlayer
+{
+public:
+	/**
+	 * @param fileName Path of the log to play back.
+	 * @param ecs ECS to compare snapshots against.
+	 */
+	ReplayPlayer(const std::string& fileName, ECS& ecs);
+
+	/**
+	 * @brief Plays back the next frame. Call every frame instead of processing the application's
+	 *		events for the event handler.
+	 * @param deltaTime Set to the recorded delta time of the frame.
+	 * @param eventHandler Event handler to send the frame's recorded events to.
+	 * @return Whether a frame was played; false once the end of the log is reached.
+	 */
+	bool NextFrame(float& deltaTime, IApplicationEventHandler& eventHandler);
+
+	inline bool IsOpen() const { return isValid; }
+	inline unsigned int GetNumFrames() const { return numFrames; }
+	inline unsigned int GetNumDivergences() const { return numDivergences; }
+
+private:
+	// Disallow copy and assign
+	ReplayPlayer(const ReplayPlayer& other) = delete;
+	void operator=(const ReplayPlayer& other) = delete;
+
+	bool PlayRecord(ReplayLog::RecordType type, IApplicationEventHandler& eventHandler);
+	bool CompareSnapshot();
+
+	ECS& ecs;
+	std::vector<unsigned char> log;
+	const unsigned char* position;
+	const unsigned char* end;
+	bool isValid;
+
+	unsigned int numFrames;
+	unsigned int numDivergences;
+	unsigned int previousDeltaTimeBits;
+	int previousMouseX;
+	int previousMouseY;
+
+	// Previous recorded snapshot of every field, which the next one is relative to
+	std::vector<std::vector<unsigned char>> recordedSnapshots;
+	std::vector<unsigned char> snapshot;
+};
@@ -0,0 +1,139 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#include "ReplayRecorder.h"
+#include "Log.h"
+
+#include <cstring>
+
+// Size the buffer may grow to before it is written to the file
+static const size_t MAX_BUFFER_SIZE = 1 << 16;
+
+ReplayRecorder::ReplayRecorder(const std::string& fileName,
+	IApplicationEventHandler& eventHandler, ECS& ecs, unsigned int snapshotInterval) :
+	eventHandler(eventHandler), ecs(ecs), file(fileName, std::ios::binary),
+	snapshotInterval(snapshotInterval), numFrames(0), previousDeltaTimeBits(0), previousMouseX(0),
+	previousMouseY(0)
+{
+	if (!file.is_open())
+	{
+		Log::Error("Could not open replay file {} for writing", fileName);
+		return;
+	}
+
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		buffer.push_back((unsigned char)(ReplayLog::MAGIC >> (i * 8)));
+	}
+	ReplayLog::WriteVarint(buffer, ReplayLog::VERSION);
+}
+
+ReplayRecorder::~ReplayRecorder()
+{
+	buffer.push_back(ReplayLog::RECORD_END);
+	FlushBuffer();
+}
+
+void ReplayRecorder::BeginFrame(float deltaTime)
+{
+	if (buffer.size() >= MAX_BUFFER_SIZE)
+	{
+		FlushBuffer();
+	}
+
+	// Frame times are usually close to each other, so most of their bits are the same
+	unsigned int deltaTimeBits;
+	std::memcpy(&deltaTimeBits, &deltaTime, sizeof(deltaTimeBits));
+	buffer.push_back(ReplayLog::RECORD_FRAME);
+	ReplayLog::WriteVarint(buffer, deltaTimeBits ^ previousDeltaTimeBits);
+	previousDeltaTimeBits = deltaTimeBits;
+
+	if (!snapshotFields.empty() && numFrames % snapshotInterval == 0)
+	{
+		WriteSnapshot();
+	}
+
+	numFrames++;
+}
+
+void ReplayRecorder::Update()
+{
+	eventHandler.Update();
+}
+
+void ReplayRecorder::OnKeyDown(unsigned int keyCode, bool isRepeat)
+{
+	buffer.push_back(ReplayLog::RECORD_KEY_DOWN);
+	ReplayLog::WriteVarint(buffer, ((unsigned long long)keyCode << 1) | (isRepeat ? 1 : 0));
+	eventHandler.OnKeyDown(keyCode, isRepeat);
+}
+
+void ReplayRecorder::OnKeyUp(unsigned int keyCode, bool isRepeat)
+{
+	buffer.push_back(ReplayLog::RECORD_KEY_UP);
+	ReplayLog::WriteVarint(buffer, ((unsigned long long)keyCode << 1) | (isRepeat ? 1 : 0));
+	eventHandler.OnKeyUp(keyCode, isRepeat);
+}
+
+void ReplayRecorder::OnMouseDown(unsigned int mouseButton, unsigned char numberOfClicks)
+{
+	buffer.push_back(ReplayLog::RECORD_MOUSE_DOWN);
+	ReplayLog::WriteVarint(buffer, mouseButton);
+	buffer.push_back(numberOfClicks);
+	eventHandler.OnMouseDown(mouseButton, numberOfClicks);
+}
+
+void ReplayRecorder::OnMouseUp(unsigned int mouseButton, unsigned char numberOfClicks)
+{
+	buffer.push_back(ReplayLog::RECORD_MOUSE_UP);
+	ReplayLog::WriteVarint(buffer, mouseButton);
+	buffer.push_back(numberOfClicks);
+	eventHandler.OnMouseUp(mouseButton, numberOfClicks);
+}
+
+void ReplayRecorder::OnMouseMove(unsigned int mousePositionX, unsigned int mousePositionY,
+	int deltaX, int deltaY)
+{
+	buffer.push_back(ReplayLog::RECORD_MOUSE_MOVE);
+	ReplayLog::WriteVarint(buffer, ReplayLog::ZigZagEncode((int)mousePositionX - previousMouseX));
+	ReplayLog::WriteVarint(buffer, ReplayLog::ZigZagEncode((int)mousePositionY - previousMouseY));
+	ReplayLog::WriteVarint(buffer, ReplayLog::ZigZagEncode(deltaX));
+	ReplayLog::WriteVarint(buffer, ReplayLog::ZigZagEncode(deltaY));
+	previousMouseX = (int)mousePositionX;
+	previousMouseY = (int)mousePositionY;
+	eventHandler.OnMouseMove(mousePositionX, mousePositionY, deltaX, deltaY);
+}
+
+void ReplayRecorder::OnWindowResize(unsigned int windowWidth, unsigned int windowHeight)
+{
+	buffer.push_back(ReplayLog::RECORD_WINDOW_RESIZE);
+	ReplayLog::WriteVarint(buffer, windowWidth);
+	ReplayLog::WriteVarint(buffer, windowHeight);
+	eventHandler.OnWindowResize(windowWidth, windowHeight);
+}
+
+void ReplayRecorder::WriteSnapshot()
+{
+	buffer.push_back(ReplayLog::RECORD_SNAPSHOT);
+	ReplayLog::WriteVarint(buffer, snapshotFields.size());
+
+	for (size_t i = 0; i < snapshotFields.size(); i++)
+	{
+		const ReplayLog::SnapshotField& field = snapshotFields[i];
+		ReplayLog::GatherField(ecs, field, snapshot);
+
+		ReplayLog::WriteVarint(buffer, field.componentID);
+		ReplayLog::WriteVarint(buffer, field.offset);
+		ReplayLog::WriteVarint(buffer, field.size);
+		ReplayLog::EncodeDelta(previousSnapshots[i], snapshot, buffer);
+		previousSnapshots[i].swap(snapshot);
+	}
+}
+
+void ReplayRecorder::FlushBuffer()
+{
+	if (file.is_open())
+	{
+		file.write((const char*)buffer.data(), buffer.size());
+	}
+	buffer.clear();
+}
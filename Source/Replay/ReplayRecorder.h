@@ -0,0 +1,96 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include "Events/IApplicationEventHandler.h"
+#include "ReplayLog.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Records a session into a log which ReplayPlayer can play back deterministically.
+ *
+ * The recorder sits between the application and the game's event handler; every event is
+ * recorded, then forwarded. Along with the delta time of every frame, this is all the input the
+ * game logic depends on. Snapshots of selected component fields are recorded periodically, so
+ * the player can detect when a replay diverges from the recording.
+ *
+ * Records are buffered in memory and written to the file in large blocks.
+ */
+class ReplayRecorder : public IApplicationEventHandler
+{
+public:
+	/**
+	 * @param fileName Path of the log to write.
+	 * @param eventHandler Event handler which events are forwarded to.
+	 * @param ecs ECS to take snapshots of.
+	 * @param snapshotInterval Number of frames between snapshots.
+	 */
+	ReplayRecorder(const std::string& fileName, IApplicationEventHandler& eventHandler, ECS& ecs,
+		unsigned int snapshotInterval = 60);
+
+	/** @brief Ends the log, and writes any buffered records. */
+	virtual ~ReplayRecorder();
+
+	/**
+	 * @brief Adds a field of a component type to snapshots. Fields are used rather than whole
+	 *		components, as entity handles differ between runs, and padding holds no state.
+	 * @param field Pointer to the field, such as &TransformComponent::transform. Must be plain
+	 *		data, without any pointers or padding.
+	 */
+	template<class Component, class Field>
+	inline void AddSnapshotField(Field Component::* field)
+	{
+		Component component;
+		const size_t offset = (const unsigned char*)&(component.*field) -
+			(const unsigned char*)&component;
+		snapshotFields.push_back({ Component::ID, offset, sizeof(Field) });
+		previousSnapshots.emplace_back();
+	}
+
+	/**
+	 * @brief Starts recording a frame. Must be called every frame, before processing the
+	 *		application's events.
+	 * @param deltaTime Delta time of the frame.
+	 */
+	void BeginFrame(float deltaTime);
+
+	/** @see IApplicationEventHandler */
+	void Update() override;
+	void OnKeyDown(unsigned int keyCode, bool isRepeat) override;
+	void OnKeyUp(unsigned int keyCode, bool isRepeat) override;
+	void OnMouseDown(unsigned int mouseButton, unsigned char numberOfClicks) override;
+	void OnMouseUp(unsigned int mouseButton, unsigned char numberOfClicks) override;
+	void OnMouseMove(unsigned int mousePositionX, unsigned int mousePositionY, int deltaX,
+		int deltaY) override;
+	void OnWindowResize(unsigned int windowWidth, unsigned int windowHeight) override;
+
+	inline bool IsOpen() const { return file.is_open(); }
+	inline unsigned int GetNumFrames() const { return numFrames; }
+
+private:
+	// Disallow copy and assign
+	ReplayRecorder(const ReplayRecorder& other) = delete;
+	void operator=(const ReplayRecorder& other) = delete;
+
+	void WriteSnapshot();
+	void FlushBuffer();
+
+	IApplicationEventHandler& eventHandler;
+	ECS& ecs;
+	std::ofstream file;
+	std::vector<unsigned char> buffer;
+
+	unsigned int snapshotInterval;
+	unsigned int numFrames;
+	unsigned int previousDeltaTimeBits;
+	int previousMouseX;
+	int previousMouseY;
+
+	std::vector<ReplayLog::SnapshotField> snapshotFields;
+	// Previous snapshot of every field, which the next one is stored relative to
+	std::vector<std::vector<unsigned char>> previousSnapshots;
+	std::vector<unsigned char> snapshot;
+};
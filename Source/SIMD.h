@@ -0,0 +1,134 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include <GLM/glm.hpp>
+
+// SSE2 is part of the x86-64 baseline, so it is always available on 64-bit builds. On any other
+// target the scalar fallbacks are used instead.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GLENGINE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+/**
+ * @brief Small vectorized helpers shared by the hot loops of the engine (animation, particles,
+ * transform batching...). Each helper has a scalar fallback with identical results.
+ */
+namespace SIMD
+{
+	/**
+	 * @brief Multiplies two column-major 4x4 matrices; result = a * b. The result may alias
+	 *		either input.
+	 * @param a Pointer to the 16 floats of the left-hand matrix.
+	 * @param b Pointer to the 16 floats of the right-hand matrix.
+	 * @param result Pointer to 16 floats to write the product to.
+	 */
+	inline void MultiplyMat4(const float* a, const float* b, float* result)
+	{
+#if defined(GLENGINE_SSE2)
+		const __m128 a0 = _mm_loadu_ps(a);
+		const __m128 a1 = _mm_loadu_ps(a + 4);
+		const __m128 a2 = _mm_loadu_ps(a + 8);
+		const __m128 a3 = _mm_loadu_ps(a + 12);
+
+		__m128 columns[4];
+		for (unsigned int i = 0; i < 4; i++)
+		{
+			// Each column of the result is a linear combination of the columns of a
+			__m128 column = _mm_mul_ps(a0, _mm_set1_ps(b[i * 4 + 0]));
+			column = _mm_add_ps(column, _mm_mul_ps(a1, _mm_set1_ps(b[i * 4 + 1])));
+			column = _mm_add_ps(column, _mm_mul_ps(a2, _mm_set1_ps(b[i * 4 + 2])));
+			column = _mm_add_ps(column, _mm_mul_ps(a3, _mm_set1_ps(b[i * 4 + 3])));
+			columns[i] = column;
+		}
+
+		for (unsigned int i = 0; i < 4; i++)
+		{
+			_mm_storeu_ps(result + i * 4, columns[i]);
+		}
+#else
+		float columns[16];
+		for (unsigned int i = 0; i < 4; i++)
+		{
+			for (unsigned int j = 0; j < 4; j++)
+			{
+				columns[i * 4 + j] = a[j] * b[i * 4 + 0] + a[4 + j] * b[i * 4 + 1] +
+					a[8 + j] * b[i * 4 + 2] + a[12 + j] * b[i * 4 + 3];
+			}
+		}
+
+		for (unsigned int i = 0; i < 16; i++)
+		{
+			result[i] = columns[i];
+		}
+#endif
+	}
+
+	inline void MultiplyMat4(const glm::mat4& a, const glm::mat4& b, glm::mat4& result)
+	{
+		MultiplyMat4(&a[0][0], &b[0][0], &result[0][0]);
+	}
+
+#if defined(GLENGINE_SSE2)
+	/**
+	 * @brief Computes the sine and cosine of 4 angles at once. Uses the range reduction and
+	 *		minimax polynomials of the Cephes library, accurate to about 1e-7 for angles of
+	 *		moderate magnitude.
+	 * @param x Angles, in radians.
+	 * @param sine Output sines.
+	 * @param cosine Output cosines.
+	 */
+	inline void SinCos(__m128 x, __m128& sine, __m128& cosine)
+	{
+		const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32((int)0x80000000));
+		const __m128i one = _mm_set1_epi32(1);
+		const __m128i two = _mm_set1_epi32(2);
+		const __m128i four = _mm_set1_epi32(4);
+
+		__m128 sineSign = _mm_and_ps(x, signMask);
+		x = _mm_andnot_ps(signMask, x);
+
+		// Find the octant of the angle, rounded up to an even number
+		__m128i octant = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.27323954473516f)));
+		octant = _mm_andnot_si128(one, _mm_add_epi32(octant, one));
+		const __m128 y = _mm_cvtepi32_ps(octant);
+
+		sineSign = _mm_xor_ps(sineSign,
+			_mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(octant, four), 29)));
+		const __m128 cosineSign = _mm_castsi128_ps(_mm_slli_epi32(
+			_mm_andnot_si128(_mm_sub_epi32(octant, two), four), 29));
+		// Lanes where the sine polynomial gives the sine (and the cosine polynomial the cosine)
+		const __m128 polynomialMask = _mm_castsi128_ps(
+			_mm_cmpeq_epi32(_mm_and_si128(octant, two), _mm_setzero_si128()));
+
+		// Extended precision modular arithmetic; x - y * pi / 4
+		x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-0.78515625f)));
+		x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-2.4187564849853515625e-4f)));
+		x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-3.77489497744594108e-8f)));
+		const __m128 z = _mm_mul_ps(x, x);
+
+		__m128 cosinePolynomial = _mm_set1_ps(2.443315711809948e-5f);
+		cosinePolynomial = _mm_add_ps(_mm_mul_ps(cosinePolynomial, z),
+			_mm_set1_ps(-1.388731625493765e-3f));
+		cosinePolynomial = _mm_add_ps(_mm_mul_ps(cosinePolynomial, z),
+			_mm_set1_ps(4.166664568298827e-2f));
+		cosinePolynomial = _mm_mul_ps(_mm_mul_ps(cosinePolynomial, z), z);
+		cosinePolynomial = _mm_sub_ps(cosinePolynomial, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+		cosinePolynomial = _mm_add_ps(cosinePolynomial, _mm_set1_ps(1.0f));
+
+		__m128 sinePolynomial = _mm_set1_ps(-1.9515295891e-4f);
+		sinePolynomial = _mm_add_ps(_mm_mul_ps(sinePolynomial, z), _mm_set1_ps(8.3321608736e-3f));
+		sinePolynomial = _mm_add_ps(_mm_mul_ps(sinePolynomial, z), _mm_set1_ps(-1.6666654611e-1f));
+		sinePolynomial = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sinePolynomial, z), x), x);
+
+		const __m128 sineResult = _mm_or_ps(_mm_and_ps(polynomialMask, sinePolynomial),
+			_mm_andnot_ps(polynomialMask, cosinePolynomial));
+		const __m128 cosineResult = _mm_or_ps(_mm_and_ps(polynomialMask, cosinePolynomial),
+			_mm_andnot_ps(polynomialMask, sinePolynomial));
+
+		sine = _mm_xor_ps(sineResult, sineSign);
+		cosine = _mm_xor_ps(cosineResult, cosineSign);
+	}
+#endif
+}
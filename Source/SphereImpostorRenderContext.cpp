@@ -0,0 +1,92 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#include "SphereImpostorRenderContext.h"
+#include "Rendering/Frustum.h"
+
+#include <algorithm>
+
+SphereImpostorRenderContext::SphereImpostorRenderContext(RenderDevice& device,
+	RenderTarget& target, RenderDevice::DrawParameters& drawParameters, Shader& shader,
+	Sampler& sampler, Camera& camera) : RenderContext(device, target, drawParameters),
+	shader(shader), sampler(sampler), camera(camera),
+	quad(device, CreateQuadModel(), RenderDevice::USAGE_STATIC_DRAW),
+	cameraBuffer(device, 2 * sizeof(glm::mat4), RenderDevice::USAGE_STREAM_DRAW) {}
+
+IndexedModel SphereImpostorRenderContext::CreateQuadModel()
+{
+	IndexedModel model;
+	model.AllocateElement(2); // Corner
+	model.SetInstancedElementStartIndex(1); // Begin instanced data
+	model.AllocateElement(4); // Center and radius
+
+	model.AddElement2f(0, -1.0f, -1.0f);
+	model.AddElement2f(0, 1.0f, -1.0f);
+	model.AddElement2f(0, 1.0f, 1.0f);
+	model.AddElement2f(0, -1.0f, 1.0f);
+
+	model.AddIndices3i(0, 1, 2);
+	model.AddIndices3i(0, 2, 3);
+	return model;
+}
+
+void SphereImpostorRenderContext::RenderSpheres(Texture& texture,
+	const Transform* const* transforms, size_t numTransforms, float radius)
+{
+	std::vector<glm::vec4>& spheres = sphereRenderBuffer[&texture];
+	spheres.reserve(spheres.size() + numTransforms);
+
+	for (size_t i = 0; i < numTransforms; i++)
+	{
+		const glm::vec3 scale = glm::abs(transforms[i]->GetScale());
+		spheres.emplace_back(transforms[i]->GetPosition(),
+			radius * std::max(scale.x, std::max(scale.y, scale.z)));
+	}
+}
+
+void SphereImpostorRenderContext::Flush()
+{
+	if (sphereRenderBuffer.empty())
+	{
+		return;
+	}
+
+	const glm::mat4 cameraData[2] = { camera.GetView(), camera.GetProjection() };
+	cameraBuffer.Update(cameraData);
+	shader.SetUniformBuffer("Camera", cameraBuffer);
+
+	const Frustum frustum(camera.GetViewProjection());
+
+	for (auto it = sphereRenderBuffer.begin(); it != sphereRenderBuffer.end(); ++it)
+	{
+		Texture* texture = it->first;
+		std::vector<glm::vec4>& spheres = it->second;
+
+		// Drop spheres entirely behind any plane of the view, keeping the rest in order
+		const auto isOutside = [&frustum](const glm::vec4& sphere)
+		{
+			for (const glm::vec4& plane : frustum.planes)
+			{
+				if (glm::dot(glm::vec3(plane), glm::vec3(sphere)) + plane.w < -sphere.w)
+				{
+					return true;
+				}
+			}
+
+			return false;
+		};
+		spheres.erase(std::remove_if(spheres.begin(), spheres.end(), isOutside), spheres.end());
+
+		if (spheres.empty()) // No instances to draw
+		{
+			continue;
+		}
+
+		shader.SetSampler("diffuse", *texture, sampler, 0);
+
+		// Index 1 is the center and radius of each sphere
+		quad.UpdateBuffer(1, spheres.data(), spheres.size() * sizeof(glm::vec4));
+		Draw(shader, quad, drawParameters, (unsigned int)spheres.size());
+
+		spheres.clear();
+	}
+}
@@ -0,0 +1,63 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include "Rendering/RenderContext.h"
+#include "Rendering/Camera.h"
+#include "Transform.h"
+
+#include <map>
+#include <vector>
+
+/**
+ * @brief Draws spheres as impostors: one camera-facing quad per sphere, which the fragment shader
+ * ray traces against the exact sphere and writes the depth of the hit. Spheres are perfectly round
+ * at any distance, and cost 4 vertices and 4 floats of instance data each, rather than a full
+ * mesh and transform matrix.
+ *
+ * All spheres sharing a texture are merged into a single instanced draw. Spheres outside the view
+ * are dropped before their instance data is uploaded.
+ */
+class SphereImpostorRenderContext : public RenderContext
+{
+public:
+	/**
+	 * @param drawParameters Parameters of the draws. Depth should be tested and written, as the
+	 *		impostors are opaque.
+	 * @param shader Sphere impostor shader, with a "Camera" uniform block holding the view and
+	 *		projection matrices.
+	 */
+	SphereImpostorRenderContext(RenderDevice& device, RenderTarget& target,
+		RenderDevice::DrawParameters& drawParameters, Shader& shader, Sampler& sampler,
+		Camera& camera);
+
+	inline void RenderSphere(Texture& texture, const glm::vec3& center, float radius)
+	{
+		sphereRenderBuffer[&texture].emplace_back(center, radius);
+	}
+
+	/**
+	 * @brief Draws spheres centered on each transform's position.
+	 * @param texture Texture of every sphere.
+	 * @param transforms Transforms of the spheres.
+	 * @param numTransforms Number of transforms.
+	 * @param radius Radius of the spheres in model space. Scaled by the largest scale axis of each
+	 *		transform, so the sphere encloses the scaled mesh it stands in for.
+	 */
+	void RenderSpheres(Texture& texture, const Transform* const* transforms,
+		size_t numTransforms, float radius);
+
+	void Flush();
+
+private:
+	/** @brief Creates a quad with corners at -1 and 1, with 1 instanced element. */
+	static IndexedModel CreateQuadModel();
+
+	Shader& shader;
+	Sampler& sampler;
+	Camera& camera;
+	VertexArray quad;
+	UniformBuffer cameraBuffer;
+	// Center and radius of every sphere, by texture
+	std::map<Texture*, std::vector<glm::vec4>> sphereRenderBuffer;
+};
@@ -29,6 +29,8 @@
 #include <GLM/glm.hpp>
 #include <GLM/gtx/transform.hpp>
 
+#include <cmath>
+
 class Transform
 {
 public:
@@ -36,23 +38,29 @@ public:
 		const glm::vec3& scale = glm::vec3(1.0f, 1.0f, 1.0f)) : position(position),
 		rotation(rotation), scale(scale) {}
 
+	/**
+	 * @brief Builds the model matrix; translation * rotation * scale, where the rotation is
+	 *		Rz * Ry * Rx. The matrix is built directly from the closed-form rotation. To convert
+	 *		many transforms at once, use TransformBatch.
+	 */
 	[[nodiscard]] glm::mat4 GetModel() const
 	{
-		const glm::mat4 positionMatrix = glm::translate(position);
-
-		const glm::mat4 rotationXMatrix = glm::rotate(glm::radians(rotation.x), 
-			glm::vec3(1.0, 0.0, 0.0));
-		const glm::mat4 rotationYMatrix = glm::rotate(glm::radians(rotation.y), 
-			glm::vec3(0.0, 1.0, 0.0));
-		const glm::mat4 rotationZMatrix = glm::rotate(glm::radians(rotation.z),
-			glm::vec3(0.0, 0.0, 1.0));
-
-		const glm::mat4 scaleMatrix = glm::scale(scale);
-
-		const glm::mat4 rotationMatrix = rotationZMatrix * rotationYMatrix * rotationXMatrix;
+		const glm::vec3 radians = glm::radians(rotation);
+		const float sinX = std::sin(radians.x);
+		const float cosX = std::cos(radians.x);
+		const float sinY = std::sin(radians.y);
+		const float cosY = std::cos(radians.y);
+		const float sinZ = std::sin(radians.z);
+		const float cosZ = std::cos(radians.z);
 
-		// Matrix multiplication is applied in reverse order
-		return positionMatrix * rotationMatrix * scaleMatrix;
+		glm::mat4 model;
+		model[0] = glm::vec4(cosZ * cosY, sinZ * cosY, -sinY, 0.0f) * scale.x;
+		model[1] = glm::vec4(cosZ * sinY * sinX - sinZ * cosX, sinZ * sinY * sinX + cosZ * cosX,
+			cosY * sinX, 0.0f) * scale.y;
+		model[2] = glm::vec4(cosZ * sinY * cosX + sinZ * sinX, sinZ * sinY * cosX - cosZ * sinX,
+			cosY * cosX, 0.0f) * scale.z;
+		model[3] = glm::vec4(position, 1.0f);
+		return model;
 	}
 
 	[[nodiscard]] glm::vec3& GetPosition() { return position; }
@@ -63,6 +71,13 @@ public:
 	[[nodiscard]] const glm::vec3& GetRotation() const { return rotation; }
 	[[nodiscard]] const glm::vec3& GetScale() const { return scale; }
 
+	bool operator==(const Transform& other) const
+	{
+		return position == other.position && rotation == other.rotation && scale == other.scale;
+	}
+
+	bool operator!=(const Transform& other) const { return !(*this == other); }
+
 	void SetPosition(const glm::vec3& position) { this->position = position; }
 	void SetRotation(const glm::vec3& rotation) { this->rotation = rotation; }
 	void SetScale(const glm::vec3& scale) { this->scale = scale; }
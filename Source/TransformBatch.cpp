@@ -0,0 +1,140 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#include "TransformBatch.h"
+#include "SIMD.h"
+
+#include <cmath>
+
+unsigned int TransformBatch::Add(const Transform& transform)
+{
+	const unsigned int index = numTransforms++;
+	if (positionX.size() < numTransforms)
+	{
+		const size_t paddedSize = ((size_t)numTransforms * 2 + 3) & ~(size_t)3;
+		for (std::vector<float>* array : { &positionX, &positionY, &positionZ, &rotationX,
+			&rotationY, &rotationZ, &scaleX, &scaleY, &scaleZ })
+		{
+			array->resize(paddedSize);
+		}
+	}
+
+	Set(index, transform);
+	return index;
+}
+
+void TransformBatch::Set(unsigned int index, const Transform& transform)
+{
+	const glm::vec3& position = transform.GetPosition();
+	const glm::vec3 rotation = glm::radians(transform.GetRotation());
+	const glm::vec3& scale = transform.GetScale();
+
+	positionX[index] = position.x;
+	positionY[index] = position.y;
+	positionZ[index] = position.z;
+	rotationX[index] = rotation.x;
+	rotationY[index] = rotation.y;
+	rotationZ[index] = rotation.z;
+	scaleX[index] = scale.x;
+	scaleY[index] = scale.y;
+	scaleZ[index] = scale.z;
+}
+
+void TransformBatch::ComputeModels(glm::mat4* models) const
+{
+	ComputeModels(nullptr, models);
+}
+
+void TransformBatch::ComputeModels(const glm::mat4& parent, glm::mat4* models) const
+{
+	ComputeModels(&parent, models);
+}
+
+void TransformBatch::ComputeModels(const glm::mat4* parent, glm::mat4* models) const
+{
+#if defined(GLENGINE_SSE2)
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	for (unsigned int i = 0; i < numTransforms; i += 4)
+	{
+		__m128 sinX, cosX, sinY, cosY, sinZ, cosZ;
+		SIMD::SinCos(_mm_loadu_ps(&rotationX[i]), sinX, cosX);
+		SIMD::SinCos(_mm_loadu_ps(&rotationY[i]), sinY, cosY);
+		SIMD::SinCos(_mm_loadu_ps(&rotationZ[i]), sinZ, cosZ);
+
+		const __m128 sx = _mm_loadu_ps(&scaleX[i]);
+		const __m128 sy = _mm_loadu_ps(&scaleY[i]);
+		const __m128 sz = _mm_loadu_ps(&scaleZ[i]);
+
+		// Rotation is Rz * Ry * Rx; each column is then scaled by the matching scale component
+		const __m128 sinYSinX = _mm_mul_ps(sinY, sinX);
+		const __m128 sinYCosX = _mm_mul_ps(sinY, cosX);
+
+		__m128 columns[4][4];
+		columns[0][0] = _mm_mul_ps(_mm_mul_ps(cosZ, cosY), sx);
+		columns[0][1] = _mm_mul_ps(_mm_mul_ps(sinZ, cosY), sx);
+		columns[0][2] = _mm_mul_ps(_mm_sub_ps(zero, sinY), sx);
+		columns[0][3] = zero;
+
+		columns[1][0] = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(cosZ, sinYSinX), _mm_mul_ps(sinZ, cosX)), sy);
+		columns[1][1] = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(sinZ, sinYSinX), _mm_mul_ps(cosZ, cosX)), sy);
+		columns[1][2] = _mm_mul_ps(_mm_mul_ps(cosY, sinX), sy);
+		columns[1][3] = zero;
+
+		columns[2][0] = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(cosZ, sinYCosX), _mm_mul_ps(sinZ, sinX)), sz);
+		columns[2][1] = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(sinZ, sinYCosX), _mm_mul_ps(cosZ, sinX)), sz);
+		columns[2][2] = _mm_mul_ps(_mm_mul_ps(cosY, cosX), sz);
+		columns[2][3] = zero;
+
+		columns[3][0] = _mm_loadu_ps(&positionX[i]);
+		columns[3][1] = _mm_loadu_ps(&positionY[i]);
+		columns[3][2] = _mm_loadu_ps(&positionZ[i]);
+		columns[3][3] = one;
+
+		// Convert each column from SoA to one vector per transform
+		for (unsigned int j = 0; j < 4; j++)
+		{
+			_MM_TRANSPOSE4_PS(columns[j][0], columns[j][1], columns[j][2], columns[j][3]);
+		}
+
+		// The last group may be partially filled; only write the valid transforms
+		const unsigned int numValid = glm::min(numTransforms - i, 4u);
+		for (unsigned int j = 0; j < numValid; j++)
+		{
+			float* output = &models[i + j][0][0];
+			for (unsigned int k = 0; k < 4; k++)
+			{
+				_mm_storeu_ps(output + k * 4, columns[k][j]);
+			}
+
+			if (parent != nullptr)
+			{
+				SIMD::MultiplyMat4(&(*parent)[0][0], output, output);
+			}
+		}
+	}
+#else
+	for (unsigned int i = 0; i < numTransforms; i++)
+	{
+		const float sinX = std::sin(rotationX[i]);
+		const float cosX = std::cos(rotationX[i]);
+		const float sinY = std::sin(rotationY[i]);
+		const float cosY = std::cos(rotationY[i]);
+		const float sinZ = std::sin(rotationZ[i]);
+		const float cosZ = std::cos(rotationZ[i]);
+
+		glm::mat4& model = models[i];
+		model[0] = glm::vec4(cosZ * cosY, sinZ * cosY, -sinY, 0.0f) * scaleX[i];
+		model[1] = glm::vec4(cosZ * sinY * sinX - sinZ * cosX, sinZ * sinY * sinX + cosZ * cosX,
+			cosY * sinX, 0.0f) * scaleY[i];
+		model[2] = glm::vec4(cosZ * sinY * cosX + sinZ * sinX, sinZ * sinY * cosX - cosZ * sinX,
+			cosY * cosX, 0.0f) * scaleZ[i];
+		model[3] = glm::vec4(positionX[i], positionY[i], positionZ[i], 1.0f);
+
+		if (parent != nullptr)
+		{
+			SIMD::MultiplyMat4(*parent, model, model);
+		}
+	}
+#endif
+}
@@ -0,0 +1,70 @@
+/** Copyright (c) 2022-2023 Alexander Kaminsky and Maxwell Hunt */
+
+#pragma once
+
+#include "Transform.h"
+
+#include <vector>
+
+/**
+ * @brief Converts many transforms into model matrices at once. Transforms are stored as
+ * structure of arrays, and the matrices are built directly from the closed-form Euler rotation,
+ * 4 transforms at a time with SIMD, rather than by multiplying five separate matrices.
+ *
+ * The matrices match Transform::GetModel.
+ */
+class TransformBatch
+{
+public:
+	TransformBatch() : numTransforms(0) {}
+
+	/**
+	 * @brief Adds a transform to the batch.
+	 * @param transform Transform to add.
+	 * @return Index of the transform, which is also the index of its model matrix.
+	 */
+	unsigned int Add(const Transform& transform);
+
+	/**
+	 * @brief Replaces a transform already in the batch.
+	 * @param index Index returned by Add.
+	 * @param transform New transform.
+	 */
+	void Set(unsigned int index, const Transform& transform);
+
+	/** @brief Removes all transforms. Storage is kept for reuse. */
+	void Clear() { numTransforms = 0; }
+
+	/**
+	 * @brief Computes the model matrices of all transforms in the batch.
+	 * @param models Array of at least GetNumTransforms matrices to write to.
+	 */
+	void ComputeModels(glm::mat4* models) const;
+
+	/**
+	 * @brief Computes the model matrices of all transforms in the batch, premultiplied by another
+	 *		matrix, such as a view projection.
+	 * @param parent Matrix to premultiply every model matrix by.
+	 * @param models Array of at least GetNumTransforms matrices to write to.
+	 */
+	void ComputeModels(const glm::mat4& parent, glm::mat4* models) const;
+
+	inline unsigned int GetNumTransforms() const { return numTransforms; }
+
+private:
+	void ComputeModels(const glm::mat4* parent, glm::mat4* models) const;
+
+	unsigned int numTransforms;
+
+	// Padded to a multiple of 4
+	std::vector<float> positionX;
+	std::vector<float> positionY;
+	std::vector<float> positionZ;
+	// In radians, unlike Transform
+	std::vector<float> rotationX;
+	std::vector<float> rotationY;
+	std::vector<float> rotationZ;
+	std::vector<float> scaleX;
+	std::vector<float> scaleY;
+	std::vector<float> scaleZ;
+};